@@ -0,0 +1,178 @@
+#include "bench.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include "../../core/src/memory/alloc_tracker.h"
+
+namespace
+{
+    bool read_results(const std::string& path, std::map<std::string, double>& out)
+    {
+        std::ifstream file(path);
+        if (!file)
+        {
+            printf("can not open %s\n", path.c_str());
+            return false;
+        }
+
+        // one result object per line, see bench_runner::write_json()
+        std::string line;
+        while (std::getline(file, line))
+        {
+            auto name_pos = line.find("\"name\": \"");
+            auto ns_pos = line.find("\"ns_per_op\": ");
+            if (name_pos == std::string::npos || ns_pos == std::string::npos)
+            {
+                continue;
+            }
+
+            name_pos += std::strlen("\"name\": \"");
+            auto name_end = line.find('"', name_pos);
+            out[line.substr(name_pos, name_end - name_pos)] = std::atof(line.c_str() + ns_pos + std::strlen("\"ns_per_op\": "));
+        }
+
+        return true;
+    }
+}
+
+bool bench_runner::enabled(const std::string& name) const
+{
+    // a group prefix such as "dispatch/" is enabled by any filter below it
+    return options_.filter.empty() || name.find(options_.filter) != std::string::npos || options_.filter.compare(0, name.size(), name) == 0;
+}
+
+void bench_runner::measure(const std::string& name, double bytes_per_op, const std::function<void(uint64_t)>& fn)
+{
+    if (!enabled(name))
+    {
+        return;
+    }
+
+    using clock_type = std::chrono::steady_clock;
+
+    // warm up
+    fn(1);
+
+    uint64_t iterations = 1;
+    double elapsed_ns = 0.0;
+    uint64_t allocations = 0;
+    while (true)
+    {
+        core::alloc_probe probe;
+        auto begin = clock_type::now();
+        fn(iterations);
+        elapsed_ns = std::chrono::duration<double, std::nano>(clock_type::now() - begin).count();
+        allocations = probe.allocations();
+
+        if (elapsed_ns >= options_.min_time_ms * 1e6 || iterations >= (uint64_t(1) << 40))
+        {
+            break;
+        }
+
+        // aim a bit past min_time, at most 10x per step
+        auto scale = elapsed_ns > 0 ? options_.min_time_ms * 1e6 * 1.2 / elapsed_ns : 10.0;
+        if (scale > 10.0) scale = 10.0;
+        if (scale < 2.0) scale = 2.0;
+        iterations = static_cast<uint64_t>(iterations * scale);
+    }
+
+    bench_result result;
+    result.name = name;
+    result.iterations = iterations;
+    result.ns_per_op = elapsed_ns / iterations;
+    result.ops_per_sec = 1e9 / result.ns_per_op;
+    result.bytes_per_op = bytes_per_op;
+    result.allocs_per_op = static_cast<double>(allocations) / iterations;
+
+    if (std::find(zero_alloc_names_.begin(), zero_alloc_names_.end(), name) != zero_alloc_names_.end() && allocations != 0)
+    {
+        printf("FAIL %s: %llu allocations in %llu iterations, expected none\n", name.c_str(), static_cast<unsigned long long>(allocations), static_cast<unsigned long long>(iterations));
+        ++failures_;
+    }
+
+    record(std::move(result));
+}
+
+void bench_runner::fail(const std::string& name, const std::string& reason)
+{
+    printf("FAIL %s: %s\n", name.c_str(), reason.c_str());
+    ++failures_;
+}
+
+void bench_runner::record(bench_result result)
+{
+    printf("%-60s %12.1f ns/op %14.0f ops/s", result.name.c_str(), result.ns_per_op, result.ops_per_sec);
+    if (result.p99_ns > 0)
+    {
+        printf("  p50 %.1fus p99 %.1fus", result.p50_ns / 1000.0, result.p99_ns / 1000.0);
+    }
+    if (result.allocs_per_op > 0)
+    {
+        printf("  %.2f allocs/op", result.allocs_per_op);
+    }
+    printf("\n");
+
+    results_.emplace_back(std::move(result));
+}
+
+bool bench_runner::write_json() const
+{
+    if (options_.json_path.empty())
+    {
+        return true;
+    }
+
+    auto file = fopen(options_.json_path.c_str(), "w");
+    if (file == nullptr)
+    {
+        printf("can not open %s\n", options_.json_path.c_str());
+        return false;
+    }
+
+    fprintf(file, "{\n  \"results\": [\n");
+    for (size_t i = 0; i < results_.size(); ++i)
+    {
+        auto& r = results_[i];
+        fprintf(file, "    { \"name\": \"%s\", \"iterations\": %llu, \"ns_per_op\": %.3f, \"ops_per_sec\": %.1f, \"bytes_per_op\": %.1f, \"p50_ns\": %.1f, \"p99_ns\": %.1f, \"allocs_per_op\": %.3f }%s\n",
+            r.name.c_str(), static_cast<unsigned long long>(r.iterations), r.ns_per_op, r.ops_per_sec, r.bytes_per_op, r.p50_ns, r.p99_ns, r.allocs_per_op,
+            i + 1 < results_.size() ? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+    fclose(file);
+
+    printf("results written: %s\n", options_.json_path.c_str());
+    return true;
+}
+
+int compare_results(const std::string& base_path, const std::string& current_path, double threshold_pct)
+{
+    std::map<std::string, double> base;
+    std::map<std::string, double> current;
+    if (!read_results(base_path, base) || !read_results(current_path, current))
+    {
+        return -1;
+    }
+
+    auto regressions = 0;
+    printf("%-60s %12s %12s %9s\n", "benchmark", "base ns/op", "ns/op", "delta");
+    for (auto& c : current)
+    {
+        auto it = base.find(c.first);
+        if (it == base.end() || it->second <= 0.0)
+        {
+            printf("%-60s %12s %12.1f %9s\n", c.first.c_str(), "-", c.second, "new");
+            continue;
+        }
+
+        auto delta_pct = (c.second - it->second) / it->second * 100.0;
+        auto regressed = delta_pct > threshold_pct;
+        regressions += regressed ? 1 : 0;
+
+        printf("%-60s %12.1f %12.1f %+8.1f%%%s\n", c.first.c_str(), it->second, c.second, delta_pct, regressed ? "  REGRESSION" : "");
+    }
+
+    printf("%d regression(s) beyond %.1f%%\n", regressions, threshold_pct);
+    return regressions;
+}
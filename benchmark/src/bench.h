@@ -0,0 +1,89 @@
+#ifndef __BENCH_H
+#define __BENCH_H
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+struct bench_result
+{
+    std::string name;
+    uint64_t iterations = 0;
+    double ns_per_op = 0.0;
+    double ops_per_sec = 0.0;
+    double bytes_per_op = 0.0;
+
+    // latency benchmarks only
+    double p50_ns = 0.0;
+    double p99_ns = 0.0;
+
+    // heap allocations by the measuring thread, measure() only
+    double allocs_per_op = 0.0;
+};
+
+struct bench_options
+{
+    std::string filter;
+    std::string json_path;
+    double min_time_ms = 200.0;
+    size_t max_threads = 1;
+    unsigned short port = 3100;
+
+    // --replay: capture file recorded by sgs2 --capture
+    std::string replay_path;
+    double replay_speed = 0.0;      // 0 = as fast as possible, 1 = recorded pacing
+    bool replay_sockets = false;
+
+    // --scale: ramp to scale_max connections against an in-process server, linux only
+    size_t scale_max = 0;
+    double scale_active = 0.1;      // share of the connections that ping once a second
+    std::string scale_report = "scale_report.txt";
+};
+
+class bench_runner
+{
+public:
+    explicit bench_runner(bench_options options) : options_(std::move(options)) {}
+
+    const bench_options& options() const { return options_; }
+
+    bool enabled(const std::string& name) const;
+
+    // calls fn(iterations) with a growing count until it runs for min_time_ms
+    void measure(const std::string& name, double bytes_per_op, const std::function<void(uint64_t)>& fn);
+
+    // for benchmarks that time themselves
+    void record(bench_result result);
+
+    // the next measure() of this name fails the run if the measuring thread allocates
+    void expect_zero_allocations(const std::string& name) { zero_alloc_names_.push_back(name); }
+    int failures() const { return failures_; }
+
+    // for benchmarks that check their own results (stress runs), fails the run
+    void fail(const std::string& name, const std::string& reason);
+
+    bool write_json() const;
+
+private:
+    bench_options options_;
+    std::vector<bench_result> results_;
+    std::vector<std::string> zero_alloc_names_;
+    int failures_ = 0;
+};
+
+// base.json vs current.json, returns the number of regressions beyond threshold_pct
+int compare_results(const std::string& base_path, const std::string& current_path, double threshold_pct);
+
+void run_job_system_benchmark(bench_runner& runner);
+void run_packet_benchmark(bench_runner& runner);
+void run_loopback_benchmark(bench_runner& runner);
+void run_replay_benchmark(bench_runner& runner);
+void run_string_benchmark(bench_runner& runner);
+void run_memory_benchmark(bench_runner& runner);
+void run_concurrency_benchmark(bench_runner& runner);
+void run_room_benchmark(bench_runner& runner);
+void run_scale_benchmark(bench_runner& runner);
+
+#endif
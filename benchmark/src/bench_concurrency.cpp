@@ -0,0 +1,443 @@
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "bench.h"
+#include "../../core/src/concurrency/concurrent_hash_map.h"
+#include "../../core/src/concurrency/mpmc_queue.h"
+#include "../../core/src/concurrency/mpsc_queue.h"
+#include "../../core/src/concurrency/mpsc_ring.h"
+#include "../../core/src/concurrency/spsc_ring.h"
+
+namespace
+{
+    // producer in the high bits, its sequence number in the low bits, consumers check per producer order
+    constexpr int producer_shift = 40;
+    constexpr uint64_t sequence_mask = (uint64_t(1) << producer_shift) - 1;
+
+    volatile uint64_t sink = 0;
+
+    constexpr size_t ring_size = 1024;
+    constexpr size_t batch_size = 32;
+
+    // every value of every producer exactly once, each producer's values in the order they were pushed
+    class order_check
+    {
+    public:
+        explicit order_check(size_t producers) : next_(producers, 0) {}
+
+        void accept(uint64_t value)
+        {
+            const auto producer = static_cast<size_t>(value >> producer_shift);
+            if (producer >= next_.size() || (value & sequence_mask) != next_[producer])
+            {
+                ok_ = false;
+                return;
+            }
+            ++next_[producer];
+        }
+
+        bool ok() const { return ok_; }
+
+    private:
+        std::vector<uint64_t> next_;
+        bool ok_ = true;
+    };
+
+    // push(first, last) returns how many went in, pop(out, max) how many came out; the calling thread consumes
+    template <typename Push, typename Pop>
+    bool producers_to_one(uint64_t iterations, size_t producers, size_t batch, Push push, Pop pop)
+    {
+        const auto per_producer = iterations / producers + 1;
+
+        std::vector<std::thread> threads;
+        for (size_t p = 0; p < producers; ++p)
+        {
+            threads.emplace_back([&, p]
+            {
+                std::vector<uint64_t> values(batch);
+                for (uint64_t sent = 0; sent < per_producer;)
+                {
+                    const auto count = per_producer - sent < batch ? static_cast<size_t>(per_producer - sent) : batch;
+                    for (size_t i = 0; i < count; ++i)
+                    {
+                        values[i] = (uint64_t(p) << producer_shift) | (sent + i);
+                    }
+
+                    auto first = values.data();
+                    const auto last = first + count;
+                    while (first != last)
+                    {
+                        const auto pushed = push(first, last);
+                        if (pushed == 0)
+                        {
+                            std::this_thread::yield();
+                        }
+                        first += pushed;
+                    }
+                    sent += count;
+                }
+            });
+        }
+
+        order_check check(producers);
+        std::vector<uint64_t> out(batch);
+        for (uint64_t received = 0; received < per_producer * producers;)
+        {
+            const auto count = pop(out.data(), batch);
+            if (count == 0)
+            {
+                std::this_thread::yield();
+            }
+            for (size_t i = 0; i < count; ++i)
+            {
+                check.accept(out[i]);
+            }
+            received += count;
+        }
+
+        for (auto& t : threads)
+        {
+            t.join();
+        }
+        return check.ok();
+    }
+
+    // mutex + deque, what the queues replace
+    class locked_queue
+    {
+    public:
+        size_t push(const uint64_t* first, const uint64_t* last)
+        {
+            std::lock_guard<std::mutex> lock(m_);
+            q_.insert(q_.end(), first, last);
+            return last - first;
+        }
+
+        size_t pop(uint64_t* out, size_t max)
+        {
+            std::lock_guard<std::mutex> lock(m_);
+            size_t count = 0;
+            for (; count < max && !q_.empty(); ++count)
+            {
+                out[count] = q_.front();
+                q_.pop_front();
+            }
+            return count;
+        }
+
+    private:
+        std::mutex m_;
+        std::deque<uint64_t> q_;
+    };
+
+    template <typename Queue>
+    size_t push_each(Queue& q, const uint64_t* first, const uint64_t* last)
+    {
+        size_t count = 0;
+        for (; first != last && q.try_push(*first); ++first)
+        {
+            ++count;
+        }
+        return count;
+    }
+
+    template <typename Queue>
+    size_t pop_each(Queue& q, uint64_t* out, size_t max)
+    {
+        size_t count = 0;
+        for (; count < max && q.try_pop(out[count]); ++count)
+        {
+        }
+        return count;
+    }
+
+    void queue_benchmarks(bench_runner& runner, const std::vector<size_t>& producer_counts)
+    {
+        auto check = [&runner](const std::string& name, bool ok)
+        {
+            if (!ok)
+            {
+                runner.fail(name, "values lost, duplicated or out of order");
+            }
+        };
+
+        for (size_t batch : { size_t(1), batch_size })
+        {
+            const auto suffix = "/batch:" + std::to_string(batch);
+
+            auto name = "concurrency/spsc_ring" + suffix;
+            runner.measure(name, 0.0, [&](uint64_t iterations)
+            {
+                core::spsc_ring<uint64_t> ring(ring_size);
+                check(name, producers_to_one(iterations, 1, batch,
+                    [&](const uint64_t* first, const uint64_t* last) { return batch == 1 ? push_each(ring, first, last) : ring.push_batch(first, last); },
+                    [&](uint64_t* out, size_t max) { return batch == 1 ? pop_each(ring, out, max) : ring.pop_batch(out, max); }));
+            });
+
+            for (auto producers : producer_counts)
+            {
+                const auto shape = "/producers:" + std::to_string(producers) + suffix;
+
+                name = "concurrency/mpsc_ring" + shape;
+                runner.measure(name, 0.0, [&](uint64_t iterations)
+                {
+                    core::mpsc_ring<uint64_t> ring(ring_size);
+                    check(name, producers_to_one(iterations, producers, batch,
+                        [&](const uint64_t* first, const uint64_t* last) { return batch == 1 ? push_each(ring, first, last) : ring.push_batch(first, last); },
+                        [&](uint64_t* out, size_t max) { return batch == 1 ? pop_each(ring, out, max) : ring.pop_batch(out, max); }));
+                });
+
+                name = "concurrency/mpsc_queue" + shape;
+                runner.measure(name, 0.0, [&](uint64_t iterations)
+                {
+                    core::mpsc_queue<uint64_t> queue;
+                    check(name, producers_to_one(iterations, producers, batch,
+                        [&](const uint64_t* first, const uint64_t* last) -> size_t
+                        {
+                            if (batch == 1)
+                            {
+                                queue.push(*first);
+                                return 1;
+                            }
+                            queue.push_batch(first, last);
+                            return last - first;
+                        },
+                        [&](uint64_t* out, size_t max) { return queue.pop_batch(out, max); }));
+                });
+
+                name = "concurrency/mpmc_queue" + shape;
+                runner.measure(name, 0.0, [&](uint64_t iterations)
+                {
+                    core::mpmc_queue<uint64_t> queue(ring_size);
+                    check(name, producers_to_one(iterations, producers, batch,
+                        [&](const uint64_t* first, const uint64_t* last) { return batch == 1 ? push_each(queue, first, last) : queue.push_batch(first, last); },
+                        [&](uint64_t* out, size_t max) { return batch == 1 ? pop_each(queue, out, max) : queue.pop_batch(out, max); }));
+                });
+
+                name = "concurrency/mutex_deque" + shape;
+                runner.measure(name, 0.0, [&](uint64_t iterations)
+                {
+                    locked_queue queue;
+                    check(name, producers_to_one(iterations, producers, batch,
+                        [&](const uint64_t* first, const uint64_t* last) { return queue.push(first, last); },
+                        [&](uint64_t* out, size_t max) { return queue.pop(out, max); }));
+                });
+            }
+        }
+
+        // many to many: no global order, but each consumer must see each producer's values in order
+        for (auto threads : producer_counts)
+        {
+            const auto name = "concurrency/mpmc_queue/threads:" + std::to_string(threads) + "x" + std::to_string(threads);
+            runner.measure(name, 0.0, [&](uint64_t iterations)
+            {
+                core::mpmc_queue<uint64_t> queue(ring_size);
+                const auto per_producer = iterations / threads + 1;
+                std::atomic<uint64_t> remaining{ per_producer * threads };
+                std::atomic<bool> ok{ true };
+
+                std::vector<std::thread> workers;
+                for (size_t p = 0; p < threads; ++p)
+                {
+                    workers.emplace_back([&, p]
+                    {
+                        for (uint64_t seq = 0; seq < per_producer; ++seq)
+                        {
+                            while (!queue.try_push((uint64_t(p) << producer_shift) | seq))
+                            {
+                                std::this_thread::yield();
+                            }
+                        }
+                    });
+
+                    workers.emplace_back([&]
+                    {
+                        std::vector<uint64_t> last(threads, 0);
+                        std::vector<bool> seen(threads, false);
+                        uint64_t value;
+                        while (remaining.load(std::memory_order_relaxed) != 0)
+                        {
+                            if (!queue.try_pop(value))
+                            {
+                                std::this_thread::yield();
+                                continue;
+                            }
+
+                            remaining.fetch_sub(1, std::memory_order_relaxed);
+                            const auto producer = static_cast<size_t>(value >> producer_shift);
+                            const auto seq = value & sequence_mask;
+                            if (producer >= threads || (seen[producer] && seq <= last[producer]))
+                            {
+                                ok = false;
+                                continue;
+                            }
+                            seen[producer] = true;
+                            last[producer] = seq;
+                        }
+                    });
+                }
+
+                for (auto& t : workers)
+                {
+                    t.join();
+                }
+                check(name, ok && queue.empty());
+            });
+        }
+    }
+
+    // one writer churning part of the key space while readers look up the rest, like a session registry
+    // every stored value is key * 2, a reader that sees anything else has read a freed or torn node
+    void hash_map_benchmarks(bench_runner& runner, const std::vector<size_t>& reader_counts)
+    {
+        static constexpr uint64_t stable_keys = 1 << 16;
+        static constexpr uint64_t churn_keys = 1 << 12;
+
+        for (auto readers : reader_counts)
+        {
+            const auto shape = "/readers:" + std::to_string(readers);
+
+            auto name = "concurrency/hash_map/find" + shape;
+            core::concurrent_hash_map<uint64_t, uint64_t> map;
+            for (uint64_t k = 0; k < stable_keys; ++k)
+            {
+                map.insert(k, k * 2);
+            }
+
+            runner.measure(name, 0.0, [&](uint64_t iterations)
+            {
+                std::atomic<bool> stop{ false };
+                std::atomic<bool> ok{ true };
+
+                auto read = [&](uint64_t count, uint64_t seed)
+                {
+                    uint64_t value = 0;
+                    for (uint64_t i = 0; i < count && !stop.load(std::memory_order_relaxed); ++i)
+                    {
+                        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+                        const auto key = (seed >> 33) % (stable_keys + churn_keys);
+                        const auto found = map.find(key, value);
+                        if ((found && value != key * 2) || (!found && key < stable_keys))
+                        {
+                            ok = false;
+                        }
+                    }
+                };
+
+                std::vector<std::thread> threads;
+                threads.emplace_back([&]
+                {
+                    for (uint64_t i = 0; !stop.load(std::memory_order_relaxed); ++i)
+                    {
+                        const auto key = stable_keys + i % churn_keys;
+                        if ((i / churn_keys) % 2 == 0)
+                        {
+                            map.insert(key, key * 2);
+                        }
+                        else
+                        {
+                            map.erase(key);
+                        }
+                        map.insert_or_assign(i % stable_keys, (i % stable_keys) * 2);
+                    }
+                });
+                for (size_t r = 1; r < readers; ++r)
+                {
+                    threads.emplace_back([&, r] { read(~uint64_t(0), r); });
+                }
+
+                read(iterations, 0);
+                stop = true;
+                for (auto& t : threads)
+                {
+                    t.join();
+                }
+
+                if (!ok)
+                {
+                    runner.fail(name, "lookup returned a wrong value or missed a stable key");
+                }
+            });
+
+            name = "concurrency/mutex_unordered_map/find" + shape;
+            std::mutex m;
+            std::unordered_map<uint64_t, uint64_t> locked;
+            for (uint64_t k = 0; k < stable_keys; ++k)
+            {
+                locked.emplace(k, k * 2);
+            }
+
+            runner.measure(name, 0.0, [&](uint64_t iterations)
+            {
+                std::atomic<bool> stop{ false };
+
+                auto read = [&](uint64_t count, uint64_t seed)
+                {
+                    for (uint64_t i = 0; i < count && !stop.load(std::memory_order_relaxed); ++i)
+                    {
+                        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+                        const auto key = (seed >> 33) % (stable_keys + churn_keys);
+                        std::lock_guard<std::mutex> lock(m);
+                        auto it = locked.find(key);
+                        if (it != locked.end())
+                        {
+                            sink += it->second;
+                        }
+                    }
+                };
+
+                std::vector<std::thread> threads;
+                threads.emplace_back([&]
+                {
+                    for (uint64_t i = 0; !stop.load(std::memory_order_relaxed); ++i)
+                    {
+                        const auto key = stable_keys + i % churn_keys;
+                        std::lock_guard<std::mutex> lock(m);
+                        if ((i / churn_keys) % 2 == 0)
+                        {
+                            locked.emplace(key, key * 2);
+                        }
+                        else
+                        {
+                            locked.erase(key);
+                        }
+                        locked[i % stable_keys] = (i % stable_keys) * 2;
+                    }
+                });
+                for (size_t r = 1; r < readers; ++r)
+                {
+                    threads.emplace_back([&, r] { read(~uint64_t(0), r); });
+                }
+
+                read(iterations, 0);
+                stop = true;
+                for (auto& t : threads)
+                {
+                    t.join();
+                }
+            });
+        }
+    }
+}
+
+void run_concurrency_benchmark(bench_runner& runner)
+{
+    if (!runner.enabled("concurrency/"))
+    {
+        return;
+    }
+
+    // one thread is the consumer / measuring reader
+    std::vector<size_t> counts;
+    for (size_t n = 1; n <= 4 && (n == 1 || n < runner.options().max_threads); n *= 2)
+    {
+        counts.push_back(n);
+    }
+
+    queue_benchmarks(runner, counts);
+    hash_map_benchmarks(runner, counts);
+}
@@ -0,0 +1,81 @@
+#include <atomic>
+#include <cmath>
+#include <string>
+#include <vector>
+#include "bench.h"
+#include "../../core/src/job/job_system.h"
+
+namespace
+{
+    // cpu bound kernel, roughly what per entity ai / physics steps look like
+    void kernel(std::vector<double>& data, size_t first, size_t last)
+    {
+        for (auto i = first; i < last; ++i)
+        {
+            auto v = data[i];
+            for (auto k = 0; k < 32; ++k)
+            {
+                v = std::sqrt(v * v + 1.0);
+            }
+            data[i] = v;
+        }
+    }
+
+    // many small dependent jobs: fan out, fan in, continuation
+    void job_graph(core::job_system& jobs, size_t width)
+    {
+        auto root = jobs.create([] {});
+        auto join = jobs.create([] {});
+
+        for (size_t i = 0; i < width; ++i)
+        {
+            auto leaf = jobs.create([] {});
+            jobs.add_dependency(root, leaf);
+            jobs.add_dependency(leaf, join);
+            jobs.submit(leaf);
+        }
+
+        jobs.submit(join);
+        auto done = jobs.then(join, [] {});
+        jobs.submit(root);
+        jobs.wait(done);
+    }
+}
+
+void run_job_system_benchmark(bench_runner& runner)
+{
+    static constexpr size_t element_count = 1 << 18;
+    static constexpr size_t grains[] = { 256, 4096, 65536 };
+    static constexpr size_t width = 256;
+
+    std::vector<double> data(element_count, 1.0);
+    auto& jobs = core::job_system::instance();
+
+    for (size_t threads = 1; threads <= runner.options().max_threads; ++threads)
+    {
+        jobs.start(threads);
+
+        // one op = one parallel_for over element_count elements, compare across thread counts for scaling
+        for (auto grain : grains)
+        {
+            auto name = "job_system/parallel_for/grain:" + std::to_string(grain) + "/threads:" + std::to_string(threads);
+            runner.measure(name, 0.0, [&](uint64_t iterations)
+            {
+                for (uint64_t i = 0; i < iterations; ++i)
+                {
+                    jobs.parallel_for(0, data.size(), grain, [&data](size_t first, size_t last) { kernel(data, first, last); });
+                }
+            });
+        }
+
+        runner.measure("job_system/graph/width:" + std::to_string(width) + "/threads:" + std::to_string(threads), 0.0, [&](uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                job_graph(jobs, width);
+            }
+        });
+
+        jobs.stop();
+    }
+}
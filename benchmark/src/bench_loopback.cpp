@@ -0,0 +1,432 @@
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <boost/asio.hpp>
+#include "bench.h"
+#include "io_helper.h"
+#include "server/server.h"
+#include "buffer_pool/send_buffer_pool.h"
+#include "buffer_pool/receive_buffer_pool.h"
+#include "../../client/src/packet_writer.h"
+#include "../../core/src/memory/alloc_tracker.h"
+#include "../../core/src/metrics/histogram.h"
+#include "../../sgs2/src/packet_processor/packet_processor.h"
+#include "../../sgs2/src/server_session/server_session.h"
+#include "../../sgs2/src/executor/executor.h"
+
+namespace
+{
+    using boost::asio::ip::tcp;
+
+    // blocking read of one frame, returns its opcode
+    bool read_frame(tcp::socket& socket, std::array<char, network::packet_buf_size>& body, opcode& code)
+    {
+        boost::system::error_code ec;
+
+        unsigned short size = 0;
+        boost::asio::read(socket, boost::asio::buffer(&size, sizeof(size)), ec);
+        if (ec || size < sizeof(unsigned short) || size > network::max_packet_size)
+        {
+            return false;
+        }
+
+        boost::asio::read(socket, boost::asio::buffer(body.data(), size), ec);
+        if (ec)
+        {
+            return false;
+        }
+
+        std::memcpy(&code, body.data(), sizeof(code));
+        return true;
+    }
+
+    // request / response round trips against a live server, one blocking client per io thread
+    void round_trip(bench_runner& runner, const std::string& name, const std::vector<char>& request, opcode expected, size_t client_count)
+    {
+        if (!runner.enabled(name))
+        {
+            return;
+        }
+
+        const auto endpoint = tcp::endpoint(boost::asio::ip::address_v4::loopback(), runner.options().port);
+        const auto duration = std::chrono::duration<double, std::milli>(runner.options().min_time_ms);
+
+        std::vector<core::histogram> histograms(client_count);
+        std::vector<uint64_t> counts(client_count, 0);
+        std::vector<std::thread> clients;
+
+        const auto begin = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < client_count; ++i)
+        {
+            clients.emplace_back([&, i]
+            {
+                boost::asio::io_service io_service;
+                tcp::socket socket(io_service);
+                boost::system::error_code ec;
+
+                socket.connect(endpoint, ec);
+                if (ec)
+                {
+                    return;
+                }
+                socket.set_option(tcp::no_delay(true));
+
+                std::array<char, network::packet_buf_size> body;
+                opcode code;
+
+                // SC_LOG_IN pushed by server_session::on_connect
+                if (!read_frame(socket, body, code))
+                {
+                    return;
+                }
+
+                const auto deadline = std::chrono::steady_clock::now() + duration;
+                while (std::chrono::steady_clock::now() < deadline)
+                {
+                    const auto sent = std::chrono::steady_clock::now();
+                    boost::asio::write(socket, boost::asio::buffer(request), ec);
+                    if (ec)
+                    {
+                        return;
+                    }
+
+                    do
+                    {
+                        if (!read_frame(socket, body, code))
+                        {
+                            return;
+                        }
+                    } while (code != expected);
+
+                    histograms[i].record(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - sent).count());
+                    ++counts[i];
+                }
+
+                socket.shutdown(tcp::socket::shutdown_both, ec);
+                socket.close(ec);
+            });
+        }
+
+        for (auto& client : clients)
+        {
+            client.join();
+        }
+
+        const auto elapsed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count();
+
+        core::histogram merged;
+        uint64_t total = 0;
+        for (size_t i = 0; i < client_count; ++i)
+        {
+            merged.merge(histograms[i]);
+            total += counts[i];
+        }
+
+        if (total == 0)
+        {
+            printf("%-60s no round trips, is port %u free?\n", name.c_str(), runner.options().port);
+            return;
+        }
+
+        bench_result result;
+        result.name = name;
+        result.iterations = total;
+        result.ns_per_op = static_cast<double>(elapsed_ns) / total;
+        result.ops_per_sec = total * 1e9 / elapsed_ns;
+        result.bytes_per_op = static_cast<double>(request.size());
+        result.p50_ns = static_cast<double>(merged.percentile(50.0));
+        result.p99_ns = static_cast<double>(merged.percentile(99.0));
+        runner.record(result);
+    }
+
+    uint64_t total_allocations()
+    {
+        uint64_t total = 0;
+        for (auto& counts : core::alloc_tracker::snapshot())
+        {
+            total += counts.allocations;
+        }
+        return total;
+    }
+
+    int64_t live_heap_bytes()
+    {
+        int64_t total = 0;
+        for (auto& counts : core::alloc_tracker::snapshot())
+        {
+            total += counts.live_bytes();
+        }
+        return total;
+    }
+
+    // idle lobby players: connect, get the SC_LOG_IN greeting, then send nothing
+    // bytes/session is the server's user space memory per connection once every greeting is out:
+    // heap growth (session, socket state, posted read, send queue) minus the client sockets, plus the
+    // receive buffers held; send buffers live in the shared pool's slabs, off the heap, and are left out
+    void idle_connections(bench_runner& runner, size_t count, bool lazy)
+    {
+        const auto name = "loopback/idle/sessions:" + std::to_string(count) + "/lazy_receive:" + (lazy ? "on" : "off");
+        if (!runner.enabled(name))
+        {
+            return;
+        }
+
+        network::session::set_lazy_receive(lazy);
+        network::initialize();
+
+        tcp::endpoint endpoint(tcp::v4(), runner.options().port);
+        auto svr = std::make_unique<network::server<server_session>>(network::io_service(), endpoint);
+
+        // one time io thread and pool setup stays out of the numbers
+        auto& send_pool = network::send_buffer_pool::instance();
+        send_pool.reserve(64);
+        network::start(1);
+        start_executors(1, 1);
+
+        const auto before_clients = live_heap_bytes();
+        boost::asio::io_service client_io;
+        std::vector<tcp::socket> clients;
+        clients.reserve(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            clients.emplace_back(client_io);
+            clients.back().open(tcp::v4());
+        }
+        const auto client_bytes = live_heap_bytes() - before_clients;
+
+        const auto before_sessions = live_heap_bytes();
+        const auto target = tcp::endpoint(boost::asio::ip::address_v4::loopback(), runner.options().port);
+        const auto begin = std::chrono::steady_clock::now();
+
+        size_t connected = 0;
+        for (auto& client : clients)
+        {
+            boost::system::error_code ec;
+            client.connect(target, ec);
+            if (ec)
+            {
+                break;
+            }
+            ++connected;
+        }
+
+        // every session started and its greeting written
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while ((network::session::count() < connected || send_pool.in_use() > 0) && std::chrono::steady_clock::now() < deadline)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        const auto elapsed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count();
+
+        const auto started = network::session::count();
+        const auto receive_bytes = static_cast<int64_t>(network::receive_buffer_pool::instance().in_use() * sizeof(network::packet_buffer_type));
+        const auto session_bytes = live_heap_bytes() - before_sessions + receive_bytes;
+
+        for (auto& client : clients)
+        {
+            boost::system::error_code ec;
+            client.set_option(boost::asio::socket_base::linger(true, 0), ec);
+            client.close(ec);
+        }
+
+        svr->stop();
+        network::stop();
+        stop_executors();
+        svr.reset();
+        network::session::set_lazy_receive(false);
+
+        if (connected == 0 || started < connected)
+        {
+            runner.fail(name, std::to_string(started) + " of " + std::to_string(connected) + " connections started, is port " + std::to_string(runner.options().port) + " free?");
+            return;
+        }
+
+        const auto per_session = static_cast<double>(session_bytes) / connected;
+        printf("%-60s %.0f bytes/session (%.0f client bytes/socket left out)\n", name.c_str(), per_session, static_cast<double>(client_bytes) / connected);
+
+        bench_result result;
+        result.name = name;
+        result.iterations = connected;
+        result.ns_per_op = static_cast<double>(elapsed_ns) / connected;
+        result.ops_per_sec = connected * 1e9 / elapsed_ns;
+        result.bytes_per_op = per_session;
+        runner.record(result);
+
+        if (lazy && per_session >= 1024.0)
+        {
+            runner.fail(name, "idle session holds " + std::to_string(static_cast<int64_t>(per_session)) + " bytes, budget is 1024");
+        }
+    }
+
+    // reconnect storm: paced clients connect, wait for the SC_LOG_IN greeting and reset the connection
+    // one op = one connection, latency is connect() to greeting, allocs/op is process wide (clients included)
+    void connect_churn(bench_runner& runner, size_t idle_sessions, double rate, size_t threads)
+    {
+        const auto name = "loopback/connect_churn/rate:" + std::to_string(static_cast<int>(rate)) + "/idle_sessions:" + std::to_string(idle_sessions) + "/threads:" + std::to_string(threads);
+        if (!runner.enabled(name))
+        {
+            return;
+        }
+
+        static constexpr size_t client_count = 2;
+
+        network::initialize();
+
+        tcp::endpoint endpoint(tcp::v4(), runner.options().port);
+        auto svr = std::make_unique<network::server<server_session>>(network::io_service(), endpoint, idle_sessions);
+
+        network::start(threads);
+        start_executors(threads, 4);
+
+        const auto target = tcp::endpoint(boost::asio::ip::address_v4::loopback(), runner.options().port);
+        const auto duration = std::chrono::duration<double, std::milli>(runner.options().min_time_ms);
+        const auto interval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(client_count / rate));
+
+        std::vector<core::histogram> histograms(client_count);
+        std::vector<uint64_t> counts(client_count, 0);
+        std::vector<std::thread> clients;
+
+        const auto allocations_before = total_allocations();
+        const auto begin = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < client_count; ++i)
+        {
+            clients.emplace_back([&, i]
+            {
+                boost::asio::io_service io_service;
+                std::array<char, network::packet_buf_size> body;
+                opcode code;
+
+                auto next = std::chrono::steady_clock::now();
+                const auto deadline = next + duration;
+                while (next < deadline)
+                {
+                    std::this_thread::sleep_until(next);
+                    next += interval;
+
+                    const auto started = std::chrono::steady_clock::now();
+
+                    tcp::socket socket(io_service);
+                    boost::system::error_code ec;
+                    socket.connect(target, ec);
+                    if (ec)
+                    {
+                        continue;
+                    }
+
+                    if (read_frame(socket, body, code))
+                    {
+                        histograms[i].record(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - started).count());
+                        ++counts[i];
+                    }
+
+                    // rst instead of fin, keeps the client ports out of time_wait
+                    socket.set_option(boost::asio::socket_base::linger(true, 0), ec);
+                    socket.close(ec);
+                }
+            });
+        }
+
+        for (auto& client : clients)
+        {
+            client.join();
+        }
+
+        const auto elapsed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count();
+        const auto allocations = total_allocations() - allocations_before;
+
+        svr->stop();
+        network::stop();
+        stop_executors();
+
+        core::histogram merged;
+        uint64_t total = 0;
+        for (size_t i = 0; i < client_count; ++i)
+        {
+            merged.merge(histograms[i]);
+            total += counts[i];
+        }
+
+        if (total == 0)
+        {
+            printf("%-60s no connections, is port %u free?\n", name.c_str(), runner.options().port);
+            return;
+        }
+
+        printf("%-60s %zu session objects for %llu connections\n", name.c_str(), svr->sessions().created(), static_cast<unsigned long long>(total));
+        svr.reset();
+
+        bench_result result;
+        result.name = name;
+        result.iterations = total;
+        result.ns_per_op = static_cast<double>(elapsed_ns) / total;
+        result.ops_per_sec = total * 1e9 / elapsed_ns;
+        result.p50_ns = static_cast<double>(merged.percentile(50.0));
+        result.p99_ns = static_cast<double>(merged.percentile(99.0));
+        result.allocs_per_op = static_cast<double>(allocations) / total;
+        runner.record(result);
+    }
+}
+
+void run_loopback_benchmark(bench_runner& runner)
+{
+    if (!runner.enabled("loopback/"))
+    {
+        return;
+    }
+
+    register_handlers();
+
+    GAME::CS_PING ping;
+    ping.set_timestamp(1234567890123LL);
+
+    std::vector<char> ping_request;
+    write_packet(ping, ping_request);
+
+    for (size_t threads = 1; threads <= runner.options().max_threads; threads *= 2)
+    {
+        network::initialize();
+
+        tcp::endpoint endpoint(tcp::v4(), runner.options().port);
+        auto svr = std::make_unique<network::server<server_session>>(network::io_service(), endpoint);
+
+        network::start(threads);
+        start_executors(threads, 4);
+
+        const auto suffix = "/threads:" + std::to_string(threads);
+
+        round_trip(runner, "loopback/CS_PING" + suffix, ping_request, opcode::SC_PING, threads);
+
+        for (auto id_size : { 16, 256, 4096 })
+        {
+            LOBBY::CS_LOG_IN login;
+            login.set_id(std::string(id_size, 'a'));
+            login.set_password("password");
+
+            std::vector<char> login_request;
+            write_packet(login, login_request);
+
+            round_trip(runner, "loopback/CS_LOG_IN/id:" + std::to_string(id_size) + suffix, login_request, opcode::SC_LOG_IN, threads);
+        }
+
+        svr->stop();
+        network::stop();
+        stop_executors();
+        svr.reset();
+    }
+
+    // fresh session per connection vs recycled ones, at the 20k connections/sec of a reconnect storm
+    for (auto idle_sessions : { size_t(0), network::server<server_session>::default_idle_sessions })
+    {
+        connect_churn(runner, idle_sessions, 20000.0, runner.options().max_threads);
+    }
+
+    // 100k mostly idle lobby players, scaled down to what one listen backlog takes
+    for (auto lazy : { false, true })
+    {
+        idle_connections(runner, 1000, lazy);
+    }
+}
@@ -0,0 +1,236 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "bench.h"
+#include "io_helper.h"
+#include "../../core/src/memory/arena.h"
+#include "../../core/src/memory/object_pool.h"
+#include "../../sgs2/src/server_session/server_session.h"
+
+namespace
+{
+    volatile size_t sink = 0;
+
+    // server_session without the socket, the allocation is what matters here
+    struct session_sized
+    {
+        char bytes[sizeof(server_session)];
+    };
+
+    // shapes of a parsed CS_LOG_IN: the message, two strings, their reps and a response
+    const size_t packet_allocations[] = { 48, 32, 32, 24, 24, 64 };
+
+    // a allocates batch_size blocks, b frees them, like a send buffer filled by a handler and released by an io thread
+    template <typename Allocate, typename Free>
+    void cross_thread(uint64_t iterations, Allocate allocate, Free free)
+    {
+        static constexpr size_t batch_size = 256;
+
+        std::vector<void*> batches[2] = { std::vector<void*>(batch_size), std::vector<void*>(batch_size) };
+        std::atomic<int> ready{ -1 };
+        std::atomic<bool> done{ false };
+
+        std::thread consumer([&]
+        {
+            for (;;)
+            {
+                const auto index = ready.load(std::memory_order_acquire);
+                if (index < 0)
+                {
+                    if (done.load(std::memory_order_acquire))
+                    {
+                        return;
+                    }
+                    std::this_thread::yield();
+                    continue;
+                }
+
+                for (auto p : batches[index])
+                {
+                    free(p);
+                }
+                ready.store(-1, std::memory_order_release);
+            }
+        });
+
+        auto index = 0;
+        for (uint64_t done_ops = 0; done_ops < iterations; done_ops += batch_size)
+        {
+            for (auto& p : batches[index])
+            {
+                p = allocate();
+            }
+
+            int expected = -1;
+            while (!ready.compare_exchange_weak(expected, index, std::memory_order_acq_rel))
+            {
+                expected = -1;
+                std::this_thread::yield();
+            }
+            index ^= 1;
+        }
+
+        while (ready.load(std::memory_order_acquire) >= 0)
+        {
+            std::this_thread::yield();
+        }
+        done.store(true, std::memory_order_release);
+        consumer.join();
+    }
+}
+
+void run_memory_benchmark(bench_runner& runner)
+{
+    if (!runner.enabled("memory/"))
+    {
+        return;
+    }
+
+    // server<T>::do_accept: one session per connection, freed when it closes
+    runner.measure("memory/session/make_shared", sizeof(session_sized), [](uint64_t iterations)
+    {
+        for (uint64_t i = 0; i < iterations; ++i)
+        {
+            auto s = std::make_shared<session_sized>();
+            sink += reinterpret_cast<size_t>(s.get());
+        }
+    });
+
+    runner.measure("memory/session/allocate_shared", sizeof(session_sized), [](uint64_t iterations)
+    {
+        for (uint64_t i = 0; i < iterations; ++i)
+        {
+            auto s = std::allocate_shared<session_sized>(core::pool_allocator<session_sized>());
+            sink += reinterpret_cast<size_t>(s.get());
+        }
+    });
+
+    core::object_pool<session_sized> sessions;
+    runner.measure("memory/session/object_pool", sizeof(session_sized), [&](uint64_t iterations)
+    {
+        for (uint64_t i = 0; i < iterations; ++i)
+        {
+            auto s = sessions.make_shared();
+            sink += reinterpret_cast<size_t>(s.get());
+        }
+    });
+
+    // connection churn: 4096 live sessions, closed in random order and replaced
+    {
+        static constexpr size_t live = 4096;
+        std::vector<size_t> order(live);
+        for (size_t i = 0; i < live; ++i)
+        {
+            order[i] = i;
+        }
+        std::shuffle(order.begin(), order.end(), std::mt19937(7));
+
+        std::vector<void*> slots(live);
+        runner.measure("memory/session_churn/malloc", sizeof(session_sized), [&](uint64_t iterations)
+        {
+            for (auto& s : slots)
+            {
+                s = std::malloc(sizeof(session_sized));
+            }
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                auto& s = slots[order[i % live]];
+                std::free(s);
+                s = std::malloc(sizeof(session_sized));
+            }
+            for (auto s : slots)
+            {
+                std::free(s);
+            }
+        });
+
+        core::fixed_pool churn_pool(sizeof(session_sized));
+        runner.measure("memory/session_churn/fixed_pool", sizeof(session_sized), [&](uint64_t iterations)
+        {
+            for (auto& s : slots)
+            {
+                s = churn_pool.allocate();
+            }
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                auto& s = slots[order[i % live]];
+                churn_pool.deallocate(s);
+                s = churn_pool.allocate();
+            }
+            for (auto s : slots)
+            {
+                churn_pool.deallocate(s);
+            }
+        });
+    }
+
+    // session::do_read_body: a packet_buffer_type per received packet
+    runner.measure("memory/receive_buffer/make_shared", sizeof(network::packet_buffer_type), [](uint64_t iterations)
+    {
+        for (uint64_t i = 0; i < iterations; ++i)
+        {
+            auto b = std::make_shared<network::packet_buffer_type>();
+            sink += reinterpret_cast<size_t>(b.get());
+        }
+    });
+
+    core::object_pool<network::packet_buffer_type> receive_buffers;
+    runner.measure("memory/receive_buffer/object_pool", sizeof(network::packet_buffer_type), [&](uint64_t iterations)
+    {
+        for (uint64_t i = 0; i < iterations; ++i)
+        {
+            auto b = receive_buffers.make_shared();
+            sink += reinterpret_cast<size_t>(b.get());
+        }
+    });
+
+    // send_packet: filled on a handler thread, released on the io thread after the write
+    runner.measure("memory/send_buffer/cross_thread/malloc", sizeof(network::send_buffer), [](uint64_t iterations)
+    {
+        cross_thread(iterations, [] { return std::malloc(sizeof(network::send_buffer)); }, [](void* p) { std::free(p); });
+    });
+
+    core::fixed_pool send_pool(sizeof(network::send_buffer));
+    runner.measure("memory/send_buffer/cross_thread/fixed_pool", sizeof(network::send_buffer), [&](uint64_t iterations)
+    {
+        cross_thread(iterations, [&] { return send_pool.allocate(); }, [&](void* p) { send_pool.deallocate(p); });
+    });
+
+    // deserialize + handler: a few small allocations per packet, all dead when the handler returns
+    runner.measure("memory/packet_scratch/malloc", 0.0, [](uint64_t iterations)
+    {
+        void* blocks[sizeof(packet_allocations) / sizeof(packet_allocations[0])];
+        for (uint64_t i = 0; i < iterations; ++i)
+        {
+            size_t n = 0;
+            for (auto size : packet_allocations)
+            {
+                blocks[n++] = std::malloc(size);
+            }
+            sink += reinterpret_cast<size_t>(blocks[0]);
+            for (size_t k = 0; k < n; ++k)
+            {
+                std::free(blocks[k]);
+            }
+        }
+    });
+
+    core::arena scratch;
+    runner.expect_zero_allocations("memory/packet_scratch/arena");
+    runner.measure("memory/packet_scratch/arena", 0.0, [&](uint64_t iterations)
+    {
+        for (uint64_t i = 0; i < iterations; ++i)
+        {
+            core::arena::scope packet(scratch);
+            for (auto size : packet_allocations)
+            {
+                sink += reinterpret_cast<size_t>(scratch.allocate(size));
+            }
+        }
+    });
+}
@@ -0,0 +1,870 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <atomic>
+#include <cstring>
+#include <future>
+#include <limits>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <boost/asio.hpp>
+#include "bench.h"
+#include "io_helper.h"
+#include "buffer_pool/send_buffer_pool.h"
+#include "monitor/io_monitor.h"
+#include "../../sgs2/src/packet_processor/packet_traits.h"
+#include "../../sgs2/src/packet_processor/packet_processor.h"
+#include "../../sgs2/src/packet_processor/send_helper.h"
+#include "../../sgs2/src/server_session/server_session.h"
+#include "../../sgs2/src/executor/executor.h"
+#include "../../sgs2/src/capture/capture.h"
+#include "../../core/src/trace/trace.h"
+
+namespace
+{
+    using boost::asio::ip::tcp;
+
+    static constexpr size_t payload_sizes[] = { 16, 256, 2048 };
+
+    // fills every field through reflection so new messages in packet.xml are covered without edits
+    void fill_message(google::protobuf::Message& message, size_t payload_size)
+    {
+        using google::protobuf::FieldDescriptor;
+
+        auto descriptor = message.GetDescriptor();
+        auto reflection = message.GetReflection();
+
+        for (auto i = 0; i < descriptor->field_count(); ++i)
+        {
+            auto field = descriptor->field(i);
+            if (field->is_repeated())
+            {
+                continue;
+            }
+
+            switch (field->cpp_type())
+            {
+            case FieldDescriptor::CPPTYPE_STRING: reflection->SetString(&message, field, std::string(payload_size, 'x')); break;
+            case FieldDescriptor::CPPTYPE_INT32: reflection->SetInt32(&message, field, 123456); break;
+            case FieldDescriptor::CPPTYPE_INT64: reflection->SetInt64(&message, field, 1234567890123LL); break;
+            case FieldDescriptor::CPPTYPE_UINT32: reflection->SetUInt32(&message, field, 123456); break;
+            case FieldDescriptor::CPPTYPE_UINT64: reflection->SetUInt64(&message, field, 1234567890123ULL); break;
+            case FieldDescriptor::CPPTYPE_FLOAT: reflection->SetFloat(&message, field, 1.5f); break;
+            case FieldDescriptor::CPPTYPE_DOUBLE: reflection->SetDouble(&message, field, 1.5); break;
+            case FieldDescriptor::CPPTYPE_BOOL: reflection->SetBool(&message, field, true); break;
+            default: break;
+            }
+        }
+    }
+
+    // same framing as send_packet(): [size][opcode][body]
+    template <class Protobuf>
+    size_t frame(const Protobuf& protobuf, char* out)
+    {
+        static constexpr auto header_size = sizeof(unsigned short) * 2;
+
+        const auto body_size = protobuf.ByteSizeLong();
+        const auto size = static_cast<unsigned short>(body_size + sizeof(unsigned short));
+        const auto code = packet_traits<Protobuf>::code;
+
+        std::memcpy(out, &size, sizeof(unsigned short));
+        std::memcpy(out + sizeof(unsigned short), &code, sizeof(unsigned short));
+        protobuf.SerializeWithCachedSizesToArray(reinterpret_cast<google::protobuf::uint8*>(out + header_size));
+        return header_size + body_size;
+    }
+
+    template <class Protobuf>
+    void serialize_benchmark(bench_runner& runner, const char* name)
+    {
+        for (auto payload_size : payload_sizes)
+        {
+            Protobuf message;
+            fill_message(message, payload_size);
+
+            const auto bytes = message.ByteSizeLong() + sizeof(unsigned short) * 2;
+            if (bytes > network::packet_buf_size)
+            {
+                continue;
+            }
+
+            network::send_buffer buffer;
+            runner.measure(std::string("serialize/") + name + "/payload:" + std::to_string(payload_size), static_cast<double>(bytes), [&](uint64_t iterations)
+            {
+                for (uint64_t i = 0; i < iterations; ++i)
+                {
+                    buffer.size = static_cast<unsigned short>(frame(message, buffer.buf.data()));
+                }
+            });
+        }
+    }
+
+    // header / opcode split over a contiguous stream, what session::do_read_header/body does per frame
+    void frame_parse_benchmark(bench_runner& runner)
+    {
+        for (auto payload_size : payload_sizes)
+        {
+            LOBBY::CS_LOG_IN message;
+            fill_message(message, payload_size);
+
+            std::vector<char> stream(1 << 20);
+            size_t used = 0;
+            size_t frames = 0;
+            while (used + network::packet_buf_size < stream.size())
+            {
+                used += frame(message, stream.data() + used);
+                ++frames;
+            }
+
+            network::packet_buffer_type packet;
+            runner.measure("frame_parse/CS_LOG_IN/payload:" + std::to_string(payload_size), static_cast<double>(used) / frames, [&](uint64_t iterations)
+            {
+                uint64_t checksum = 0;
+                for (uint64_t i = 0; i < iterations;)
+                {
+                    size_t offset = 0;
+                    while (offset < used && i < iterations)
+                    {
+                        unsigned short size;
+                        std::memcpy(&size, stream.data() + offset, sizeof(size));
+                        offset += sizeof(size);
+
+                        if (size < sizeof(unsigned short) || size > network::max_packet_size)
+                        {
+                            return;
+                        }
+
+                        std::memcpy(packet.data(), stream.data() + offset, size);
+                        offset += size;
+
+                        opcode code;
+                        std::memcpy(&code, packet.data(), sizeof(code));
+                        checksum += static_cast<unsigned short>(code);
+                        ++i;
+                    }
+                }
+
+                if (checksum == 0)
+                {
+                    printf("frame_parse: no frames\n");
+                }
+            });
+        }
+    }
+
+    // per frame cost added to server_session::on_read_packet by --capture
+    void capture_benchmark(bench_runner& runner)
+    {
+        if (!runner.enabled("capture/"))
+        {
+            return;
+        }
+
+        static const char* path = "bench_capture.bin";
+        auto& capture = capture_writer::instance();
+
+        for (auto payload_size : payload_sizes)
+        {
+            LOBBY::CS_LOG_IN message;
+            fill_message(message, payload_size);
+
+            std::array<char, network::packet_buf_size> raw;
+            const auto framed = frame(message, raw.data());
+            const auto size = static_cast<unsigned short>(framed - sizeof(unsigned short));
+
+            // open() prefaults the whole file, keep it out of the timed loop
+            const uint64_t iterations = 200000;
+            if (!capture.open(path, static_cast<size_t>(iterations) * (size + sizeof(capture_format::record_header)) + 4096))
+            {
+                break;
+            }
+
+            const auto begin = std::chrono::steady_clock::now();
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                capture.record(1, raw.data() + sizeof(unsigned short), size);
+            }
+            const auto elapsed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count();
+
+            capture.close();
+
+            bench_result result;
+            result.name = "capture/record/payload:" + std::to_string(payload_size);
+            result.iterations = iterations;
+            result.ns_per_op = static_cast<double>(elapsed_ns) / iterations;
+            result.ops_per_sec = iterations * 1e9 / elapsed_ns;
+            result.bytes_per_op = size;
+            runner.record(result);
+        }
+
+        std::remove(path);
+    }
+
+    // one span with tracing off (the cost every build pays) and on
+    void trace_benchmark(bench_runner& runner)
+    {
+        runner.measure("trace/scope/off", 0.0, [&](uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                TRACE_SCOPE("bench", 1, 1);
+            }
+        });
+
+        if (!runner.enabled("trace/scope/on"))
+        {
+            return;
+        }
+
+        // first touch of the buffer pages is part of the cost, spans past capacity take the drop path
+        core::trace::start(1 << 22);
+        runner.measure("trace/scope/on", 0.0, [&](uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                TRACE_SCOPE("bench", 1, 1);
+            }
+        });
+        core::trace::stop();
+    }
+
+    // the same counts at commit 026fdff, before sessions were refcounted in place: its std::shared_ptr<session>
+    // and std::shared_ptr<server_session> swapped for a shared_ptr subclass that counts copies, non null
+    // destructions and shared_from_this() locks per thread, run through the same two measurements
+    constexpr double shared_ptr_dispatch_ref_ops = 8.00;
+    constexpr double shared_ptr_read_path_ref_ops = 20.00;
+
+    // session::ref_ops() of the io thread, network::start(1) runs just one
+    // the benchmark project compiles the network sources itself with NETWORK_COUNT_REF_OPS, the server never counts
+    uint64_t io_thread_ref_ops(boost::asio::io_service& io_service)
+    {
+        std::promise<uint64_t> ops;
+        io_service.post([&] { ops.set_value(network::session::ref_ops()); });
+        return ops.get_future().get();
+    }
+
+    // session refcount traffic per CS_PING over the whole server path: header and body reads, inline dispatch,
+    // the SC_PING send and its write completion, all on the single io thread; one ping in flight at a time
+    void read_path_ref_ops(tcp::acceptor& acceptor, const char* frame, size_t framed)
+    {
+        static constexpr uint64_t packets = 10000;
+
+        auto& io_service = network::io_service();
+        tcp::socket client(io_service);
+        client.connect(acceptor.local_endpoint());
+        client.set_option(tcp::no_delay(true));
+        tcp::socket accepted(io_service);
+        acceptor.accept(accepted);
+        server_session_ptr session(new server_session(std::move(accepted)));
+        session->start();
+
+        std::array<char, network::packet_buf_size> body;
+        auto read_frame = [&]
+        {
+            unsigned short size = 0;
+            boost::asio::read(client, boost::asio::buffer(&size, sizeof(size)));
+            boost::asio::read(client, boost::asio::buffer(body.data(), (std::min)(static_cast<size_t>(size), body.size())));
+        };
+
+        // SC_LOG_IN from on_connect, then the read loop is posted
+        read_frame();
+
+        const auto before = io_thread_ref_ops(io_service);
+        for (uint64_t i = 0; i < packets; ++i)
+        {
+            boost::asio::write(client, boost::asio::buffer(frame, framed));
+            read_frame();
+        }
+        const auto ops = io_thread_ref_ops(io_service) - before;
+
+        printf("%-60s %.2f session ref ops/packet (read, dispatch, send, write completion), shared_ptr sessions %.2f\n", "dispatch/CS_PING/ref_ops/read_path",
+            static_cast<double>(ops) / packets, shared_ptr_read_path_ref_ops);
+
+        boost::system::error_code ec;
+        client.shutdown(tcp::socket::shutdown_both, ec);
+        client.close(ec);
+        session->close();
+    }
+
+    // --capture at full load: frames arrive on a started session's socket and take the real read path,
+    // server_session::on_read_packet records them before dispatching; a round ends when every SC_PING is back
+    // at full load the io threads are the bottleneck: the budget is record() against io thread busy time per frame
+    // (io_monitor) with capture off, best of the rounds; record() runs as on_read_packet runs it, on the io thread
+    // inside a read handler; off and on rounds alternate and their end to end difference is reported alongside
+    // it is the same cost, but within round to round noise on a loaded box
+    void capture_overhead_benchmark(bench_runner& runner, tcp::acceptor& acceptor, const char* frame, size_t framed)
+    {
+        static const char* name = "dispatch/CS_PING/capture:on";
+        if (!runner.enabled(name))
+        {
+            return;
+        }
+
+        static const char* path = "bench_capture.bin";
+        static constexpr size_t packets = 10000;
+        static constexpr int rounds = 30;
+        static constexpr double max_overhead_pct = 2.0;
+
+        auto& io_service = network::io_service();
+        tcp::socket client(io_service);
+        client.connect(acceptor.local_endpoint());
+        tcp::socket accepted(io_service);
+        acceptor.accept(accepted);
+        server_session_ptr session(new server_session(std::move(accepted)));
+
+        std::vector<char> burst(packets * framed);
+        for (size_t i = 0; i < packets; ++i)
+        {
+            std::memcpy(burst.data() + i * framed, frame, framed);
+        }
+
+        // counts response frames, SC_LOG_IN from on_connect is the first
+        std::atomic<uint64_t> responses{ 0 };
+        std::thread reader([&]
+        {
+            std::vector<char> stream;
+            std::array<char, 64 * 1024> chunk;
+            boost::system::error_code ec;
+            size_t at = 0;
+            while (!ec)
+            {
+                const auto n = client.read_some(boost::asio::buffer(chunk), ec);
+                stream.insert(stream.end(), chunk.data(), chunk.data() + n);
+
+                uint64_t complete = 0;
+                unsigned short size = 0;
+                while (stream.size() - at >= sizeof(size))
+                {
+                    std::memcpy(&size, stream.data() + at, sizeof(size));
+                    if (stream.size() - at < sizeof(size) + size)
+                    {
+                        break;
+                    }
+                    at += sizeof(size) + size;
+                    ++complete;
+                }
+                stream.erase(stream.begin(), stream.begin() + at);
+                at = 0;
+                responses.fetch_add(complete, std::memory_order_release);
+            }
+        });
+
+        session->start();
+        while (responses.load(std::memory_order_acquire) < 1)
+        {
+            std::this_thread::yield();
+        }
+
+        static const auto usage_window = network::io_monitor::instance().open_window();
+        auto io_busy_ns = []
+        {
+            double busy = 0.0;
+            for (auto& thread : network::io_monitor::instance().snapshot(usage_window).threads)
+            {
+                busy += static_cast<double>(thread.busy_ns);
+            }
+            return busy;
+        };
+
+        // wall time and io busy time of one burst
+        struct timing
+        {
+            double wall_ns;
+            double busy_ns;
+        };
+
+        auto& capture = capture_writer::instance();
+        auto round = [&](bool record)
+        {
+            if (record && !capture.open(path, packets * (framed + sizeof(capture_format::record_header)) + 4096))
+            {
+                return timing{ 0.0, 0.0 };
+            }
+
+            const auto expected = responses.load(std::memory_order_acquire) + packets;
+            const auto busy = io_busy_ns();
+            const auto begin = std::chrono::steady_clock::now();
+            boost::asio::write(client, boost::asio::buffer(burst));
+            while (responses.load(std::memory_order_acquire) < expected)
+            {
+                std::this_thread::yield();
+            }
+            const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count();
+            const auto t = timing{ static_cast<double>(elapsed), io_busy_ns() - busy };
+
+            if (record)
+            {
+                capture.close();
+            }
+            return t;
+        };
+
+        round(false);
+        timing best_off{ std::numeric_limits<double>::max(), std::numeric_limits<double>::max() };
+        timing best_on = best_off;
+        for (auto i = 0; i < rounds; ++i)
+        {
+            const auto off = round(false);
+            const auto on = round(true);
+            best_off = timing{ (std::min)(best_off.wall_ns, off.wall_ns), (std::min)(best_off.busy_ns, off.busy_ns) };
+            best_on = timing{ (std::min)(best_on.wall_ns, on.wall_ns), (std::min)(best_on.busy_ns, on.busy_ns) };
+        }
+
+        // record() alone over the same frames, on the io thread inside a handler scope like the read path
+        auto record_ns = 0.0;
+        if (capture.open(path, packets * (framed + sizeof(capture_format::record_header)) + 4096))
+        {
+            std::promise<double> elapsed;
+            io_service.post([&]
+            {
+                network::io_monitor::scope busy;
+                const auto begin = std::chrono::steady_clock::now();
+                for (size_t i = 0; i < packets; ++i)
+                {
+                    capture.record(session->id(), frame + sizeof(unsigned short), static_cast<unsigned short>(framed - sizeof(unsigned short)));
+                }
+                elapsed.set_value(static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count()));
+            });
+            record_ns = elapsed.get_future().get() / packets;
+            capture.close();
+        }
+        std::remove(path);
+
+        boost::system::error_code ec;
+        client.shutdown(tcp::socket::shutdown_both, ec);
+        reader.join();
+        client.close(ec);
+        session->close();
+
+        if (best_on.wall_ns == 0.0 || record_ns == 0.0)
+        {
+            runner.fail(name, std::string("could not open ") + path);
+            return;
+        }
+
+        bench_result result;
+        result.name = name;
+        result.iterations = packets * rounds;
+        result.ns_per_op = best_on.wall_ns / packets;
+        result.ops_per_sec = packets * 1e9 / best_on.wall_ns;
+        result.bytes_per_op = static_cast<double>(framed);
+        runner.record(result);
+
+        const auto frame_ns = best_off.busy_ns / packets;
+        const auto overhead_pct = record_ns / frame_ns * 100.0;
+        printf("%-60s %.2f%% (record %.1f ns of %.1f ns io busy per frame, end to end %+.2f%%)\n", "dispatch/CS_PING/capture:overhead",
+            overhead_pct, record_ns, frame_ns, (best_on.busy_ns / best_off.busy_ns - 1.0) * 100.0);
+        if (overhead_pct > max_overhead_pct)
+        {
+            char reason[128];
+            snprintf(reason, sizeof(reason), "recording adds %.2f%%, budget is %.0f%%", overhead_pct, max_overhead_pct);
+            runner.fail(name, reason);
+        }
+    }
+
+    // handle_packet() on a server_session whose peer is drained by a local thread
+    void dispatch_benchmark(bench_runner& runner)
+    {
+        if (!runner.enabled("dispatch/"))
+        {
+            return;
+        }
+
+        network::initialize();
+        register_handlers();
+        start_executors(1, 1);
+
+        auto& io_service = network::io_service();
+        tcp::acceptor acceptor(io_service, tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0));
+
+        tcp::socket peer(io_service);
+        peer.connect(acceptor.local_endpoint());
+
+        tcp::socket accepted(io_service);
+        acceptor.accept(accepted);
+        server_session_ptr session(new server_session(std::move(accepted)));
+
+        // nothing else keeps run() alive between async_writes
+        auto work = std::make_unique<boost::asio::io_service::work>(io_service);
+        network::start(1);
+
+        std::atomic_bool draining{ true };
+        std::thread drain([&]
+        {
+            std::array<char, 64 * 1024> sink;
+            boost::system::error_code ec;
+            while (draining && !ec)
+            {
+                peer.read_some(boost::asio::buffer(sink), ec);
+            }
+        });
+
+        GAME::CS_PING ping;
+        ping.set_timestamp(1234567890123LL);
+
+        LOBBY::CS_LOG_IN login;
+        fill_message(login, 16);
+
+        {
+            std::array<char, network::packet_buf_size> raw;
+            auto framed = frame(ping, raw.data());
+            auto buffer = std::make_shared<network::packet_buffer_type>();
+            std::memcpy(buffer->data(), raw.data() + sizeof(unsigned short), framed - sizeof(unsigned short));
+
+            // inline policy, parse + handler + SC_PING send on this thread
+            runner.measure("dispatch/CS_PING", static_cast<double>(framed), [&](uint64_t iterations)
+            {
+                for (uint64_t i = 0; i < iterations; ++i)
+                {
+                    handle_packet(*session, buffer, static_cast<int>(framed - sizeof(unsigned short)));
+                }
+            });
+
+            // one SC_PING in flight, its buffer is back in the pool before the next dispatch
+            // open loop above outruns the socket and grows the send queue, this is the steady state
+            // that must not touch the heap on the dispatching thread
+            // a control block comes back just after in_use drops, a few spares cover that window
+            auto& pool = network::send_buffer_pool::instance();
+            pool.reserve(4);
+            while (pool.in_use() > 0)
+            {
+                std::this_thread::yield();
+            }
+            const auto in_use = pool.in_use();
+            runner.expect_zero_allocations("dispatch/CS_PING/closed_loop");
+            runner.measure("dispatch/CS_PING/closed_loop", static_cast<double>(framed), [&](uint64_t iterations)
+            {
+                for (uint64_t i = 0; i < iterations; ++i)
+                {
+                    handle_packet(*session, buffer, static_cast<int>(framed - sizeof(unsigned short)));
+                    while (pool.in_use() > in_use)
+                    {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+
+            // session refcount traffic per packet, on this thread (dispatch, send) and the io thread (write completion)
+            if (runner.enabled("dispatch/CS_PING/ref_ops"))
+            {
+                static constexpr uint64_t packets = 10000;
+                const auto dispatch_before = network::session::ref_ops();
+                const auto io_before = io_thread_ref_ops(io_service);
+                for (uint64_t i = 0; i < packets; ++i)
+                {
+                    handle_packet(*session, buffer, static_cast<int>(framed - sizeof(unsigned short)));
+                    while (pool.in_use() > in_use)
+                    {
+                        std::this_thread::yield();
+                    }
+                }
+                const auto dispatch_ops = network::session::ref_ops() - dispatch_before;
+                const auto io_ops = io_thread_ref_ops(io_service) - io_before;
+                printf("%-60s %.2f session ref ops/packet (dispatch %.2f, io %.2f), shared_ptr sessions %.2f\n", "dispatch/CS_PING/ref_ops",
+                    static_cast<double>(dispatch_ops + io_ops) / packets, static_cast<double>(dispatch_ops) / packets, static_cast<double>(io_ops) / packets,
+                    shared_ptr_dispatch_ref_ops);
+            }
+
+            if (runner.enabled("dispatch/CS_PING/ref_ops/read_path"))
+            {
+                read_path_ref_ops(acceptor, raw.data(), framed);
+            }
+
+            capture_overhead_benchmark(runner, acceptor, raw.data(), framed);
+
+            if (runner.enabled("dispatch/CS_PING/trace:on"))
+            {
+                core::trace::start();
+                runner.measure("dispatch/CS_PING/trace:on", static_cast<double>(framed), [&](uint64_t iterations)
+                {
+                    for (uint64_t i = 0; i < iterations; ++i)
+                    {
+                        handle_packet(*session, buffer, static_cast<int>(framed - sizeof(unsigned short)));
+                    }
+                });
+                core::trace::stop();
+            }
+        }
+
+        {
+            std::array<char, network::packet_buf_size> raw;
+            auto framed = frame(login, raw.data());
+            auto buffer = std::make_shared<network::packet_buffer_type>();
+            std::memcpy(buffer->data(), raw.data() + sizeof(unsigned short), framed - sizeof(unsigned short));
+
+            // blocking policy, waits for the executor so the handler runs are part of the batch
+            runner.measure("dispatch/CS_LOG_IN", static_cast<double>(framed), [&](uint64_t iterations)
+            {
+                for (uint64_t i = 0; i < iterations; ++i)
+                {
+                    handle_packet(*session, buffer, static_cast<int>(framed - sizeof(unsigned short)));
+                }
+
+                while (blocking_executor().stats().queue_depth > 0)
+                {
+                    std::this_thread::yield();
+                }
+            });
+        }
+
+        stop_executors();
+
+        draining = false;
+        session->close();
+        session.reset();
+        boost::system::error_code ec;
+        peer.shutdown(tcp::socket::shutdown_both, ec);
+        drain.join();
+
+        work.reset();
+        network::stop();
+    }
+
+    // a client that stops reading while entities keep moving, then catches up
+    // unkeyed updates pile up behind the stalled write; keyed ones replace their unsent predecessor,
+    // the queue stays at one update per entity and the client only receives the latest states
+    void coalesce_benchmark(bench_runner& runner, bool keyed)
+    {
+        static constexpr uint64_t entities = 100;
+        static constexpr uint64_t updates = 100000;
+
+        const std::string name = std::string("send/coalesce/entities:100/keyed:") + (keyed ? "on" : "off");
+        if (!runner.enabled(name))
+        {
+            return;
+        }
+
+        network::initialize();
+
+        auto& io_service = network::io_service();
+        tcp::acceptor acceptor(io_service, tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0));
+
+        // small socket buffers so the stall shows up after a few frames
+        tcp::socket peer(io_service);
+        peer.open(tcp::v4());
+        peer.set_option(boost::asio::socket_base::receive_buffer_size(4096));
+        peer.connect(acceptor.local_endpoint());
+
+        tcp::socket accepted(io_service);
+        acceptor.accept(accepted);
+        accepted.set_option(boost::asio::socket_base::send_buffer_size(4096));
+        server_session_ptr session(new server_session(std::move(accepted)));
+
+        auto work = std::make_unique<boost::asio::io_service::work>(io_service);
+        network::start(1);
+
+        // SC_PING stands in for a position update, the timestamp is the state
+        GAME::SC_PING update;
+        size_t max_queued = 0;
+        const auto begin = std::chrono::steady_clock::now();
+        for (uint64_t i = 0; i < updates; ++i)
+        {
+            update.set_timestamp(static_cast<google::protobuf::int64>(i));
+            const auto key = keyed ? network::coalesce_key{ i % entities, static_cast<unsigned short>(opcode::SC_PING) } : network::coalesce_key();
+            send_packet<opcode::SC_PING>(*session, update, network::send_priority::normal, key);
+            max_queued = (std::max)(max_queued, session->queued());
+        }
+        const auto elapsed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count();
+
+        uint64_t received = 0;
+        std::thread drain([&]
+        {
+            std::array<char, 64 * 1024> sink;
+            boost::system::error_code ec;
+            while (!ec)
+            {
+                received += peer.read_some(boost::asio::buffer(sink), ec);
+            }
+        });
+
+        auto& pool = network::send_buffer_pool::instance();
+        while (session->queued() > 0 || pool.in_use() > 0)
+        {
+            std::this_thread::yield();
+        }
+
+        // eof ends the drain once everything sent has been read
+        session->close();
+        session.reset();
+        drain.join();
+
+        work.reset();
+        network::stop();
+
+        bench_result result;
+        result.name = name;
+        result.iterations = updates;
+        result.ns_per_op = static_cast<double>(elapsed_ns) / updates;
+        result.ops_per_sec = updates * 1e9 / elapsed_ns;
+        result.bytes_per_op = static_cast<double>(received) / updates;
+        runner.record(result);
+        printf("%-60s max %zu queued, %llu bytes delivered\n", name.c_str(), max_queued, static_cast<unsigned long long>(received));
+
+        if (keyed && max_queued > entities)
+        {
+            runner.fail(name, "send queue grew past one update per entity");
+        }
+    }
+
+    // a client behind a large bulk response, then one SC_PING: as bulk the ping waits for the whole
+    // backlog, as control it goes out with the next write and only what was already in flight is ahead
+    void priority_benchmark(bench_runner& runner, network::send_priority ping_priority)
+    {
+        static constexpr size_t backlog_frames = 256;
+
+        const auto control = ping_priority == network::send_priority::control;
+        const std::string name = std::string("send/priority/bulk_backlog:1MB/ping:") + (control ? "control" : "bulk");
+        if (!runner.enabled(name))
+        {
+            return;
+        }
+
+        network::initialize();
+
+        auto& io_service = network::io_service();
+        tcp::acceptor acceptor(io_service, tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0));
+
+        tcp::socket peer(io_service);
+        peer.open(tcp::v4());
+        peer.set_option(boost::asio::socket_base::receive_buffer_size(4096));
+        peer.connect(acceptor.local_endpoint());
+
+        tcp::socket accepted(io_service);
+        acceptor.accept(accepted);
+        accepted.set_option(boost::asio::socket_base::send_buffer_size(4096));
+        server_session_ptr session(new server_session(std::move(accepted)));
+
+        auto work = std::make_unique<boost::asio::io_service::work>(io_service);
+        network::start(1);
+
+        // room list sized frames
+        LOBBY::SC_LOG_IN response;
+        fill_message(response, 4000);
+        for (size_t i = 0; i < backlog_frames; ++i)
+        {
+            send_packet<opcode::SC_LOG_IN>(*session, response, network::send_priority::bulk);
+        }
+
+        GAME::SC_PING ping;
+        ping.set_timestamp(1);
+        send(*session, ping, ping_priority);
+
+        uint64_t received = 0;
+        uint64_t ahead = 0;
+        std::thread drain([&]
+        {
+            std::array<char, network::packet_buf_size> body;
+            unsigned short size = 0;
+            auto seen = false;
+            boost::system::error_code ec;
+            while (boost::asio::read(peer, boost::asio::buffer(&size, sizeof(size)), ec), !ec)
+            {
+                boost::asio::read(peer, boost::asio::buffer(body.data(), size), ec);
+                if (ec)
+                {
+                    break;
+                }
+
+                unsigned short code = 0;
+                std::memcpy(&code, body.data(), sizeof(code));
+                if (!seen && code == static_cast<unsigned short>(opcode::SC_PING))
+                {
+                    ahead = received;
+                    seen = true;
+                }
+                received += sizeof(size) + size;
+            }
+        });
+
+        auto& pool = network::send_buffer_pool::instance();
+        while (session->queued() > 0 || pool.in_use() > 0)
+        {
+            std::this_thread::yield();
+        }
+
+        session->close();
+        session.reset();
+        drain.join();
+
+        work.reset();
+        network::stop();
+
+        printf("%-60s %llu of %llu bytes read before SC_PING\n", name.c_str(), static_cast<unsigned long long>(ahead), static_cast<unsigned long long>(received));
+
+        if (control && ahead > received / 4)
+        {
+            runner.fail(name, "control frame waited behind the bulk backlog");
+        }
+    }
+
+    // a keyed update resent at another priority leaves its old lane and is written at the new one
+    void coalesce_priority_check(bench_runner& runner)
+    {
+        static const std::string name = "send/coalesce/priority_change";
+        if (!runner.enabled(name))
+        {
+            return;
+        }
+
+        auto make = [](network::send_priority priority, network::coalesce_key key)
+        {
+            auto buf = network::acquire_send_buffer();
+            buf->size = 4;
+            buf->priority = priority;
+            buf->key = key;
+            return buf;
+        };
+
+        const network::coalesce_key key{ 7, static_cast<unsigned short>(opcode::SC_PING) };
+        network::send_queue q;
+        std::vector<network::send_buf_ptr> out;
+
+        // escalated: out of the bulk lane, written ahead of the bulk frame queued before it
+        auto bulk = make(network::send_priority::bulk, network::coalesce_key());
+        auto escalated = make(network::send_priority::control, key);
+        q.push(bulk);
+        q.push(make(network::send_priority::bulk, key));
+        q.push(escalated);
+        while (q.take(out))
+        {
+        }
+        auto ok = out.size() == 2 && out[0] == escalated && out[1] == bulk;
+
+        // demoted: out of the control lane, behind the bulk frame queued before it
+        out.clear();
+        auto ahead = make(network::send_priority::bulk, network::coalesce_key());
+        auto demoted = make(network::send_priority::bulk, key);
+        q.push(make(network::send_priority::control, key));
+        q.push(ahead);
+        q.push(demoted);
+        while (q.take(out))
+        {
+        }
+        ok = ok && out.size() == 2 && out[0] == ahead && out[1] == demoted && q.coalesced() == 2 && q.empty();
+
+        printf("%-60s %s\n", name.c_str(), ok ? "ok" : "wrong order or lane");
+        if (!ok)
+        {
+            runner.fail(name, "a key that changed priority was not moved to its new lane");
+        }
+    }
+}
+
+void run_packet_benchmark(bench_runner& runner)
+{
+#define SERIALIZE_BENCHMARK(package, message) serialize_benchmark<package::message>(runner, #message);
+    FOR_EACH_PACKET(SERIALIZE_BENCHMARK)
+#undef SERIALIZE_BENCHMARK
+
+    frame_parse_benchmark(runner);
+    capture_benchmark(runner);
+    trace_benchmark(runner);
+    dispatch_benchmark(runner);
+    coalesce_benchmark(runner, false);
+    coalesce_benchmark(runner, true);
+    coalesce_priority_check(runner);
+    priority_benchmark(runner, network::send_priority::bulk);
+    priority_benchmark(runner, network::send_priority::control);
+}
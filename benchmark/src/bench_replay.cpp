@@ -0,0 +1,231 @@
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <boost/asio.hpp>
+#include "bench.h"
+#include "io_helper.h"
+#include "server/server.h"
+#include "../../core/src/metrics/histogram.h"
+#include "../../sgs2/src/capture/capture.h"
+#include "../../sgs2/src/packet_processor/packet_processor.h"
+#include "../../sgs2/src/server_session/server_session.h"
+#include "../../sgs2/src/executor/executor.h"
+#include "../../sgs2/src/metrics/packet_metrics.h"
+
+namespace
+{
+    using boost::asio::ip::tcp;
+    using clock_type = std::chrono::steady_clock;
+
+    // sleeps until the record's capture time scaled by speed, no pacing when speed is 0
+    void pace(const capture_record& record, clock_type::time_point start, double speed)
+    {
+        if (speed <= 0.0)
+        {
+            return;
+        }
+
+        const auto due = start + std::chrono::nanoseconds(static_cast<long long>(record.timestamp_ns / speed));
+        if (clock_type::now() < due)
+        {
+            std::this_thread::sleep_until(due);
+        }
+    }
+
+    void print_mix(const std::map<unsigned short, uint64_t>& mix)
+    {
+        for (auto& entry : mix)
+        {
+            printf("  %-24s %llu\n", opcode_name(static_cast<opcode>(entry.first)), static_cast<unsigned long long>(entry.second));
+        }
+    }
+
+    void finish(bench_runner& runner, const std::string& name, uint64_t records, uint64_t bytes, clock_type::duration elapsed, const core::histogram& latency)
+    {
+        if (records == 0)
+        {
+            printf("%s: empty capture\n", name.c_str());
+            return;
+        }
+
+        const auto elapsed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+
+        bench_result result;
+        result.name = name;
+        result.iterations = records;
+        result.ns_per_op = static_cast<double>(elapsed_ns) / records;
+        result.ops_per_sec = records * 1e9 / elapsed_ns;
+        result.bytes_per_op = static_cast<double>(bytes) / records;
+        result.p50_ns = static_cast<double>(latency.percentile(50.0));
+        result.p99_ns = static_cast<double>(latency.percentile(99.0));
+        runner.record(result);
+    }
+
+    // handle_packet() straight from the capture, sessions have unopened sockets so responses fail fast
+    void replay_in_process(bench_runner& runner, capture_reader& reader)
+    {
+        network::initialize();
+        register_handlers();
+        start_executors(runner.options().max_threads, 4);
+
+        auto work = std::make_unique<boost::asio::io_service::work>(network::io_service());
+        network::start(1);
+
+        std::unordered_map<unsigned int, server_session_ptr> sessions;
+        std::map<unsigned short, uint64_t> mix;
+        core::histogram latency;
+        uint64_t records = 0;
+        uint64_t bytes = 0;
+
+        capture_record record;
+        const auto start = clock_type::now();
+        while (reader.next(record))
+        {
+            auto& session = sessions[record.session_id];
+            if (!session)
+            {
+                session.reset(new server_session(tcp::socket(network::io_service())));
+            }
+
+            pace(record, start, runner.options().replay_speed);
+
+            // a fresh buffer per frame, same as session::do_read_body
+            const auto begin = clock_type::now();
+            auto buffer = std::make_shared<network::packet_buffer_type>();
+            std::memcpy(buffer->data(), record.data, record.size);
+            handle_packet(*session, std::move(buffer), record.size);
+            latency.record(std::chrono::duration_cast<std::chrono::nanoseconds>(clock_type::now() - begin).count());
+
+            ++mix[record.opcode()];
+            ++records;
+            bytes += record.size;
+        }
+        const auto elapsed = clock_type::now() - start;
+
+        stop_executors();
+        sessions.clear();
+        work.reset();
+        network::stop();
+
+        finish(runner, "replay/in_process", records, bytes, elapsed, latency);
+        print_mix(mix);
+    }
+
+    // one client connection per captured session against a live server on options().port
+    void replay_sockets(bench_runner& runner, capture_reader& reader)
+    {
+        network::initialize();
+        register_handlers();
+
+        tcp::endpoint endpoint(tcp::v4(), runner.options().port);
+        auto svr = std::make_unique<network::server<server_session>>(network::io_service(), endpoint);
+
+        network::start(runner.options().max_threads);
+        start_executors(runner.options().max_threads, 4);
+
+        boost::asio::io_service client_io_service;
+        std::unordered_map<unsigned int, std::unique_ptr<tcp::socket>> clients;
+        std::map<unsigned short, uint64_t> mix;
+        core::histogram latency;
+        uint64_t records = 0;
+        uint64_t bytes = 0;
+
+        std::array<char, 64 * 1024> sink;
+        std::vector<char> frame;
+
+        // responses are read and dropped so the server never blocks on a full socket
+        auto drain = [&sink](tcp::socket& socket)
+        {
+            boost::system::error_code ec;
+            while (socket.available(ec) > 0 && !ec)
+            {
+                socket.read_some(boost::asio::buffer(sink), ec);
+            }
+        };
+
+        capture_record record;
+        const auto start = clock_type::now();
+        while (reader.next(record))
+        {
+            auto& client = clients[record.session_id];
+            if (!client)
+            {
+                boost::system::error_code ec;
+                client = std::make_unique<tcp::socket>(client_io_service);
+                client->connect(tcp::endpoint(boost::asio::ip::address_v4::loopback(), runner.options().port), ec);
+                if (ec)
+                {
+                    printf("replay connect failed: %s\n", ec.message().c_str());
+                    break;
+                }
+                client->set_option(tcp::no_delay(true));
+            }
+
+            pace(record, start, runner.options().replay_speed);
+
+            frame.resize(sizeof(unsigned short) + record.size);
+            std::memcpy(frame.data(), &record.size, sizeof(unsigned short));
+            std::memcpy(frame.data() + sizeof(unsigned short), record.data, record.size);
+
+            boost::system::error_code ec;
+            const auto begin = clock_type::now();
+            boost::asio::write(*client, boost::asio::buffer(frame), ec);
+            latency.record(std::chrono::duration_cast<std::chrono::nanoseconds>(clock_type::now() - begin).count());
+            if (ec)
+            {
+                printf("replay write failed: %s\n", ec.message().c_str());
+                break;
+            }
+
+            drain(*client);
+
+            ++mix[record.opcode()];
+            ++records;
+            bytes += frame.size();
+        }
+        const auto elapsed = clock_type::now() - start;
+
+        for (auto& client : clients)
+        {
+            boost::system::error_code ec;
+            client.second->shutdown(tcp::socket::shutdown_both, ec);
+            client.second->close(ec);
+        }
+
+        svr->stop();
+        network::stop();
+        stop_executors();
+
+        finish(runner, "replay/sockets", records, bytes, elapsed, latency);
+        print_mix(mix);
+    }
+}
+
+void run_replay_benchmark(bench_runner& runner)
+{
+    capture_reader reader;
+    if (!reader.open(runner.options().replay_path))
+    {
+        printf("can not open capture %s\n", runner.options().replay_path.c_str());
+        return;
+    }
+
+    const auto before = packet_metrics::snapshot();
+
+    if (runner.options().replay_sockets)
+    {
+        replay_sockets(runner, reader);
+    }
+    else
+    {
+        replay_in_process(runner, reader);
+    }
+
+    printf("%s", packet_metrics::report(before, packet_metrics::snapshot()).c_str());
+}
@@ -0,0 +1,401 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <boost/asio.hpp>
+#include "bench.h"
+#include "io_helper.h"
+#include "../../sgs2/src/packet_processor/send_helper.h"
+#include "../../sgs2/src/server_session/server_session.h"
+#include "../../sgs2/src/room/room_scheduler.h"
+
+namespace
+{
+    using boost::asio::ip::tcp;
+
+    // stamps every reply with the tick it was issued in and can be told to overrun its tick
+    class probe_room : public room
+    {
+    public:
+        probe_room(unsigned int id, unsigned int tick_rate) : room(id, tick_rate) {}
+
+        // a packet handler running under post_logic, answers with the tick it ran in
+        void handle(server_session& session)
+        {
+            if (room::current() != this)
+            {
+                outside_tick_.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            ++in_this_tick_;
+            executed_.fetch_add(1, std::memory_order_relaxed);
+
+            GAME::SC_PING reply;
+            reply.set_timestamp(static_cast<int64_t>(tick_ + 1));
+            ::send(session, reply);
+        }
+
+        void set_overload(bool on) { overload_.store(on, std::memory_order_relaxed); }
+
+        // last tick whose on_tick ran, its replies may be on the wire from here on
+        uint64_t sealed() const { return sealed_.load(std::memory_order_acquire); }
+        uint64_t executed() const { return executed_.load(std::memory_order_relaxed); }
+        uint64_t outside_tick() const { return outside_tick_.load(std::memory_order_relaxed); }
+        uint64_t busy_ticks() const { return busy_ticks_.load(std::memory_order_relaxed); }
+        uint64_t batched_ticks() const { return batched_ticks_.load(std::memory_order_relaxed); }
+
+    protected:
+        virtual void on_tick(clock::duration dt) override
+        {
+            // every 8th tick runs 1.5 ticks long while overloaded
+            if (overload_.load(std::memory_order_relaxed) && tick_ % 8 == 0)
+            {
+                const auto until = clock::now() + dt + dt / 2;
+                while (clock::now() < until)
+                {
+                }
+            }
+
+            if (in_this_tick_ > 0)
+            {
+                busy_ticks_.fetch_add(1, std::memory_order_relaxed);
+            }
+            if (in_this_tick_ > 1)
+            {
+                batched_ticks_.fetch_add(1, std::memory_order_relaxed);
+            }
+            in_this_tick_ = 0;
+
+            sealed_.store(++tick_, std::memory_order_release);
+        }
+
+    private:
+        // room thread only
+        uint64_t tick_ = 0;
+        uint64_t in_this_tick_ = 0;
+
+        std::atomic_bool overload_{ false };
+        std::atomic<uint64_t> sealed_{ 0 };
+        std::atomic<uint64_t> executed_{ 0 };
+        std::atomic<uint64_t> outside_tick_{ 0 };
+        std::atomic<uint64_t> busy_ticks_{ 0 };
+        std::atomic<uint64_t> batched_ticks_{ 0 };
+    };
+
+    // one connected session per room, its peer checks every reply against the room's sealed tick
+    struct member
+    {
+        std::shared_ptr<probe_room> room;
+        server_session_ptr session;
+        std::unique_ptr<tcp::socket> peer;
+        std::thread reader;
+
+        std::atomic<uint64_t> received{ 0 };
+        std::atomic<uint64_t> early{ 0 };          // arrived before on_tick of its tick ran
+        std::atomic<uint64_t> reordered{ 0 };
+    };
+
+    void read_replies(member& m)
+    {
+        std::array<char, network::packet_buf_size> body;
+        boost::system::error_code ec;
+        uint64_t last_tick = 0;
+
+        for (;;)
+        {
+            unsigned short size = 0;
+            boost::asio::read(*m.peer, boost::asio::buffer(&size, sizeof(size)), ec);
+            if (ec || size < sizeof(unsigned short) || size > network::max_packet_size)
+            {
+                return;
+            }
+
+            boost::asio::read(*m.peer, boost::asio::buffer(body.data(), size), ec);
+            if (ec)
+            {
+                return;
+            }
+
+            GAME::SC_PING reply;
+            if (!reply.ParseFromArray(body.data() + sizeof(unsigned short), size - sizeof(unsigned short)))
+            {
+                return;
+            }
+
+            const auto tick = static_cast<uint64_t>(reply.timestamp());
+            if (tick > m.room->sealed())
+            {
+                m.early.fetch_add(1, std::memory_order_relaxed);
+            }
+            if (tick < last_tick)
+            {
+                m.reordered.fetch_add(1, std::memory_order_relaxed);
+            }
+            last_tick = tick;
+
+            m.received.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    struct phase_totals
+    {
+        size_t ticks = 0;
+        size_t overruns = 0;
+        long long total_jitter_us = 0;
+        long long max_jitter_us = 0;
+        long long cpu_time_us = 0;
+        uint64_t executed = 0;
+    };
+
+    phase_totals totals(const std::vector<std::unique_ptr<member>>& members)
+    {
+        phase_totals t;
+        for (auto& m : members)
+        {
+            const auto stats = m->room->stats();
+            t.ticks += stats.ticks;
+            t.overruns += stats.overruns;
+            t.total_jitter_us += stats.total_jitter_us;
+            t.max_jitter_us = (std::max)(t.max_jitter_us, stats.max_jitter_us);
+            t.cpu_time_us += stats.cpu_time_us;
+            t.executed += m->room->executed();
+        }
+        return t;
+    }
+
+    void record_phase(bench_runner& runner, const std::string& name, const phase_totals& before, const phase_totals& after, double seconds)
+    {
+        const auto ticks = after.ticks - before.ticks;
+        const auto executed = after.executed - before.executed;
+        const auto jitter_us = after.total_jitter_us - before.total_jitter_us;
+
+        printf("%-60s %zu ticks, %zu overruns, jitter mean %.1fus max %lldus, %.1f tasks/tick, %lld us room cpu\n",
+            name.c_str(), ticks, after.overruns - before.overruns,
+            ticks > 0 ? static_cast<double>(jitter_us) / ticks : 0.0, after.max_jitter_us,
+            ticks > 0 ? static_cast<double>(executed) / ticks : 0.0,
+            after.cpu_time_us - before.cpu_time_us);
+
+        // one op = one tick, ns/op is its mean start jitter
+        bench_result result;
+        result.name = name;
+        result.iterations = ticks;
+        result.ns_per_op = ticks > 0 ? static_cast<double>(jitter_us) * 1000.0 / ticks : 0.0;
+        result.ops_per_sec = seconds > 0 ? executed / seconds : 0.0;
+        runner.record(std::move(result));
+    }
+}
+
+// rooms at 30 and 60 Hz take packets posted by io threads through post_logic, the path a room's
+// handlers take; checks that a tick runs the packets queued since the last one as one batch, that
+// replies leave at the end of the tick that issued them and not before, and that overrun and jitter
+// counters move once ticks run long
+void run_room_benchmark(bench_runner& runner)
+{
+    static const std::string name = "room/stress/hz:30+60";
+    if (!runner.enabled(name))
+    {
+        return;
+    }
+
+    static constexpr unsigned int tick_rates[] = { 30, 60 };
+    static constexpr size_t rooms_per_rate = 4;
+    static constexpr size_t sim_threads = 2;
+    static constexpr auto post_interval = std::chrono::microseconds(500);
+
+    const auto io_threads = (std::max)(runner.options().max_threads, size_t(2));
+    const auto phase_time = std::chrono::duration<double, std::milli>((std::max)(runner.options().min_time_ms, 1000.0));
+
+    network::initialize();
+
+    auto& io_service = network::io_service();
+    tcp::acceptor acceptor(io_service, tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0));
+
+    auto& scheduler = room_scheduler::instance();
+    scheduler.start(sim_threads);
+
+    std::vector<std::unique_ptr<member>> members;
+    unsigned int next_id = 1;
+    for (auto rate : tick_rates)
+    {
+        for (size_t i = 0; i < rooms_per_rate; ++i)
+        {
+            auto m = std::make_unique<member>();
+            m->room = std::make_shared<probe_room>(next_id++, rate);
+
+            m->peer = std::make_unique<tcp::socket>(io_service);
+            m->peer->connect(acceptor.local_endpoint());
+            tcp::socket accepted(io_service);
+            acceptor.accept(accepted);
+            m->session.reset(new server_session(std::move(accepted)));
+            m->session->enter_room(m->room);
+
+            if (!scheduler.add(m->room))
+            {
+                runner.fail(name, "room scheduler has no sim threads");
+            }
+            members.emplace_back(std::move(m));
+        }
+    }
+
+    for (auto& m : members)
+    {
+        auto ptr = m.get();
+        m->reader = std::thread([ptr] { read_replies(*ptr); });
+    }
+
+    auto work = std::make_unique<boost::asio::io_service::work>(io_service);
+    network::start(io_threads);
+
+    // one pump per io thread, each round posts a packet to every room
+    std::atomic_bool posting{ true };
+    std::atomic<size_t> pumps_running{ 0 };
+    std::function<void()> pump = [&]
+    {
+        while (posting.load(std::memory_order_relaxed))
+        {
+            for (auto& m : members)
+            {
+                auto r = m->room.get();
+                server_session_ptr session = m->session;
+                post_logic(*session, [r, session] { r->handle(*session); });
+            }
+            std::this_thread::sleep_for(post_interval);
+        }
+        pumps_running.fetch_sub(1, std::memory_order_release);
+    };
+
+    pumps_running = io_threads;
+    for (size_t i = 0; i < io_threads; ++i)
+    {
+        io_service.post(pump);
+    }
+
+    // steady: batching and flush
+    auto before = totals(members);
+    auto begin = std::chrono::steady_clock::now();
+    std::this_thread::sleep_for(phase_time);
+    auto steady = totals(members);
+    auto steady_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    // overloaded: every 8th tick of each room overruns
+    for (auto& m : members)
+    {
+        m->room->set_overload(true);
+    }
+
+    begin = std::chrono::steady_clock::now();
+    std::this_thread::sleep_for(phase_time);
+    auto overloaded = totals(members);
+    auto overloaded_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    for (auto& m : members)
+    {
+        m->room->set_overload(false);
+    }
+
+    posting = false;
+    while (pumps_running.load(std::memory_order_acquire) > 0)
+    {
+        std::this_thread::yield();
+    }
+
+    // the last posted packets run and their replies go out within a couple of ticks
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    auto all_replied = [&]
+    {
+        for (auto& m : members)
+        {
+            if (m->received.load(std::memory_order_relaxed) < m->room->executed())
+            {
+                return false;
+            }
+        }
+        return true;
+    };
+    while (!all_replied() && std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    record_phase(runner, name + "/steady", before, steady, steady_seconds);
+    record_phase(runner, name + "/overloaded", steady, overloaded, overloaded_seconds);
+
+    uint64_t executed = 0, received = 0, early = 0, reordered = 0, outside_tick = 0, busy_ticks = 0, batched_ticks = 0;
+    for (auto& m : members)
+    {
+        executed += m->room->executed();
+        received += m->received.load(std::memory_order_relaxed);
+        early += m->early.load(std::memory_order_relaxed);
+        reordered += m->reordered.load(std::memory_order_relaxed);
+        outside_tick += m->room->outside_tick();
+        busy_ticks += m->room->busy_ticks();
+        batched_ticks += m->room->batched_ticks();
+    }
+
+    // a round lands every post_interval per pump, a 60 Hz tick sees dozens of them
+    if (outside_tick > 0)
+    {
+        runner.fail(name, std::to_string(outside_tick) + " packets ran outside their room's tick");
+    }
+    if (busy_ticks == 0 || batched_ticks * 10 < busy_ticks * 9)
+    {
+        runner.fail(name, std::to_string(batched_ticks) + " of " + std::to_string(busy_ticks) + " ticks ran more than one packet, posts are not batched into the next tick");
+    }
+    if (early > 0)
+    {
+        runner.fail(name, std::to_string(early) + " replies arrived before their tick ended");
+    }
+    if (reordered > 0)
+    {
+        runner.fail(name, std::to_string(reordered) + " replies arrived behind a later tick's");
+    }
+    if (received != executed)
+    {
+        runner.fail(name, std::to_string(received) + " replies for " + std::to_string(executed) + " packets, deferred sends were not flushed");
+    }
+
+    const auto steady_ticks = steady.ticks - before.ticks;
+    const auto overloaded_ticks = overloaded.ticks - steady.ticks;
+    if (overloaded.overruns - steady.overruns <= steady.overruns - before.overruns)
+    {
+        runner.fail(name, "overrun counter did not move under load");
+    }
+    if (steady_ticks == 0 || overloaded_ticks == 0 ||
+        (overloaded.total_jitter_us - steady.total_jitter_us) * static_cast<long long>(steady_ticks) <=
+        (steady.total_jitter_us - before.total_jitter_us) * static_cast<long long>(overloaded_ticks))
+    {
+        runner.fail(name, "mean tick jitter did not grow under load");
+    }
+
+    for (auto& m : members)
+    {
+        scheduler.remove(m->room);
+    }
+    scheduler.stop();
+
+    // a stopped scheduler refuses rooms instead of letting their mailboxes grow untouched
+    if (scheduler.add(members.front()->room))
+    {
+        runner.fail(name, "room scheduler took a room after stop()");
+    }
+
+    boost::system::error_code ec;
+    for (auto& m : members)
+    {
+        m->session->leave_room();
+        m->session->close();
+        m->session.reset();
+        m->peer->shutdown(tcp::socket::shutdown_both, ec);
+        m->reader.join();
+    }
+
+    work.reset();
+    network::stop();
+}
@@ -0,0 +1,609 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+#include <boost/asio.hpp>
+#include "bench.h"
+
+#ifdef __linux__
+#include <cerrno>
+#include <fstream>
+#include <sstream>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+#include "io_helper.h"
+#include "server/server.h"
+#include "monitor/io_monitor.h"
+#include "monitor/lag_probe.h"
+#include "../../client/src/packet_writer.h"
+#include "../../core/src/metrics/histogram.h"
+#include "../../sgs2/src/packet_processor/packet_processor.h"
+#include "../../sgs2/src/server_session/server_session.h"
+#include "../../sgs2/src/executor/executor.h"
+
+namespace
+{
+    using clock_type = std::chrono::steady_clock;
+
+    // connections per loopback source address, under the ~28k ephemeral ports one (source, destination) pair gets
+    constexpr size_t connections_per_address = 25000;
+
+    // non blocking connects outstanding at once, well under the listen backlog
+    constexpr size_t max_connecting = 256;
+
+    // a step that makes no progress for this long is where the server broke
+    constexpr auto stall_timeout = std::chrono::seconds(10);
+
+    int64_t now_ns()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(clock_type::now().time_since_epoch()).count();
+    }
+
+    int64_t cpu_ns(int who)
+    {
+        rusage usage;
+        getrusage(who, &usage);
+        return (static_cast<int64_t>(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000 + usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1000;
+    }
+
+    size_t rss_bytes()
+    {
+        size_t pages = 0;
+        size_t resident = 0;
+        std::ifstream statm("/proc/self/statm");
+        statm >> pages >> resident;
+        return resident * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    }
+
+    // socket buffers and tcp control blocks live in the kernel, outside rss
+    size_t kernel_tcp_bytes()
+    {
+        std::ifstream sockstat("/proc/net/sockstat");
+        std::string line;
+        while (std::getline(sockstat, line))
+        {
+            if (line.compare(0, 4, "TCP:") != 0)
+            {
+                continue;
+            }
+
+            std::istringstream fields(line);
+            std::string key;
+            size_t value = 0;
+            while (fields >> key >> value)
+            {
+                if (key == "mem")
+                {
+                    return value * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+                }
+            }
+        }
+        return 0;
+    }
+
+    struct step_report
+    {
+        size_t target = 0;
+        size_t connections = 0;
+        size_t sessions = 0;
+        double rss_per_connection = 0.0;
+        double kernel_per_connection = 0.0;
+        uint64_t accept_p50_ns = 0;
+        uint64_t accept_p99_ns = 0;
+        uint64_t accept_max_ns = 0;
+        double io_cpu_pct = 0.0;        // server process cpu over one core, clients excluded
+        double io_busy_pct = 0.0;       // completion handler time, io_monitor
+        long long io_lag_max_us = 0;
+        uint64_t pings = 0;
+        uint64_t rtt_p50_ns = 0;
+        uint64_t rtt_p99_ns = 0;
+        uint64_t rtt_max_ns = 0;
+    };
+
+    // raw non blocking sockets on one epoll, driven by the calling thread so the clients cost next to
+    // nothing in user space and their cpu can be taken out of the process total
+    class scale_clients
+    {
+    public:
+        explicit scale_clients(unsigned short port) : port_(port), epoll_(epoll_create1(0))
+        {
+            GAME::CS_PING ping;
+            ping.set_timestamp(1);
+            write_packet(ping, ping_request_);
+        }
+
+        ~scale_clients()
+        {
+            for (auto& c : connections_)
+            {
+                if (c.fd >= 0)
+                {
+                    // rst, nothing lingers in time_wait for the next run
+                    linger l{ 1, 0 };
+                    setsockopt(c.fd, SOL_SOCKET, SO_LINGER, &l, sizeof(l));
+                    close(c.fd);
+                }
+            }
+            close(epoll_);
+        }
+
+        size_t greeted() const { return greeted_; }
+        const std::string& failure() const { return failure_; }
+        size_t client_bytes() const { return connections_.capacity() * sizeof(connection); }
+
+        void reserve(size_t count) { connections_.reserve(count); }
+
+        // opens connections until target have their SC_LOG_IN greeting, false with failure() set when
+        // the ramp stops short; connect -> greeting latencies go to accept_latency
+        bool ramp(size_t target, core::histogram& accept_latency)
+        {
+            auto last_progress = clock_type::now();
+            auto progress = greeted_;
+
+            while (greeted_ < target)
+            {
+                while (connecting_ < max_connecting && connections_.size() < target)
+                {
+                    if (!open_one())
+                    {
+                        return false;
+                    }
+                }
+
+                poll(10, &accept_latency);
+                if (!failure_.empty())
+                {
+                    return false;
+                }
+
+                if (greeted_ != progress)
+                {
+                    progress = greeted_;
+                    last_progress = clock_type::now();
+                }
+                else if (clock_type::now() - last_progress > stall_timeout)
+                {
+                    failure_ = "no greeting for " + std::to_string(stall_timeout.count()) + " s at " + std::to_string(greeted_) + " connections, "
+                        + std::to_string(dropped_) + " closed by the server";
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        // every active connection sends a CS_PING once a second, one outstanding at a time
+        void run(std::chrono::milliseconds duration, double active_share, core::histogram& rtt)
+        {
+            const auto active = static_cast<size_t>(connections_.size() * active_share);
+            const auto begin = clock_type::now();
+            const auto end = begin + duration;
+
+            size_t cursor = 0;
+            double owed = 0.0;
+            auto last = begin;
+            while (clock_type::now() < end)
+            {
+                // spread the pings over the second instead of sending them in one burst
+                const auto now = clock_type::now();
+                owed += active * std::chrono::duration<double>(now - last).count();
+                last = now;
+
+                for (; owed >= 1.0 && active > 0; owed -= 1.0)
+                {
+                    auto& c = connections_[cursor];
+                    cursor = (cursor + 1) % active;
+                    if (c.state == state_idle && c.fd >= 0)
+                    {
+                        c.sent_ns = now_ns();
+                        c.state = state_ping;
+                        if (::send(c.fd, ping_request_.data(), ping_request_.size(), MSG_NOSIGNAL) != static_cast<ssize_t>(ping_request_.size()))
+                        {
+                            c.state = state_idle;
+                        }
+                    }
+                }
+
+                poll(1, nullptr, &rtt);
+            }
+        }
+
+    private:
+        enum : unsigned char
+        {
+            state_connecting,
+            state_greeting,
+            state_idle,
+            state_ping,
+        };
+
+        struct connection
+        {
+            int fd = -1;
+            unsigned char state = state_connecting;
+            unsigned char header_have = 0;
+            unsigned short header = 0;
+            unsigned short body_left = 0;
+            int64_t sent_ns = 0;        // connect started or ping sent
+        };
+
+        bool open_one()
+        {
+            const auto index = connections_.size();
+
+            sockaddr_in source{};
+            source.sin_family = AF_INET;
+            source.sin_addr.s_addr = htonl(INADDR_LOOPBACK + static_cast<uint32_t>(index / connections_per_address));
+
+            sockaddr_in target{};
+            target.sin_family = AF_INET;
+            target.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            target.sin_port = htons(port_);
+
+            const auto fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+            if (fd < 0)
+            {
+                failure_ = std::string("socket: ") + std::strerror(errno) + " at " + std::to_string(index) + " connections";
+                return false;
+            }
+
+            // the port is picked at connect() from the full 4-tuple, not reserved by bind()
+#ifdef IP_BIND_ADDRESS_NO_PORT
+            int one = 1;
+            setsockopt(fd, IPPROTO_IP, IP_BIND_ADDRESS_NO_PORT, &one, sizeof(one));
+#endif
+            if (bind(fd, reinterpret_cast<sockaddr*>(&source), sizeof(source)) != 0)
+            {
+                failure_ = std::string("bind: ") + std::strerror(errno) + " at " + std::to_string(index) + " connections";
+                close(fd);
+                return false;
+            }
+
+            connection c;
+            c.fd = fd;
+            c.sent_ns = now_ns();
+            if (connect(fd, reinterpret_cast<sockaddr*>(&target), sizeof(target)) != 0 && errno != EINPROGRESS)
+            {
+                failure_ = std::string("connect: ") + std::strerror(errno) + " at " + std::to_string(index) + " connections";
+                close(fd);
+                return false;
+            }
+
+            epoll_event ev{};
+            ev.events = EPOLLIN | EPOLLOUT;
+            ev.data.u64 = index;
+            epoll_ctl(epoll_, EPOLL_CTL_ADD, fd, &ev);
+
+            connections_.push_back(c);
+            ++connecting_;
+            return true;
+        }
+
+        void poll(int timeout_ms, core::histogram* accept_latency, core::histogram* rtt = nullptr)
+        {
+            epoll_event events[256];
+            const auto n = epoll_wait(epoll_, events, 256, timeout_ms);
+            for (auto i = 0; i < n; ++i)
+            {
+                auto& c = connections_[events[i].data.u64];
+                if (c.state == state_connecting && (events[i].events & (EPOLLOUT | EPOLLERR | EPOLLHUP)))
+                {
+                    int error = 0;
+                    socklen_t length = sizeof(error);
+                    getsockopt(c.fd, SOL_SOCKET, SO_ERROR, &error, &length);
+                    --connecting_;
+                    c.state = state_greeting;
+                    if (error != 0)
+                    {
+                        failure_ = std::string("connect: ") + std::strerror(error) + " at " + std::to_string(greeted_) + " connections";
+                        drop(c);
+                        continue;
+                    }
+
+                    epoll_event ev{};
+                    ev.events = EPOLLIN;
+                    ev.data.u64 = events[i].data.u64;
+                    epoll_ctl(epoll_, EPOLL_CTL_MOD, c.fd, &ev);
+                }
+
+                if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+                {
+                    receive(c, accept_latency, rtt);
+                }
+            }
+        }
+
+        // counts whole frames, the contents don't matter here
+        void receive(connection& c, core::histogram* accept_latency, core::histogram* rtt)
+        {
+            char data[4096];
+            for (;;)
+            {
+                const auto n = ::recv(c.fd, data, sizeof(data), 0);
+                if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR))
+                {
+                    drop(c);
+                    return;
+                }
+                if (n < 0)
+                {
+                    return;
+                }
+
+                for (ssize_t at = 0; at < n;)
+                {
+                    if (c.header_have < sizeof(c.header))
+                    {
+                        reinterpret_cast<char*>(&c.header)[c.header_have++] = data[at++];
+                        if (c.header_have == sizeof(c.header))
+                        {
+                            c.body_left = c.header;
+                        }
+                        continue;
+                    }
+
+                    const auto take = (std::min)(static_cast<ssize_t>(c.body_left), n - at);
+                    at += take;
+                    c.body_left = static_cast<unsigned short>(c.body_left - take);
+                    if (c.body_left == 0)
+                    {
+                        c.header_have = 0;
+                        on_frame(c, accept_latency, rtt);
+                    }
+                }
+            }
+        }
+
+        void on_frame(connection& c, core::histogram* accept_latency, core::histogram* rtt)
+        {
+            const auto elapsed = static_cast<uint64_t>(now_ns() - c.sent_ns);
+            if (c.state == state_greeting)
+            {
+                c.state = state_idle;
+                ++greeted_;
+                if (accept_latency)
+                {
+                    accept_latency->record(elapsed);
+                }
+            }
+            else if (c.state == state_ping)
+            {
+                c.state = state_idle;
+                if (rtt)
+                {
+                    rtt->record(elapsed);
+                }
+            }
+        }
+
+        void drop(connection& c)
+        {
+            ++dropped_;
+            if (c.state == state_connecting)
+            {
+                --connecting_;
+            }
+            else if (c.state != state_greeting)
+            {
+                --greeted_;
+            }
+            close(c.fd);
+            c.fd = -1;
+            c.state = state_greeting;
+        }
+
+        const unsigned short port_;
+        const int epoll_;
+        std::vector<char> ping_request_;
+        std::vector<connection> connections_;
+        size_t connecting_ = 0;
+        size_t greeted_ = 0;
+        size_t dropped_ = 0;
+        std::string failure_;
+    };
+
+    // both ends of every connection are in this process
+    size_t fd_limit()
+    {
+        rlimit limit;
+        getrlimit(RLIMIT_NOFILE, &limit);
+        if (limit.rlim_cur < limit.rlim_max)
+        {
+            limit.rlim_cur = limit.rlim_max;
+            setrlimit(RLIMIT_NOFILE, &limit);
+            getrlimit(RLIMIT_NOFILE, &limit);
+        }
+        return static_cast<size_t>(limit.rlim_cur);
+    }
+
+    std::vector<size_t> ramp_steps(size_t max)
+    {
+        std::vector<size_t> steps;
+        for (size_t step = 1000; step < max; step *= 4)
+        {
+            steps.push_back(step);
+        }
+        steps.push_back(max);
+        return steps;
+    }
+
+    std::string format_report(const bench_options& options, const std::vector<step_report>& steps, const std::string& broke)
+    {
+        std::string out;
+        char line[512];
+
+        snprintf(line, sizeof(line), "sgs2 scale test: up to %zu connections, %.0f%% pinging once a second, %zu io threads\n\n",
+            options.scale_max, options.scale_active * 100.0, options.max_threads);
+        out += line;
+
+        snprintf(line, sizeof(line), "%10s %10s %12s %12s %11s %11s %11s %8s %8s %10s %9s %9s %9s\n",
+            "conns", "sessions", "rss/conn B", "kernel/conn", "accept p50", "accept p99", "accept max",
+            "io cpu%", "io busy%", "io lag ms", "rtt p50", "rtt p99", "rtt max");
+        out += line;
+
+        for (auto& s : steps)
+        {
+            snprintf(line, sizeof(line), "%10zu %10zu %12.0f %12.0f %9.2fms %9.2fms %9.2fms %8.1f %8.1f %10.2f %7.2fms %7.2fms %7.2fms\n",
+                s.connections, s.sessions, s.rss_per_connection, s.kernel_per_connection,
+                s.accept_p50_ns / 1e6, s.accept_p99_ns / 1e6, s.accept_max_ns / 1e6,
+                s.io_cpu_pct, s.io_busy_pct, s.io_lag_max_us / 1000.0,
+                s.rtt_p50_ns / 1e6, s.rtt_p99_ns / 1e6, s.rtt_max_ns / 1e6);
+            out += line;
+        }
+
+        out += "\n";
+        out += broke.empty() ? "reached the target without a failure\n" : "stopped: " + broke + "\n";
+        return out;
+    }
+}
+
+void run_scale_benchmark(bench_runner& runner)
+{
+    const auto& options = runner.options();
+
+    std::string broke;
+    auto max = options.scale_max;
+    const auto fds = fd_limit();
+    if (max * 2 + 64 > fds)
+    {
+        max = fds > 64 ? (fds - 64) / 2 : 0;
+        broke = "fd limit " + std::to_string(fds) + " caps the ramp at " + std::to_string(max) + " connections (raise ulimit -n / fs.nr_open)";
+    }
+
+    register_handlers();
+    network::initialize();
+
+    // mostly idle connections, the server runs in idle lobby mode
+    network::session::set_lazy_receive(true);
+
+    tcp::endpoint endpoint(tcp::v4(), options.port);
+    auto svr = std::make_unique<network::server<server_session>>(network::io_service(), endpoint);
+
+    network::start(options.max_threads);
+    start_executors(options.max_threads, 4);
+    network::lag_probe::instance().start(std::chrono::milliseconds(100));
+    const auto lag_window = network::lag_probe::instance().open_window();
+    const auto usage_window = network::io_monitor::instance().open_window();
+
+    auto clients = std::make_unique<scale_clients>(options.port);
+    clients->reserve(max);
+
+    // clients run on this thread, the rest of the process is the server
+    const auto sample = std::chrono::milliseconds(static_cast<long long>((std::max)(options.min_time_ms, 3000.0)));
+    const auto rss_base = rss_bytes();
+    const auto kernel_base = kernel_tcp_bytes();
+
+    std::vector<step_report> steps;
+    for (auto target : ramp_steps(max))
+    {
+        if (target == 0)
+        {
+            break;
+        }
+
+        step_report step;
+        step.target = target;
+
+        core::histogram accept_latency;
+        const auto ramped = clients->ramp(target, accept_latency);
+
+        // measure window: idle connections plus the active share pinging
+        network::lag_probe::instance().snapshot(lag_window);
+        const auto io_before = network::io_monitor::instance().snapshot(usage_window);
+        const auto process_before = cpu_ns(RUSAGE_SELF);
+        const auto clients_before = cpu_ns(RUSAGE_THREAD);
+        const auto begin = clock_type::now();
+
+        core::histogram rtt;
+        clients->run(sample, options.scale_active, rtt);
+
+        const auto wall_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(clock_type::now() - begin).count();
+        const auto server_cpu_ns = (cpu_ns(RUSAGE_SELF) - process_before) - (cpu_ns(RUSAGE_THREAD) - clients_before);
+        const auto io_after = network::io_monitor::instance().snapshot(usage_window);
+
+        uint64_t busy_ns = 0;
+        for (size_t i = 0; i < io_after.threads.size(); ++i)
+        {
+            busy_ns += io_after.threads[i].busy_ns - (i < io_before.threads.size() ? io_before.threads[i].busy_ns : 0);
+        }
+        for (auto& lag : network::lag_probe::instance().snapshot(lag_window))
+        {
+            step.io_lag_max_us = (std::max)(step.io_lag_max_us, lag.max_us);
+        }
+
+        step.connections = clients->greeted();
+        step.sessions = network::session::count();
+        if (step.connections > 0)
+        {
+            const auto rss = static_cast<double>(rss_bytes()) - rss_base - clients->client_bytes();
+            step.rss_per_connection = rss / step.connections;
+            step.kernel_per_connection = (static_cast<double>(kernel_tcp_bytes()) - kernel_base) / step.connections;
+        }
+        step.accept_p50_ns = accept_latency.percentile(50.0);
+        step.accept_p99_ns = accept_latency.percentile(99.0);
+        step.accept_max_ns = accept_latency.max();
+        step.io_cpu_pct = wall_ns > 0 ? 100.0 * server_cpu_ns / wall_ns : 0.0;
+        step.io_busy_pct = wall_ns > 0 ? 100.0 * busy_ns / wall_ns : 0.0;
+        step.pings = rtt.count();
+        step.rtt_p50_ns = rtt.percentile(50.0);
+        step.rtt_p99_ns = rtt.percentile(99.0);
+        step.rtt_max_ns = rtt.max();
+        steps.push_back(step);
+
+        printf("scale %zu: %zu connected, rss %.0f B/conn, accept p99 %.2f ms, io cpu %.1f%%, rtt p99 %.2f ms (%llu pings)\n",
+            target, step.connections, step.rss_per_connection, step.accept_p99_ns / 1e6, step.io_cpu_pct, step.rtt_p99_ns / 1e6,
+            static_cast<unsigned long long>(step.pings));
+
+        bench_result result;
+        result.name = "scale/connections:" + std::to_string(target) + "/ping";
+        result.iterations = step.pings;
+        result.ns_per_op = step.pings > 0 ? rtt.mean() : 0.0;
+        result.ops_per_sec = step.pings * 1e9 / wall_ns;
+        result.p50_ns = static_cast<double>(step.rtt_p50_ns);
+        result.p99_ns = static_cast<double>(step.rtt_p99_ns);
+        runner.record(result);
+
+        if (!ramped)
+        {
+            broke = clients->failure();
+            break;
+        }
+    }
+
+    // clients go first so the sessions see a reset, not a stopped io_service
+    clients.reset();
+    network::lag_probe::instance().stop();
+    svr->stop();
+    network::stop();
+    stop_executors();
+    svr.reset();
+
+    const auto report = format_report(options, steps, broke);
+    printf("\n%s", report.c_str());
+
+    if (auto file = std::fopen(options.scale_report.c_str(), "w"))
+    {
+        std::fputs(report.c_str(), file);
+        std::fclose(file);
+        printf("report written to %s\n", options.scale_report.c_str());
+    }
+    else
+    {
+        runner.fail("scale", "cannot write " + options.scale_report);
+    }
+}
+#else
+void run_scale_benchmark(bench_runner& runner)
+{
+    runner.fail("scale", "the scale test needs linux (epoll, loopback source addresses, /proc)");
+}
+#endif
@@ -0,0 +1,149 @@
+#include <codecvt>
+#include <locale>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "bench.h"
+#include "../../core/src/locale/string_helper.h"
+#include "../../core/src/locale/utf8.h"
+
+namespace
+{
+    volatile size_t sink = 0;
+
+    // what core::string_helper did before the utf8 layer
+    std::wstring_convert<std::codecvt_utf8<wchar_t>>& codecvt()
+    {
+        static thread_local std::wstring_convert<std::codecvt_utf8<wchar_t>> cvt;
+        return cvt;
+    }
+
+    struct input
+    {
+        const char* name;
+        std::string utf8;
+    };
+
+    std::vector<input> inputs()
+    {
+        // ascii with some hangul (3 byte sequences), the mix of a korean chat line
+        std::string hangul;
+        while (hangul.size() < 4096)
+        {
+            hangul += "\xEA\xB0\x80\xEB\x82\x98\xEB\x8B\xA4 abc \xED\x95\x9C\xEA\xB8\x80 ";
+        }
+
+        return{
+            { "login", "player_0123456789_abcdef" },
+            { "ascii_4k", std::string(4096, 'a') },
+            { "hangul_4k", hangul },
+        };
+    }
+}
+
+void run_string_benchmark(bench_runner& runner)
+{
+    if (!runner.enabled("utf8/"))
+    {
+        return;
+    }
+
+    const core::utf8_isa isas[] = { core::utf8_isa::scalar, core::utf8_isa::sse2, core::utf8_isa::avx2 };
+    const auto best = core::utf8_active_isa();
+
+    for (auto& in : inputs())
+    {
+        const auto bytes = static_cast<double>(in.utf8.size());
+        const auto wide = core::utf8_to_wstring(in.utf8);
+        const std::string prefix = std::string("utf8/");
+
+        // validation, the old path could only find out by converting
+        runner.measure(prefix + "validate/" + in.name + "/codecvt", bytes, [&](uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                try
+                {
+                    sink += codecvt().from_bytes(in.utf8).size();
+                }
+                catch (std::range_error&)
+                {
+                }
+            }
+        });
+
+        for (auto isa : isas)
+        {
+            if (static_cast<int>(isa) > static_cast<int>(best))
+            {
+                continue;
+            }
+
+            core::utf8_set_max_isa(isa);
+            const auto name = prefix + "validate/" + in.name + "/" + core::utf8_isa_name(isa);
+            runner.expect_zero_allocations(name);
+            runner.measure(name, bytes, [&](uint64_t iterations)
+            {
+                for (uint64_t i = 0; i < iterations; ++i)
+                {
+                    sink += core::utf8_validate(in.utf8);
+                }
+            });
+        }
+        core::utf8_set_max_isa(best);
+
+        // utf-8 -> wchar_t
+        runner.measure(prefix + "to_wide/" + in.name + "/codecvt", bytes, [&](uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                sink += codecvt().from_bytes(in.utf8).size();
+            }
+        });
+
+        runner.measure(prefix + "to_wide/" + in.name + "/string_helper", bytes, [&](uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                sink += core::utf8_to_wstring(in.utf8).size();
+            }
+        });
+
+        std::vector<wchar_t> wide_buffer(core::max_wide_length_from_utf8(in.utf8.size()));
+        runner.expect_zero_allocations(prefix + "to_wide/" + in.name + "/buffer");
+        runner.measure(prefix + "to_wide/" + in.name + "/buffer", bytes, [&](uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                sink += core::utf8_to_wide(in.utf8, wide_buffer.data(), wide_buffer.size()).written;
+            }
+        });
+
+        // wchar_t -> utf-8
+        runner.measure(prefix + "from_wide/" + in.name + "/codecvt", bytes, [&](uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                sink += codecvt().to_bytes(wide).size();
+            }
+        });
+
+        runner.measure(prefix + "from_wide/" + in.name + "/string_helper", bytes, [&](uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                sink += core::wstring_to_string(wide).size();
+            }
+        });
+
+        std::vector<char> utf8_buffer(core::max_utf8_length_from_wide(wide.size()));
+        runner.expect_zero_allocations(prefix + "from_wide/" + in.name + "/buffer");
+        runner.measure(prefix + "from_wide/" + in.name + "/buffer", bytes, [&](uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                sink += core::wide_to_utf8(wide, utf8_buffer.data(), utf8_buffer.size()).written;
+            }
+        });
+    }
+}
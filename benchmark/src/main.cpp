@@ -0,0 +1,129 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cwchar>
+#include <string>
+#include <thread>
+#include "bench.h"
+
+namespace
+{
+    void usage()
+    {
+        printf("usage: benchmark [--filter substring] [--json out.json] [--min-time ms] [--max-threads n] [--port p]\n");
+        printf("       benchmark --replay capture.bin [--speed x] [--sockets] [--json out.json]\n");
+        printf("       benchmark --compare base.json current.json [--threshold pct]\n");
+        printf("       benchmark --scale connections [--active share] [--report out.txt] [--min-time ms] [--max-threads n] [--port p]\n");
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    bench_options options;
+    options.max_threads = std::thread::hardware_concurrency();
+
+    std::string compare_base;
+    std::string compare_current;
+    auto threshold_pct = 5.0;
+
+    for (auto i = 1; i < argc; ++i)
+    {
+        auto has_value = i + 1 < argc;
+
+        if (std::strcmp(argv[i], "--filter") == 0 && has_value)
+        {
+            options.filter = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--json") == 0 && has_value)
+        {
+            options.json_path = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--min-time") == 0 && has_value)
+        {
+            options.min_time_ms = std::atof(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--max-threads") == 0 && has_value)
+        {
+            options.max_threads = std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if (std::strcmp(argv[i], "--port") == 0 && has_value)
+        {
+            options.port = static_cast<unsigned short>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (std::strcmp(argv[i], "--replay") == 0 && has_value)
+        {
+            options.replay_path = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--speed") == 0 && has_value)
+        {
+            options.replay_speed = std::atof(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--sockets") == 0)
+        {
+            options.replay_sockets = true;
+        }
+        else if (std::strcmp(argv[i], "--scale") == 0 && has_value)
+        {
+            options.scale_max = std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if (std::strcmp(argv[i], "--active") == 0 && has_value)
+        {
+            options.scale_active = std::atof(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--report") == 0 && has_value)
+        {
+            options.scale_report = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--compare") == 0 && i + 2 < argc)
+        {
+            compare_base = argv[++i];
+            compare_current = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--threshold") == 0 && has_value)
+        {
+            threshold_pct = std::atof(argv[++i]);
+        }
+        else
+        {
+            usage();
+            return 1;
+        }
+    }
+
+    if (!compare_base.empty())
+    {
+        return compare_results(compare_base, compare_current, threshold_pct) == 0 ? 0 : 1;
+    }
+
+    if (options.max_threads == 0)
+    {
+        options.max_threads = 1;
+    }
+
+    // byte oriented stdout, a stray wprintf must not swallow the result table
+    fwide(stdout, -1);
+
+    bench_runner runner(options);
+
+    if (!runner.options().replay_path.empty())
+    {
+        run_replay_benchmark(runner);
+        return runner.write_json() ? 0 : 1;
+    }
+
+    if (runner.options().scale_max > 0)
+    {
+        run_scale_benchmark(runner);
+        return runner.write_json() && runner.failures() == 0 ? 0 : 1;
+    }
+
+    run_packet_benchmark(runner);
+    run_loopback_benchmark(runner);
+    run_job_system_benchmark(runner);
+    run_string_benchmark(runner);
+    run_memory_benchmark(runner);
+    run_concurrency_benchmark(runner);
+    run_room_benchmark(runner);
+
+    return runner.write_json() && runner.failures() == 0 ? 0 : 1;
+}
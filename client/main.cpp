@@ -1,9 +1,17 @@
 #include <iostream>
+#include "src/scenario.h"
+#include "src/swarm.h"
 
-int main()
+int main(int argc, char* argv[])
 {
-    printf("hello client\n");
+    scenario s;
+    if (!parse_arguments(argc, argv, s))
+    {
+        return 1;
+    }
 
-    getchar();
-    return 0;
+    printf("bot swarm: %zu connections to %s:%u\n", s.connections, s.host.c_str(), s.port);
+
+    swarm bots(s);
+    return bots.run();
 }
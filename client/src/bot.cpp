@@ -0,0 +1,290 @@
+#include "bot.h"
+#include "swarm.h"
+#include "scenario.h"
+#include "packet_writer.h"
+
+namespace
+{
+#ifdef IP_BIND_ADDRESS_NO_PORT
+    using bind_address_no_port = boost::asio::detail::socket_option::boolean<IPPROTO_IP, IP_BIND_ADDRESS_NO_PORT>;
+#endif
+
+    long long now_us()
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+}
+
+bot::bot(boost::asio::io_service& io_service, swarm& owner, const scenario& s, unsigned int seed)
+    : owner_(owner), scenario_(s), strand_(io_service), socket_(io_service), timer_(io_service), seed_(seed ? seed : 1)
+{
+}
+
+void bot::start(const tcp::endpoint& endpoint, const boost::asio::ip::address& source)
+{
+    auto self(shared_from_this());
+    connect_begin_ = std::chrono::steady_clock::now();
+
+    boost::system::error_code ec;
+    socket_.open(endpoint.protocol(), ec);
+    if (!ec && !source.is_unspecified())
+    {
+#ifdef IP_BIND_ADDRESS_NO_PORT
+        // the port is picked at connect() from the full 4-tuple, not reserved by bind()
+        socket_.set_option(bind_address_no_port(true), ec);
+#endif
+        if (!ec)
+        {
+            socket_.bind(tcp::endpoint(source, 0), ec);
+        }
+    }
+
+    if (ec)
+    {
+        owner_.on_connect_failed(ec);
+        close();
+        return;
+    }
+
+    socket_.async_connect(endpoint, strand_.wrap([this, self](boost::system::error_code ec)
+    {
+        if (ec)
+        {
+            owner_.on_connect_failed(ec);
+            close();
+            return;
+        }
+
+        auto latency = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - connect_begin_).count();
+        owner_.on_connected(static_cast<uint64_t>(latency));
+        on_connect();
+    }));
+}
+
+void bot::stop()
+{
+    auto self(shared_from_this());
+    strand_.post([this, self] { close(); });
+}
+
+void bot::on_connect()
+{
+    connected_ = true;
+
+    boost::system::error_code ec;
+    socket_.set_option(tcp::no_delay(true), ec);
+
+    do_read_header();
+
+    if (scenario_.login)
+    {
+        LOBBY::CS_LOG_IN login;
+        login.set_id("bot" + std::to_string(seed_));
+        login.set_password("bot");
+
+        std::vector<char> packet;
+        write_packet(login, packet);
+        send(std::move(packet));
+    }
+
+    start_active();
+}
+
+void bot::do_read_header()
+{
+    auto self(shared_from_this());
+    boost::asio::async_read(socket_, boost::asio::buffer(&header_, sizeof(header_)),
+        strand_.wrap([this, self](boost::system::error_code ec, std::size_t /*length*/)
+    {
+        if (ec || header_ < sizeof(unsigned short))
+        {
+            close();
+            return;
+        }
+
+        do_read_body();
+    }));
+}
+
+void bot::do_read_body()
+{
+    body_.resize(header_);
+
+    auto self(shared_from_this());
+    boost::asio::async_read(socket_, boost::asio::buffer(body_.data(), body_.size()),
+        strand_.wrap([this, self](boost::system::error_code ec, std::size_t length)
+    {
+        if (ec)
+        {
+            close();
+            return;
+        }
+
+        on_packet(body_.data(), length);
+        do_read_header();
+    }));
+}
+
+void bot::on_packet(const char* data, size_t size)
+{
+    owner_.on_received();
+
+    opcode code;
+    std::memcpy(&code, data, sizeof(code));
+
+    auto body = data + sizeof(unsigned short);
+    auto body_size = static_cast<int>(size - sizeof(unsigned short));
+
+    switch (code)
+    {
+    case opcode::SC_PING:
+        {
+            GAME::SC_PING read;
+            if (read.ParseFromArray(body, body_size))
+            {
+                server_time_ = read.server_time();
+                server_time_received_ = now_us();
+
+                auto rtt = server_time_received_ - read.timestamp();
+                if (rtt >= 0)
+                {
+                    owner_.record_rtt(static_cast<uint64_t>(rtt));
+                }
+            }
+        }
+        break;
+
+    default:
+        break;
+    }
+}
+
+void bot::start_active()
+{
+    if (closed_)
+    {
+        return;
+    }
+
+    active_until_ = std::chrono::steady_clock::now() + std::chrono::milliseconds(scenario_.active_ms);
+    send_ping();
+}
+
+void bot::think()
+{
+    if (closed_)
+    {
+        return;
+    }
+
+    auto range = scenario_.think_max_ms - scenario_.think_min_ms;
+    auto think_ms = scenario_.think_min_ms + (range ? next_random() % (range + 1) : 0);
+
+    auto self(shared_from_this());
+    timer_.expires_from_now(std::chrono::milliseconds(think_ms));
+    timer_.async_wait(strand_.wrap([this, self](boost::system::error_code ec)
+    {
+        if (!ec)
+        {
+            start_active();
+        }
+    }));
+}
+
+void bot::send_ping()
+{
+    if (closed_)
+    {
+        return;
+    }
+
+    if (scenario_.ping_rate == 0 || std::chrono::steady_clock::now() >= active_until_)
+    {
+        think();
+        return;
+    }
+
+    const auto now = now_us();
+
+    GAME::CS_PING ping;
+    ping.set_timestamp(now);
+    if (server_time_ != 0)
+    {
+        ping.set_echo(server_time_);
+        ping.set_hold(now - server_time_received_);
+    }
+
+    std::vector<char> packet;
+    write_packet(ping, packet);
+    send(std::move(packet));
+
+    auto self(shared_from_this());
+    timer_.expires_from_now(std::chrono::microseconds(1000000 / scenario_.ping_rate));
+    timer_.async_wait(strand_.wrap([this, self](boost::system::error_code ec)
+    {
+        if (!ec)
+        {
+            send_ping();
+        }
+    }));
+}
+
+// called on the strand
+void bot::send(std::vector<char> packet)
+{
+    write_q_.emplace_back(std::move(packet));
+    if (write_q_.size() == 1)
+    {
+        do_write();
+    }
+}
+
+void bot::do_write()
+{
+    auto self(shared_from_this());
+    boost::asio::async_write(socket_, boost::asio::buffer(write_q_.front()),
+        strand_.wrap([this, self](boost::system::error_code ec, std::size_t /*length*/)
+    {
+        if (ec)
+        {
+            close();
+            return;
+        }
+
+        owner_.on_sent();
+        write_q_.pop_front();
+
+        if (!write_q_.empty())
+        {
+            do_write();
+        }
+    }));
+}
+
+void bot::close()
+{
+    if (closed_)
+    {
+        return;
+    }
+
+    closed_ = true;
+
+    boost::system::error_code ec;
+    timer_.cancel(ec);
+    socket_.close(ec);
+
+    if (connected_)
+    {
+        owner_.on_disconnected();
+    }
+}
+
+unsigned int bot::next_random()
+{
+    // xorshift32, a std::mt19937 per bot is too big for 100k bots
+    seed_ ^= seed_ << 13;
+    seed_ ^= seed_ >> 17;
+    seed_ ^= seed_ << 5;
+    return seed_;
+}
@@ -0,0 +1,66 @@
+#ifndef __BOT_H
+#define __BOT_H
+
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <vector>
+#include <boost/asio.hpp>
+#include <boost/asio/steady_timer.hpp>
+
+class swarm;
+struct scenario;
+
+using boost::asio::ip::tcp;
+
+// one simulated player connection
+class bot : public std::enable_shared_from_this<bot>
+{
+public:
+    bot(boost::asio::io_service& io_service, swarm& owner, const scenario& s, unsigned int seed);
+
+    // binds to source first unless it is unspecified
+    void start(const tcp::endpoint& endpoint, const boost::asio::ip::address& source);
+    void stop();
+
+private:
+    void on_connect();
+
+    void do_read_header();
+    void do_read_body();
+    void on_packet(const char* data, size_t size);
+
+    void start_active();
+    void think();
+    void send_ping();
+
+    void send(std::vector<char> packet);
+    void do_write();
+
+    void close();
+    unsigned int next_random();
+
+    swarm& owner_;
+    const scenario& scenario_;
+
+    boost::asio::io_service::strand strand_;
+    tcp::socket socket_;
+    boost::asio::steady_timer timer_;
+
+    unsigned short header_ = 0;
+    std::vector<char> body_;
+    std::deque<std::vector<char>> write_q_;
+
+    std::chrono::steady_clock::time_point connect_begin_;
+    std::chrono::steady_clock::time_point active_until_;
+    unsigned int seed_;
+
+    // server_time of the last SC_PING and when it arrived, echoed by the next CS_PING for the server's rtt
+    long long server_time_ = 0;
+    long long server_time_received_ = 0;
+
+    bool connected_ = false;
+    bool closed_ = false;
+};
+
+#endif
@@ -0,0 +1,25 @@
+#ifndef __PACKET_WRITER_H
+#define __PACKET_WRITER_H
+
+#include <cstring>
+#include <vector>
+#include "../../sgs2/src/packet_processor/packet_traits.h"
+
+// [size][opcode][body], size counts opcode + body
+template <class Protobuf>
+bool write_packet(const Protobuf& protobuf, std::vector<char>& out)
+{
+    static constexpr auto header_size = sizeof(unsigned short) * 2;
+
+    const auto body_size = protobuf.ByteSizeLong();
+    const auto size = static_cast<unsigned short>(body_size + sizeof(unsigned short));
+    const auto code = packet_traits<Protobuf>::code;
+
+    out.resize(header_size + body_size);
+    std::memcpy(out.data(), &size, sizeof(unsigned short));
+    std::memcpy(out.data() + sizeof(unsigned short), &code, sizeof(unsigned short));
+    protobuf.SerializeWithCachedSizesToArray(reinterpret_cast<google::protobuf::uint8*>(out.data() + header_size));
+    return true;
+}
+
+#endif
@@ -0,0 +1,122 @@
+#include "scenario.h"
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+
+namespace
+{
+    std::string trim(const std::string& s)
+    {
+        auto first = s.find_first_not_of(" \t\r\n");
+        if (first == std::string::npos)
+        {
+            return{};
+        }
+
+        auto last = s.find_last_not_of(" \t\r\n");
+        return s.substr(first, last - first + 1);
+    }
+
+    size_t to_size(const std::string& value)
+    {
+        return static_cast<size_t>(std::strtoull(value.c_str(), nullptr, 10));
+    }
+}
+
+bool scenario::set(const std::string& key, const std::string& value)
+{
+    if (key == "host") host = value;
+    else if (key == "port") port = static_cast<unsigned short>(to_size(value));
+    else if (key == "connections") connections = to_size(value);
+    else if (key == "connect_rate") connect_rate = to_size(value);
+    else if (key == "duration") duration_sec = to_size(value);
+    else if (key == "io_threads") io_threads = to_size(value);
+    else if (key == "connections_per_source") connections_per_source = to_size(value);
+    else if (key == "login") login = (value == "1" || value == "true");
+    else if (key == "ping_rate") ping_rate = to_size(value);
+    else if (key == "active_ms") active_ms = to_size(value);
+    else if (key == "think_min_ms") think_min_ms = to_size(value);
+    else if (key == "think_max_ms") think_max_ms = to_size(value);
+    else if (key == "report_interval") report_interval_sec = to_size(value);
+    else if (key == "report") report_path = value;
+    else
+    {
+        printf("unknown scenario key: %s\n", key.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+bool scenario::load(const std::string& path)
+{
+    std::ifstream file(path);
+    if (!file)
+    {
+        printf("can not open scenario: %s\n", path.c_str());
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(file, line))
+    {
+        line = trim(line);
+        if (line.empty() || line[0] == '#')
+        {
+            continue;
+        }
+
+        auto eq = line.find('=');
+        if (eq == std::string::npos)
+        {
+            continue;
+        }
+
+        if (!set(trim(line.substr(0, eq)), trim(line.substr(eq + 1))))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool parse_arguments(int argc, char* argv[], scenario& out)
+{
+    for (auto i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg.compare(0, 2, "--") != 0 || i + 1 >= argc)
+        {
+            printf("usage: client [--scenario file] [--key value]...\n");
+            return false;
+        }
+
+        auto key = arg.substr(2);
+        std::string value = argv[++i];
+
+        if (key == "scenario")
+        {
+            if (!out.load(value))
+            {
+                return false;
+            }
+        }
+        else if (!out.set(key, value))
+        {
+            return false;
+        }
+    }
+
+    if (out.connections_per_source == 0)
+    {
+        out.connections_per_source = 1;
+    }
+
+    if (out.think_max_ms < out.think_min_ms)
+    {
+        out.think_max_ms = out.think_min_ms;
+    }
+
+    return true;
+}
@@ -0,0 +1,37 @@
+#ifndef __SCENARIO_H
+#define __SCENARIO_H
+
+#include <string>
+
+// load test scenario, key = value file and/or --key value arguments
+struct scenario
+{
+    std::string host = "127.0.0.1";
+    unsigned short port = 3000;
+
+    size_t connections = 100;
+    size_t connect_rate = 1000;     // new connections per second
+    size_t duration_sec = 30;       // measured time after the ramp up
+    size_t io_threads = 0;          // 0 = hardware_concurrency
+
+    // loopback host only: bots per 127.0.0.x source address, each address gets its own ~28k ephemeral ports
+    size_t connections_per_source = 25000;
+
+    bool login = true;
+
+    // each bot: ping at ping_rate for active_ms, then think for [think_min_ms, think_max_ms]
+    size_t ping_rate = 10;          // CS_PING per second per bot while active
+    size_t active_ms = 5000;
+    size_t think_min_ms = 0;
+    size_t think_max_ms = 0;
+
+    size_t report_interval_sec = 1;
+    std::string report_path;        // json report, empty = stdout
+
+    bool set(const std::string& key, const std::string& value);
+    bool load(const std::string& path);
+};
+
+bool parse_arguments(int argc, char* argv[], scenario& out);
+
+#endif
@@ -0,0 +1,299 @@
+#include "swarm.h"
+#include "bot.h"
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+#ifdef __linux__
+#include <sys/resource.h>
+#endif
+
+namespace
+{
+    using clock_type = std::chrono::steady_clock;
+
+    double seconds_since(clock_type::time_point begin)
+    {
+        return std::chrono::duration<double>(clock_type::now() - begin).count();
+    }
+
+    thread_local void* local_shard = nullptr;
+
+    // a single source address reaches about this many connections to one host:port
+    constexpr size_t ephemeral_ports = 28000;
+
+    // stdio, the io threads' reactor and other descriptors that are not bots
+    constexpr size_t reserved_fds = 64;
+
+#ifdef __linux__
+    // one descriptor per bot, the soft limit is usually 1024
+    size_t fd_limit()
+    {
+        rlimit limit;
+        getrlimit(RLIMIT_NOFILE, &limit);
+        if (limit.rlim_cur < limit.rlim_max)
+        {
+            limit.rlim_cur = limit.rlim_max;
+            setrlimit(RLIMIT_NOFILE, &limit);
+            getrlimit(RLIMIT_NOFILE, &limit);
+        }
+        return static_cast<size_t>(limit.rlim_cur);
+    }
+#endif
+}
+
+swarm::swarm(const scenario& s) : scenario_(s)
+{
+}
+
+swarm::~swarm()
+{
+}
+
+swarm::shard& swarm::local()
+{
+    if (local_shard == nullptr)
+    {
+        std::lock_guard<std::mutex> lock(shards_m_);
+        shards_.emplace_back(std::make_unique<shard>());
+        local_shard = shards_.back().get();
+    }
+
+    return *static_cast<shard*>(local_shard);
+}
+
+int swarm::run()
+{
+    const auto host = boost::asio::ip::address::from_string(scenario_.host);
+    if (!(host.is_v4() && host.is_loopback()) && scenario_.connections > ephemeral_ports)
+    {
+        printf("error: %zu connections to %s:%u need more than one source address, only a loopback host spreads them\n",
+            scenario_.connections, scenario_.host.c_str(), scenario_.port);
+        return 1;
+    }
+
+#ifdef __linux__
+    const auto fds = fd_limit();
+    if (fds < scenario_.connections + reserved_fds)
+    {
+        printf("error: open file limit is %zu, %zu connections need %zu, raise the hard limit (ulimit -Hn)\n",
+            fds, scenario_.connections, scenario_.connections + reserved_fds);
+        return 1;
+    }
+#endif
+
+    auto thread_count = scenario_.io_threads ? scenario_.io_threads : std::thread::hardware_concurrency();
+    if (thread_count == 0)
+    {
+        thread_count = 1;
+    }
+
+    work_ = std::make_unique<boost::asio::io_service::work>(io_service_);
+    for (size_t i = 0; i < thread_count; ++i)
+    {
+        threads_.emplace_back([this]
+        {
+            boost::system::error_code ec;
+            io_service_.run(ec);
+        });
+    }
+
+    auto ramp_begin = clock_type::now();
+    ramp_up();
+    auto ramp_sec = seconds_since(ramp_begin);
+
+    const auto established = connected_.load();
+    if (established < scenario_.connections)
+    {
+        std::lock_guard<std::mutex> lock(first_failure_m_);
+        printf("error: %zu of %zu connections established, %zu failed%s%s\n", established, scenario_.connections, failed_.load(),
+            first_failure_.empty() ? "" : ", first: ", first_failure_.c_str());
+    }
+
+    // measured window starts after the ramp up
+    {
+        std::lock_guard<std::mutex> lock(shards_m_);
+        for (auto& s : shards_)
+        {
+            sent_at_measure_ += s->sent.load(std::memory_order_relaxed);
+            received_at_measure_ += s->received.load(std::memory_order_relaxed);
+        }
+    }
+    measuring_ = true;
+
+    auto measure_begin = clock_type::now();
+    auto next_report = measure_begin;
+    while (seconds_since(measure_begin) < scenario_.duration_sec)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+        if (scenario_.report_interval_sec && clock_type::now() >= next_report)
+        {
+            print_progress(seconds_since(measure_begin));
+            next_report += std::chrono::seconds(scenario_.report_interval_sec);
+        }
+    }
+
+    measuring_ = false;
+    auto measure_sec = seconds_since(measure_begin);
+
+    for (auto& b : bots_)
+    {
+        b->stop();
+    }
+
+    work_.reset();
+    io_service_.stop();
+    for (auto& t : threads_)
+    {
+        t.join();
+    }
+    threads_.clear();
+
+    write_report(ramp_sec, measure_sec);
+    bots_.clear();
+    return established < scenario_.connections ? 1 : 0;
+}
+
+void swarm::ramp_up()
+{
+    boost::asio::ip::tcp::endpoint endpoint(boost::asio::ip::address::from_string(scenario_.host), scenario_.port);
+
+    // a loopback host spreads bots over 127.0.0.1, 127.0.0.2, ... so the swarm is not capped by one address's ports
+    const auto loopback = endpoint.address().is_v4() && endpoint.address().is_loopback();
+
+    auto rate = scenario_.connect_rate ? scenario_.connect_rate : scenario_.connections;
+    auto begin = clock_type::now();
+
+    bots_.reserve(scenario_.connections);
+    for (size_t i = 0; i < scenario_.connections; ++i)
+    {
+        // pace connects to connect_rate per second
+        auto due = begin + std::chrono::microseconds(static_cast<long long>(i * 1000000.0 / rate));
+        std::this_thread::sleep_until(due);
+
+        auto b = std::make_shared<bot>(io_service_, *this, scenario_, static_cast<unsigned int>(i + 1));
+        bots_.push_back(b);
+        auto source = loopback
+            ? boost::asio::ip::address(boost::asio::ip::address_v4(0x7F000001 + static_cast<unsigned long>(i / scenario_.connections_per_source)))
+            : boost::asio::ip::address();
+        b->start(endpoint, source);
+    }
+
+    // wait for outstanding connects
+    while (connected_ + failed_ < scenario_.connections && seconds_since(begin) < scenario_.connections / double(rate) + 10.0)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+}
+
+void swarm::on_connected(uint64_t latency_us)
+{
+    connected_.fetch_add(1, std::memory_order_relaxed);
+    local().connect.record(latency_us);
+}
+
+void swarm::on_connect_failed(const boost::system::error_code& ec)
+{
+    if (failed_.fetch_add(1, std::memory_order_relaxed) == 0)
+    {
+        std::lock_guard<std::mutex> lock(first_failure_m_);
+        first_failure_ = ec.message();
+    }
+}
+
+void swarm::on_disconnected()
+{
+    disconnected_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void swarm::on_sent()
+{
+    local().sent.fetch_add(1, std::memory_order_relaxed);
+}
+
+void swarm::on_received()
+{
+    local().received.fetch_add(1, std::memory_order_relaxed);
+}
+
+void swarm::record_rtt(uint64_t rtt_us)
+{
+    if (measuring_.load(std::memory_order_relaxed))
+    {
+        local().rtt.record(rtt_us);
+    }
+}
+
+void swarm::print_progress(double elapsed_sec)
+{
+    uint64_t sent = 0;
+    uint64_t received = 0;
+    {
+        std::lock_guard<std::mutex> lock(shards_m_);
+        for (auto& s : shards_)
+        {
+            sent += s->sent.load(std::memory_order_relaxed);
+            received += s->received.load(std::memory_order_relaxed);
+        }
+    }
+
+    printf("[%6.1fs] connected:%zu failed:%zu closed:%zu sent:%llu recv:%llu\n", elapsed_sec,
+        connected_.load(), failed_.load(), disconnected_.load(),
+        static_cast<unsigned long long>(sent - sent_at_measure_), static_cast<unsigned long long>(received - received_at_measure_));
+}
+
+void swarm::write_report(double ramp_sec, double measure_sec)
+{
+    core::histogram rtt;
+    core::histogram connect;
+    uint64_t sent = 0;
+    uint64_t received = 0;
+
+    for (auto& s : shards_)
+    {
+        rtt.merge(s->rtt);
+        connect.merge(s->connect);
+        sent += s->sent.load(std::memory_order_relaxed);
+        received += s->received.load(std::memory_order_relaxed);
+    }
+
+    sent -= sent_at_measure_;
+    received -= received_at_measure_;
+
+    auto file = scenario_.report_path.empty() ? stdout : fopen(scenario_.report_path.c_str(), "w");
+    if (file == nullptr)
+    {
+        printf("can not open report: %s\n", scenario_.report_path.c_str());
+        return;
+    }
+
+    auto summary = [file](const char* name, const core::histogram& h, const char* tail)
+    {
+        fprintf(file, "  \"%s\": { \"count\": %llu, \"mean\": %.1f, \"p50\": %llu, \"p99\": %llu, \"p999\": %llu, \"max\": %llu }%s\n", name,
+            static_cast<unsigned long long>(h.count()), h.mean(),
+            static_cast<unsigned long long>(h.percentile(50.0)),
+            static_cast<unsigned long long>(h.percentile(99.0)),
+            static_cast<unsigned long long>(h.percentile(99.9)),
+            static_cast<unsigned long long>(h.max()), tail);
+    };
+
+    fprintf(file, "{\n");
+    fprintf(file, "  \"scenario\": { \"host\": \"%s\", \"port\": %u, \"connections\": %zu, \"connect_rate\": %zu, \"duration_sec\": %zu, \"ping_rate\": %zu, \"active_ms\": %zu, \"think_min_ms\": %zu, \"think_max_ms\": %zu, \"login\": %s },\n",
+        scenario_.host.c_str(), scenario_.port, scenario_.connections, scenario_.connect_rate, scenario_.duration_sec,
+        scenario_.ping_rate, scenario_.active_ms, scenario_.think_min_ms, scenario_.think_max_ms, scenario_.login ? "true" : "false");
+    fprintf(file, "  \"connections\": { \"established\": %zu, \"failed\": %zu, \"closed\": %zu, \"ramp_sec\": %.3f, \"connects_per_sec\": %.1f },\n",
+        connected_.load(), failed_.load(), disconnected_.load(), ramp_sec, ramp_sec > 0 ? connected_.load() / ramp_sec : 0.0);
+    fprintf(file, "  \"messages\": { \"measure_sec\": %.3f, \"sent\": %llu, \"received\": %llu, \"sent_per_sec\": %.1f, \"received_per_sec\": %.1f },\n",
+        measure_sec, static_cast<unsigned long long>(sent), static_cast<unsigned long long>(received),
+        measure_sec > 0 ? sent / measure_sec : 0.0, measure_sec > 0 ? received / measure_sec : 0.0);
+    summary("connect_latency_us", connect, ",");
+    summary("rtt_us", rtt, "");
+    fprintf(file, "}\n");
+
+    if (file != stdout)
+    {
+        fclose(file);
+        printf("report written: %s\n", scenario_.report_path.c_str());
+    }
+}
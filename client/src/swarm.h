@@ -0,0 +1,70 @@
+#ifndef __SWARM_H
+#define __SWARM_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <boost/asio.hpp>
+#include "scenario.h"
+#include "../../core/src/metrics/histogram.h"
+
+class bot;
+
+// headless bot swarm against a single server
+class swarm
+{
+public:
+    explicit swarm(const scenario& s);
+    ~swarm();
+
+    // ramp up, measure for scenario.duration_sec, write the report
+    int run();
+
+    void on_connected(uint64_t latency_us);
+    void on_connect_failed(const boost::system::error_code& ec);
+    void on_disconnected();
+    void on_sent();
+    void on_received();
+    void record_rtt(uint64_t rtt_us);
+
+private:
+    // per io thread, merged after the io threads are joined
+    struct shard
+    {
+        core::histogram rtt;
+        core::histogram connect;
+        std::atomic<uint64_t> sent{ 0 };
+        std::atomic<uint64_t> received{ 0 };
+    };
+
+    shard& local();
+
+    void ramp_up();
+    void print_progress(double elapsed_sec);
+    void write_report(double ramp_sec, double measure_sec);
+
+    scenario scenario_;
+
+    boost::asio::io_service io_service_;
+    std::unique_ptr<boost::asio::io_service::work> work_;
+    std::vector<std::thread> threads_;
+    std::vector<std::shared_ptr<bot>> bots_;
+
+    std::mutex shards_m_;
+    std::vector<std::unique_ptr<shard>> shards_;
+
+    std::atomic<size_t> connected_{ 0 };
+    std::atomic<size_t> failed_{ 0 };
+    std::mutex first_failure_m_;
+    std::string first_failure_;
+    std::atomic<size_t> disconnected_{ 0 };
+    std::atomic_bool measuring_{ false };
+
+    uint64_t sent_at_measure_ = 0;
+    uint64_t received_at_measure_ = 0;
+};
+
+#endif
@@ -0,0 +1,23 @@
+#ifndef __CACHE_LINE_H
+#define __CACHE_LINE_H
+
+#include <cstddef>
+
+namespace core
+{
+    // fields written by different threads go on separate lines so they don't invalidate each other
+    static constexpr size_t cache_line_size = 64;
+
+    // rounds a small capacity up to a power of two, the rings index with a mask
+    inline size_t ring_capacity(size_t value)
+    {
+        size_t result = 2;
+        while (result < value)
+        {
+            result <<= 1;
+        }
+        return result;
+    }
+}
+
+#endif
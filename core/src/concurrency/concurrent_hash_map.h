@@ -0,0 +1,285 @@
+#ifndef __CONCURRENT_HASH_MAP_H
+#define __CONCURRENT_HASH_MAP_H
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include "cache_line.h"
+#include "epoch.h"
+
+namespace core
+{
+    // sharded hash map with lock free lookups
+    // writers lock one shard, readers never lock: they walk the chains under an epoch_guard and
+    // unlinked nodes / replaced tables are freed through epoch::retire once no reader can hold them
+    // nodes are immutable once published, an assign links a new node in place of the old one
+    // K and V must be copyable, lookups return copies
+    template <typename K, typename V, typename Hash = std::hash<K>, size_t Shards = 16>
+    class concurrent_hash_map
+    {
+        static_assert((Shards & (Shards - 1)) == 0, "shard count must be a power of two");
+
+        struct node
+        {
+            node(size_t h, const K& k, const V& v) : hash(h), key(k), value(v) {}
+
+            const size_t hash;
+            const K key;
+            const V value;
+            std::atomic<node*> next{ nullptr };
+        };
+
+        struct table
+        {
+            explicit table(size_t size) : mask(size - 1), buckets(new std::atomic<node*>[size])
+            {
+                for (size_t i = 0; i < size; ++i)
+                {
+                    buckets[i].store(nullptr, std::memory_order_relaxed);
+                }
+            }
+
+            size_t bucket_count() const { return mask + 1; }
+
+            const size_t mask;
+            std::unique_ptr<std::atomic<node*>[]> buckets;
+        };
+
+        struct alignas(cache_line_size) shard
+        {
+            std::mutex m;
+            std::atomic<table*> current{ nullptr };
+            std::atomic<size_t> size{ 0 };
+        };
+
+    public:
+        explicit concurrent_hash_map(size_t expected = 0)
+        {
+            const auto per_shard = ring_capacity(expected / Shards + 1 < 8 ? 8 : expected / Shards + 1);
+            for (auto& s : shards_)
+            {
+                s.current.store(new table(per_shard), std::memory_order_relaxed);
+            }
+        }
+
+        // no other thread may use the map any more
+        ~concurrent_hash_map()
+        {
+            for (auto& s : shards_)
+            {
+                auto t = s.current.load(std::memory_order_relaxed);
+                free_chains(t);
+                delete t;
+            }
+        }
+
+        concurrent_hash_map(const concurrent_hash_map&) = delete;
+        concurrent_hash_map& operator=(const concurrent_hash_map&) = delete;
+
+        bool find(const K& key, V& value) const
+        {
+            epoch_guard guard;
+            if (auto n = lookup(key))
+            {
+                value = n->value;
+                return true;
+            }
+            return false;
+        }
+
+        bool contains(const K& key) const
+        {
+            epoch_guard guard;
+            return lookup(key) != nullptr;
+        }
+
+        // fn(const V&) runs under the guard without copying, keep it short and don't keep references
+        template <typename Fn>
+        bool visit(const K& key, Fn&& fn) const
+        {
+            epoch_guard guard;
+            if (auto n = lookup(key))
+            {
+                fn(n->value);
+                return true;
+            }
+            return false;
+        }
+
+        // false and no change when the key is already there
+        bool insert(const K& key, const V& value)
+        {
+            return upsert(key, value, false);
+        }
+
+        // true when the key was new
+        bool insert_or_assign(const K& key, const V& value)
+        {
+            return upsert(key, value, true);
+        }
+
+        bool erase(const K& key)
+        {
+            const auto h = hash_(key);
+            auto& s = shard_of(h);
+
+            std::lock_guard<std::mutex> lock(s.m);
+            auto t = s.current.load(std::memory_order_relaxed);
+            auto link = &t->buckets[bucket_of(t, h)];
+
+            for (auto n = link->load(std::memory_order_relaxed); n != nullptr; n = link->load(std::memory_order_relaxed))
+            {
+                if (n->hash == h && n->key == key)
+                {
+                    link->store(n->next.load(std::memory_order_relaxed), std::memory_order_release);
+                    s.size.fetch_sub(1, std::memory_order_relaxed);
+                    epoch::retire(n);
+                    return true;
+                }
+                link = &n->next;
+            }
+            return false;
+        }
+
+        // fn(const K&, const V&) for every entry, shard by shard, entries added meanwhile may be missed
+        template <typename Fn>
+        void for_each(Fn&& fn) const
+        {
+            epoch_guard guard;
+            for (auto& s : shards_)
+            {
+                auto t = s.current.load(std::memory_order_acquire);
+                for (size_t i = 0; i < t->bucket_count(); ++i)
+                {
+                    for (auto n = t->buckets[i].load(std::memory_order_acquire); n != nullptr; n = n->next.load(std::memory_order_acquire))
+                    {
+                        fn(n->key, n->value);
+                    }
+                }
+            }
+        }
+
+        size_t size() const
+        {
+            size_t total = 0;
+            for (auto& s : shards_)
+            {
+                total += s.size.load(std::memory_order_relaxed);
+            }
+            return total;
+        }
+
+        bool empty() const { return size() == 0; }
+
+    private:
+        static constexpr size_t log2(size_t n)
+        {
+            return n <= 1 ? 0 : 1 + log2(n / 2);
+        }
+
+        // low bits pick the shard, the rest pick the bucket, so a shard's buckets are evenly used
+        shard& shard_of(size_t h) { return shards_[h & (Shards - 1)]; }
+        const shard& shard_of(size_t h) const { return shards_[h & (Shards - 1)]; }
+        static size_t bucket_of(const table* t, size_t h) { return (h >> log2(Shards)) & t->mask; }
+
+        // caller holds an epoch_guard
+        const node* lookup(const K& key) const
+        {
+            const auto h = hash_(key);
+            auto t = shard_of(h).current.load(std::memory_order_acquire);
+
+            for (auto n = t->buckets[bucket_of(t, h)].load(std::memory_order_acquire); n != nullptr; n = n->next.load(std::memory_order_acquire))
+            {
+                if (n->hash == h && n->key == key)
+                {
+                    return n;
+                }
+            }
+            return nullptr;
+        }
+
+        bool upsert(const K& key, const V& value, bool assign)
+        {
+            const auto h = hash_(key);
+            auto& s = shard_of(h);
+
+            std::lock_guard<std::mutex> lock(s.m);
+            auto t = s.current.load(std::memory_order_relaxed);
+            auto& bucket = t->buckets[bucket_of(t, h)];
+
+            auto link = &bucket;
+            for (auto n = link->load(std::memory_order_relaxed); n != nullptr; n = link->load(std::memory_order_relaxed))
+            {
+                if (n->hash == h && n->key == key)
+                {
+                    if (assign)
+                    {
+                        // readers already on n carry on to n->next
+                        auto replacement = new node(h, key, value);
+                        replacement->next.store(n->next.load(std::memory_order_relaxed), std::memory_order_relaxed);
+                        link->store(replacement, std::memory_order_release);
+                        epoch::retire(n);
+                    }
+                    return false;
+                }
+                link = &n->next;
+            }
+
+            auto n = new node(h, key, value);
+            n->next.store(bucket.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            bucket.store(n, std::memory_order_release);
+
+            if (s.size.fetch_add(1, std::memory_order_relaxed) + 1 > t->bucket_count() * 2)
+            {
+                grow(s, t);
+            }
+            return true;
+        }
+
+        // called with the shard locked; readers still walking the old table keep seeing its (old) nodes
+        void grow(shard& s, table* old)
+        {
+            auto bigger = new table(old->bucket_count() * 2);
+            for (size_t i = 0; i < old->bucket_count(); ++i)
+            {
+                for (auto n = old->buckets[i].load(std::memory_order_relaxed); n != nullptr; n = n->next.load(std::memory_order_relaxed))
+                {
+                    auto copy = new node(n->hash, n->key, n->value);
+                    auto& bucket = bigger->buckets[bucket_of(bigger, n->hash)];
+                    copy->next.store(bucket.load(std::memory_order_relaxed), std::memory_order_relaxed);
+                    bucket.store(copy, std::memory_order_relaxed);
+                }
+            }
+
+            s.current.store(bigger, std::memory_order_release);
+            epoch::retire(old, [](void* p)
+            {
+                auto t = static_cast<table*>(p);
+                free_chains(t);
+                delete t;
+            });
+        }
+
+        static void free_chains(table* t)
+        {
+            for (size_t i = 0; i < t->bucket_count(); ++i)
+            {
+                auto n = t->buckets[i].load(std::memory_order_relaxed);
+                while (n != nullptr)
+                {
+                    auto next = n->next.load(std::memory_order_relaxed);
+                    delete n;
+                    n = next;
+                }
+            }
+        }
+
+        Hash hash_;
+        shard shards_[Shards];
+    };
+}
+
+#endif
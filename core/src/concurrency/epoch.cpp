@@ -0,0 +1,172 @@
+#include "epoch.h"
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace core
+{
+    namespace epoch
+    {
+        namespace
+        {
+            // retired nodes a thread holds before it tries to advance the epoch
+            constexpr size_t collect_threshold = 64;
+
+            struct retired
+            {
+                void* p;
+                void (*deleter)(void*);
+                uint64_t epoch;
+            };
+
+            struct participant
+            {
+                // 0 while quiescent, otherwise the epoch this thread pinned
+                std::atomic<uint64_t> local{ 0 };
+                std::atomic<bool> in_use{ true };
+                size_t nesting = 0;
+                size_t since_collect = 0;
+                std::vector<retired> limbo;
+                participant* next = nullptr;
+            };
+
+            std::atomic<uint64_t> global_epoch{ 1 };
+            std::atomic<participant*> participants{ nullptr };
+            std::atomic<size_t> pending_count{ 0 };
+
+            // records are never freed, a thread reuses one left behind by an exited thread along with its limbo list
+            participant* acquire()
+            {
+                for (auto p = participants.load(std::memory_order_acquire); p != nullptr; p = p->next)
+                {
+                    auto expected = false;
+                    if (!p->in_use.load(std::memory_order_relaxed) && p->in_use.compare_exchange_strong(expected, true, std::memory_order_acquire))
+                    {
+                        return p;
+                    }
+                }
+
+                auto p = new participant;
+                auto head = participants.load(std::memory_order_relaxed);
+                do
+                {
+                    p->next = head;
+                } while (!participants.compare_exchange_weak(head, p, std::memory_order_release, std::memory_order_relaxed));
+                return p;
+            }
+
+            struct thread_record
+            {
+                participant* p = acquire();
+                ~thread_record() { p->in_use.store(false, std::memory_order_release); }
+            };
+
+            participant& self()
+            {
+                static thread_local thread_record record;
+                return *record.p;
+            }
+
+            // every pinned thread has seen e, so nothing can still reach a node retired before e - 1
+            void try_advance(uint64_t e)
+            {
+                for (auto p = participants.load(std::memory_order_acquire); p != nullptr; p = p->next)
+                {
+                    const auto local = p->local.load(std::memory_order_seq_cst);
+                    if (local != 0 && local != e)
+                    {
+                        return;
+                    }
+                }
+
+                global_epoch.compare_exchange_strong(e, e + 1, std::memory_order_seq_cst);
+            }
+
+            void free_old(participant& s)
+            {
+                const auto e = global_epoch.load(std::memory_order_seq_cst);
+
+                // a deleter may retire more nodes, work on a private list
+                std::vector<retired> limbo;
+                limbo.swap(s.limbo);
+
+                size_t kept = 0;
+                for (auto& r : limbo)
+                {
+                    if (r.epoch + 2 <= e)
+                    {
+                        r.deleter(r.p);
+                    }
+                    else
+                    {
+                        limbo[kept++] = r;
+                    }
+                }
+
+                pending_count.fetch_sub(limbo.size() - kept, std::memory_order_relaxed);
+                limbo.resize(kept);
+                limbo.insert(limbo.end(), s.limbo.begin(), s.limbo.end());
+                s.limbo.swap(limbo);
+            }
+        }
+
+        void pin()
+        {
+            auto& s = self();
+            if (s.nesting++ != 0)
+            {
+                return;
+            }
+
+            // published before any shared pointer is read, and not behind an epoch that already moved on
+            auto e = global_epoch.load(std::memory_order_relaxed);
+            for (;;)
+            {
+                s.local.store(e, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+
+                const auto now = global_epoch.load(std::memory_order_relaxed);
+                if (now == e)
+                {
+                    return;
+                }
+                e = now;
+            }
+        }
+
+        void unpin()
+        {
+            auto& s = self();
+            if (--s.nesting == 0)
+            {
+                s.local.store(0, std::memory_order_release);
+            }
+        }
+
+        void retire(void* p, void (*deleter)(void*))
+        {
+            auto& s = self();
+            s.limbo.push_back({ p, deleter, global_epoch.load(std::memory_order_seq_cst) });
+            pending_count.fetch_add(1, std::memory_order_relaxed);
+
+            // a long pinned reader keeps the list growing, don't rescan it on every retire
+            if (++s.since_collect >= collect_threshold)
+            {
+                s.since_collect = 0;
+                collect();
+            }
+        }
+
+        void collect()
+        {
+            auto& s = self();
+            try_advance(global_epoch.load(std::memory_order_seq_cst));
+            free_old(s);
+        }
+
+        size_t pending()
+        {
+            return pending_count.load(std::memory_order_relaxed);
+        }
+    }
+}
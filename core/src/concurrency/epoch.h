@@ -0,0 +1,48 @@
+#ifndef __EPOCH_H
+#define __EPOCH_H
+
+#include <cstddef>
+
+namespace core
+{
+    // epoch based reclamation for lock free readers
+    // a reader pins the current epoch for as long as it may hold pointers into a shared structure,
+    // a writer unlinks a node and retires it, and the node is freed once every pinned thread has moved
+    // past the epoch it was retired in
+    //   {
+    //       core::epoch_guard guard;
+    //       auto n = bucket.load(std::memory_order_acquire);   // n stays valid until guard goes
+    //   }
+    namespace epoch
+    {
+        void pin();
+        void unpin();
+
+        // deleter(p) runs on some thread that calls retire() or collect() later, never while p may be read
+        void retire(void* p, void (*deleter)(void*));
+
+        template <typename T>
+        void retire(T* p)
+        {
+            retire(p, [](void* x) { delete static_cast<T*>(x); });
+        }
+
+        // tries to advance the epoch and frees this thread's retired nodes that are old enough
+        void collect();
+
+        // nodes retired and not freed yet, by all threads
+        size_t pending();
+    }
+
+    class epoch_guard
+    {
+    public:
+        epoch_guard() { epoch::pin(); }
+        ~epoch_guard() { epoch::unpin(); }
+
+        epoch_guard(const epoch_guard&) = delete;
+        epoch_guard& operator=(const epoch_guard&) = delete;
+    };
+}
+
+#endif
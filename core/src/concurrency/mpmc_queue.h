@@ -0,0 +1,195 @@
+#ifndef __MPMC_QUEUE_H
+#define __MPMC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <utility>
+#include "cache_line.h"
+
+namespace core
+{
+    // bounded lock free multi producer / multi consumer queue (Vyukov), capacity rounded up to a power of two
+    // every cell carries a sequence number: pos when free for the producer of pos, pos + 1 once filled
+    template <typename T>
+    class mpmc_queue
+    {
+    public:
+        explicit mpmc_queue(size_t capacity) : capacity_(ring_capacity(capacity)), mask_(capacity_ - 1), cells_(new cell[capacity_])
+        {
+            for (size_t i = 0; i < capacity_; ++i)
+            {
+                cells_[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        mpmc_queue(const mpmc_queue&) = delete;
+        mpmc_queue& operator=(const mpmc_queue&) = delete;
+
+        size_t capacity() const { return capacity_; }
+
+        // any thread, false when full
+        bool try_push(T value)
+        {
+            auto pos = head_.load(std::memory_order_relaxed);
+            for (;;)
+            {
+                auto& c = cells_[pos & mask_];
+                const auto sequence = c.sequence.load(std::memory_order_acquire);
+                const auto diff = static_cast<std::ptrdiff_t>(sequence - pos);
+
+                if (diff == 0)
+                {
+                    if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    {
+                        c.value = std::move(value);
+                        c.sequence.store(pos + 1, std::memory_order_release);
+                        return true;
+                    }
+                }
+                else if (diff < 0)
+                {
+                    return false;
+                }
+                else
+                {
+                    pos = head_.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        // any thread, claims a run of free cells with one cas, returns how many of [first, last) went in
+        template <typename It>
+        size_t push_batch(It first, It last)
+        {
+            const auto wanted = static_cast<size_t>(std::distance(first, last));
+            auto pos = head_.load(std::memory_order_relaxed);
+
+            for (;;)
+            {
+                size_t count = 0;
+                while (count < wanted && cells_[(pos + count) & mask_].sequence.load(std::memory_order_acquire) == pos + count)
+                {
+                    ++count;
+                }
+
+                if (count == 0)
+                {
+                    const auto sequence = cells_[pos & mask_].sequence.load(std::memory_order_acquire);
+                    if (static_cast<std::ptrdiff_t>(sequence - pos) < 0)
+                    {
+                        return 0;
+                    }
+                    pos = head_.load(std::memory_order_relaxed);
+                    continue;
+                }
+
+                if (head_.compare_exchange_weak(pos, pos + count, std::memory_order_relaxed))
+                {
+                    for (size_t i = 0; i < count; ++i, ++first)
+                    {
+                        auto& c = cells_[(pos + i) & mask_];
+                        c.value = std::move(*first);
+                        c.sequence.store(pos + i + 1, std::memory_order_release);
+                    }
+                    return count;
+                }
+            }
+        }
+
+        // any thread, false when empty
+        bool try_pop(T& value)
+        {
+            auto pos = tail_.load(std::memory_order_relaxed);
+            for (;;)
+            {
+                auto& c = cells_[pos & mask_];
+                const auto sequence = c.sequence.load(std::memory_order_acquire);
+                const auto diff = static_cast<std::ptrdiff_t>(sequence - (pos + 1));
+
+                if (diff == 0)
+                {
+                    if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    {
+                        value = std::move(c.value);
+                        c.sequence.store(pos + capacity_, std::memory_order_release);
+                        return true;
+                    }
+                }
+                else if (diff < 0)
+                {
+                    return false;
+                }
+                else
+                {
+                    pos = tail_.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        // any thread, claims a run of filled cells with one cas, up to max values
+        template <typename Out>
+        size_t pop_batch(Out out, size_t max)
+        {
+            auto pos = tail_.load(std::memory_order_relaxed);
+
+            for (;;)
+            {
+                size_t count = 0;
+                while (count < max && cells_[(pos + count) & mask_].sequence.load(std::memory_order_acquire) == pos + count + 1)
+                {
+                    ++count;
+                }
+
+                if (count == 0)
+                {
+                    const auto sequence = cells_[pos & mask_].sequence.load(std::memory_order_acquire);
+                    if (static_cast<std::ptrdiff_t>(sequence - (pos + 1)) < 0)
+                    {
+                        return 0;
+                    }
+                    pos = tail_.load(std::memory_order_relaxed);
+                    continue;
+                }
+
+                if (tail_.compare_exchange_weak(pos, pos + count, std::memory_order_relaxed))
+                {
+                    for (size_t i = 0; i < count; ++i)
+                    {
+                        auto& c = cells_[(pos + i) & mask_];
+                        *out++ = std::move(c.value);
+                        c.sequence.store(pos + i + capacity_, std::memory_order_release);
+                    }
+                    return count;
+                }
+            }
+        }
+
+        // approximate
+        size_t size() const
+        {
+            const auto tail = tail_.load(std::memory_order_acquire);
+            const auto head = head_.load(std::memory_order_acquire);
+            return head > tail ? head - tail : 0;
+        }
+
+        bool empty() const { return size() == 0; }
+
+    protected:
+        struct cell
+        {
+            std::atomic<size_t> sequence;
+            T value;
+        };
+
+        const size_t capacity_;
+        const size_t mask_;
+        std::unique_ptr<cell[]> cells_;
+
+        alignas(cache_line_size) std::atomic<size_t> head_{ 0 };
+        alignas(cache_line_size) std::atomic<size_t> tail_{ 0 };
+    };
+}
+
+#endif
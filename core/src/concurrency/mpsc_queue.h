@@ -0,0 +1,147 @@
+#ifndef __MPSC_QUEUE_H
+#define __MPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include "cache_line.h"
+
+namespace core
+{
+    // unbounded lock free multi producer / single consumer queue (Vyukov)
+    // push() may be called from any thread, pop() only from the owning consumer
+    template <typename T>
+    class mpsc_queue
+    {
+        struct node
+        {
+            node() = default;
+            explicit node(T&& v) : value(std::move(v)) {}
+
+            std::atomic<node*> next{ nullptr };
+            T value;
+        };
+
+    public:
+        mpsc_queue() : head_(&stub_), tail_(&stub_)
+        {
+        }
+
+        ~mpsc_queue()
+        {
+            T value;
+            while (pop(value))
+            {
+            }
+        }
+
+        mpsc_queue(const mpsc_queue&) = delete;
+        mpsc_queue& operator=(const mpsc_queue&) = delete;
+
+        void push(T value)
+        {
+            push_node(new node(std::move(value)));
+        }
+
+        // links [first, last) privately and publishes them with one exchange
+        template <typename It>
+        void push_batch(It first, It last)
+        {
+            if (first == last)
+            {
+                return;
+            }
+
+            auto head = new node(T(std::move(*first)));
+            auto tail = head;
+            for (++first; first != last; ++first)
+            {
+                auto n = new node(T(std::move(*first)));
+                tail->next.store(n, std::memory_order_relaxed);
+                tail = n;
+            }
+
+            auto prev = head_.exchange(tail, std::memory_order_acq_rel);
+            prev->next.store(head, std::memory_order_release);
+        }
+
+        bool pop(T& value)
+        {
+            auto tail = tail_;
+            auto next = tail->next.load(std::memory_order_acquire);
+
+            if (tail == &stub_)
+            {
+                if (next == nullptr)
+                {
+                    return false;
+                }
+
+                tail_ = next;
+                tail = next;
+                next = next->next.load(std::memory_order_acquire);
+            }
+
+            if (next != nullptr)
+            {
+                tail_ = next;
+                value = std::move(tail->value);
+                delete tail;
+                return true;
+            }
+
+            // a producer is between exchange and link, try again later
+            if (tail != head_.load(std::memory_order_acquire))
+            {
+                return false;
+            }
+
+            push_node(&stub_);
+
+            next = tail->next.load(std::memory_order_acquire);
+            if (next != nullptr)
+            {
+                tail_ = next;
+                value = std::move(tail->value);
+                delete tail;
+                return true;
+            }
+
+            return false;
+        }
+
+        // up to max values, stops early at a producer that is between exchange and link
+        template <typename Out>
+        size_t pop_batch(Out out, size_t max)
+        {
+            size_t count = 0;
+            T value;
+            while (count < max && pop(value))
+            {
+                *out++ = std::move(value);
+                ++count;
+            }
+            return count;
+        }
+
+        // consumer side only
+        bool empty() const
+        {
+            return tail_ == &stub_ && stub_.next.load(std::memory_order_acquire) == nullptr;
+        }
+
+    private:
+        void push_node(node* n)
+        {
+            n->next.store(nullptr, std::memory_order_relaxed);
+            auto prev = head_.exchange(n, std::memory_order_acq_rel);
+            prev->next.store(n, std::memory_order_release);
+        }
+
+        alignas(cache_line_size) std::atomic<node*> head_;
+        alignas(cache_line_size) node* tail_;
+        node stub_;
+    };
+}
+
+#endif
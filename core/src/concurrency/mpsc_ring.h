@@ -0,0 +1,65 @@
+#ifndef __MPSC_RING_H
+#define __MPSC_RING_H
+
+#include "mpmc_queue.h"
+
+namespace core
+{
+    // bounded multi producer / single consumer queue, the producer side of mpmc_queue
+    // with a consumer that owns the tail and never has to cas it
+    template <typename T>
+    class mpsc_ring : private mpmc_queue<T>
+    {
+        using base = mpmc_queue<T>;
+
+    public:
+        explicit mpsc_ring(size_t capacity) : base(capacity) {}
+
+        using base::capacity;
+        using base::try_push;
+        using base::push_batch;
+        using base::size;
+        using base::empty;
+
+        // consumer only, false when empty
+        bool try_pop(T& value)
+        {
+            const auto pos = this->tail_.load(std::memory_order_relaxed);
+            auto& c = this->cells_[pos & this->mask_];
+            if (c.sequence.load(std::memory_order_acquire) != pos + 1)
+            {
+                return false;
+            }
+
+            value = std::move(c.value);
+            c.sequence.store(pos + this->capacity_, std::memory_order_release);
+            this->tail_.store(pos + 1, std::memory_order_relaxed);
+            return true;
+        }
+
+        // consumer only, up to max values, stops at the first cell a producer has not filled yet
+        template <typename Out>
+        size_t pop_batch(Out out, size_t max)
+        {
+            const auto pos = this->tail_.load(std::memory_order_relaxed);
+
+            size_t count = 0;
+            for (; count < max; ++count)
+            {
+                auto& c = this->cells_[(pos + count) & this->mask_];
+                if (c.sequence.load(std::memory_order_acquire) != pos + count + 1)
+                {
+                    break;
+                }
+
+                *out++ = std::move(c.value);
+                c.sequence.store(pos + count + this->capacity_, std::memory_order_release);
+            }
+
+            this->tail_.store(pos + count, std::memory_order_relaxed);
+            return count;
+        }
+    };
+}
+
+#endif
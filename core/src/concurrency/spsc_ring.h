@@ -0,0 +1,133 @@
+#ifndef __SPSC_RING_H
+#define __SPSC_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <utility>
+#include "cache_line.h"
+
+namespace core
+{
+    // bounded single producer / single consumer ring, capacity rounded up to a power of two
+    // each side caches the other's index and only rereads it when the ring looks full / empty
+    template <typename T>
+    class spsc_ring
+    {
+    public:
+        explicit spsc_ring(size_t capacity) : capacity_(ring_capacity(capacity)), mask_(capacity_ - 1), slots_(new T[capacity_]) {}
+
+        spsc_ring(const spsc_ring&) = delete;
+        spsc_ring& operator=(const spsc_ring&) = delete;
+
+        size_t capacity() const { return capacity_; }
+
+        // producer, false when full
+        bool try_push(T value)
+        {
+            const auto head = head_.load(std::memory_order_relaxed);
+            if (head - cached_tail_ == capacity_)
+            {
+                cached_tail_ = tail_.load(std::memory_order_acquire);
+                if (head - cached_tail_ == capacity_)
+                {
+                    return false;
+                }
+            }
+
+            slots_[head & mask_] = std::move(value);
+            head_.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+        // producer, moves as many of [first, last) as fit and publishes them once, returns the count
+        template <typename It>
+        size_t push_batch(It first, It last)
+        {
+            const auto head = head_.load(std::memory_order_relaxed);
+            const auto wanted = static_cast<size_t>(std::distance(first, last));
+            if (capacity_ - (head - cached_tail_) < wanted)
+            {
+                cached_tail_ = tail_.load(std::memory_order_acquire);
+            }
+
+            const auto free_slots = capacity_ - (head - cached_tail_);
+            const auto count = wanted < free_slots ? wanted : free_slots;
+            for (size_t i = 0; i < count; ++i, ++first)
+            {
+                slots_[(head + i) & mask_] = std::move(*first);
+            }
+
+            if (count != 0)
+            {
+                head_.store(head + count, std::memory_order_release);
+            }
+            return count;
+        }
+
+        // consumer, false when empty
+        bool try_pop(T& value)
+        {
+            const auto tail = tail_.load(std::memory_order_relaxed);
+            if (tail == cached_head_)
+            {
+                cached_head_ = head_.load(std::memory_order_acquire);
+                if (tail == cached_head_)
+                {
+                    return false;
+                }
+            }
+
+            value = std::move(slots_[tail & mask_]);
+            tail_.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        // consumer, up to max values, frees their slots once
+        template <typename Out>
+        size_t pop_batch(Out out, size_t max)
+        {
+            const auto tail = tail_.load(std::memory_order_relaxed);
+            if (cached_head_ - tail < max)
+            {
+                cached_head_ = head_.load(std::memory_order_acquire);
+            }
+
+            const auto available = cached_head_ - tail;
+            const auto count = max < available ? max : available;
+            for (size_t i = 0; i < count; ++i)
+            {
+                *out++ = std::move(slots_[(tail + i) & mask_]);
+            }
+
+            if (count != 0)
+            {
+                tail_.store(tail + count, std::memory_order_release);
+            }
+            return count;
+        }
+
+        // approximate from any other thread
+        size_t size() const
+        {
+            const auto tail = tail_.load(std::memory_order_acquire);
+            return head_.load(std::memory_order_acquire) - tail;
+        }
+
+        bool empty() const { return size() == 0; }
+
+    private:
+        const size_t capacity_;
+        const size_t mask_;
+        std::unique_ptr<T[]> slots_;
+
+        alignas(cache_line_size) std::atomic<size_t> head_{ 0 };
+        size_t cached_tail_ = 0;
+
+        alignas(cache_line_size) std::atomic<size_t> tail_{ 0 };
+        size_t cached_head_ = 0;
+    };
+}
+
+#endif
@@ -0,0 +1,213 @@
+#include "mapped_file.h"
+
+#ifndef __linux__
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace core
+{
+    mapped_file::~mapped_file()
+    {
+        close();
+    }
+
+#ifndef __linux__
+
+    bool mapped_file::create(const std::string& path, size_t size)
+    {
+        close();
+
+        file_ = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file_ == INVALID_HANDLE_VALUE)
+        {
+            file_ = nullptr;
+            return false;
+        }
+
+        const auto high = static_cast<DWORD>(static_cast<unsigned long long>(size) >> 32);
+        const auto low = static_cast<DWORD>(size & 0xffffffff);
+
+        mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READWRITE, high, low, nullptr);
+        if (mapping_ == nullptr)
+        {
+            close();
+            return false;
+        }
+
+        data_ = static_cast<char*>(MapViewOfFile(mapping_, FILE_MAP_WRITE, 0, 0, size));
+        if (data_ == nullptr)
+        {
+            close();
+            return false;
+        }
+
+        size_ = size;
+        writable_ = true;
+        return true;
+    }
+
+    bool mapped_file::open_read(const std::string& path)
+    {
+        close();
+
+        file_ = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file_ == INVALID_HANDLE_VALUE)
+        {
+            file_ = nullptr;
+            return false;
+        }
+
+        LARGE_INTEGER file_size;
+        if (!GetFileSizeEx(file_, &file_size) || file_size.QuadPart == 0)
+        {
+            close();
+            return false;
+        }
+
+        mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping_ == nullptr)
+        {
+            close();
+            return false;
+        }
+
+        data_ = static_cast<char*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+        if (data_ == nullptr)
+        {
+            close();
+            return false;
+        }
+
+        size_ = static_cast<size_t>(file_size.QuadPart);
+        writable_ = false;
+        return true;
+    }
+
+    void mapped_file::close(size_t truncate_to)
+    {
+        if (data_)
+        {
+            if (writable_)
+            {
+                FlushViewOfFile(data_, 0);
+            }
+            UnmapViewOfFile(data_);
+        }
+
+        if (mapping_)
+        {
+            CloseHandle(mapping_);
+        }
+
+        if (file_)
+        {
+            if (writable_ && truncate_to < size_)
+            {
+                LARGE_INTEGER end;
+                end.QuadPart = static_cast<long long>(truncate_to);
+                SetFilePointerEx(file_, end, nullptr, FILE_BEGIN);
+                SetEndOfFile(file_);
+            }
+            CloseHandle(file_);
+        }
+
+        data_ = nullptr;
+        mapping_ = nullptr;
+        file_ = nullptr;
+        size_ = 0;
+        writable_ = false;
+    }
+
+#else
+
+    bool mapped_file::create(const std::string& path, size_t size)
+    {
+        close();
+
+        fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd_ < 0)
+        {
+            return false;
+        }
+
+        if (::ftruncate(fd_, static_cast<off_t>(size)) != 0)
+        {
+            close();
+            return false;
+        }
+
+        auto data = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+        if (data == MAP_FAILED)
+        {
+            close();
+            return false;
+        }
+
+        data_ = static_cast<char*>(data);
+        size_ = size;
+        writable_ = true;
+        return true;
+    }
+
+    bool mapped_file::open_read(const std::string& path)
+    {
+        close();
+
+        fd_ = ::open(path.c_str(), O_RDONLY);
+        if (fd_ < 0)
+        {
+            return false;
+        }
+
+        struct stat st;
+        if (::fstat(fd_, &st) != 0 || st.st_size == 0)
+        {
+            close();
+            return false;
+        }
+
+        auto data = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd_, 0);
+        if (data == MAP_FAILED)
+        {
+            close();
+            return false;
+        }
+
+        data_ = static_cast<char*>(data);
+        size_ = static_cast<size_t>(st.st_size);
+        writable_ = false;
+        return true;
+    }
+
+    void mapped_file::close(size_t truncate_to)
+    {
+        if (data_)
+        {
+            ::munmap(data_, size_);
+        }
+
+        if (fd_ >= 0)
+        {
+            if (writable_ && truncate_to < size_)
+            {
+                if (::ftruncate(fd_, static_cast<off_t>(truncate_to)) != 0)
+                {
+                    // keeps the zero filled tail, readers stop at the first empty record
+                }
+            }
+            ::close(fd_);
+        }
+
+        data_ = nullptr;
+        fd_ = -1;
+        size_ = 0;
+        writable_ = false;
+    }
+
+#endif
+}
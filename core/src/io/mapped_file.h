@@ -0,0 +1,44 @@
+#ifndef __MAPPED_FILE_H
+#define __MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+
+namespace core
+{
+    // whole file mapping, read only or a fixed size writable file
+    class mapped_file
+    {
+    public:
+        mapped_file() = default;
+        ~mapped_file();
+
+        mapped_file(const mapped_file&) = delete;
+        mapped_file& operator=(const mapped_file&) = delete;
+
+        // creates or truncates path to size bytes
+        bool create(const std::string& path, size_t size);
+        bool open_read(const std::string& path);
+
+        // truncate_to < size() shrinks the file on disk after unmapping
+        void close(size_t truncate_to = static_cast<size_t>(-1));
+
+        bool is_open() const { return data_ != nullptr; }
+        char* data() const { return data_; }
+        size_t size() const { return size_; }
+
+    private:
+        char* data_ = nullptr;
+        size_t size_ = 0;
+        bool writable_ = false;
+
+#ifndef __linux__
+        void* file_ = nullptr;
+        void* mapping_ = nullptr;
+#else
+        int fd_ = -1;
+#endif
+    };
+}
+
+#endif
@@ -0,0 +1,296 @@
+#include "job_system.h"
+#include <algorithm>
+
+namespace core
+{
+    namespace
+    {
+        constexpr size_t not_worker = static_cast<size_t>(-1);
+
+        thread_local job_system* current_system = nullptr;
+        thread_local size_t current_worker = not_worker;
+        thread_local unsigned int steal_seed = 0;
+    }
+
+    job_system& job_system::instance()
+    {
+        static job_system system;
+        return system;
+    }
+
+    void job_system::start(size_t thread_count)
+    {
+        stop_ = false;
+
+        workers_.reserve(thread_count);
+        for (size_t i = 0; i < thread_count; ++i)
+        {
+            workers_.emplace_back(std::make_unique<worker>());
+        }
+
+        for (size_t i = 0; i < thread_count; ++i)
+        {
+            workers_[i]->thread = std::thread([this, i] { run(i); });
+        }
+    }
+
+    void job_system::stop()
+    {
+        stop_ = true;
+
+        {
+            std::lock_guard<std::mutex> lock(sleep_m_);
+        }
+        sleep_cv_.notify_all();
+
+        for (auto& w : workers_)
+        {
+            w->thread.join();
+        }
+
+        workers_.clear();
+    }
+
+    job_ptr job_system::create(job::function fn)
+    {
+        return std::allocate_shared<job>(pool_allocator<job>(), std::move(fn));
+    }
+
+    job_ptr job_system::create_child(const job_ptr& parent, job::function fn)
+    {
+        auto j = create(std::move(fn));
+        j->parent_ = parent;
+        parent->unfinished_.fetch_add(1, std::memory_order_relaxed);
+        return j;
+    }
+
+    void job_system::add_dependency(const job_ptr& before, const job_ptr& after)
+    {
+        std::lock_guard<std::mutex> lock(before->m_);
+        if (before->finished())
+        {
+            return;
+        }
+
+        after->pending_.fetch_add(1, std::memory_order_relaxed);
+        if (!before->successor_)
+        {
+            before->successor_ = after;
+        }
+        else
+        {
+            before->successors_.emplace_back(after);
+        }
+    }
+
+    job_ptr job_system::then(const job_ptr& before, job::function fn)
+    {
+        auto j = create(std::move(fn));
+        add_dependency(before, j);
+        submit(j);
+        return j;
+    }
+
+    void job_system::submit(const job_ptr& j)
+    {
+        j->self_ = j;
+
+        if (j->pending_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            enqueue(j.get());
+        }
+    }
+
+    void job_system::wait(const job_ptr& j)
+    {
+        while (!j->finished())
+        {
+            if (!try_run_one())
+            {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    void job_system::parallel_for(size_t begin, size_t end, size_t grain, const std::function<void(size_t, size_t)>& fn)
+    {
+        if (begin >= end)
+        {
+            return;
+        }
+
+        grain = (std::max)(grain, size_t(1));
+
+        auto root = create([] {});
+        for (auto first = begin; first < end; first += grain)
+        {
+            auto last = (std::min)(first + grain, end);
+            submit(create_child(root, [&fn, first, last] { fn(first, last); }));
+        }
+
+        submit(root);
+        wait(root);
+    }
+
+    void job_system::run(size_t index)
+    {
+        current_system = this;
+        current_worker = index;
+        steal_seed = static_cast<unsigned int>(index * 2654435761u + 1);
+
+        static constexpr int spin_count = 64;
+
+        while (!stop_)
+        {
+            if (try_run_one())
+            {
+                continue;
+            }
+
+            auto found = false;
+            for (auto i = 0; i < spin_count && !found; ++i)
+            {
+                std::this_thread::yield();
+                found = try_run_one();
+            }
+
+            if (found)
+            {
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(sleep_m_);
+            sleepers_.fetch_add(1, std::memory_order_seq_cst);
+            sleep_cv_.wait_for(lock, std::chrono::milliseconds(1));
+            sleepers_.fetch_sub(1, std::memory_order_relaxed);
+        }
+
+        current_system = nullptr;
+        current_worker = not_worker;
+    }
+
+    void job_system::enqueue(job* j)
+    {
+        if (current_system == this && current_worker != not_worker)
+        {
+            workers_[current_worker]->deque.push(j);
+        }
+        else if (!injection_.try_push(j))
+        {
+            std::lock_guard<std::mutex> lock(overflow_m_);
+            overflow_.push_back(j);
+            overflow_size_.fetch_add(1, std::memory_order_release);
+        }
+
+        if (sleepers_.load(std::memory_order_seq_cst) > 0)
+        {
+            sleep_cv_.notify_one();
+        }
+    }
+
+    bool job_system::try_run_one()
+    {
+        auto j = find_job();
+        if (j == nullptr)
+        {
+            return false;
+        }
+
+        execute(j);
+        return true;
+    }
+
+    job* job_system::find_job()
+    {
+        job* j = nullptr;
+        auto self = (current_system == this) ? current_worker : not_worker;
+
+        if (self != not_worker && workers_[self]->deque.pop(j))
+        {
+            return j;
+        }
+
+        if (injection_.try_pop(j))
+        {
+            return j;
+        }
+
+        if (overflow_size_.load(std::memory_order_acquire) != 0)
+        {
+            std::lock_guard<std::mutex> lock(overflow_m_);
+            if (!overflow_.empty())
+            {
+                j = overflow_.front();
+                overflow_.pop_front();
+                overflow_size_.fetch_sub(1, std::memory_order_relaxed);
+                return j;
+            }
+        }
+
+        const auto count = workers_.size();
+        if (count == 0)
+        {
+            return nullptr;
+        }
+
+        steal_seed = steal_seed * 1103515245u + 12345u;
+        auto start = static_cast<size_t>(steal_seed >> 8) % count;
+        for (size_t i = 0; i < count; ++i)
+        {
+            auto victim = (start + i) % count;
+            if (victim != self && workers_[victim]->deque.steal(j))
+            {
+                return j;
+            }
+        }
+
+        return nullptr;
+    }
+
+    void job_system::execute(job* j)
+    {
+        j->fn_();
+        j->fn_ = nullptr;
+        finish(j);
+    }
+
+    void job_system::finish(job* j)
+    {
+        if (j->unfinished_.fetch_sub(1, std::memory_order_acq_rel) != 1)
+        {
+            return;
+        }
+
+        job_ptr successor;
+        std::vector<job_ptr> successors;
+        {
+            std::lock_guard<std::mutex> lock(j->m_);
+            j->finished_.store(true, std::memory_order_release);
+            successor = std::move(j->successor_);
+            successors.swap(j->successors_);
+        }
+
+        if (successor && successor->pending_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            enqueue(successor.get());
+        }
+
+        for (auto& s : successors)
+        {
+            if (s->pending_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            {
+                enqueue(s.get());
+            }
+        }
+
+        auto parent = std::move(j->parent_);
+
+        // last reference may be this one
+        auto self = std::move(j->self_);
+
+        if (parent)
+        {
+            finish(parent.get());
+        }
+    }
+}
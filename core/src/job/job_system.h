@@ -0,0 +1,263 @@
+#ifndef __JOB_SYSTEM_H
+#define __JOB_SYSTEM_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "work_stealing_deque.h"
+#include "../concurrency/mpmc_queue.h"
+#include "../memory/object_pool.h"
+
+namespace core
+{
+    class job_system;
+
+    class job
+    {
+    public:
+        // move only void() callable, closures up to inline_size live in the job node,
+        // bigger ones in a block from the shared size class pools
+        class function
+        {
+        public:
+            static constexpr size_t inline_size = 48;
+
+            function() = default;
+            function(std::nullptr_t) {}
+
+            template <typename F, typename = std::enable_if_t<!std::is_same<std::decay_t<F>, function>::value>>
+            function(F&& f)
+            {
+                using target = std::decay_t<F>;
+                emplace<target>(std::forward<F>(f), std::integral_constant<bool, fits_inline<target>()>());
+            }
+
+            function(function&& other) noexcept
+            {
+                take(other);
+            }
+
+            function& operator=(function&& other) noexcept
+            {
+                if (this != &other)
+                {
+                    reset();
+                    take(other);
+                }
+                return *this;
+            }
+
+            function& operator=(std::nullptr_t)
+            {
+                reset();
+                return *this;
+            }
+
+            ~function() { reset(); }
+
+            function(const function&) = delete;
+            function& operator=(const function&) = delete;
+
+            explicit operator bool() const { return ops_ != nullptr; }
+
+            void operator()() { ops_->invoke(&storage_); }
+
+        private:
+            struct operations
+            {
+                void (*invoke)(void* storage);
+                void (*move)(void* from, void* to);
+                void (*destroy)(void* storage);
+            };
+
+            template <typename F>
+            static constexpr bool fits_inline()
+            {
+                return sizeof(F) <= inline_size && alignof(F) <= alignof(std::max_align_t) && std::is_nothrow_move_constructible<F>::value;
+            }
+
+            template <typename F>
+            struct inline_target
+            {
+                static void invoke(void* storage) { (*static_cast<F*>(storage))(); }
+                static void move(void* from, void* to)
+                {
+                    new (to) F(std::move(*static_cast<F*>(from)));
+                    static_cast<F*>(from)->~F();
+                }
+                static void destroy(void* storage) { static_cast<F*>(storage)->~F(); }
+
+                static const operations* get()
+                {
+                    static const operations ops = { &invoke, &move, &destroy };
+                    return &ops;
+                }
+            };
+
+            template <typename F>
+            struct pooled_target
+            {
+                static F*& target(void* storage) { return *static_cast<F**>(storage); }
+
+                static void invoke(void* storage) { (*target(storage))(); }
+                static void move(void* from, void* to) { new (to) F*(target(from)); }
+                static void destroy(void* storage)
+                {
+                    auto p = target(storage);
+                    p->~F();
+                    pool_allocator<F>().deallocate(p, 1);
+                }
+
+                static const operations* get()
+                {
+                    static const operations ops = { &invoke, &move, &destroy };
+                    return &ops;
+                }
+            };
+
+            template <typename F, typename Arg>
+            void emplace(Arg&& f, std::true_type)
+            {
+                new (&storage_) F(std::forward<Arg>(f));
+                ops_ = inline_target<F>::get();
+            }
+
+            template <typename F, typename Arg>
+            void emplace(Arg&& f, std::false_type)
+            {
+                pool_allocator<F> allocator;
+                auto p = allocator.allocate(1);
+                try
+                {
+                    new (p) F(std::forward<Arg>(f));
+                }
+                catch (...)
+                {
+                    allocator.deallocate(p, 1);
+                    throw;
+                }
+
+                new (&storage_) F*(p);
+                ops_ = pooled_target<F>::get();
+            }
+
+            void take(function& other)
+            {
+                if (other.ops_ != nullptr)
+                {
+                    other.ops_->move(&other.storage_, &storage_);
+                    ops_ = other.ops_;
+                    other.ops_ = nullptr;
+                }
+            }
+
+            void reset()
+            {
+                if (ops_ != nullptr)
+                {
+                    ops_->destroy(&storage_);
+                    ops_ = nullptr;
+                }
+            }
+
+            std::aligned_storage_t<inline_size, alignof(std::max_align_t)> storage_;
+            const operations* ops_ = nullptr;
+        };
+
+        explicit job(function fn) : fn_(std::move(fn)) {}
+
+        bool finished() const { return finished_.load(std::memory_order_acquire); }
+
+    private:
+        friend class job_system;
+
+        function fn_;
+        std::shared_ptr<job> parent_;
+        std::shared_ptr<job> self_;
+
+        // 1 for the job itself + unfinished children
+        std::atomic<int> unfinished_{ 1 };
+
+        // unfinished predecessors + 1 until submit()
+        std::atomic<int> pending_{ 1 };
+
+        // a job mostly has one successor, it is kept inline and only the rest go to the vector
+        std::mutex m_;
+        std::shared_ptr<job> successor_;
+        std::vector<std::shared_ptr<job>> successors_;
+        std::atomic_bool finished_{ false };
+    };
+
+    using job_ptr = std::shared_ptr<job>;
+
+    class job_system
+    {
+    public:
+        static job_system& instance();
+
+        void start(size_t thread_count);
+        void stop();
+
+        size_t thread_count() const { return workers_.size(); }
+
+        // job node and control block come from one pooled block
+        job_ptr create(job::function fn);
+
+        // parent is not finished until all of its children are finished
+        job_ptr create_child(const job_ptr& parent, job::function fn);
+
+        // after runs once before (and its children) finished, call before submit(after)
+        void add_dependency(const job_ptr& before, const job_ptr& after);
+
+        // continuation job, already submitted
+        job_ptr then(const job_ptr& before, job::function fn);
+
+        void submit(const job_ptr& j);
+
+        // runs other jobs while waiting, safe from worker and non worker threads
+        void wait(const job_ptr& j);
+
+        // fn(begin, end) over [begin, end) split into chunks of at most grain
+        void parallel_for(size_t begin, size_t end, size_t grain, const std::function<void(size_t, size_t)>& fn);
+
+    private:
+        struct worker
+        {
+            work_stealing_deque<job*> deque;
+            std::thread thread;
+        };
+
+        job_system() = default;
+
+        void run(size_t index);
+        void enqueue(job* j);
+        bool try_run_one();
+        job* find_job();
+        void execute(job* j);
+        void finish(job* j);
+
+        std::vector<std::unique_ptr<worker>> workers_;
+
+        // submissions from threads that are not workers (io, room), the deque only takes what the ring can't
+        mpmc_queue<job*> injection_{ 4096 };
+        std::mutex overflow_m_;
+        std::deque<job*> overflow_;
+        std::atomic<size_t> overflow_size_{ 0 };
+
+        std::mutex sleep_m_;
+        std::condition_variable sleep_cv_;
+        std::atomic<int> sleepers_{ 0 };
+        std::atomic_bool stop_{ false };
+    };
+}
+
+#endif
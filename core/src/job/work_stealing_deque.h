@@ -0,0 +1,134 @@
+#ifndef __WORK_STEALING_DEQUE_H
+#define __WORK_STEALING_DEQUE_H
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace core
+{
+    // Chase-Lev deque, "Correct and Efficient Work-Stealing for Weak Memory Models"
+    // push()/pop() from the owning thread only, steal() from any thread
+    template <typename T>
+    class work_stealing_deque
+    {
+        struct ring
+        {
+            explicit ring(long long capacity)
+                : capacity(capacity), mask(capacity - 1), items(new std::atomic<T>[capacity])
+            {
+            }
+
+            T get(long long i) const
+            {
+                return items[i & mask].load(std::memory_order_relaxed);
+            }
+
+            void put(long long i, T item)
+            {
+                items[i & mask].store(item, std::memory_order_relaxed);
+            }
+
+            long long capacity;
+            long long mask;
+            std::unique_ptr<std::atomic<T>[]> items;
+        };
+
+    public:
+        explicit work_stealing_deque(long long capacity = 1024)
+        {
+            rings_.emplace_back(std::make_unique<ring>(capacity));
+            ring_.store(rings_.back().get(), std::memory_order_relaxed);
+        }
+
+        work_stealing_deque(const work_stealing_deque&) = delete;
+        work_stealing_deque& operator=(const work_stealing_deque&) = delete;
+
+        void push(T item)
+        {
+            auto b = bottom_.load(std::memory_order_relaxed);
+            auto t = top_.load(std::memory_order_acquire);
+            auto r = ring_.load(std::memory_order_relaxed);
+
+            if (b - t > r->capacity - 1)
+            {
+                r = grow(r, b, t);
+            }
+
+            r->put(b, item);
+            std::atomic_thread_fence(std::memory_order_release);
+            bottom_.store(b + 1, std::memory_order_relaxed);
+        }
+
+        bool pop(T& item)
+        {
+            auto b = bottom_.load(std::memory_order_relaxed) - 1;
+            auto r = ring_.load(std::memory_order_relaxed);
+            bottom_.store(b, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            auto t = top_.load(std::memory_order_relaxed);
+
+            if (t > b)
+            {
+                bottom_.store(b + 1, std::memory_order_relaxed);
+                return false;
+            }
+
+            item = r->get(b);
+            if (t == b)
+            {
+                // last item, race against thieves
+                auto won = top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+                bottom_.store(b + 1, std::memory_order_relaxed);
+                return won;
+            }
+
+            return true;
+        }
+
+        bool steal(T& item)
+        {
+            auto t = top_.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            auto b = bottom_.load(std::memory_order_acquire);
+
+            if (t >= b)
+            {
+                return false;
+            }
+
+            auto r = ring_.load(std::memory_order_acquire);
+            item = r->get(t);
+            return top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+        }
+
+        long long size() const
+        {
+            auto b = bottom_.load(std::memory_order_relaxed);
+            auto t = top_.load(std::memory_order_relaxed);
+            return b > t ? b - t : 0;
+        }
+
+    private:
+        ring* grow(ring* old, long long b, long long t)
+        {
+            // old rings stay alive until the deque dies, a thief may still be reading one
+            rings_.emplace_back(std::make_unique<ring>(old->capacity * 2));
+            auto r = rings_.back().get();
+            for (auto i = t; i < b; ++i)
+            {
+                r->put(i, old->get(i));
+            }
+
+            ring_.store(r, std::memory_order_release);
+            return r;
+        }
+
+        alignas(64) std::atomic<long long> top_{ 0 };
+        alignas(64) std::atomic<long long> bottom_{ 0 };
+        alignas(64) std::atomic<ring*> ring_{ nullptr };
+        std::vector<std::unique_ptr<ring>> rings_;
+    };
+}
+
+#endif
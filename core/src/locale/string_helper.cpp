@@ -1,54 +1,81 @@
 #include "string_helper.h"
-#include <vector>
+#include <cstdlib>
+#include <cwchar>
+#include <stdexcept>
 #ifndef __linux__
 #include <windows.h>
 #endif
-#include <codecvt>
+#include "utf8.h"
 
 namespace core
 {
-    static thread_local std::wstring_convert<std::codecvt_utf8<wchar_t>> cvt;
-
-    std::wstring utf8_to_wstring(const std::string& str)
+    namespace
     {
-        return cvt.from_bytes(str);
-    }
-
-    std::wstring string_to_wstring(std::string bytes)
-    {
-        try
+        bool from_utf8(string_view str, std::wstring& out)
         {
-            return cvt.from_bytes(bytes);
+            out.resize(max_wide_length_from_utf8(str.size()));
+            const auto result = utf8_to_wide(str, &out[0], out.size());
+            out.resize(result.ok ? result.written : 0);
+            return result.ok;
         }
-        catch (std::range_error& e)
+
+        std::wstring from_code_page(string_view bytes)
         {
-            thread_local wchar_t buf[1024] = { 0 };
-            if (bytes.length() >= sizeof(buf) - 1)
+#ifndef __linux__
+            const auto size = MultiByteToWideChar(CP_ACP, 0, bytes.data(), static_cast<int>(bytes.size()), nullptr, 0);
+            if (size <= 0)
             {
                 return{};
             }
 
-            thread_local size_t converted = 0;
-            mbstowcs_s(&converted, buf, bytes.c_str(), sizeof(buf));
-            return buf;
-        }
-        catch (std::exception& e)
-        {
-            return{}; 
+            std::wstring out(size, L'\0');
+            MultiByteToWideChar(CP_ACP, 0, bytes.data(), static_cast<int>(bytes.size()), &out[0], size);
+            return out;
+#else
+            // LC_CTYPE of the process, needs a terminated copy
+            const auto terminated = bytes.to_string();
+            std::mbstate_t state = std::mbstate_t();
+            const char* src = terminated.c_str();
+
+            std::wstring out(terminated.size(), L'\0');
+            const auto size = std::mbsrtowcs(&out[0], &src, out.size(), &state);
+            if (size == static_cast<size_t>(-1))
+            {
+                return{};
+            }
+
+            out.resize(size);
+            return out;
+#endif
         }
     }
 
-    std::string wstring_to_string(std::wstring wstr)
+    std::wstring utf8_to_wstring(string_view str)
     {
-        try
+        std::wstring out;
+        if (!from_utf8(str, out))
         {
-            return cvt.to_bytes(wstr);
+            throw std::range_error("invalid utf-8");
         }
-        catch (std::exception& e)
+        return out;
+    }
+
+    std::wstring string_to_wstring(string_view bytes)
+    {
+        std::wstring out;
+        if (from_utf8(bytes, out))
         {
-            
-            return{};
+            return out;
         }
+
+        return from_code_page(bytes);
     }
 
+    std::string wstring_to_string(wstring_view wstr)
+    {
+        std::string out(max_utf8_length_from_wide(wstr.size()), '\0');
+        const auto result = wide_to_utf8(wstr, &out[0], out.size());
+        out.resize(result.ok ? result.written : 0);
+        return out;
+    }
 }
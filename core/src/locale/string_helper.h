@@ -1,13 +1,18 @@
 #ifndef __STRING_HELPER_H
 #define __STRING_HELPER_H
 #include <string>
+#include "string_view.h"
 
 namespace core
 {
-    std::wstring utf8_to_wstring(const std::string& str);
+    // throws std::range_error on invalid utf-8
+    std::wstring utf8_to_wstring(string_view str);
 
-    std::wstring    string_to_wstring(std::string bytes);
-    std::string     wstring_to_string(std::wstring wstr);
+    // utf-8, or the system code page when bytes is not valid utf-8, empty if neither converts
+    std::wstring    string_to_wstring(string_view bytes);
+
+    // empty on unpaired surrogates
+    std::string     wstring_to_string(wstring_view wstr);
 }
 
 #endif
@@ -0,0 +1,38 @@
+#ifndef __STRING_VIEW_H
+#define __STRING_VIEW_H
+
+#include <cstddef>
+#include <string>
+
+namespace core
+{
+    // non owning (pointer, length), stands in for std::string_view until the project builds as c++17
+    template <typename Char>
+    class basic_string_view
+    {
+    public:
+        basic_string_view() = default;
+        basic_string_view(const Char* data, size_t size) : data_(data), size_(size) {}
+        basic_string_view(const Char* str) : data_(str), size_(std::char_traits<Char>::length(str)) {}
+        basic_string_view(const std::basic_string<Char>& str) : data_(str.data()), size_(str.size()) {}
+
+        const Char* data() const { return data_; }
+        size_t size() const { return size_; }
+        bool empty() const { return size_ == 0; }
+
+        const Char* begin() const { return data_; }
+        const Char* end() const { return data_ + size_; }
+        Char operator[](size_t i) const { return data_[i]; }
+
+        std::basic_string<Char> to_string() const { return std::basic_string<Char>(data_, size_); }
+
+    private:
+        const Char* data_ = nullptr;
+        size_t size_ = 0;
+    };
+
+    using string_view = basic_string_view<char>;
+    using wstring_view = basic_string_view<wchar_t>;
+}
+
+#endif
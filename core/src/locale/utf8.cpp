@@ -0,0 +1,794 @@
+#include "utf8.h"
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define CORE_UTF8_X86 1
+#include <emmintrin.h>
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// avx2 functions are compiled for avx2 whatever the project flags, and only called after the cpuid check
+#if defined(__GNUC__) || defined(__clang__)
+#define CORE_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define CORE_TARGET_AVX2
+#endif
+
+namespace core
+{
+    namespace
+    {
+        std::atomic<int> max_isa{ static_cast<int>(utf8_isa::avx2) };
+
+        utf8_isa detect_isa()
+        {
+#ifdef CORE_UTF8_X86
+#ifdef _MSC_VER
+            int regs[4];
+            __cpuid(regs, 0);
+            if (regs[0] >= 7)
+            {
+                __cpuid(regs, 1);
+                const auto osxsave = (regs[2] & (1 << 27)) != 0;
+                const auto avx = (regs[2] & (1 << 28)) != 0;
+
+                // the os must save the ymm registers too
+                if (osxsave && avx && (_xgetbv(0) & 6) == 6)
+                {
+                    __cpuidex(regs, 7, 0);
+                    if (regs[1] & (1 << 5))
+                    {
+                        return utf8_isa::avx2;
+                    }
+                }
+            }
+            return utf8_isa::sse2;
+#else
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2") ? utf8_isa::avx2 : utf8_isa::sse2;
+#endif
+#else
+            return utf8_isa::scalar;
+#endif
+        }
+
+        utf8_isa current_isa()
+        {
+            static const auto detected = detect_isa();
+            const auto cap = max_isa.load(std::memory_order_relaxed);
+            return static_cast<int>(detected) < cap ? detected : static_cast<utf8_isa>(cap);
+        }
+
+        // one code point at p, returns its length or 0 when the sequence is not well formed (unicode table 3-7)
+        inline size_t decode(const unsigned char* p, size_t n, uint32_t& cp)
+        {
+            const uint32_t b0 = p[0];
+            if (b0 < 0x80)
+            {
+                cp = b0;
+                return 1;
+            }
+
+            if (b0 < 0xC2)
+            {
+                return 0;
+            }
+
+            if (b0 < 0xE0)
+            {
+                if (n < 2 || (p[1] & 0xC0) != 0x80)
+                {
+                    return 0;
+                }
+                cp = ((b0 & 0x1F) << 6) | (p[1] & 0x3F);
+                return 2;
+            }
+
+            if (b0 < 0xF0)
+            {
+                if (n < 3)
+                {
+                    return 0;
+                }
+
+                // E0 excludes overlongs, ED excludes surrogates
+                const uint32_t b1 = p[1];
+                const uint32_t lo = b0 == 0xE0 ? 0xA0 : 0x80;
+                const uint32_t hi = b0 == 0xED ? 0x9F : 0xBF;
+                if (b1 < lo || b1 > hi || (p[2] & 0xC0) != 0x80)
+                {
+                    return 0;
+                }
+                cp = ((b0 & 0x0F) << 12) | ((b1 & 0x3F) << 6) | (p[2] & 0x3F);
+                return 3;
+            }
+
+            if (b0 < 0xF5)
+            {
+                if (n < 4)
+                {
+                    return 0;
+                }
+
+                // F0 excludes overlongs, F4 stops at U+10FFFF
+                const uint32_t b1 = p[1];
+                const uint32_t lo = b0 == 0xF0 ? 0x90 : 0x80;
+                const uint32_t hi = b0 == 0xF4 ? 0x8F : 0xBF;
+                if (b1 < lo || b1 > hi || (p[2] & 0xC0) != 0x80 || (p[3] & 0xC0) != 0x80)
+                {
+                    return 0;
+                }
+                cp = ((b0 & 0x07) << 18) | ((b1 & 0x3F) << 12) | ((p[2] & 0x3F) << 6) | (p[3] & 0x3F);
+                return 4;
+            }
+
+            return 0;
+        }
+
+        bool validate_scalar(const unsigned char* p, size_t n)
+        {
+            size_t i = 0;
+            while (i < n)
+            {
+                // 8 ascii bytes at a time
+                if (i + 8 <= n)
+                {
+                    uint64_t word;
+                    std::memcpy(&word, p + i, sizeof(word));
+                    if ((word & 0x8080808080808080ull) == 0)
+                    {
+                        i += 8;
+                        continue;
+                    }
+                }
+
+                uint32_t cp;
+                const auto length = decode(p + i, n - i, cp);
+                if (length == 0)
+                {
+                    return false;
+                }
+                i += length;
+            }
+            return true;
+        }
+
+#ifdef CORE_UTF8_X86
+
+        bool validate_sse2(const unsigned char* p, size_t n)
+        {
+            size_t i = 0;
+            while (i + 16 <= n)
+            {
+                if (_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i))) == 0)
+                {
+                    i += 16;
+                    continue;
+                }
+
+                // decode past the block before the next simd check
+                const auto block_end = i + 16;
+                while (i < block_end)
+                {
+                    uint32_t cp;
+                    const auto length = decode(p + i, n - i, cp);
+                    if (length == 0)
+                    {
+                        return false;
+                    }
+                    i += length;
+                }
+            }
+            return validate_scalar(p + i, n - i);
+        }
+
+        // Keiser & Lemire, "Validating UTF-8 in less than one instruction per byte" (2021), the lookup algorithm
+        // three nibble table lookups classify every byte pair, continuation counts come from the bytes 2 and 3 back
+        namespace avx2
+        {
+            constexpr uint8_t too_short = 1 << 0;     // lead followed by a lead or ascii
+            constexpr uint8_t too_long = 1 << 1;      // ascii followed by a continuation
+            constexpr uint8_t overlong_3 = 1 << 2;
+            constexpr uint8_t too_large = 1 << 3;
+            constexpr uint8_t surrogate = 1 << 4;
+            constexpr uint8_t overlong_2 = 1 << 5;
+            constexpr uint8_t too_large_1000 = 1 << 6;
+            constexpr uint8_t overlong_4 = 1 << 6;
+            constexpr uint8_t two_conts = 1 << 7;
+            constexpr uint8_t carry = too_short | too_long | two_conts;
+
+            CORE_TARGET_AVX2 inline __m256i table(uint8_t t0, uint8_t t1, uint8_t t2, uint8_t t3, uint8_t t4, uint8_t t5, uint8_t t6, uint8_t t7,
+                uint8_t t8, uint8_t t9, uint8_t t10, uint8_t t11, uint8_t t12, uint8_t t13, uint8_t t14, uint8_t t15)
+            {
+                return _mm256_broadcastsi128_si256(_mm_setr_epi8(
+                    static_cast<char>(t0), static_cast<char>(t1), static_cast<char>(t2), static_cast<char>(t3),
+                    static_cast<char>(t4), static_cast<char>(t5), static_cast<char>(t6), static_cast<char>(t7),
+                    static_cast<char>(t8), static_cast<char>(t9), static_cast<char>(t10), static_cast<char>(t11),
+                    static_cast<char>(t12), static_cast<char>(t13), static_cast<char>(t14), static_cast<char>(t15)));
+            }
+
+            // input shifted by n bytes with the tail of the previous block shifted in
+            template <int N>
+            CORE_TARGET_AVX2 inline __m256i prev(__m256i input, __m256i prev_input)
+            {
+                return _mm256_alignr_epi8(input, _mm256_permute2x128_si256(prev_input, input, 0x21), 16 - N);
+            }
+
+            CORE_TARGET_AVX2 inline __m256i high_nibble(__m256i v)
+            {
+                return _mm256_and_si256(_mm256_srli_epi16(v, 4), _mm256_set1_epi8(0x0F));
+            }
+
+            CORE_TARGET_AVX2 inline __m256i special_cases(__m256i input, __m256i prev1)
+            {
+                const auto byte_1_high = _mm256_shuffle_epi8(table(
+                    // 0_______ ________
+                    too_long, too_long, too_long, too_long,
+                    too_long, too_long, too_long, too_long,
+                    // 10______ ________
+                    two_conts, two_conts, two_conts, two_conts,
+                    // 1100____ ________
+                    too_short | overlong_2,
+                    // 1101____ ________
+                    too_short,
+                    // 1110____ ________
+                    too_short | overlong_3 | surrogate,
+                    // 1111____ ________
+                    too_short | too_large | too_large_1000 | overlong_4), high_nibble(prev1));
+
+                const auto byte_1_low = _mm256_shuffle_epi8(table(
+                    // ____0000 ________
+                    carry | overlong_3 | overlong_2 | overlong_4,
+                    // ____0001 ________
+                    carry | overlong_2,
+                    // ____001_ ________
+                    carry,
+                    carry,
+                    // ____0100 ________
+                    carry | too_large,
+                    // ____0101 ________
+                    carry | too_large | too_large_1000,
+                    // ____011_ ________
+                    carry | too_large | too_large_1000,
+                    carry | too_large | too_large_1000,
+                    // ____1___ ________
+                    carry | too_large | too_large_1000,
+                    carry | too_large | too_large_1000,
+                    carry | too_large | too_large_1000,
+                    carry | too_large | too_large_1000,
+                    carry | too_large | too_large_1000,
+                    // ____1101 ________
+                    carry | too_large | too_large_1000 | surrogate,
+                    carry | too_large | too_large_1000,
+                    carry | too_large | too_large_1000), _mm256_and_si256(prev1, _mm256_set1_epi8(0x0F)));
+
+                const auto byte_2_high = _mm256_shuffle_epi8(table(
+                    // ________ 0_______
+                    too_short, too_short, too_short, too_short,
+                    too_short, too_short, too_short, too_short,
+                    // ________ 1000____
+                    too_long | overlong_2 | two_conts | overlong_3 | too_large_1000 | overlong_4,
+                    // ________ 1001____
+                    too_long | overlong_2 | two_conts | overlong_3 | too_large,
+                    // ________ 101_____
+                    too_long | overlong_2 | two_conts | surrogate | too_large,
+                    too_long | overlong_2 | two_conts | surrogate | too_large,
+                    // ________ 11______
+                    too_short, too_short, too_short, too_short), high_nibble(input));
+
+                return _mm256_and_si256(_mm256_and_si256(byte_1_high, byte_1_low), byte_2_high);
+            }
+
+            CORE_TARGET_AVX2 inline __m256i multibyte_lengths(__m256i input, __m256i prev_input, __m256i special)
+            {
+                // only 111_____ two back and 1111____ three back reach 0x80
+                const auto third = _mm256_subs_epu8(prev<2>(input, prev_input), _mm256_set1_epi8(static_cast<char>(0xE0 - 0x80)));
+                const auto fourth = _mm256_subs_epu8(prev<3>(input, prev_input), _mm256_set1_epi8(static_cast<char>(0xF0 - 0x80)));
+                const auto must_be_continuation = _mm256_and_si256(_mm256_or_si256(third, fourth), _mm256_set1_epi8(static_cast<char>(0x80)));
+                return _mm256_xor_si256(must_be_continuation, special);
+            }
+
+            // leads in the last three bytes that need bytes from the next block
+            CORE_TARGET_AVX2 inline __m256i incomplete(__m256i input)
+            {
+                const auto max = _mm256_setr_epi8(
+                    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                    static_cast<char>(0xF0 - 1), static_cast<char>(0xE0 - 1), static_cast<char>(0xC0 - 1));
+                return _mm256_subs_epu8(input, max);
+            }
+
+            struct state
+            {
+                __m256i error;
+                __m256i prev_input;
+                __m256i prev_incomplete;
+            };
+
+            CORE_TARGET_AVX2 inline void check(state& s, __m256i input)
+            {
+                if (_mm256_movemask_epi8(input) == 0)
+                {
+                    s.error = _mm256_or_si256(s.error, s.prev_incomplete);
+                }
+                else
+                {
+                    const auto special = special_cases(input, prev<1>(input, s.prev_input));
+                    s.error = _mm256_or_si256(s.error, multibyte_lengths(input, s.prev_input, special));
+                    s.prev_incomplete = incomplete(input);
+                }
+                s.prev_input = input;
+            }
+
+            CORE_TARGET_AVX2 bool validate(const unsigned char* p, size_t n)
+            {
+                state s;
+                s.error = _mm256_setzero_si256();
+                s.prev_input = _mm256_setzero_si256();
+                s.prev_incomplete = _mm256_setzero_si256();
+
+                size_t i = 0;
+                for (; i + 32 <= n; i += 32)
+                {
+                    check(s, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i)));
+                }
+
+                // zero padding reads as ascii, a sequence cut by the end shows up as too_short
+                if (i < n)
+                {
+                    alignas(32) unsigned char tail[32] = {};
+                    std::memcpy(tail, p + i, n - i);
+                    check(s, _mm256_load_si256(reinterpret_cast<const __m256i*>(tail)));
+                }
+
+                s.error = _mm256_or_si256(s.error, s.prev_incomplete);
+                return _mm256_testz_si256(s.error, s.error) != 0;
+            }
+        }
+
+        // 16 ascii bytes to 16 code units
+        template <size_t UnitSize>
+        struct widen;
+
+        template <>
+        struct widen<2>
+        {
+            static void store(__m128i v, void* out)
+            {
+                const auto zero = _mm_setzero_si128();
+                auto dst = static_cast<__m128i*>(out);
+                _mm_storeu_si128(dst, _mm_unpacklo_epi8(v, zero));
+                _mm_storeu_si128(dst + 1, _mm_unpackhi_epi8(v, zero));
+            }
+        };
+
+        template <>
+        struct widen<4>
+        {
+            static void store(__m128i v, void* out)
+            {
+                const auto zero = _mm_setzero_si128();
+                const auto lo = _mm_unpacklo_epi8(v, zero);
+                const auto hi = _mm_unpackhi_epi8(v, zero);
+                auto dst = static_cast<__m128i*>(out);
+                _mm_storeu_si128(dst, _mm_unpacklo_epi16(lo, zero));
+                _mm_storeu_si128(dst + 1, _mm_unpackhi_epi16(lo, zero));
+                _mm_storeu_si128(dst + 2, _mm_unpacklo_epi16(hi, zero));
+                _mm_storeu_si128(dst + 3, _mm_unpackhi_epi16(hi, zero));
+            }
+        };
+
+        // ascii code units to bytes, returns how many it narrowed (0 or a full block)
+        inline size_t narrow_ascii(const char16_t* in, size_t n, unsigned char* out)
+        {
+            if (n < 8)
+            {
+                return 0;
+            }
+
+            const auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+            const auto high = _mm_and_si128(v, _mm_set1_epi16(static_cast<short>(0xFF80)));
+            if (_mm_movemask_epi8(_mm_cmpeq_epi16(high, _mm_setzero_si128())) != 0xFFFF)
+            {
+                return 0;
+            }
+
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(out), _mm_packus_epi16(v, v));
+            return 8;
+        }
+
+        inline size_t narrow_ascii(const char32_t* in, size_t n, unsigned char* out)
+        {
+            if (n < 4)
+            {
+                return 0;
+            }
+
+            const auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+            const auto high = _mm_and_si128(v, _mm_set1_epi32(static_cast<int>(0xFFFFFF80)));
+            if (_mm_movemask_epi8(_mm_cmpeq_epi32(high, _mm_setzero_si128())) != 0xFFFF)
+            {
+                return 0;
+            }
+
+            const auto words = _mm_packs_epi32(v, v);
+            const auto bytes = _mm_cvtsi128_si32(_mm_packus_epi16(words, words));
+            std::memcpy(out, &bytes, sizeof(bytes));
+            return 4;
+        }
+
+#endif
+
+        // input already validated, only the lead byte decides the length
+        inline size_t decode_valid(const unsigned char* p, uint32_t& cp)
+        {
+            const uint32_t b0 = p[0];
+            if (b0 < 0x80)
+            {
+                cp = b0;
+                return 1;
+            }
+            if (b0 < 0xE0)
+            {
+                cp = ((b0 & 0x1F) << 6) | (p[1] & 0x3F);
+                return 2;
+            }
+            if (b0 < 0xF0)
+            {
+                cp = ((b0 & 0x0F) << 12) | ((p[1] & 0x3F) << 6) | (p[2] & 0x3F);
+                return 3;
+            }
+            cp = ((b0 & 0x07) << 18) | ((p[1] & 0x3F) << 12) | ((p[2] & 0x3F) << 6) | (p[3] & 0x3F);
+            return 4;
+        }
+
+        // valid input into a buffer of at least n units, never fails
+        template <typename Unit>
+        size_t from_valid_utf8(const unsigned char* p, size_t n, Unit* out)
+        {
+#ifdef CORE_UTF8_X86
+            const auto simd = current_isa() != utf8_isa::scalar;
+#endif
+
+            size_t i = 0;
+            size_t o = 0;
+            size_t next_block = 0;
+            while (i < n)
+            {
+#ifdef CORE_UTF8_X86
+                if (simd && i >= next_block && i + 16 <= n)
+                {
+                    const auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+                    if (_mm_movemask_epi8(v) == 0)
+                    {
+                        widen<sizeof(Unit)>::store(v, out + o);
+                        i += 16;
+                        o += 16;
+                        continue;
+                    }
+                    next_block = i + 16;
+                }
+#endif
+
+                uint32_t cp;
+                i += decode_valid(p + i, cp);
+
+                if (sizeof(Unit) == 2 && cp >= 0x10000)
+                {
+                    cp -= 0x10000;
+                    out[o++] = static_cast<Unit>(0xD800 + (cp >> 10));
+                    out[o++] = static_cast<Unit>(0xDC00 + (cp & 0x3FF));
+                }
+                else
+                {
+                    out[o++] = static_cast<Unit>(cp);
+                }
+            }
+            return o;
+        }
+
+        template <typename Unit>
+        transcode_result from_utf8(const unsigned char* p, size_t n, Unit* out, size_t capacity)
+        {
+            static_assert(sizeof(Unit) == 2 || sizeof(Unit) == 4, "utf-16 or utf-32 code units");
+
+            transcode_result result;
+
+            // the simd validator is cheap next to per byte checks, the common case then decodes unchecked
+            if (capacity >= n && utf8_validate(string_view(reinterpret_cast<const char*>(p), n)))
+            {
+                result.written = from_valid_utf8(p, n, out);
+                result.ok = true;
+                return result;
+            }
+
+#ifdef CORE_UTF8_X86
+            const auto simd = current_isa() != utf8_isa::scalar;
+#endif
+
+            size_t i = 0;
+            size_t o = 0;
+            size_t next_block = 0;      // no simd check until a failed block is decoded
+            while (i < n)
+            {
+#ifdef CORE_UTF8_X86
+                if (simd && i >= next_block && i + 16 <= n && o + 16 <= capacity)
+                {
+                    const auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+                    if (_mm_movemask_epi8(v) == 0)
+                    {
+                        widen<sizeof(Unit)>::store(v, out + o);
+                        i += 16;
+                        o += 16;
+                        continue;
+                    }
+                    next_block = i + 16;
+                }
+#endif
+
+                uint32_t cp;
+                const auto length = decode(p + i, n - i, cp);
+                if (length == 0)
+                {
+                    result.written = o;
+                    return result;
+                }
+
+                if (sizeof(Unit) == 2 && cp >= 0x10000)
+                {
+                    if (o + 2 > capacity)
+                    {
+                        result.written = o;
+                        return result;
+                    }
+                    cp -= 0x10000;
+                    out[o++] = static_cast<Unit>(0xD800 + (cp >> 10));
+                    out[o++] = static_cast<Unit>(0xDC00 + (cp & 0x3FF));
+                }
+                else
+                {
+                    if (o >= capacity)
+                    {
+                        result.written = o;
+                        return result;
+                    }
+                    out[o++] = static_cast<Unit>(cp);
+                }
+
+                i += length;
+            }
+
+            result.written = o;
+            result.ok = true;
+            return result;
+        }
+
+        template <typename Unit, typename Simd>
+        transcode_result to_utf8(const Unit* in, size_t n, unsigned char* out, size_t capacity)
+        {
+            static_assert(sizeof(Unit) == 2 || sizeof(Unit) == 4, "utf-16 or utf-32 code units");
+
+#ifdef CORE_UTF8_X86
+            const auto simd = current_isa() != utf8_isa::scalar;
+#endif
+
+            transcode_result result;
+            size_t i = 0;
+            size_t o = 0;
+            size_t next_block = 0;
+            while (i < n)
+            {
+#ifdef CORE_UTF8_X86
+                if (simd && i >= next_block && o + 8 <= capacity)
+                {
+                    const auto narrowed = narrow_ascii(reinterpret_cast<const Simd*>(in + i), n - i, out + o);
+                    if (narrowed != 0)
+                    {
+                        i += narrowed;
+                        o += narrowed;
+                        continue;
+                    }
+                    next_block = i + 16 / sizeof(Unit);
+                }
+#endif
+
+                uint32_t cp = static_cast<uint32_t>(in[i]);
+                size_t consumed = 1;
+
+                if (cp >= 0xD800 && cp <= 0xDFFF)
+                {
+                    // utf-32 never carries surrogates, utf-16 only as high + low pairs
+                    if (sizeof(Unit) == 4 || cp >= 0xDC00 || i + 1 >= n)
+                    {
+                        result.written = o;
+                        return result;
+                    }
+
+                    const auto low = static_cast<uint32_t>(in[i + 1]);
+                    if (low < 0xDC00 || low > 0xDFFF)
+                    {
+                        result.written = o;
+                        return result;
+                    }
+
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                    consumed = 2;
+                }
+                else if (cp > 0x10FFFF)
+                {
+                    result.written = o;
+                    return result;
+                }
+
+                const size_t length = cp < 0x80 ? 1 : cp < 0x800 ? 2 : cp < 0x10000 ? 3 : 4;
+                if (o + length > capacity)
+                {
+                    result.written = o;
+                    return result;
+                }
+
+                switch (length)
+                {
+                case 1:
+                    out[o] = static_cast<unsigned char>(cp);
+                    break;
+                case 2:
+                    out[o] = static_cast<unsigned char>(0xC0 | (cp >> 6));
+                    out[o + 1] = static_cast<unsigned char>(0x80 | (cp & 0x3F));
+                    break;
+                case 3:
+                    out[o] = static_cast<unsigned char>(0xE0 | (cp >> 12));
+                    out[o + 1] = static_cast<unsigned char>(0x80 | ((cp >> 6) & 0x3F));
+                    out[o + 2] = static_cast<unsigned char>(0x80 | (cp & 0x3F));
+                    break;
+                default:
+                    out[o] = static_cast<unsigned char>(0xF0 | (cp >> 18));
+                    out[o + 1] = static_cast<unsigned char>(0x80 | ((cp >> 12) & 0x3F));
+                    out[o + 2] = static_cast<unsigned char>(0x80 | ((cp >> 6) & 0x3F));
+                    out[o + 3] = static_cast<unsigned char>(0x80 | (cp & 0x3F));
+                    break;
+                }
+
+                i += consumed;
+                o += length;
+            }
+
+            result.written = o;
+            result.ok = true;
+            return result;
+        }
+
+        const unsigned char* bytes(string_view str)
+        {
+            return reinterpret_cast<const unsigned char*>(str.data());
+        }
+    }
+
+    utf8_isa utf8_active_isa()
+    {
+        return current_isa();
+    }
+
+    const char* utf8_isa_name(utf8_isa isa)
+    {
+        switch (isa)
+        {
+        case utf8_isa::scalar: return "scalar";
+        case utf8_isa::sse2: return "sse2";
+        case utf8_isa::avx2: return "avx2";
+        default: return "?";
+        }
+    }
+
+    void utf8_set_max_isa(utf8_isa isa)
+    {
+        max_isa.store(static_cast<int>(isa), std::memory_order_relaxed);
+    }
+
+    bool utf8_validate(string_view str)
+    {
+        switch (current_isa())
+        {
+#ifdef CORE_UTF8_X86
+        case utf8_isa::avx2:
+            // below one block the padding copy costs more than the scalar loop
+            if (str.size() < 32)
+            {
+                return validate_scalar(bytes(str), str.size());
+            }
+            return avx2::validate(bytes(str), str.size());
+        case utf8_isa::sse2:
+            return validate_sse2(bytes(str), str.size());
+#endif
+        default:
+            return validate_scalar(bytes(str), str.size());
+        }
+    }
+
+    size_t utf16_length_from_utf8(string_view str)
+    {
+        // every non continuation byte starts a code unit, 4 byte leads need a surrogate pair
+        size_t length = 0;
+        for (auto c : str)
+        {
+            const auto b = static_cast<unsigned char>(c);
+            length += ((b & 0xC0) != 0x80) + (b >= 0xF0);
+        }
+        return length;
+    }
+
+    size_t utf32_length_from_utf8(string_view str)
+    {
+        size_t length = 0;
+        for (auto c : str)
+        {
+            length += (static_cast<unsigned char>(c) & 0xC0) != 0x80;
+        }
+        return length;
+    }
+
+    size_t utf8_length_from_utf16(const char16_t* data, size_t size)
+    {
+        // a surrogate pair counts 2 + 2
+        size_t length = 0;
+        for (size_t i = 0; i < size; ++i)
+        {
+            const auto u = data[i];
+            length += u < 0x80 ? 1 : u < 0x800 ? 2 : (u >= 0xD800 && u <= 0xDFFF) ? 2 : 3;
+        }
+        return length;
+    }
+
+    size_t utf8_length_from_utf32(const char32_t* data, size_t size)
+    {
+        size_t length = 0;
+        for (size_t i = 0; i < size; ++i)
+        {
+            const auto u = data[i];
+            length += u < 0x80 ? 1 : u < 0x800 ? 2 : u < 0x10000 ? 3 : 4;
+        }
+        return length;
+    }
+
+    transcode_result utf8_to_utf16(string_view str, char16_t* out, size_t capacity)
+    {
+        return from_utf8(bytes(str), str.size(), out, capacity);
+    }
+
+    transcode_result utf8_to_utf32(string_view str, char32_t* out, size_t capacity)
+    {
+        return from_utf8(bytes(str), str.size(), out, capacity);
+    }
+
+    transcode_result utf16_to_utf8(const char16_t* data, size_t size, char* out, size_t capacity)
+    {
+        return to_utf8<char16_t, char16_t>(data, size, reinterpret_cast<unsigned char*>(out), capacity);
+    }
+
+    transcode_result utf32_to_utf8(const char32_t* data, size_t size, char* out, size_t capacity)
+    {
+        return to_utf8<char32_t, char32_t>(data, size, reinterpret_cast<unsigned char*>(out), capacity);
+    }
+
+    namespace
+    {
+        // char16_t / char32_t of the same width as wchar_t, for the simd loads
+        using wide_unit = std::conditional<sizeof(wchar_t) == 2, char16_t, char32_t>::type;
+    }
+
+    transcode_result utf8_to_wide(string_view str, wchar_t* out, size_t capacity)
+    {
+        return from_utf8(bytes(str), str.size(), out, capacity);
+    }
+
+    transcode_result wide_to_utf8(wstring_view str, char* out, size_t capacity)
+    {
+        return to_utf8<wchar_t, wide_unit>(str.data(), str.size(), reinterpret_cast<unsigned char*>(out), capacity);
+    }
+}
@@ -0,0 +1,56 @@
+#ifndef __UTF8_H
+#define __UTF8_H
+
+#include <cstddef>
+#include "string_view.h"
+
+namespace core
+{
+    // utf-8 validation and transcoding into caller buffers, nothing here allocates
+    // valid means well formed utf-8: no overlongs, surrogates or code points past U+10FFFF
+    // x86 uses avx2 when the cpu has it, sse2 otherwise, other targets run the scalar loops
+
+    enum class utf8_isa
+    {
+        scalar,
+        sse2,
+        avx2,
+    };
+
+    // instruction set the functions below currently use
+    utf8_isa utf8_active_isa();
+    const char* utf8_isa_name(utf8_isa isa);
+
+    // caps the instruction set, for benchmarks and for ruling the simd paths out
+    void utf8_set_max_isa(utf8_isa isa);
+
+    bool utf8_validate(string_view str);
+
+    struct transcode_result
+    {
+        size_t written = 0;     // code units in the output
+        bool ok = false;        // false on invalid input or when the output is too small
+    };
+
+    // output sizes for valid input, size() code units is always enough going from utf-8
+    size_t utf16_length_from_utf8(string_view str);
+    size_t utf32_length_from_utf8(string_view str);
+    size_t utf8_length_from_utf16(const char16_t* data, size_t size);
+    size_t utf8_length_from_utf32(const char32_t* data, size_t size);
+
+    // validate while converting, out is untouched past written
+    transcode_result utf8_to_utf16(string_view str, char16_t* out, size_t capacity);
+    transcode_result utf8_to_utf32(string_view str, char32_t* out, size_t capacity);
+    transcode_result utf16_to_utf8(const char16_t* data, size_t size, char* out, size_t capacity);
+    transcode_result utf32_to_utf8(const char32_t* data, size_t size, char* out, size_t capacity);
+
+    // wchar_t is utf-16 on windows and utf-32 elsewhere
+    transcode_result utf8_to_wide(string_view str, wchar_t* out, size_t capacity);
+    transcode_result wide_to_utf8(wstring_view str, char* out, size_t capacity);
+
+    // worst case output sizes
+    inline size_t max_wide_length_from_utf8(size_t bytes) { return bytes; }
+    inline size_t max_utf8_length_from_wide(size_t units) { return units * (sizeof(wchar_t) == 2 ? 3 : 4); }
+}
+
+#endif
@@ -0,0 +1,117 @@
+#ifndef __LOG_RING_H
+#define __LOG_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+namespace core
+{
+    // single producer / single consumer byte ring, records are contiguous
+    // [u32 size][payload], size == wrap_marker means skip to the start of the buffer
+    class log_ring
+    {
+    public:
+        static constexpr uint32_t wrap_marker = 0xffffffff;
+
+        explicit log_ring(size_t capacity) : capacity_(round_up(capacity)), mask_(capacity_ - 1), buffer_(new char[capacity_]) {}
+
+        // producer, nullptr when full (the record is dropped)
+        char* reserve(uint32_t size)
+        {
+            const auto need = align(sizeof(uint32_t) + size);
+            const auto head = head_.load(std::memory_order_relaxed);
+            const auto offset = head & mask_;
+            const auto to_end = capacity_ - offset;
+            const auto total = to_end < need ? to_end + need : need;
+
+            if (head + total - cached_tail_ > capacity_)
+            {
+                cached_tail_ = tail_.load(std::memory_order_acquire);
+                if (head + total - cached_tail_ > capacity_)
+                {
+                    return nullptr;
+                }
+            }
+
+            auto at = offset;
+            if (to_end < need)
+            {
+                std::memcpy(buffer_.get() + offset, &wrap_marker, sizeof(uint32_t));
+                at = 0;
+            }
+
+            const auto record_size = static_cast<uint32_t>(size);
+            std::memcpy(buffer_.get() + at, &record_size, sizeof(uint32_t));
+            pending_ = total;
+            return buffer_.get() + at + sizeof(uint32_t);
+        }
+
+        void commit()
+        {
+            head_.store(head_.load(std::memory_order_relaxed) + pending_, std::memory_order_release);
+        }
+
+        // consumer, nullptr when empty
+        const char* peek(uint32_t& size)
+        {
+            auto tail = tail_.load(std::memory_order_relaxed);
+            const auto head = head_.load(std::memory_order_acquire);
+
+            while (tail != head)
+            {
+                const auto offset = tail & mask_;
+
+                uint32_t record_size;
+                std::memcpy(&record_size, buffer_.get() + offset, sizeof(uint32_t));
+
+                if (record_size == wrap_marker)
+                {
+                    tail += capacity_ - offset;
+                    tail_.store(tail, std::memory_order_release);
+                    continue;
+                }
+
+                size = record_size;
+                return buffer_.get() + offset + sizeof(uint32_t);
+            }
+
+            return nullptr;
+        }
+
+        void pop(uint32_t size)
+        {
+            tail_.store(tail_.load(std::memory_order_relaxed) + align(sizeof(uint32_t) + size), std::memory_order_release);
+        }
+
+    private:
+        static size_t round_up(size_t value)
+        {
+            size_t result = 64;
+            while (result < value)
+            {
+                result <<= 1;
+            }
+            return result;
+        }
+
+        static size_t align(size_t value)
+        {
+            return (value + 7) & ~static_cast<size_t>(7);
+        }
+
+        const size_t capacity_;
+        const size_t mask_;
+        std::unique_ptr<char[]> buffer_;
+
+        alignas(64) std::atomic<size_t> head_{ 0 };
+        size_t cached_tail_ = 0;
+        size_t pending_ = 0;
+
+        alignas(64) std::atomic<size_t> tail_{ 0 };
+    };
+}
+
+#endif
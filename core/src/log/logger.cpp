@@ -0,0 +1,439 @@
+#include "logger.h"
+#include <condition_variable>
+#include <cstdio>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "log_ring.h"
+#include "../locale/utf8.h"
+
+namespace core
+{
+    namespace
+    {
+        struct log_state
+        {
+            std::mutex m;
+            std::condition_variable cv;
+            std::vector<std::shared_ptr<log_ring>> rings;
+            logger_config config;
+            std::thread thread;
+            bool running = false;
+            bool stopping = false;
+
+            std::atomic<uint64_t> dropped{ 0 };
+
+            FILE* file = nullptr;
+            size_t file_bytes = 0;
+        };
+
+        // never destroyed, threads may log during static destruction
+        log_state& state()
+        {
+            static auto s = new log_state;
+            return *s;
+        }
+
+        thread_local std::shared_ptr<log_ring> local_ring;
+
+        const char* level_name(log_level level)
+        {
+            switch (level)
+            {
+            case log_level::trace: return "TRACE";
+            case log_level::debug: return "DEBUG";
+            case log_level::info: return "INFO";
+            case log_level::warn: return "WARN";
+            case log_level::error: return "ERROR";
+            default: return "?";
+            }
+        }
+
+        const char* base_name(const char* path)
+        {
+            auto name = path;
+            for (auto p = path; *p; ++p)
+            {
+                if (*p == '/' || *p == '\\')
+                {
+                    name = p + 1;
+                }
+            }
+            return name;
+        }
+
+        std::string file_name(const logger_config& config, size_t index)
+        {
+            return index == 0 ? config.path + ".log" : config.path + "." + std::to_string(index) + ".log";
+        }
+
+        void open_file(log_state& s)
+        {
+            s.file = fopen(file_name(s.config, 0).c_str(), "ab");
+            s.file_bytes = 0;
+            if (s.file)
+            {
+                fseek(s.file, 0, SEEK_END);
+                s.file_bytes = static_cast<size_t>(ftell(s.file));
+            }
+        }
+
+        // path.log -> path.1.log -> ... oldest is removed
+        void rotate(log_state& s)
+        {
+            if (s.file)
+            {
+                fclose(s.file);
+                s.file = nullptr;
+            }
+
+            if (s.config.max_files > 1)
+            {
+                std::remove(file_name(s.config, s.config.max_files - 1).c_str());
+                for (auto i = s.config.max_files - 1; i > 0; --i)
+                {
+                    std::rename(file_name(s.config, i - 1).c_str(), file_name(s.config, i).c_str());
+                }
+            }
+            else
+            {
+                std::remove(file_name(s.config, 0).c_str());
+            }
+
+            open_file(s);
+        }
+
+        void format_time(int64_t ns, char* out, size_t size)
+        {
+            const auto seconds = static_cast<std::time_t>(ns / 1000000000);
+            const auto micros = static_cast<long>((ns % 1000000000) / 1000);
+
+            std::tm tm;
+#ifndef __linux__
+            localtime_s(&tm, &seconds);
+#else
+            localtime_r(&seconds, &tm);
+#endif
+            auto n = std::strftime(out, size, "%Y-%m-%d %H:%M:%S", &tm);
+            snprintf(out + n, size - n, ".%06ld", micros);
+        }
+
+        // reads one encoded argument and appends its text
+        bool append_arg(const char*& in, const char* end, std::string& out)
+        {
+            if (in >= end)
+            {
+                return false;
+            }
+
+            const auto type = static_cast<log_detail::arg_type>(*in++);
+            char text[64];
+
+            switch (type)
+            {
+            case log_detail::arg_type::i64:
+            {
+                int64_t v;
+                std::memcpy(&v, in, 8);
+                in += 8;
+                snprintf(text, sizeof(text), "%lld", static_cast<long long>(v));
+                out += text;
+                return true;
+            }
+            case log_detail::arg_type::u64:
+            {
+                uint64_t v;
+                std::memcpy(&v, in, 8);
+                in += 8;
+                snprintf(text, sizeof(text), "%llu", static_cast<unsigned long long>(v));
+                out += text;
+                return true;
+            }
+            case log_detail::arg_type::f64:
+            {
+                double v;
+                std::memcpy(&v, in, 8);
+                in += 8;
+                snprintf(text, sizeof(text), "%g", v);
+                out += text;
+                return true;
+            }
+            case log_detail::arg_type::boolean:
+                out += *in++ ? "true" : "false";
+                return true;
+            case log_detail::arg_type::ptr:
+            {
+                uint64_t v;
+                std::memcpy(&v, in, 8);
+                in += 8;
+                snprintf(text, sizeof(text), "0x%llx", static_cast<unsigned long long>(v));
+                out += text;
+                return true;
+            }
+            case log_detail::arg_type::str:
+            case log_detail::arg_type::wstr:
+            {
+                uint32_t size;
+                std::memcpy(&size, in, sizeof(size));
+                in += sizeof(size);
+                if (type == log_detail::arg_type::str)
+                {
+                    out.append(in, size);
+                }
+                else
+                {
+                    // the record is not wchar_t aligned
+                    std::wstring wide(size / sizeof(wchar_t), L'\0');
+                    std::memcpy(&wide[0], in, size);
+
+                    const auto at = out.size();
+                    out.resize(at + max_utf8_length_from_wide(wide.size()));
+                    const auto result = wide_to_utf8(wide, &out[at], out.size() - at);
+                    out.resize(at + result.written);
+                }
+                in += size;
+                return true;
+            }
+            default:
+                return false;
+            }
+        }
+
+        std::string format_record(const char* record, uint32_t size)
+        {
+            const log_site* site;
+            int64_t timestamp;
+            uint32_t suppressed;
+            std::memcpy(&site, record, sizeof(site));
+            std::memcpy(&timestamp, record + sizeof(site), sizeof(timestamp));
+            std::memcpy(&suppressed, record + sizeof(site) + sizeof(timestamp), sizeof(suppressed));
+
+            const char* in = record + log_detail::header_size;
+            const char* end = record + size;
+
+            char prefix[128];
+            char time[48];
+            format_time(timestamp, time, sizeof(time));
+            snprintf(prefix, sizeof(prefix), "%s %-5s %s:%d ", time, level_name(site->level), base_name(site->file), site->line);
+
+            std::string line = prefix;
+            for (auto f = site->format; *f; ++f)
+            {
+                if (f[0] == '{' && f[1] == '}')
+                {
+                    if (!append_arg(in, end, line))
+                    {
+                        line += "{}";
+                    }
+                    ++f;
+                    continue;
+                }
+                line += *f;
+            }
+
+            if (suppressed)
+            {
+                line += " (" + std::to_string(suppressed) + " suppressed)";
+            }
+
+            line += '\n';
+            return line;
+        }
+
+        void write_line(log_state& s, log_level level, const std::string& line)
+        {
+            if (s.file)
+            {
+                fwrite(line.data(), 1, line.size(), s.file);
+                s.file_bytes += line.size();
+                if (s.file_bytes >= s.config.max_file_bytes)
+                {
+                    rotate(s);
+                }
+            }
+
+            if (level >= s.config.console_level)
+            {
+                fputs(line.c_str(), stderr);
+            }
+        }
+
+        // returns the number of records written
+        size_t drain(log_state& s)
+        {
+            std::vector<std::shared_ptr<log_ring>> rings;
+            {
+                std::lock_guard<std::mutex> lock(s.m);
+                rings = s.rings;
+            }
+
+            size_t written = 0;
+            for (auto& ring : rings)
+            {
+                uint32_t size;
+                while (auto record = ring->peek(size))
+                {
+                    const log_site* site;
+                    std::memcpy(&site, record, sizeof(site));
+
+                    write_line(s, site->level, format_record(record, size));
+                    ring->pop(size);
+                    ++written;
+                }
+            }
+
+            // release the snapshot so the use count only reflects live threads
+            rings.clear();
+
+            // rings of exited threads are dropped once empty
+            {
+                std::lock_guard<std::mutex> lock(s.m);
+                for (auto it = s.rings.begin(); it != s.rings.end();)
+                {
+                    uint32_t size;
+                    if (it->use_count() == 1 && (*it)->peek(size) == nullptr)
+                    {
+                        it = s.rings.erase(it);
+                    }
+                    else
+                    {
+                        ++it;
+                    }
+                }
+            }
+
+            return written;
+        }
+
+        void run(log_state& s)
+        {
+            for (;;)
+            {
+                const auto written = drain(s);
+
+                std::unique_lock<std::mutex> lock(s.m);
+                if (s.stopping)
+                {
+                    break;
+                }
+
+                if (written == 0)
+                {
+                    if (s.file)
+                    {
+                        fflush(s.file);
+                    }
+                    s.cv.wait_for(lock, s.config.flush_interval);
+                }
+            }
+
+            drain(s);
+            if (s.file)
+            {
+                fclose(s.file);
+                s.file = nullptr;
+            }
+        }
+    }
+
+    bool log_rate_limiter::allow(uint32_t& suppressed)
+    {
+        const auto second = log_detail::now_ns() / 1000000000;
+
+        auto window = window_.load(std::memory_order_relaxed);
+        if (window != second && window_.compare_exchange_strong(window, second, std::memory_order_relaxed))
+        {
+            count_.store(0, std::memory_order_relaxed);
+        }
+
+        if (count_.fetch_add(1, std::memory_order_relaxed) < max_per_second_)
+        {
+            suppressed = suppressed_.exchange(0, std::memory_order_relaxed);
+            return true;
+        }
+
+        suppressed_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    namespace log_detail
+    {
+        char* reserve(size_t size)
+        {
+            if (!local_ring)
+            {
+                auto& s = state();
+                std::lock_guard<std::mutex> lock(s.m);
+                local_ring = std::make_shared<log_ring>(s.config.ring_bytes);
+                s.rings.push_back(local_ring);
+            }
+
+            auto out = local_ring->reserve(static_cast<uint32_t>(size));
+            if (out == nullptr)
+            {
+                state().dropped.fetch_add(1, std::memory_order_relaxed);
+            }
+            return out;
+        }
+
+        void commit()
+        {
+            local_ring->commit();
+        }
+
+        int64_t now_ns()
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+        }
+    }
+
+    logger& logger::instance()
+    {
+        static logger l;
+        return l;
+    }
+
+    void logger::start(const logger_config& config)
+    {
+        auto& s = state();
+
+        std::lock_guard<std::mutex> lock(s.m);
+        if (s.running)
+        {
+            return;
+        }
+
+        s.config = config;
+        s.stopping = false;
+        s.running = true;
+        open_file(s);
+
+        s.thread = std::thread([&s] { run(s); });
+    }
+
+    void logger::stop()
+    {
+        auto& s = state();
+        {
+            std::lock_guard<std::mutex> lock(s.m);
+            if (!s.running)
+            {
+                return;
+            }
+            s.stopping = true;
+        }
+        s.cv.notify_all();
+
+        s.thread.join();
+
+        std::lock_guard<std::mutex> lock(s.m);
+        s.running = false;
+    }
+
+    uint64_t logger::dropped() const
+    {
+        return state().dropped.load(std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,236 @@
+#ifndef __LOGGER_H
+#define __LOGGER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <cwchar>
+#include <string>
+#include <type_traits>
+
+// levels below CORE_LOG_MIN_LEVEL are removed at compile time, arguments are not evaluated
+#define CORE_LOG_LEVEL_TRACE 0
+#define CORE_LOG_LEVEL_DEBUG 1
+#define CORE_LOG_LEVEL_INFO  2
+#define CORE_LOG_LEVEL_WARN  3
+#define CORE_LOG_LEVEL_ERROR 4
+
+#ifndef CORE_LOG_MIN_LEVEL
+#ifdef _DEBUG
+#define CORE_LOG_MIN_LEVEL CORE_LOG_LEVEL_DEBUG
+#else
+#define CORE_LOG_MIN_LEVEL CORE_LOG_LEVEL_INFO
+#endif
+#endif
+
+namespace core
+{
+    enum class log_level : uint8_t
+    {
+        trace = CORE_LOG_LEVEL_TRACE,
+        debug = CORE_LOG_LEVEL_DEBUG,
+        info = CORE_LOG_LEVEL_INFO,
+        warn = CORE_LOG_LEVEL_WARN,
+        error = CORE_LOG_LEVEL_ERROR,
+    };
+
+    // one static instance per call site, its address is the format id written to the ring
+    struct log_site
+    {
+        log_level level;
+        const char* format;     // "{}" placeholders
+        const char* file;
+        int line;
+    };
+
+    // at most max_per_second records per call site, the next allowed record reports how many were dropped
+    class log_rate_limiter
+    {
+    public:
+        explicit log_rate_limiter(uint32_t max_per_second) : max_per_second_(max_per_second) {}
+
+        bool allow(uint32_t& suppressed);
+
+    private:
+        const uint32_t max_per_second_;
+        std::atomic<int64_t> window_{ 0 };
+        std::atomic<uint32_t> count_{ 0 };
+        std::atomic<uint32_t> suppressed_{ 0 };
+    };
+
+    struct logger_config
+    {
+        std::string path = "sgs2";              // path.log, path.1.log ... path.<max_files - 1>.log
+        size_t max_file_bytes = 64 * 1024 * 1024;
+        size_t max_files = 8;
+        size_t ring_bytes = 1024 * 1024;        // per thread
+        log_level console_level = log_level::warn;
+        std::chrono::milliseconds flush_interval{ 50 };
+    };
+
+    namespace log_detail
+    {
+        enum class arg_type : uint8_t { i64, u64, f64, boolean, str, wstr, ptr };
+
+        // [site*][timestamp ns][suppressed u32][arg]...
+        static constexpr size_t header_size = sizeof(const log_site*) + sizeof(int64_t) + sizeof(uint32_t);
+
+        template <typename T>
+        using is_signed_integer = std::integral_constant<bool, std::is_integral<T>::value && std::is_signed<T>::value && !std::is_same<T, bool>::value>;
+
+        template <typename T>
+        using is_unsigned_integer = std::integral_constant<bool, std::is_integral<T>::value && std::is_unsigned<T>::value && !std::is_same<T, bool>::value>;
+
+        inline size_t size_of(bool) { return 1 + 1; }
+        inline size_t size_of(double) { return 1 + 8; }
+        inline size_t size_of(float) { return 1 + 8; }
+        inline size_t size_of(const char* s) { return 1 + 4 + (s ? std::strlen(s) : 0); }
+        inline size_t size_of(const std::string& s) { return 1 + 4 + s.size(); }
+        inline size_t size_of(const wchar_t* s) { return 1 + 4 + (s ? std::wcslen(s) : 0) * sizeof(wchar_t); }
+        inline size_t size_of(const std::wstring& s) { return 1 + 4 + s.size() * sizeof(wchar_t); }
+        inline size_t size_of(const void*) { return 1 + 8; }
+
+        template <typename T, typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value, int>::type = 0>
+        size_t size_of(T) { return 1 + 8; }
+
+        template <typename T, typename std::enable_if<std::is_enum<T>::value, int>::type = 0>
+        size_t size_of(T) { return 1 + 8; }
+
+        inline void put(char*& out, arg_type type, const void* data, size_t size)
+        {
+            *out++ = static_cast<char>(type);
+            std::memcpy(out, data, size);
+            out += size;
+        }
+
+        inline void put_bytes(char*& out, arg_type type, const void* data, uint32_t size)
+        {
+            *out++ = static_cast<char>(type);
+            std::memcpy(out, &size, sizeof(size));
+            out += sizeof(size);
+            if (size)
+            {
+                std::memcpy(out, data, size);
+                out += size;
+            }
+        }
+
+        inline void encode(char*& out, bool v) { uint8_t b = v ? 1 : 0; put(out, arg_type::boolean, &b, 1); }
+        inline void encode(char*& out, double v) { put(out, arg_type::f64, &v, 8); }
+        inline void encode(char*& out, float v) { double d = v; put(out, arg_type::f64, &d, 8); }
+        inline void encode(char*& out, const char* s) { put_bytes(out, arg_type::str, s, static_cast<uint32_t>(s ? std::strlen(s) : 0)); }
+        inline void encode(char*& out, const std::string& s) { put_bytes(out, arg_type::str, s.data(), static_cast<uint32_t>(s.size())); }
+        inline void encode(char*& out, const wchar_t* s) { put_bytes(out, arg_type::wstr, s, static_cast<uint32_t>((s ? std::wcslen(s) : 0) * sizeof(wchar_t))); }
+        inline void encode(char*& out, const std::wstring& s) { put_bytes(out, arg_type::wstr, s.data(), static_cast<uint32_t>(s.size() * sizeof(wchar_t))); }
+        inline void encode(char*& out, const void* p) { auto v = reinterpret_cast<uint64_t>(p); put(out, arg_type::ptr, &v, 8); }
+
+        template <typename T, typename std::enable_if<is_signed_integer<T>::value, int>::type = 0>
+        void encode(char*& out, T v) { int64_t w = v; put(out, arg_type::i64, &w, 8); }
+
+        template <typename T, typename std::enable_if<is_unsigned_integer<T>::value, int>::type = 0>
+        void encode(char*& out, T v) { uint64_t w = v; put(out, arg_type::u64, &w, 8); }
+
+        template <typename T, typename std::enable_if<std::is_enum<T>::value, int>::type = 0>
+        void encode(char*& out, T v) { int64_t w = static_cast<int64_t>(v); put(out, arg_type::i64, &w, 8); }
+
+        inline size_t total_size() { return 0; }
+
+        template <typename T, typename... Rest>
+        size_t total_size(const T& first, const Rest&... rest) { return size_of(first) + total_size(rest...); }
+
+        inline void encode_all(char*&) {}
+
+        template <typename T, typename... Rest>
+        void encode_all(char*& out, const T& first, const Rest&... rest)
+        {
+            encode(out, first);
+            encode_all(out, rest...);
+        }
+
+        // calling thread's ring, nullptr when the record does not fit (counted as dropped)
+        char* reserve(size_t size);
+        void commit();
+
+        int64_t now_ns();
+    }
+
+    class logger
+    {
+    public:
+        static logger& instance();
+
+        void start(const logger_config& config);
+
+        // drains every ring before returning
+        void stop();
+
+        // records that did not fit in their thread's ring
+        uint64_t dropped() const;
+
+        template <typename... Args>
+        static void write(const log_site& site, uint32_t suppressed, const Args&... args)
+        {
+            const auto size = log_detail::header_size + log_detail::total_size(args...);
+
+            auto out = log_detail::reserve(size);
+            if (out == nullptr)
+            {
+                return;
+            }
+
+            const auto site_ptr = &site;
+            const auto timestamp = log_detail::now_ns();
+            std::memcpy(out, &site_ptr, sizeof(site_ptr));
+            std::memcpy(out + sizeof(site_ptr), &timestamp, sizeof(timestamp));
+            std::memcpy(out + sizeof(site_ptr) + sizeof(timestamp), &suppressed, sizeof(suppressed));
+            out += log_detail::header_size;
+
+            log_detail::encode_all(out, args...);
+            log_detail::commit();
+        }
+
+    private:
+        logger() = default;
+    };
+}
+
+#define CORE_LOG_SITE(level_value, format) \
+    static const ::core::log_site core_log_site = { static_cast<::core::log_level>(level_value), format, __FILE__, __LINE__ }
+
+#define CORE_LOG(level_value, format, ...) \
+    do \
+    { \
+        if (level_value >= CORE_LOG_MIN_LEVEL) \
+        { \
+            CORE_LOG_SITE(level_value, format); \
+            ::core::logger::write(core_log_site, 0, ##__VA_ARGS__); \
+        } \
+    } while (0)
+
+#define CORE_LOG_RATE_LIMITED(level_value, max_per_second, format, ...) \
+    do \
+    { \
+        if (level_value >= CORE_LOG_MIN_LEVEL) \
+        { \
+            CORE_LOG_SITE(level_value, format); \
+            static ::core::log_rate_limiter core_log_limiter(max_per_second); \
+            uint32_t core_log_suppressed = 0; \
+            if (core_log_limiter.allow(core_log_suppressed)) \
+            { \
+                ::core::logger::write(core_log_site, core_log_suppressed, ##__VA_ARGS__); \
+            } \
+        } \
+    } while (0)
+
+#define LOG_TRACE(format, ...) CORE_LOG(CORE_LOG_LEVEL_TRACE, format, ##__VA_ARGS__)
+#define LOG_DEBUG(format, ...) CORE_LOG(CORE_LOG_LEVEL_DEBUG, format, ##__VA_ARGS__)
+#define LOG_INFO(format, ...) CORE_LOG(CORE_LOG_LEVEL_INFO, format, ##__VA_ARGS__)
+#define LOG_WARN(format, ...) CORE_LOG(CORE_LOG_LEVEL_WARN, format, ##__VA_ARGS__)
+#define LOG_ERROR(format, ...) CORE_LOG(CORE_LOG_LEVEL_ERROR, format, ##__VA_ARGS__)
+
+// error storms: LOG_WARN_LIMITED(10, "send failed {}", ec.value())
+#define LOG_WARN_LIMITED(max_per_second, format, ...) CORE_LOG_RATE_LIMITED(CORE_LOG_LEVEL_WARN, max_per_second, format, ##__VA_ARGS__)
+#define LOG_ERROR_LIMITED(max_per_second, format, ...) CORE_LOG_RATE_LIMITED(CORE_LOG_LEVEL_ERROR, max_per_second, format, ##__VA_ARGS__)
+
+#endif
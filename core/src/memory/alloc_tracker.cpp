@@ -0,0 +1,250 @@
+#include "alloc_tracker.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace core
+{
+    namespace
+    {
+        // everything here is zero / constant initialized, operator new runs before dynamic initialization
+        static constexpr size_t max_slots = 512;
+
+        struct alignas(64) thread_slot
+        {
+            std::atomic<uint64_t> allocations[alloc_tag_count];
+            std::atomic<uint64_t> bytes[alloc_tag_count];
+            std::atomic<uint64_t> frees[alloc_tag_count];
+            std::atomic<uint64_t> freed_bytes[alloc_tag_count];
+            std::atomic<uint64_t> total_allocations;
+        };
+
+        // the last slot is shared by threads beyond max_slots - 1
+        thread_slot slots[max_slots];
+        std::atomic<size_t> next_slot{ 0 };
+        std::atomic<alloc_tracker::hook> observer{ nullptr };
+
+        thread_local int slot_index = -1;
+        thread_local alloc_tag current_tag = alloc_tag::untagged;
+
+        struct alignas(16) block_header
+        {
+            uint64_t size;
+            alloc_tag tag;
+        };
+
+        static_assert(sizeof(block_header) == 16, "keeps blocks 16 byte aligned");
+
+        thread_slot& local_slot(bool& shared)
+        {
+            if (slot_index < 0)
+            {
+                const auto index = next_slot.fetch_add(1, std::memory_order_relaxed);
+                slot_index = static_cast<int>(index < max_slots - 1 ? index : max_slots - 1);
+            }
+
+            shared = slot_index == static_cast<int>(max_slots - 1);
+            return slots[slot_index];
+        }
+
+        // single writer per slot except the shared one
+        void add(std::atomic<uint64_t>& counter, uint64_t value, bool shared)
+        {
+            if (shared)
+            {
+                counter.fetch_add(value, std::memory_order_relaxed);
+            }
+            else
+            {
+                counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+            }
+        }
+
+        void* allocate(size_t size)
+        {
+            auto header = static_cast<block_header*>(std::malloc(size + sizeof(block_header)));
+            if (header == nullptr)
+            {
+                return nullptr;
+            }
+
+            const auto tag = current_tag;
+            header->size = size;
+            header->tag = tag;
+
+            auto shared = false;
+            auto& slot = local_slot(shared);
+            const auto index = static_cast<size_t>(tag);
+            add(slot.allocations[index], 1, shared);
+            add(slot.bytes[index], size, shared);
+            add(slot.total_allocations, 1, shared);
+
+            if (auto h = observer.load(std::memory_order_relaxed))
+            {
+                h(true, size, tag);
+            }
+
+            return header + 1;
+        }
+
+        void deallocate(void* p)
+        {
+            if (p == nullptr)
+            {
+                return;
+            }
+
+            auto header = static_cast<block_header*>(p) - 1;
+            const auto size = header->size;
+            const auto tag = header->tag;
+
+            auto shared = false;
+            auto& slot = local_slot(shared);
+            const auto index = static_cast<size_t>(tag);
+            add(slot.frees[index], 1, shared);
+            add(slot.freed_bytes[index], size, shared);
+
+            if (auto h = observer.load(std::memory_order_relaxed))
+            {
+                h(false, size, tag);
+            }
+
+            std::free(header);
+        }
+
+        void* allocate_or_throw(size_t size)
+        {
+            for (;;)
+            {
+                if (auto p = allocate(size))
+                {
+                    return p;
+                }
+
+                auto handler = std::get_new_handler();
+                if (handler == nullptr)
+                {
+                    throw std::bad_alloc();
+                }
+                handler();
+            }
+        }
+
+        alloc_stats read(const thread_slot& slot, alloc_stats stats)
+        {
+            for (size_t i = 0; i < alloc_tag_count; ++i)
+            {
+                stats[i].allocations += slot.allocations[i].load(std::memory_order_relaxed);
+                stats[i].bytes += slot.bytes[i].load(std::memory_order_relaxed);
+                stats[i].frees += slot.frees[i].load(std::memory_order_relaxed);
+                stats[i].freed_bytes += slot.freed_bytes[i].load(std::memory_order_relaxed);
+            }
+            return stats;
+        }
+    }
+
+    const char* alloc_tag_name(alloc_tag tag)
+    {
+        switch (tag)
+        {
+        case alloc_tag::untagged: return "untagged";
+        case alloc_tag::read: return "read";
+        case alloc_tag::dispatch: return "dispatch";
+        case alloc_tag::handler: return "handler";
+        case alloc_tag::send: return "send";
+        case alloc_tag::room: return "room";
+        case alloc_tag::admin: return "admin";
+        default: return "?";
+        }
+    }
+
+    void alloc_tracker::set_hook(hook h)
+    {
+        observer.store(h, std::memory_order_relaxed);
+    }
+
+    alloc_stats alloc_tracker::thread_stats()
+    {
+        auto shared = false;
+        return read(local_slot(shared), alloc_stats());
+    }
+
+    alloc_stats alloc_tracker::snapshot()
+    {
+        const auto used = (std::min)(next_slot.load(std::memory_order_relaxed), max_slots);
+
+        alloc_stats stats;
+        for (size_t i = 0; i < used; ++i)
+        {
+            stats = read(slots[i], stats);
+        }
+        return stats;
+    }
+
+    uint64_t alloc_tracker::thread_allocations()
+    {
+        auto shared = false;
+        return local_slot(shared).total_allocations.load(std::memory_order_relaxed);
+    }
+
+    alloc_scope::alloc_scope(alloc_tag tag) : previous_(current_tag)
+    {
+        current_tag = tag;
+    }
+
+    alloc_scope::~alloc_scope()
+    {
+        current_tag = previous_;
+    }
+}
+
+void* operator new(size_t size)
+{
+    return core::allocate_or_throw(size);
+}
+
+void* operator new[](size_t size)
+{
+    return core::allocate_or_throw(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    return core::allocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    return core::allocate(size);
+}
+
+void operator delete(void* p) noexcept
+{
+    core::deallocate(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    core::deallocate(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    core::deallocate(p);
+}
+
+void operator delete[](void* p, size_t) noexcept
+{
+    core::deallocate(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept
+{
+    core::deallocate(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept
+{
+    core::deallocate(p);
+}
@@ -0,0 +1,88 @@
+#ifndef __ALLOC_TRACKER_H
+#define __ALLOC_TRACKER_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace core
+{
+    // subsystem an allocation is charged to, set by the innermost alloc_scope
+    enum class alloc_tag : unsigned char
+    {
+        untagged,
+        read,
+        dispatch,
+        handler,
+        send,
+        room,
+        admin,
+    };
+
+    static constexpr size_t alloc_tag_count = 7;
+
+    const char* alloc_tag_name(alloc_tag tag);
+
+    struct alloc_counts
+    {
+        uint64_t allocations = 0;
+        uint64_t bytes = 0;
+        uint64_t frees = 0;
+        uint64_t freed_bytes = 0;
+
+        // frees are charged to the tag that allocated the block
+        int64_t live_bytes() const { return static_cast<int64_t>(bytes) - static_cast<int64_t>(freed_bytes); }
+    };
+
+    using alloc_stats = std::array<alloc_counts, alloc_tag_count>;
+
+    // global operator new / delete replacement, linked in with this file
+    // every block carries a 16 byte header with its size and tag so frees on any thread are charged correctly
+    // counting is per thread with plain stores, snapshot() sums every thread
+    class alloc_tracker
+    {
+    public:
+        // optional observer, called on the allocating / freeing thread, must not allocate
+        using hook = void(*)(bool allocate, size_t size, alloc_tag tag);
+        static void set_hook(hook h);
+
+        // totals of the calling thread
+        static alloc_stats thread_stats();
+
+        // totals over all threads, including exited ones
+        static alloc_stats snapshot();
+
+        // allocations by the calling thread, cheap enough for assertions in loops
+        static uint64_t thread_allocations();
+    };
+
+    class alloc_scope
+    {
+    public:
+        explicit alloc_scope(alloc_tag tag);
+        ~alloc_scope();
+
+        alloc_scope(const alloc_scope&) = delete;
+        alloc_scope& operator=(const alloc_scope&) = delete;
+
+    private:
+        const alloc_tag previous_;
+    };
+
+    // counts what the calling thread allocates while it is alive
+    //   core::alloc_probe probe;
+    //   handle_packet(...);
+    //   assert(probe.allocations() == 0);
+    class alloc_probe
+    {
+    public:
+        alloc_probe() : start_(alloc_tracker::thread_allocations()) {}
+
+        uint64_t allocations() const { return alloc_tracker::thread_allocations() - start_; }
+
+    private:
+        const uint64_t start_;
+    };
+}
+
+#endif
@@ -0,0 +1,89 @@
+#include "arena.h"
+#include <cstdint>
+
+namespace core
+{
+    namespace
+    {
+        char* align_up(char* p, size_t alignment)
+        {
+            const auto value = reinterpret_cast<uintptr_t>(p);
+            return reinterpret_cast<char*>((value + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1));
+        }
+    }
+
+    arena::arena(size_t block_size) : block_size_(block_size)
+    {
+    }
+
+    arena::~arena()
+    {
+        for (auto& b : blocks_)
+        {
+            ::operator delete(b.memory);
+        }
+    }
+
+    void* arena::allocate(size_t size, size_t alignment)
+    {
+        auto p = align_up(cursor_, alignment);
+        if (cursor_ == nullptr || p + size > end_)
+        {
+            next_block(size, alignment);
+            p = align_up(cursor_, alignment);
+        }
+
+        cursor_ = p + size;
+        return p;
+    }
+
+    void arena::next_block(size_t size, size_t alignment)
+    {
+        const auto needed = size + alignment;
+        const auto next = blocks_.empty() ? 0 : current_ + 1;
+
+        // a kept block is reused when it fits, otherwise a new one goes in front of it
+        if (next >= blocks_.size() || blocks_[next].size < needed)
+        {
+            const auto bytes = needed > block_size_ ? needed : block_size_;
+            blocks_.insert(blocks_.begin() + next, block{ static_cast<char*>(::operator new(bytes)), bytes });
+            reserved_ += bytes;
+        }
+
+        current_ = next;
+        cursor_ = blocks_[next].memory;
+        end_ = cursor_ + blocks_[next].size;
+    }
+
+    void arena::rewind(const marker& m)
+    {
+        if (blocks_.empty())
+        {
+            return;
+        }
+
+        current_ = m.block;
+        cursor_ = m.cursor != nullptr ? m.cursor : blocks_[current_].memory;
+        end_ = blocks_[current_].memory + blocks_[current_].size;
+    }
+
+    void arena::reset()
+    {
+        rewind({ 0, nullptr });
+    }
+
+    size_t arena::used() const
+    {
+        if (blocks_.empty())
+        {
+            return 0;
+        }
+
+        size_t bytes = 0;
+        for (size_t i = 0; i < current_; ++i)
+        {
+            bytes += blocks_[i].size;
+        }
+        return bytes + static_cast<size_t>(cursor_ - blocks_[current_].memory);
+    }
+}
@@ -0,0 +1,101 @@
+#ifndef __ARENA_H
+#define __ARENA_H
+
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace core
+{
+    // bump allocator for the short lived allocations of one unit of work (a packet, a tick), not thread safe
+    // nothing is freed one by one and destructors never run, reset() or a scope rewinds everything at once
+    // blocks are kept across resets, a warm arena does not allocate
+    class arena
+    {
+    public:
+        explicit arena(size_t block_size = 64 * 1024);
+        ~arena();
+
+        arena(const arena&) = delete;
+        arena& operator=(const arena&) = delete;
+
+        void* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+        template <typename T, typename... Args>
+        T* create(Args&&... args)
+        {
+            return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+        }
+
+        struct marker
+        {
+            size_t block;
+            char* cursor;
+        };
+
+        marker mark() const { return{ current_, cursor_ }; }
+        void rewind(const marker& m);
+        void reset();
+
+        // bytes handed out since the last reset, and bytes held in blocks
+        size_t used() const;
+        size_t reserved() const { return reserved_; }
+
+        // rewinds to where it was constructed
+        //   core::arena::scope scratch(frame_arena);
+        class scope
+        {
+        public:
+            explicit scope(arena& a) : arena_(a), marker_(a.mark()) {}
+            ~scope() { arena_.rewind(marker_); }
+
+            scope(const scope&) = delete;
+            scope& operator=(const scope&) = delete;
+
+        private:
+            arena& arena_;
+            const marker marker_;
+        };
+
+    private:
+        void next_block(size_t size, size_t alignment);
+
+        struct block
+        {
+            char* memory;
+            size_t size;
+        };
+
+        const size_t block_size_;
+        std::vector<block> blocks_;
+        size_t current_ = 0;
+        char* cursor_ = nullptr;
+        char* end_ = nullptr;
+        size_t reserved_ = 0;
+    };
+
+    // std allocator over an arena, deallocate is a no-op
+    template <typename T>
+    class arena_allocator
+    {
+    public:
+        using value_type = T;
+
+        explicit arena_allocator(arena& a) : arena_(&a) {}
+        template <typename U> arena_allocator(const arena_allocator<U>& other) : arena_(other.arena_) {}
+
+        T* allocate(size_t n) { return static_cast<T*>(arena_->allocate(n * sizeof(T), alignof(T))); }
+        void deallocate(T*, size_t) {}
+
+        template <typename U> bool operator==(const arena_allocator<U>& other) const { return arena_ == other.arena_; }
+        template <typename U> bool operator!=(const arena_allocator<U>& other) const { return arena_ != other.arena_; }
+
+    private:
+        template <typename U> friend class arena_allocator;
+
+        arena* arena_;
+    };
+}
+
+#endif
@@ -0,0 +1,258 @@
+#include "fixed_pool.h"
+#include <array>
+#include <atomic>
+#include <cstring>
+
+namespace core
+{
+    namespace
+    {
+        // pools with a magazine slot, later pools fall back to the depot on every call
+        constexpr size_t max_pools = 256;
+
+        std::mutex registry_lock;
+        fixed_pool* registry[max_pools] = {};
+        uint64_t next_generation = 0;
+    }
+
+    struct fixed_pool::magazine
+    {
+        fixed_pool* pool;
+        uint64_t generation;
+        size_t count = 0;
+        void* items[magazine_size * 2];
+    };
+
+    // returns every magazine to its pool when the thread exits, unless the pool is already gone
+    // current and exited are trivially destructible thread_locals, so frees that run after this is
+    // destroyed (other thread_local destructors, exit) read them instead of the dead object
+    struct fixed_pool::thread_magazines
+    {
+        std::array<magazine*, max_pools> slots{};
+        thread_magazines*& current;
+        bool& exited;
+
+        thread_magazines(thread_magazines*& current_slot, bool& exited_flag) : current(current_slot), exited(exited_flag)
+        {
+            current = this;
+        }
+
+        ~thread_magazines()
+        {
+            current = nullptr;
+            exited = true;
+
+            std::lock_guard<std::mutex> lock(registry_lock);
+            for (size_t i = 0; i < max_pools; ++i)
+            {
+                auto m = slots[i];
+                if (m == nullptr)
+                {
+                    continue;
+                }
+
+                if (registry[i] == m->pool && m->pool->generation_ == m->generation && m->count != 0)
+                {
+                    m->pool->flush(*m, m->count);
+                }
+                delete m;
+            }
+        }
+    };
+
+    fixed_pool::fixed_pool(size_t block_size, size_t alignment, const slab_options& options)
+        : block_size_(block_size), slabs_(block_size, alignment, options)
+    {
+        std::lock_guard<std::mutex> lock(registry_lock);
+        generation_ = ++next_generation;
+        for (size_t i = 0; i < max_pools; ++i)
+        {
+            if (registry[i] == nullptr)
+            {
+                registry[i] = this;
+                slot_ = static_cast<int>(i);
+                break;
+            }
+        }
+    }
+
+    fixed_pool::~fixed_pool()
+    {
+        // magazines still holding this slot are dropped by the next pool using it or at thread exit
+        std::lock_guard<std::mutex> lock(registry_lock);
+        if (slot_ >= 0)
+        {
+            registry[slot_] = nullptr;
+        }
+    }
+
+    fixed_pool::magazine* fixed_pool::local()
+    {
+        if (slot_ < 0)
+        {
+            return nullptr;
+        }
+
+        static thread_local thread_magazines* current = nullptr;
+        static thread_local bool exited = false;
+        if (current == nullptr)
+        {
+            if (exited)
+            {
+                return nullptr;
+            }
+            static thread_local thread_magazines magazines(current, exited);
+        }
+
+        auto& m = current->slots[slot_];
+        if (m != nullptr && m->pool == this && m->generation == generation_)
+        {
+            return m;
+        }
+
+        // first use on this thread, or the slot belonged to a destroyed pool
+        delete m;
+        m = new magazine;
+        m->pool = this;
+        m->generation = generation_;
+        return m;
+    }
+
+    void* fixed_pool::allocate()
+    {
+        auto m = local();
+        if (m == nullptr)
+        {
+            std::lock_guard<std::mutex> lock(m_);
+            if (!depot_.empty())
+            {
+                auto p = depot_.back();
+                depot_.pop_back();
+                return p;
+            }
+            return slabs_.allocate();
+        }
+
+        if (m->count == 0)
+        {
+            refill(*m);
+            if (m->count == 0)
+            {
+                return nullptr;
+            }
+        }
+
+        return m->items[--m->count];
+    }
+
+    void fixed_pool::deallocate(void* p)
+    {
+        if (p == nullptr)
+        {
+            return;
+        }
+
+        auto m = local();
+        if (m == nullptr)
+        {
+            std::lock_guard<std::mutex> lock(m_);
+            depot_.push_back(p);
+            return;
+        }
+
+        if (m->count == magazine_size * 2)
+        {
+            flush(*m, magazine_size);
+        }
+
+        m->items[m->count++] = p;
+    }
+
+    void fixed_pool::reserve(size_t count)
+    {
+        std::lock_guard<std::mutex> lock(m_);
+        depot_.reserve(depot_.size() + count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            auto p = slabs_.allocate();
+            if (p == nullptr)
+            {
+                break;
+            }
+            depot_.push_back(p);
+        }
+    }
+
+    void fixed_pool::refill(magazine& m)
+    {
+        std::lock_guard<std::mutex> lock(m_);
+        ++refills_;
+
+        const auto take = depot_.size() < magazine_size ? depot_.size() : magazine_size;
+        if (take != 0)
+        {
+            std::memcpy(m.items, depot_.data() + depot_.size() - take, take * sizeof(void*));
+            depot_.resize(depot_.size() - take);
+            m.count = take;
+            return;
+        }
+
+        m.count = slabs_.allocate_batch(m.items, magazine_size);
+    }
+
+    void fixed_pool::flush(magazine& m, size_t count)
+    {
+        std::lock_guard<std::mutex> lock(m_);
+        ++flushes_;
+
+        // oldest blocks go, the recently freed (cache warm) ones stay
+        depot_.insert(depot_.end(), m.items, m.items + count);
+        std::memmove(m.items, m.items + count, (m.count - count) * sizeof(void*));
+        m.count -= count;
+    }
+
+    pool_stats fixed_pool::stats() const
+    {
+        std::lock_guard<std::mutex> lock(m_);
+
+        pool_stats s;
+        s.block_size = slabs_.block_size();
+        s.blocks = slabs_.carved();
+        s.slabs = slabs_.slab_count();
+        s.reserved_bytes = slabs_.reserved_bytes();
+        s.depot = depot_.size();
+        s.refills = refills_;
+        s.flushes = flushes_;
+        return s;
+    }
+
+    fixed_pool* fixed_pool::for_size(size_t size)
+    {
+        constexpr size_t granularity = 16;
+        constexpr size_t classes = max_size_class / granularity;
+
+        if (size == 0 || size > max_size_class)
+        {
+            return nullptr;
+        }
+
+        static std::mutex lock;
+        static std::atomic<fixed_pool*> pools[classes];
+
+        const auto index = (size - 1) / granularity;
+        if (auto pool = pools[index].load(std::memory_order_acquire))
+        {
+            return pool;
+        }
+
+        std::lock_guard<std::mutex> guard(lock);
+        auto pool = pools[index].load(std::memory_order_relaxed);
+        if (pool == nullptr)
+        {
+            // never destroyed, blocks may be freed during static destruction
+            pool = new fixed_pool((index + 1) * granularity, granularity);
+            pools[index].store(pool, std::memory_order_release);
+        }
+        return pool;
+    }
+}
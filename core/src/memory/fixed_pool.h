@@ -0,0 +1,76 @@
+#ifndef __FIXED_POOL_H
+#define __FIXED_POOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include "slab.h"
+
+namespace core
+{
+    struct pool_stats
+    {
+        size_t block_size = 0;
+        size_t blocks = 0;          // carved from slabs, free or in use
+        size_t slabs = 0;
+        size_t reserved_bytes = 0;
+        size_t depot = 0;           // free blocks in the shared depot
+        uint64_t refills = 0;       // thread magazines refilled from the depot or slabs
+        uint64_t flushes = 0;       // thread magazines that overflowed into the depot
+    };
+
+    // fixed size blocks for any thread
+    // each thread keeps a magazine of free blocks per pool and frees go to the freeing thread's magazine,
+    // so a block allocated on one thread and freed on another comes back without touching its owner
+    // magazines trade batches with a shared depot under a mutex, the depot carves new blocks from slabs
+    // memory goes back to the os only when the pool is destroyed, after the threads that used it are done with it
+    class fixed_pool
+    {
+    public:
+        static constexpr size_t magazine_size = 32;
+
+        fixed_pool(size_t block_size, size_t alignment = alignof(std::max_align_t), const slab_options& options = slab_options());
+        ~fixed_pool();
+
+        fixed_pool(const fixed_pool&) = delete;
+        fixed_pool& operator=(const fixed_pool&) = delete;
+
+        // nullptr only when the os is out of memory
+        void* allocate();
+        void deallocate(void* p);
+
+        // puts count blocks in the depot ahead of the first allocations, on any thread
+        void reserve(size_t count);
+
+        size_t block_size() const { return block_size_; }
+        pool_stats stats() const;
+
+        // never destroyed pools in 16 byte classes, nullptr past max_size_class
+        static constexpr size_t max_size_class = 1024;
+        static fixed_pool* for_size(size_t size);
+
+    private:
+        // per thread state, defined in the .cpp
+        struct magazine;
+        struct thread_magazines;
+
+        magazine* local();
+        void refill(magazine& m);
+        void flush(magazine& m, size_t count);
+
+        const size_t block_size_;
+
+        mutable std::mutex m_;
+        slab_allocator slabs_;
+        std::vector<void*> depot_;
+        uint64_t refills_ = 0;
+        uint64_t flushes_ = 0;
+
+        // thread magazines are indexed by slot, the generation tells a reused slot apart
+        int slot_ = -1;
+        uint64_t generation_ = 0;
+    };
+}
+
+#endif
@@ -0,0 +1,121 @@
+#ifndef __OBJECT_POOL_H
+#define __OBJECT_POOL_H
+
+#include <memory>
+#include <new>
+#include <utility>
+#include "fixed_pool.h"
+
+namespace core
+{
+    // std allocator over the shared size class pools, single objects only, arrays go to operator new
+    // allocate_shared<T>(pool_allocator<T>(), ...) puts object and control block in one pooled block
+    template <typename T>
+    class pool_allocator
+    {
+    public:
+        using value_type = T;
+
+        pool_allocator() = default;
+        template <typename U> pool_allocator(const pool_allocator<U>&) {}
+
+        T* allocate(size_t n)
+        {
+            if (n == 1 && alignof(T) <= 16)
+            {
+                if (auto pool = fixed_pool::for_size(sizeof(T)))
+                {
+                    if (auto p = pool->allocate())
+                    {
+                        return static_cast<T*>(p);
+                    }
+                    throw std::bad_alloc();
+                }
+            }
+            return static_cast<T*>(::operator new(n * sizeof(T)));
+        }
+
+        void deallocate(T* p, size_t n)
+        {
+            if (n == 1 && alignof(T) <= 16)
+            {
+                if (auto pool = fixed_pool::for_size(sizeof(T)))
+                {
+                    pool->deallocate(p);
+                    return;
+                }
+            }
+            ::operator delete(p);
+        }
+
+        template <typename U> bool operator==(const pool_allocator<U>&) const { return true; }
+        template <typename U> bool operator!=(const pool_allocator<U>&) const { return false; }
+    };
+
+    // typed pool with its own slabs, for objects with a population of their own (sessions, rooms, entities)
+    // the pool must outlive every object it handed out
+    template <typename T>
+    class object_pool
+    {
+    public:
+        explicit object_pool(const slab_options& options = slab_options()) : pool_(sizeof(T), alignof(T), options) {}
+
+        template <typename... Args>
+        T* create(Args&&... args)
+        {
+            auto p = pool_.allocate();
+            if (p == nullptr)
+            {
+                throw std::bad_alloc();
+            }
+
+            try
+            {
+                return new (p) T(std::forward<Args>(args)...);
+            }
+            catch (...)
+            {
+                pool_.deallocate(p);
+                throw;
+            }
+        }
+
+        void destroy(T* object)
+        {
+            if (object != nullptr)
+            {
+                object->~T();
+                pool_.deallocate(object);
+            }
+        }
+
+        struct deleter
+        {
+            object_pool* pool;
+            void operator()(T* object) const { pool->destroy(object); }
+        };
+
+        using unique_ptr = std::unique_ptr<T, deleter>;
+
+        template <typename... Args>
+        unique_ptr make_unique(Args&&... args)
+        {
+            return unique_ptr(create(std::forward<Args>(args)...), deleter{ this });
+        }
+
+        // object from this pool, control block from the shared size classes
+        template <typename... Args>
+        std::shared_ptr<T> make_shared(Args&&... args)
+        {
+            return std::shared_ptr<T>(create(std::forward<Args>(args)...), deleter{ this }, pool_allocator<T>());
+        }
+
+        void reserve(size_t count) { pool_.reserve(count); }
+        pool_stats stats() const { return pool_.stats(); }
+
+    private:
+        fixed_pool pool_;
+    };
+}
+
+#endif
@@ -0,0 +1,165 @@
+#include "slab.h"
+
+#ifndef __linux__
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace core
+{
+    namespace
+    {
+        constexpr size_t huge_page_size = 2 * 1024 * 1024;
+
+        size_t round_up(size_t value, size_t multiple)
+        {
+            return (value + multiple - 1) / multiple * multiple;
+        }
+
+#ifndef __linux__
+
+        // large pages need SeLockMemoryPrivilege, without it VirtualAlloc fails and we take normal pages
+        void* map_pages(size_t& size, bool huge_pages, bool& huge)
+        {
+            huge = false;
+            if (huge_pages)
+            {
+                const auto large = GetLargePageMinimum();
+                if (large != 0)
+                {
+                    const auto rounded = round_up(size, large);
+                    if (auto p = VirtualAlloc(nullptr, rounded, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE))
+                    {
+                        size = rounded;
+                        huge = true;
+                        return p;
+                    }
+                }
+            }
+
+            return VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+        }
+
+        void unmap_pages(void* p, size_t /*size*/)
+        {
+            VirtualFree(p, 0, MEM_RELEASE);
+        }
+
+#else
+
+        // explicit hugetlb pages first, then transparent huge pages as a hint
+        void* map_pages(size_t& size, bool huge_pages, bool& huge)
+        {
+            huge = false;
+            if (huge_pages)
+            {
+                const auto rounded = round_up(size, huge_page_size);
+                auto p = mmap(nullptr, rounded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+                if (p != MAP_FAILED)
+                {
+                    size = rounded;
+                    huge = true;
+                    return p;
+                }
+            }
+
+            auto p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (p == MAP_FAILED)
+            {
+                return nullptr;
+            }
+
+#ifdef MADV_HUGEPAGE
+            if (huge_pages)
+            {
+                madvise(p, size, MADV_HUGEPAGE);
+            }
+#endif
+            return p;
+        }
+
+        void unmap_pages(void* p, size_t size)
+        {
+            munmap(p, size);
+        }
+
+#endif
+    }
+
+    slab_allocator::slab_allocator(size_t block_size, size_t alignment, const slab_options& options)
+        : block_size_(round_up(block_size < sizeof(void*) ? sizeof(void*) : block_size, alignment)), options_(options)
+    {
+    }
+
+    slab_allocator::~slab_allocator()
+    {
+        for (auto& s : slabs_)
+        {
+            unmap_pages(s.memory, s.size);
+        }
+    }
+
+    void* slab_allocator::allocate()
+    {
+        if (free_ != nullptr)
+        {
+            auto p = free_;
+            free_ = *static_cast<void**>(p);
+            return p;
+        }
+
+        if (cursor_ + block_size_ > end_ && !grow())
+        {
+            return nullptr;
+        }
+
+        auto p = cursor_;
+        cursor_ += block_size_;
+        ++carved_;
+        return p;
+    }
+
+    void slab_allocator::deallocate(void* p)
+    {
+        *static_cast<void**>(p) = free_;
+        free_ = p;
+    }
+
+    size_t slab_allocator::allocate_batch(void** out, size_t count)
+    {
+        size_t n = 0;
+        while (n < count)
+        {
+            auto p = allocate();
+            if (p == nullptr)
+            {
+                break;
+            }
+            out[n++] = p;
+        }
+        return n;
+    }
+
+    bool slab_allocator::grow()
+    {
+        auto size = round_up(options_.slab_bytes < block_size_ ? block_size_ : options_.slab_bytes, 4096);
+
+        auto huge = false;
+        auto memory = map_pages(size, options_.huge_pages, huge);
+        if (memory == nullptr)
+        {
+            return false;
+        }
+
+        slabs_.push_back({ memory, size, huge });
+        reserved_ += size;
+        huge_slabs_ += huge ? 1 : 0;
+
+        // the tail of the previous slab that does not fit a block is dropped
+        cursor_ = static_cast<char*>(memory);
+        end_ = cursor_ + size;
+        return true;
+    }
+}
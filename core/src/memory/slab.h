@@ -0,0 +1,65 @@
+#ifndef __SLAB_H
+#define __SLAB_H
+
+#include <cstddef>
+#include <vector>
+
+namespace core
+{
+    struct slab_options
+    {
+        size_t slab_bytes = 64 * 1024;
+        bool huge_pages = false;        // 2 MB pages where the os grants them, normal pages otherwise
+    };
+
+    // maps memory a slab at a time and carves it into fixed size blocks, not thread safe
+    // freed blocks go on an intrusive free list, slabs are unmapped only by the destructor
+    // slabs are page aligned, alignment up to a page holds for every block
+    class slab_allocator
+    {
+    public:
+        slab_allocator(size_t block_size, size_t alignment, const slab_options& options = slab_options());
+        ~slab_allocator();
+
+        slab_allocator(const slab_allocator&) = delete;
+        slab_allocator& operator=(const slab_allocator&) = delete;
+
+        void* allocate();
+        void deallocate(void* p);
+
+        // up to count blocks from the free list and fresh slabs, fewer only when the os is out of memory
+        size_t allocate_batch(void** out, size_t count);
+
+        size_t block_size() const { return block_size_; }
+        size_t slab_count() const { return slabs_.size(); }
+        size_t carved() const { return carved_; }      // blocks taken from fresh slab memory, free or in use
+        size_t reserved_bytes() const { return reserved_; }
+
+        // slabs that really got huge pages
+        size_t huge_slabs() const { return huge_slabs_; }
+
+    private:
+        bool grow();
+
+        struct slab
+        {
+            void* memory;
+            size_t size;
+            bool huge;
+        };
+
+        const size_t block_size_;
+        const slab_options options_;
+
+        std::vector<slab> slabs_;
+        char* cursor_ = nullptr;
+        char* end_ = nullptr;
+        void* free_ = nullptr;
+
+        size_t reserved_ = 0;
+        size_t huge_slabs_ = 0;
+        size_t carved_ = 0;
+    };
+}
+
+#endif
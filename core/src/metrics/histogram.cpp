@@ -0,0 +1,143 @@
+#include "histogram.h"
+#include <limits>
+
+namespace core
+{
+    namespace
+    {
+        int highest_bit(uint64_t value)
+        {
+            auto bit = 0;
+            while (value >>= 1)
+            {
+                ++bit;
+            }
+            return bit;
+        }
+
+        uint64_t lower_bound_of(size_t index)
+        {
+            if (index < 2 * histogram::sub_bucket_count)
+            {
+                return index;
+            }
+
+            auto shift = (index - 2 * histogram::sub_bucket_count) / histogram::sub_bucket_count + 1;
+            auto top = (index - 2 * histogram::sub_bucket_count) % histogram::sub_bucket_count + histogram::sub_bucket_count;
+            return static_cast<uint64_t>(top) << shift;
+        }
+    }
+
+    size_t histogram::index_of(uint64_t value)
+    {
+        if (value < 2 * sub_bucket_count)
+        {
+            return static_cast<size_t>(value);
+        }
+
+        auto shift = highest_bit(value) - sub_bucket_bits;
+        if (shift > max_bits - sub_bucket_bits - 1)
+        {
+            return bucket_count - 1;
+        }
+
+        auto top = value >> shift;
+        return static_cast<size_t>(2 * sub_bucket_count + (shift - 1) * sub_bucket_count + (top - sub_bucket_count));
+    }
+
+    uint64_t histogram::bucket_upper_bound(size_t index)
+    {
+        if (index + 1 >= bucket_count)
+        {
+            return (std::numeric_limits<uint64_t>::max)();
+        }
+
+        return lower_bound_of(index + 1) - 1;
+    }
+
+    void histogram::merge(const histogram& other)
+    {
+        for (size_t i = 0; i < bucket_count; ++i)
+        {
+            counts_[i] += other.counts_[i];
+        }
+
+        count_ += other.count_;
+        sum_ += other.sum_;
+        if (other.min_ < min_) min_ = other.min_;
+        if (other.max_ > max_) max_ = other.max_;
+    }
+
+    void histogram::merge(const shared_histogram& other)
+    {
+        for (size_t i = 0; i < bucket_count; ++i)
+        {
+            counts_[i] += other.counts_[i].load(std::memory_order_relaxed);
+        }
+
+        count_ += other.count_.load(std::memory_order_relaxed);
+        sum_ += other.sum_.load(std::memory_order_relaxed);
+
+        const auto min = other.min_.load(std::memory_order_relaxed);
+        const auto max = other.max_.load(std::memory_order_relaxed);
+        if (min < min_) min_ = min;
+        if (max > max_) max_ = max;
+    }
+
+    void histogram::reset()
+    {
+        counts_.fill(0);
+        count_ = 0;
+        sum_ = 0;
+        min_ = (std::numeric_limits<uint64_t>::max)();
+        max_ = 0;
+    }
+
+    shared_histogram::shared_histogram()
+    {
+        for (auto& count : counts_)
+        {
+            count.store(0, std::memory_order_relaxed);
+        }
+
+        count_.store(0, std::memory_order_relaxed);
+        sum_.store(0, std::memory_order_relaxed);
+        min_.store((std::numeric_limits<uint64_t>::max)(), std::memory_order_relaxed);
+        max_.store(0, std::memory_order_relaxed);
+    }
+
+    uint64_t histogram::percentile(double p) const
+    {
+        if (count_ == 0)
+        {
+            return 0;
+        }
+
+        auto rank = static_cast<uint64_t>(p / 100.0 * count_ + 0.5);
+        if (rank < 1) rank = 1;
+        if (rank > count_) rank = count_;
+
+        uint64_t seen = 0;
+        for (size_t i = 0; i < bucket_count; ++i)
+        {
+            seen += counts_[i];
+            if (seen >= rank)
+            {
+                auto upper = bucket_upper_bound(i);
+                return upper < max_ ? upper : max_;
+            }
+        }
+
+        return max_;
+    }
+
+    uint64_t histogram::count_at_or_below(uint64_t value) const
+    {
+        uint64_t seen = 0;
+        for (size_t i = 0; i < bucket_count && bucket_upper_bound(i) <= value; ++i)
+        {
+            seen += counts_[i];
+        }
+        return seen;
+    }
+}
@@ -0,0 +1,97 @@
+#ifndef __HISTOGRAM_H
+#define __HISTOGRAM_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace core
+{
+    class shared_histogram;
+
+    // log-linear (HDR style) histogram, 64 sub buckets per power of two (< 1.6% error)
+    // not thread safe, keep one per thread and merge() on read
+    class histogram
+    {
+    public:
+        static constexpr int sub_bucket_bits = 6;
+        static constexpr uint64_t sub_bucket_count = uint64_t(1) << sub_bucket_bits;
+        static constexpr int max_bits = 48;
+        static constexpr size_t bucket_count = 2 * sub_bucket_count + (max_bits - sub_bucket_bits - 1) * sub_bucket_count;
+
+        histogram() { reset(); }
+
+        void record(uint64_t value)
+        {
+            ++counts_[index_of(value)];
+            ++count_;
+            sum_ += value;
+            if (value < min_) min_ = value;
+            if (value > max_) max_ = value;
+        }
+
+        void merge(const histogram& other);
+        void merge(const shared_histogram& other);
+        void reset();
+
+        uint64_t count() const { return count_; }
+        uint64_t min() const { return count_ ? min_ : 0; }
+        uint64_t max() const { return max_; }
+        double mean() const { return count_ ? static_cast<double>(sum_) / count_ : 0.0; }
+        uint64_t sum() const { return sum_; }
+
+        // p in [0, 100]
+        uint64_t percentile(double p) const;
+
+        // values in buckets whose upper bound is <= value, for cumulative exporters
+        uint64_t count_at_or_below(uint64_t value) const;
+
+        // bucket access for exporters
+        uint64_t bucket(size_t index) const { return counts_[index]; }
+        static uint64_t bucket_upper_bound(size_t index);
+
+        static size_t index_of(uint64_t value);
+
+    private:
+        std::array<uint64_t, bucket_count> counts_;
+        uint64_t count_;
+        uint64_t sum_;
+        uint64_t min_;
+        uint64_t max_;
+    };
+
+    // histogram with one writing thread that other threads merge() from while it is written
+    // record() is a relaxed load + store per field, no read-modify-write; a merge may see a record half applied
+    class shared_histogram
+    {
+    public:
+        shared_histogram();
+
+        void record(uint64_t value)
+        {
+            add(counts_[histogram::index_of(value)], 1);
+            add(count_, 1);
+            add(sum_, value);
+            if (value < min_.load(std::memory_order_relaxed)) min_.store(value, std::memory_order_relaxed);
+            if (value > max_.load(std::memory_order_relaxed)) max_.store(value, std::memory_order_relaxed);
+        }
+
+    private:
+        friend class histogram;
+
+        // single writer, plain load + store
+        static void add(std::atomic<uint64_t>& counter, uint64_t value)
+        {
+            counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+        }
+
+        std::array<std::atomic<uint64_t>, histogram::bucket_count> counts_;
+        std::atomic<uint64_t> count_;
+        std::atomic<uint64_t> sum_;
+        std::atomic<uint64_t> min_;
+        std::atomic<uint64_t> max_;
+    };
+}
+
+#endif
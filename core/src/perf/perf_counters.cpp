@@ -0,0 +1,228 @@
+#include "perf_counters.h"
+#include <atomic>
+
+#ifdef __linux__
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace core
+{
+    namespace
+    {
+        std::atomic_bool perf_enabled{ false };
+    }
+
+    const char* perf_counter_name(perf_counter counter)
+    {
+        switch (counter)
+        {
+        case perf_counter::cycles: return "cycles";
+        case perf_counter::instructions: return "instructions";
+        case perf_counter::l1d_misses: return "l1d_misses";
+        case perf_counter::llc_misses: return "llc_misses";
+        case perf_counter::branch_misses: return "branch_misses";
+        default: return "?";
+        }
+    }
+
+    std::string perf_counters::describe(unsigned int valid)
+    {
+        std::string out;
+        for (size_t i = 0; i < perf_counter_count; ++i)
+        {
+            if (valid & (1u << i))
+            {
+                if (!out.empty())
+                {
+                    out += ' ';
+                }
+                out += perf_counter_name(static_cast<perf_counter>(i));
+            }
+        }
+        return out.empty() ? "none" : out;
+    }
+
+    bool perf_counters::enabled()
+    {
+        return perf_enabled.load(std::memory_order_relaxed);
+    }
+
+    void perf_counters::disable()
+    {
+        perf_enabled.store(false, std::memory_order_relaxed);
+    }
+
+#ifndef __linux__
+
+    perf_sample perf_counters::enable()
+    {
+        return perf_sample();
+    }
+
+    bool perf_counters::read(perf_sample& sample)
+    {
+        return false;
+    }
+
+#else
+
+    namespace
+    {
+        struct event_config
+        {
+            uint32_t type;
+            uint64_t config;
+        };
+
+        event_config config_of(perf_counter counter)
+        {
+            switch (counter)
+            {
+            case perf_counter::cycles:
+                return { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES };
+            case perf_counter::instructions:
+                return { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS };
+            case perf_counter::l1d_misses:
+                return { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) };
+            case perf_counter::llc_misses:
+                return { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES };
+            case perf_counter::branch_misses:
+            default:
+                return { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES };
+            }
+        }
+
+        int open_event(perf_counter counter, int group_fd)
+        {
+            const auto config = config_of(counter);
+
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = config.type;
+            attr.config = config.config;
+            attr.disabled = group_fd == -1 ? 1 : 0;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+            // this thread, any cpu
+            return static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, group_fd, 0));
+        }
+
+        // closed when the thread exits
+        struct thread_group
+        {
+            bool opened = false;
+            int leader = -1;
+            int fds[perf_counter_count];
+            size_t order[perf_counter_count];   // group read position -> perf_counter
+            size_t count = 0;
+            unsigned int valid = 0;
+
+            ~thread_group()
+            {
+                for (size_t i = 0; i < count; ++i)
+                {
+                    close(fds[i]);
+                }
+            }
+
+            void open()
+            {
+                opened = true;
+
+                // the first counter that opens leads, the rest join its group or are skipped
+                for (size_t i = 0; i < perf_counter_count; ++i)
+                {
+                    const auto fd = open_event(static_cast<perf_counter>(i), leader);
+                    if (fd < 0)
+                    {
+                        continue;
+                    }
+
+                    if (leader == -1)
+                    {
+                        leader = fd;
+                    }
+
+                    fds[count] = fd;
+                    order[count] = i;
+                    ++count;
+                    valid |= 1u << i;
+                }
+
+                if (leader != -1)
+                {
+                    ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+                    ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+                }
+            }
+        };
+
+        thread_local thread_group local_group;
+    }
+
+    perf_sample perf_counters::enable()
+    {
+        perf_enabled.store(true, std::memory_order_relaxed);
+
+        perf_sample probe;
+        if (!read(probe))
+        {
+            probe.valid = 0;
+        }
+        return probe;
+    }
+
+    bool perf_counters::read(perf_sample& sample)
+    {
+        if (!enabled())
+        {
+            return false;
+        }
+
+        auto& group = local_group;
+        if (!group.opened)
+        {
+            group.open();
+        }
+
+        if (group.leader == -1)
+        {
+            return false;
+        }
+
+        // PERF_FORMAT_GROUP with both times: nr, time_enabled, time_running, then one value per member in open order
+        uint64_t buffer[3 + perf_counter_count];
+        const auto bytes = ::read(group.leader, buffer, sizeof(buffer));
+        if (bytes < static_cast<ssize_t>(3 * sizeof(uint64_t)) || buffer[0] != group.count)
+        {
+            return false;
+        }
+
+        // a group that opened but never got a pmu slot (nmi watchdog, another perf user, a small vpmu) reads zeros
+        const auto time_enabled = buffer[1];
+        const auto time_running = buffer[2];
+        if (time_running == 0)
+        {
+            return false;
+        }
+
+        // multiplexed with other groups: scale up to the time the group was enabled, as perf stat does
+        const auto scale = time_running < time_enabled ? static_cast<double>(time_enabled) / time_running : 1.0;
+        for (size_t i = 0; i < group.count; ++i)
+        {
+            const auto value = buffer[3 + i];
+            sample.values[group.order[i]] = scale == 1.0 ? value : static_cast<uint64_t>(value * scale);
+        }
+        sample.valid = group.valid;
+        return true;
+    }
+
+#endif
+}
@@ -0,0 +1,64 @@
+#ifndef __PERF_COUNTERS_H
+#define __PERF_COUNTERS_H
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+namespace core
+{
+    enum class perf_counter
+    {
+        cycles,
+        instructions,
+        l1d_misses,
+        llc_misses,
+        branch_misses,
+    };
+
+    static constexpr size_t perf_counter_count = 5;
+
+    const char* perf_counter_name(perf_counter counter);
+
+    struct perf_sample
+    {
+        std::array<uint64_t, perf_counter_count> values{};
+        unsigned int valid = 0;     // bit per perf_counter that the thread could open
+
+        bool has(perf_counter counter) const { return (valid & (1u << static_cast<int>(counter))) != 0; }
+        uint64_t operator[](perf_counter counter) const { return values[static_cast<size_t>(counter)]; }
+
+        perf_sample operator-(const perf_sample& begin) const
+        {
+            perf_sample delta;
+            delta.valid = valid & begin.valid;
+            for (size_t i = 0; i < perf_counter_count; ++i)
+            {
+                delta.values[i] = values[i] - begin.values[i];
+            }
+            return delta;
+        }
+    };
+
+    // hardware counters of the calling thread, user space only
+    // linux perf_event_open, one event group per thread opened on first read()
+    // elsewhere, or when the kernel / hypervisor refuses the events or never schedules them, read() returns false
+    // and callers keep timing only; counters multiplexed with other groups are scaled to the time they were enabled
+    class perf_counters
+    {
+    public:
+        // opt-in, probes on the calling thread and returns the counters it could open
+        static perf_sample enable();
+        static void disable();
+
+        static bool enabled();
+
+        // false when disabled or when no counter could be opened on this thread
+        static bool read(perf_sample& sample);
+
+        // "cycles instructions ..." for the valid bits
+        static std::string describe(unsigned int valid);
+    };
+}
+
+#endif
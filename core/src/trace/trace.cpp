@@ -0,0 +1,237 @@
+#include "trace.h"
+#include <cstdarg>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace core
+{
+    namespace trace_detail
+    {
+        std::atomic_bool enabled{ false };
+    }
+
+    namespace
+    {
+        struct trace_event
+        {
+            const char* name;
+            int64_t start_ns;
+            int64_t end_ns;
+            unsigned int session;
+            int opcode;
+        };
+
+        // written only by its thread, read by to_chrome_json() after stop()
+        struct thread_buffer
+        {
+            int tid = 0;
+            std::string name;
+            std::unique_ptr<trace_event[]> events;     // left uninitialized, pages fault in as spans arrive
+            size_t capacity = 0;
+            std::atomic<size_t> size{ 0 };
+            std::atomic<uint64_t> generation{ 0 };
+            std::atomic<uint64_t> dropped{ 0 };
+        };
+
+        struct trace_state
+        {
+            std::mutex m;
+            std::vector<std::shared_ptr<thread_buffer>> buffers;
+
+            std::atomic<uint64_t> generation{ 0 };
+            size_t capacity = 0;
+            int64_t started_ns = 0;
+            bool running = false;
+
+            std::atomic<trace::opcode_namer> namer{ nullptr };
+        };
+
+        // never destroyed, threads may still hold their buffers at exit
+        trace_state& state()
+        {
+            static auto s = new trace_state;
+            return *s;
+        }
+
+        thread_local std::shared_ptr<thread_buffer> local_buffer;
+
+        thread_buffer& local()
+        {
+            if (!local_buffer)
+            {
+                auto& s = state();
+                local_buffer = std::make_shared<thread_buffer>();
+
+                std::lock_guard<std::mutex> lock(s.m);
+                local_buffer->tid = static_cast<int>(s.buffers.size()) + 1;
+                s.buffers.push_back(local_buffer);
+            }
+            return *local_buffer;
+        }
+
+        void append(std::string& out, const char* format, ...)
+        {
+            char line[512];
+
+            va_list args;
+            va_start(args, format);
+            vsnprintf(line, sizeof(line), format, args);
+            va_end(args);
+
+            out += line;
+        }
+    }
+
+    namespace trace_detail
+    {
+        int64_t now_ns()
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        void record(const char* name, int64_t start_ns, int64_t end_ns, unsigned int session, int opcode)
+        {
+            auto& s = state();
+            auto& buffer = local();
+
+            // first span of a new capture resets the buffer, the capacity is fixed while running
+            const auto generation = s.generation.load(std::memory_order_acquire);
+            if (buffer.generation.load(std::memory_order_relaxed) != generation)
+            {
+                if (buffer.capacity < s.capacity)
+                {
+                    buffer.events.reset(new trace_event[s.capacity]);
+                    buffer.capacity = s.capacity;
+                }
+                buffer.size.store(0, std::memory_order_relaxed);
+                buffer.dropped.store(0, std::memory_order_relaxed);
+                buffer.generation.store(generation, std::memory_order_release);
+            }
+
+            const auto size = buffer.size.load(std::memory_order_relaxed);
+            if (size >= buffer.capacity)
+            {
+                buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+
+            buffer.events[size] = { name, start_ns, end_ns, session, opcode };
+            buffer.size.store(size + 1, std::memory_order_release);
+        }
+    }
+
+    bool trace::start(size_t events_per_thread)
+    {
+        auto& s = state();
+        std::lock_guard<std::mutex> lock(s.m);
+        if (s.running)
+        {
+            return false;
+        }
+
+        s.capacity = events_per_thread;
+        s.started_ns = trace_detail::now_ns();
+        s.running = true;
+        s.generation.fetch_add(1, std::memory_order_release);
+        trace_detail::enabled.store(true, std::memory_order_relaxed);
+        return true;
+    }
+
+    void trace::stop()
+    {
+        auto& s = state();
+        std::lock_guard<std::mutex> lock(s.m);
+        trace_detail::enabled.store(false, std::memory_order_relaxed);
+        s.running = false;
+    }
+
+    std::string trace::to_chrome_json()
+    {
+        auto& s = state();
+        std::lock_guard<std::mutex> lock(s.m);
+
+        const auto generation = s.generation.load(std::memory_order_relaxed);
+        const auto namer = s.namer.load(std::memory_order_relaxed);
+
+        std::string out;
+        out.reserve(1024 * 1024);
+        out += "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+
+        auto first = true;
+        for (auto& buffer : s.buffers)
+        {
+            if (!buffer->name.empty())
+            {
+                append(out, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}", first ? "" : ",\n", buffer->tid, buffer->name.c_str());
+                first = false;
+            }
+
+            if (buffer->generation.load(std::memory_order_acquire) != generation)
+            {
+                continue;
+            }
+
+            const auto size = buffer->size.load(std::memory_order_acquire);
+            for (size_t i = 0; i < size; ++i)
+            {
+                const auto& e = buffer->events[i];
+                append(out, "%s{\"name\":\"%s\",\"cat\":\"sgs2\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,\"args\":{",
+                    first ? "" : ",\n", e.name, buffer->tid, (e.start_ns - s.started_ns) / 1000.0, (e.end_ns - e.start_ns) / 1000.0);
+                first = false;
+
+                if (e.session != 0)
+                {
+                    append(out, "\"session\":%u%s", e.session, e.opcode >= 0 ? "," : "");
+                }
+                if (e.opcode >= 0)
+                {
+                    const char* name = namer ? namer(e.opcode) : nullptr;
+                    if (name)
+                    {
+                        append(out, "\"opcode\":\"%s\"", name);
+                    }
+                    else
+                    {
+                        append(out, "\"opcode\":%d", e.opcode);
+                    }
+                }
+                out += "}}";
+            }
+        }
+
+        out += "\n]}\n";
+        return out;
+    }
+
+    void trace::set_thread_name(const std::string& name)
+    {
+        auto& buffer = local();
+
+        std::lock_guard<std::mutex> lock(state().m);
+        buffer.name = name;
+    }
+
+    void trace::set_opcode_namer(opcode_namer namer)
+    {
+        state().namer.store(namer, std::memory_order_relaxed);
+    }
+
+    uint64_t trace::dropped()
+    {
+        auto& s = state();
+        std::lock_guard<std::mutex> lock(s.m);
+
+        const auto generation = s.generation.load(std::memory_order_relaxed);
+        uint64_t total = 0;
+        for (auto& buffer : s.buffers)
+        {
+            if (buffer->generation.load(std::memory_order_acquire) == generation)
+            {
+                total += buffer->dropped.load(std::memory_order_relaxed);
+            }
+        }
+        return total;
+    }
+}
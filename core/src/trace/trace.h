@@ -0,0 +1,85 @@
+#ifndef __TRACE_H
+#define __TRACE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+// compiled out entirely with CORE_TRACE_ENABLED 0
+// compiled in, a disabled span costs one relaxed load and a branch
+#ifndef CORE_TRACE_ENABLED
+#define CORE_TRACE_ENABLED 1
+#endif
+
+namespace core
+{
+    namespace trace_detail
+    {
+        extern std::atomic_bool enabled;
+
+        int64_t now_ns();
+        void record(const char* name, int64_t start_ns, int64_t end_ns, unsigned int session, int opcode);
+    }
+
+    // spans go to per-thread buffers while a capture is running
+    // start() / stop() bracket one capture, to_chrome_json() reads it after stop()
+    class trace
+    {
+    public:
+        static bool enabled() { return trace_detail::enabled.load(std::memory_order_relaxed); }
+
+        // false if a capture is already running
+        static bool start(size_t events_per_thread = 1 << 18);
+        static void stop();
+
+        // Chrome trace-event JSON, loads in chrome://tracing and ui.perfetto.dev
+        static std::string to_chrome_json();
+
+        // shown as the thread name in the viewer, call once per thread
+        static void set_thread_name(const std::string& name);
+
+        // turns an opcode number into a label for span args
+        using opcode_namer = const char* (*)(int opcode);
+        static void set_opcode_namer(opcode_namer namer);
+
+        static uint64_t dropped();
+    };
+
+    class trace_scope
+    {
+    public:
+        trace_scope(const char* name, unsigned int session = 0, int opcode = -1)
+            : name_(name), session_(session), opcode_(opcode), start_ns_(trace::enabled() ? trace_detail::now_ns() : 0)
+        {
+        }
+
+        ~trace_scope()
+        {
+            if (start_ns_ != 0 && trace::enabled())
+            {
+                trace_detail::record(name_, start_ns_, trace_detail::now_ns(), session_, opcode_);
+            }
+        }
+
+        trace_scope(const trace_scope&) = delete;
+        trace_scope& operator=(const trace_scope&) = delete;
+
+    private:
+        const char* name_;
+        const unsigned int session_;
+        const int opcode_;
+        const int64_t start_ns_;
+    };
+}
+
+#define CORE_TRACE_CONCAT_(a, b) a##b
+#define CORE_TRACE_CONCAT(a, b) CORE_TRACE_CONCAT_(a, b)
+
+#if CORE_TRACE_ENABLED
+#define TRACE_SCOPE(name, ...) core::trace_scope CORE_TRACE_CONCAT(trace_scope_, __LINE__)(name, ##__VA_ARGS__)
+#else
+#define TRACE_SCOPE(name, ...) do {} while (0)
+#endif
+
+#endif
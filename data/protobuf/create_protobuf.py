@@ -13,6 +13,43 @@ BUILD_CONFIGURATION = 'Debug'
 
 SERVER_OUT_CPP_PATH = '../../sgs2/src/packet_processor'
 
+# packet.xml policy="..." -> handler executor, {task} is the deserialize + handler lambda
+EXECUTION_POLICIES = {
+	'inline' : None,
+	'worker' : 'worker_executor().post({task});',
+	'logic' : 'post_logic(session, {task});',
+	'blocking' : 'blocking_executor().post({task});',
+}
+
+def execution_policy(packet):
+	policy = packet.attrib.get('policy', 'inline').lower()
+	if policy not in EXECUTION_POLICIES:
+		sys.exit('unknown policy "' + policy + '" in ' + packet.tag)
+	return policy
+
+# packet.xml priority="..." -> default send_priority of an sc packet, send() takes an override
+SEND_PRIORITIES = ['control', 'normal', 'bulk']
+
+def send_priority(packet):
+	priority = packet.attrib.get('priority', 'normal').lower()
+	if priority not in SEND_PRIORITIES:
+		sys.exit('unknown priority "' + priority + '" in ' + packet.tag)
+	return 'network::send_priority::' + priority
+
+# packet.xml coalesce="field" -> sc packet is keyed by (field, opcode), an unsent one is replaced by a newer one
+COALESCE_FIELD_TYPES = ['int32', 'int64', 'uint32', 'uint64']
+
+def coalesce_field(packet):
+	field = packet.attrib.get('coalesce')
+	if field is None:
+		return None
+	if 'sc' not in packet.tag.lower():
+		sys.exit('coalesce on ' + packet.tag + ', only sc packets are sent')
+	for child in packet:
+		if child.tag == field and 'repeated' not in child.attrib and child.attrib.get('type') in COALESCE_FIELD_TYPES:
+			return field
+	sys.exit('coalesce field "' + field + '" of ' + packet.tag + ' must be an integer field')
+
 # ----------------------------------
 #   Ľ .proto 
 # ----------------------------------
@@ -97,12 +134,12 @@ for child in root:
 		if 'type' not in packet.attrib:
 			if 'cs' in packet.tag.lower():
 				#target.write("void handle_" + child.tag + '_' + packet.tag + "(std::shared_ptr<server_session> session, const " + child.tag + '::' + packet.tag + '& read);\n')
-				target.write("void handle_" + packet.tag + "(std::shared_ptr<server_session> session, const " + child.tag + '::' + packet.tag + '& read);\n')
+				target.write("void handle_" + packet.tag + "(server_session& session, const " + child.tag + '::' + packet.tag + '& read);\n')
 
 target.write('\n')
 target.write('\n')
 target.write('void register_handlers();\n')
-target.write('void handle_packet(std::shared_ptr<server_session> session, buf_ptr buffer, int size);\n')
+target.write('void handle_packet(server_session& session, buf_ptr buffer, int size);\n')
 
 target.write('\n')
 #target.write('}\n')
@@ -123,13 +160,22 @@ target.write('#include <array>\n')
 target.write('#include <google/protobuf/io/zero_copy_stream_impl_lite.h>\n')
 target.write('#include "opcode.h"\n')
 target.write('#include "../server_session/server_session.h"\n')
+target.write('#include "../executor/executor.h"\n')
+target.write('#include "../metrics/packet_metrics.h"\n')
+target.write('#include "../core/src/trace/trace.h"\n')
+target.write('#include "../core/src/perf/perf_counters.h"\n')
+target.write('#include "../core/src/memory/alloc_tracker.h"\n')
+target.write('#include "packet_traits.h"\n')
 
 target.write('\n')
 target.write('\n')
 
 target.write('template <typename T, typename = typename std::enable_if_t<std::is_base_of<::google::protobuf::Message, T>::value>>\n')
-target.write('void deserialize(std::shared_ptr<server_session> session, buf_ptr buffer, int size, std::function<void(std::shared_ptr<server_session>, const T&)> process_function)\n')
+target.write('void deserialize(server_session& session, buf_ptr buffer, int size, packet_metrics::clock::time_point received, void (*process_function)(server_session&, const T&))\n')
 target.write('{\n')
+target.write('\tTRACE_SCOPE("handler", session.id(), static_cast<int>(packet_traits<T>::code));\n')
+target.write('\tcore::alloc_scope alloc_tag(core::alloc_tag::handler);\n')
+target.write('\tconst auto started = packet_metrics::clock::now();\n')
 target.write('\tgoogle::protobuf::io::ArrayInputStream is(buffer->data() + sizeof(unsigned short), size - sizeof(unsigned short));\n')
 target.write('\tT read;\n')
 target.write('\n')
@@ -139,10 +185,21 @@ target.write('\t{\n')
 target.write('\t\tauto r = read.ParseFromZeroCopyStream(&is);\n')
 target.write('\t\tif (!r)\n')
 target.write('\t\t{\n')
-target.write('\t\t\tsession->close();\n')
+target.write('\t\t\tsession.close();\n')
 target.write('\t\t\treturn;\n')
 target.write('\t\t}\n')
+target.write('\n')
+target.write('\t\t// --perf: hardware counters around the handler only, timing alone when unavailable\n')
+target.write('\t\tcore::perf_sample perf_begin;\n')
+target.write('\t\tconst auto profiling = core::perf_counters::read(perf_begin);\n')
 target.write('\t\tprocess_function(session, read);\n')
+target.write('\t\tcore::perf_sample perf_end;\n')
+target.write('\t\tif (profiling && core::perf_counters::read(perf_end))\n')
+target.write('\t\t{\n')
+target.write('\t\t\tpacket_metrics::on_perf(packet_traits<T>::code, perf_end - perf_begin);\n')
+target.write('\t\t}\n')
+target.write('\n')
+target.write('\t\tpacket_metrics::on_handler(packet_traits<T>::code, session.id(), received, started, packet_metrics::clock::now());\n')
 target.write('\t}\n')
 target.write('\tcatch (std::logic_error& e)\n')
 target.write('\t{\n')
@@ -154,7 +211,8 @@ target.write('\t{\n')
 target.write('\t}\n')
 target.write('}\n') # end deserialize
 target.write('\n')
-target.write('using packet_handler = std::function<void(std::shared_ptr<server_session> session, buf_ptr buffer, int size)>;\n')
+target.write('// handlers borrow the session, only the ones that run later (executor policies) take a server_session_ptr\n')
+target.write('using packet_handler = void (*)(server_session& session, buf_ptr buffer, int size, packet_metrics::clock::time_point received);\n')
 target.write('packet_handler packet_handlers[(std::numeric_limits<unsigned short>::max)()] = { nullptr };\n')
 target.write(' auto to_index = [](opcode code)\n')
 target.write('{\n')
@@ -167,7 +225,7 @@ target.write('void register_handlers()\n')
 target.write('{\n')
 target.write('\tfor (auto& handler : packet_handlers)\n')
 target.write('\t{\n')
-target.write('\t\thandler = [](std::shared_ptr<server_session> session, buf_ptr const buffer, int size)\n')
+target.write('\t\thandler = [](server_session& session, buf_ptr const buffer, int size, packet_metrics::clock::time_point received)\n')
 target.write('\t\t{\n')
 target.write('\t\t\treturn;\n')
 target.write('\t\t};\n')
@@ -179,21 +237,30 @@ for child in root:
 		if 'type' not in packet.attrib:
 			if 'cs' in packet.tag.lower():
 				#target.write('\t' + "packet_handlers[to_index(opcode::" + packet.tag + ')] = [](std::shared_ptr<server_session> session, buf_ptr buffer, int size) { deserialize<' + child.tag + '::' + packet.tag + '>(std::move(session), std::move(buffer), size, handle_' + child.tag + '_' +  packet.tag + '); };\n')
-				target.write('\t' + "packet_handlers[to_index(opcode::" + packet.tag + ')] = [](std::shared_ptr<server_session> session, buf_ptr buffer, int size) { deserialize<' + child.tag + '::' + packet.tag + '>(std::move(session), std::move(buffer), size, handle_' + packet.tag + '); };\n')
+				executor = EXECUTION_POLICIES[execution_policy(packet)]
+				if executor is None:
+					target.write('\t' + "packet_handlers[to_index(opcode::" + packet.tag + ')] = [](server_session& session, buf_ptr buffer, int size, packet_metrics::clock::time_point received) { deserialize<' + child.tag + '::' + packet.tag + '>(session, std::move(buffer), size, received, handle_' + packet.tag + '); };\n')
+				else:
+					task = '[owner = server_session_ptr(&session), buffer = std::move(buffer), size, received]() mutable { deserialize<' + child.tag + '::' + packet.tag + '>(*owner, std::move(buffer), size, received, handle_' + packet.tag + '); }'
+					target.write('\t' + "packet_handlers[to_index(opcode::" + packet.tag + ')] = [](server_session& session, buf_ptr buffer, int size, packet_metrics::clock::time_point received) { ' + executor.format(task=task) + ' };\n')
 
 target.write('}\n')
 
 target.write('\n')
-target.write('void handle_packet(std::shared_ptr<server_session> session, buf_ptr buffer, int size)\n')
+target.write('void handle_packet(server_session& session, buf_ptr buffer, int size)\n')
 target.write('{\n')
 target.write('\tif (size < sizeof(opcode) || size - sizeof(unsigned short) < 0)\n')
 target.write('\t{\n')
 target.write('\t\treturn;\n')
 target.write('\t}\n')
 target.write('\n')
+target.write('\tconst auto received = packet_metrics::clock::now();\n')
 target.write('\tauto packet_num = *reinterpret_cast<opcode*>(buffer->data());\n')
+target.write('\tTRACE_SCOPE("dispatch", session.id(), to_index(packet_num));\n')
+target.write('\tcore::alloc_scope alloc_tag(core::alloc_tag::dispatch);\n')
+target.write('\tpacket_metrics::on_inbound(packet_num, size);\n')
 target.write('\n')
-target.write('\tpacket_handlers[to_index(packet_num)](std::move(session), std::move(buffer), size);\n')
+target.write('\tpacket_handlers[to_index(packet_num)](session, std::move(buffer), size, received);\n')
 target.write('}\n')
 
 target.close()
@@ -207,6 +274,8 @@ target = open(SERVER_OUT_CPP_PATH + '/' + 'opcode.h', 'w')
 target.write('#ifndef __OPCODE_H\n')
 target.write('#define __OPCODE_H\n')
 target.write('\n')
+target.write('#include <cstddef>\n')
+target.write('\n')
 #target.write('namespace network\n')
 #target.write('{\n')
 target.write('  enum class opcode : unsigned short\n')
@@ -225,12 +294,173 @@ for child in root:
 target.write('  };\n')
 #target.write('}\n')
 
-#target.write('\n')
+# dense index / name table for per opcode metrics
+codes = []
+for child in root:
+	for packet in child:
+		if 'type' not in packet.attrib and 'struct' not in packet.attrib:
+			codes.append(packet.tag)
+
+target.write('\n')
+target.write('static constexpr size_t opcode_count = ' + str(len(codes)) + ';\n')
+target.write('\n')
+target.write('// 0 .. opcode_count - 1, opcode_count for unknown codes\n')
+target.write('inline size_t opcode_index(opcode code)\n')
+target.write('{\n')
+target.write('\tswitch (code)\n')
+target.write('\t{\n')
+for index, code in enumerate(codes):
+	target.write('\tcase opcode::' + code + ': return ' + str(index) + ';\n')
+target.write('\tdefault: return opcode_count;\n')
+target.write('\t}\n')
+target.write('}\n')
+target.write('\n')
+target.write('inline opcode opcode_at(size_t index)\n')
+target.write('{\n')
+target.write('\tstatic constexpr opcode codes[] = { ' + ', '.join('opcode::' + code for code in codes) + ' };\n')
+target.write('\treturn codes[index];\n')
+target.write('}\n')
+target.write('\n')
+target.write('inline const char* opcode_name(opcode code)\n')
+target.write('{\n')
+target.write('\tswitch (code)\n')
+target.write('\t{\n')
+for code in codes:
+	target.write('\tcase opcode::' + code + ': return "' + code + '";\n')
+target.write('\tdefault: return "UNKNOWN";\n')
+target.write('\t}\n')
+target.write('}\n')
+target.write('\n')
 target.write('#endif')
 target.write('\n')
 target.close()
 
 
+#----------------------------------------------
+# packet_traits.h  ֱ (message -> opcode)
+#----------------------------------------------
+print ('create packet_traits.h')
+target = open(SERVER_OUT_CPP_PATH + '/' + 'packet_traits.h', 'w')
+target.write('#ifndef __PACKET_TRAITS_H\n')
+target.write('#define __PACKET_TRAITS_H\n')
+target.write('\n')
+target.write('#include "opcode.h"\n')
+
+for child in root:
+	target.write('#include "packet/' + child.tag + '.pb.h"\n')
+
+target.write('\n')
+target.write('template <class Protobuf>\n')
+target.write('struct packet_traits;\n')
+target.write('\n')
+
+for child in root:
+	for packet in child:
+		if 'type' not in packet.attrib and 'struct' not in packet.attrib:
+			target.write('template <> struct packet_traits<' + child.tag + '::' + packet.tag + '> { static constexpr opcode code = opcode::' + packet.tag + '; };\n')
+
+target.write('\n')
+target.write('// X(package, message) for every message, for code that has to touch all of them\n')
+target.write('#define FOR_EACH_PACKET(X)')
+for child in root:
+	for packet in child:
+		if 'type' not in packet.attrib and 'struct' not in packet.attrib:
+			target.write(' \\\n\tX(' + child.tag + ', ' + packet.tag + ')')
+target.write('\n')
+
+target.write('\n')
+target.write('#endif\n')
+target.close()
+
+
+#----------------------------------------------
+#  send_helper.h  ֱ
+#----------------------------------------------
+print ('create send_helper.h')
+target = open(SERVER_OUT_CPP_PATH + '/' + 'send_helper.h', 'w')
+target.write('#ifndef __SEND_HELPER_H\n')
+target.write('#define __SEND_HELPER_H\n')
+target.write('\n')
+target.write('#include <cstring>\n')
+target.write('#include "opcode.h"\n')
+target.write('#include "session/session.h"\n')
+target.write('#include "buffer_pool/send_buffer_pool.h"\n')
+target.write('#include "../room/room.h"\n')
+target.write('#include "../metrics/packet_metrics.h"\n')
+target.write('#include "../core/src/trace/trace.h"\n')
+target.write('#include "../core/src/memory/alloc_tracker.h"\n')
+
+for child in root:
+	target.write('#include "packet/' + child.tag + '.pb.h"\n')
+
+target.write('\n')
+target.write('template <opcode Opcode, class Protobuf>\n')
+target.write('bool send_packet(network::session& session, const Protobuf& protobuf, network::send_priority priority = network::send_priority::normal, network::coalesce_key key = network::coalesce_key())\n')
+target.write('{\n')
+target.write('\tstatic constexpr auto header_size = sizeof(unsigned short) * 2;\n')
+target.write('\n')
+target.write('\t// ByteSizeLong() caches the size for SerializeWithCachedSizesToArray()\n')
+target.write('\tconst auto body_size = protobuf.ByteSizeLong();\n')
+target.write('\tif (body_size + sizeof(unsigned short) > network::max_packet_size)\n')
+target.write('\t{\n')
+target.write('\t\treturn false;\n')
+target.write('\t}\n')
+target.write('\n')
+target.write('\tcore::alloc_scope alloc_tag(core::alloc_tag::send);\n')
+target.write('\tconst auto size = static_cast<unsigned short>(body_size + sizeof(unsigned short));\n')
+target.write('\tauto serialize = [&](char* data)\n')
+target.write('\t{\n')
+target.write('\t\tTRACE_SCOPE("serialize", session.id(), static_cast<int>(Opcode));\n')
+target.write('\t\tconst auto code = Opcode;\n')
+target.write('\t\tstd::memcpy(data, &size, sizeof(unsigned short));\n')
+target.write('\t\tstd::memcpy(data + sizeof(unsigned short), &code, sizeof(unsigned short));\n')
+target.write('\t\tprotobuf.SerializeWithCachedSizesToArray(reinterpret_cast<google::protobuf::uint8*>(data + header_size));\n')
+target.write('\t};\n')
+target.write('\tpacket_metrics::on_outbound(Opcode, size);\n')
+target.write('\n')
+target.write('\t// unicast frames are serialized straight into the session\'s send queue\n')
+target.write('\t// a room defers its sends to the end of the tick and a keyed frame may be replaced, both need a buffer of their own\n')
+target.write('\tauto r = room::current();\n')
+target.write('\tif (!r && key.empty())\n')
+target.write('\t{\n')
+target.write('\t\tsession.send_frame(priority, size + sizeof(unsigned short), serialize);\n')
+target.write('\t\treturn true;\n')
+target.write('\t}\n')
+target.write('\n')
+target.write('\tauto buffer = network::acquire_send_buffer();\n')
+target.write('\tserialize(buffer->buf.data());\n')
+target.write('\tbuffer->size = static_cast<unsigned short>(size + sizeof(unsigned short));\n')
+target.write('\tbuffer->key = key;\n')
+target.write('\tbuffer->priority = priority;\n')
+target.write('\n')
+target.write('\tif (r)\n')
+target.write('\t{\n')
+target.write('\t\tr->defer_send(session, std::move(buffer));\n')
+target.write('\t}\n')
+target.write('\telse\n')
+target.write('\t{\n')
+target.write('\t\tsession.send(std::move(buffer));\n')
+target.write('\t}\n')
+target.write('\n')
+target.write('\treturn true;\n')
+target.write('}\n')
+target.write('\n')
+
+for child in root:
+	for packet in child:
+		# packet
+		if 'type' not in packet.attrib:
+			field = coalesce_field(packet)
+			if field is not None:
+				target.write('inline bool send(network::session& session, const ' + child.tag + '::' + packet.tag + '& packet, network::send_priority priority = ' + send_priority(packet) + ') { return send_packet<opcode::' + packet.tag + '>(session, packet, priority, network::coalesce_key{ static_cast<uint64_t>(packet.' + field + '()), static_cast<unsigned short>(opcode::' + packet.tag + ') }); }\n')
+			elif 'sc' in packet.tag.lower():
+				target.write('inline bool send(network::session& session, const ' + child.tag + '::' + packet.tag + '& packet, network::send_priority priority = ' + send_priority(packet) + ') { return send_packet<opcode::' + packet.tag + '>(session, packet, priority); }\n')
+
+target.write('\n')
+target.write('#endif\n')
+target.close()
+
+
 #----------------------------------------------
 # packet.h/.cc  ֱ
 #----------------------------------------------
@@ -0,0 +1,28 @@
+#include "receive_buffer_pool.h"
+
+namespace network
+{
+    receive_buffer_pool& receive_buffer_pool::instance()
+    {
+        // never destroyed, same as send_buffer_pool
+        static auto pool = new receive_buffer_pool;
+        return *pool;
+    }
+
+    std::shared_ptr<packet_buffer_type> receive_buffer_pool::acquire()
+    {
+        auto buf = pool_.create();
+        in_use_.fetch_add(1, std::memory_order_relaxed);
+
+        return std::shared_ptr<packet_buffer_type>(buf, [this](packet_buffer_type* buf)
+        {
+            pool_.destroy(buf);
+            in_use_.fetch_sub(1, std::memory_order_release);
+        }, core::pool_allocator<packet_buffer_type>());
+    }
+
+    std::shared_ptr<packet_buffer_type> acquire_receive_buffer()
+    {
+        return receive_buffer_pool::instance().acquire();
+    }
+}
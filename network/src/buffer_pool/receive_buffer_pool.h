@@ -0,0 +1,33 @@
+#ifndef __RECEIVE_BUFFER_POOL_H
+#define __RECEIVE_BUFFER_POOL_H
+
+#include <atomic>
+#include <memory>
+#include "../io_helper.h"
+#include "../core/src/memory/object_pool.h"
+
+namespace network
+{
+    // frame bodies are read into these; a session takes one when a header has arrived and the buffer
+    // comes back when the last handler drops it, so an idle session holds none
+    class receive_buffer_pool
+    {
+    public:
+        static receive_buffer_pool& instance();
+
+        std::shared_ptr<packet_buffer_type> acquire();
+
+        size_t in_use() const { return in_use_.load(std::memory_order_relaxed); }
+        core::pool_stats stats() const { return pool_.stats(); }
+
+    private:
+        receive_buffer_pool() = default;
+
+        core::object_pool<packet_buffer_type> pool_;
+        std::atomic<size_t> in_use_{ 0 };
+    };
+
+    std::shared_ptr<packet_buffer_type> acquire_receive_buffer();
+}
+
+#endif
@@ -0,0 +1,30 @@
+#include "send_buffer_pool.h"
+
+namespace network
+{
+    send_buffer_pool& send_buffer_pool::instance()
+    {
+        // never destroyed, buffers still held by handlers in the global io_service come back during exit
+        static auto pool = new send_buffer_pool;
+        return *pool;
+    }
+
+    send_buf_ptr send_buffer_pool::acquire()
+    {
+        auto buf = pool_.create();
+        in_use_.fetch_add(1, std::memory_order_relaxed);
+
+        return send_buf_ptr(buf, [this](send_buffer* buf)
+        {
+            pool_.destroy(buf);
+
+            // in_use drops only once the buffer can be handed out again
+            in_use_.fetch_sub(1, std::memory_order_release);
+        }, core::pool_allocator<send_buffer>());
+    }
+
+    send_buf_ptr acquire_send_buffer()
+    {
+        return send_buffer_pool::instance().acquire();
+    }
+}
@@ -0,0 +1,35 @@
+#ifndef __SEND_BUFFER_POOL_H
+#define __SEND_BUFFER_POOL_H
+
+#include <atomic>
+#include "../io_helper.h"
+#include "../core/src/memory/object_pool.h"
+
+namespace network
+{
+    class send_buffer_pool
+    {
+    public:
+        static send_buffer_pool& instance();
+
+        send_buf_ptr acquire();
+
+        // puts count buffers in the pool's shared depot
+        void reserve(size_t count) { pool_.reserve(count); }
+
+        // buffers carved so far, free or in use
+        size_t created() const { return pool_.stats().blocks; }
+        size_t in_use() const { return in_use_.load(std::memory_order_relaxed); }
+        core::pool_stats stats() const { return pool_.stats(); }
+
+    private:
+        send_buffer_pool() = default;
+
+        core::object_pool<send_buffer> pool_;
+        std::atomic<size_t> in_use_{ 0 };
+    };
+
+    send_buf_ptr acquire_send_buffer();
+}
+
+#endif
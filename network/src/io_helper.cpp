@@ -6,11 +6,13 @@
 #include <memory>
 #include <vector>
 #include <boost/asio.hpp>
+#include "../core/src/trace/trace.h"
 
 namespace network
 {
     std::shared_ptr<boost::asio::io_service> g_io_service;
     std::vector<std::thread> g_io_threads;
+    thread_local int g_io_thread_index = -1;
 
     void create_io_service()
     {
@@ -34,7 +36,10 @@ namespace network
 
         for (auto i = 0; i < thread_count; ++i)
         {
-            g_io_threads.emplace_back([] {
+            g_io_threads.emplace_back([i] {
+
+                g_io_thread_index = i;
+                core::trace::set_thread_name("io " + std::to_string(i));
 
                 boost::system::error_code ec;
 
@@ -62,6 +67,16 @@ namespace network
 
         g_io_threads.clear();
     }
+
+    int io_thread_index()
+    {
+        return g_io_thread_index;
+    }
+
+    size_t io_thread_count()
+    {
+        return g_io_threads.size();
+    }
 }
 
 #endif
@@ -1,6 +1,7 @@
 #ifndef __IO_HELPER_H
 #define __IO_HELPER_H
 
+#include <cstdint>
 #include <boost/asio.hpp>
 
 namespace network
@@ -10,10 +11,36 @@ namespace network
 
     using packet_buffer_type = std::array<char, packet_buf_size>;
     
+    // latest value wins: a queued buffer that has not been written yet is replaced in place by a newer
+    // one with the same key, see send_queue; opcode 0 never coalesces
+    struct coalesce_key
+    {
+        uint64_t entity = 0;
+        unsigned short opcode = 0;
+
+        bool empty() const { return opcode == 0; }
+        bool operator==(const coalesce_key& other) const { return entity == other.entity && opcode == other.opcode; }
+    };
+
+    // outbound class, see send_queue::take: control goes out first, normal and bulk share the rest 4:1
+    enum class send_priority : unsigned char
+    {
+        control,
+        normal,
+        bulk,
+    };
+
+    static constexpr size_t send_priority_count = 3;
+
     struct send_buffer
     {
+        // buf is left uninitialized, only the first size bytes are ever read
+        send_buffer() {}
+
         packet_buffer_type buf;
         unsigned short size = 0;
+        coalesce_key key;
+        send_priority priority = send_priority::normal;
     };
 
     using send_buf_ptr = std::shared_ptr<send_buffer>;
@@ -24,6 +51,10 @@ namespace network
     void initialize();
     void start(size_t thread_pool_size);
     void stop();
+
+    // 0 .. io_thread_count() - 1 on threads started by start(), -1 elsewhere
+    int io_thread_index();
+    size_t io_thread_count();
 }
 
 #endif
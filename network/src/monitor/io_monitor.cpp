@@ -0,0 +1,91 @@
+#include "io_monitor.h"
+#include <algorithm>
+#include <cstdio>
+#include "../io_helper.h"
+
+namespace network
+{
+    namespace
+    {
+        thread_local io_monitor::clock::time_point g_handler_started;
+    }
+
+    io_monitor& io_monitor::instance()
+    {
+        static io_monitor monitor;
+        return monitor;
+    }
+
+    io_monitor::scope::scope()
+        : index_(io_thread_index()), started_(index_ >= 0 ? clock::now() : clock::time_point())
+    {
+        g_handler_started = started_;
+    }
+
+    io_monitor::scope::~scope()
+    {
+        g_handler_started = clock::time_point();
+        if (index_ < 0 || index_ >= static_cast<int>(max_threads))
+        {
+            return;
+        }
+
+        const auto ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - started_).count());
+
+        // single writer per slot, plain load + store
+        auto& monitor = instance();
+        auto& s = monitor.slots_[index_];
+        s.busy_ns.store(s.busy_ns.load(std::memory_order_relaxed) + ns, std::memory_order_relaxed);
+        s.handlers.store(s.handlers.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        s.max_handler_ns.record(ns, monitor.windows_.opened());
+    }
+
+    io_monitor::clock::time_point io_monitor::handler_started()
+    {
+        return g_handler_started;
+    }
+
+    io_usage_snapshot io_monitor::snapshot(size_t window)
+    {
+        io_usage_snapshot result;
+        result.taken = clock::now();
+        result.threads.resize((std::min)(io_thread_count(), max_threads));
+
+        for (size_t i = 0; i < result.threads.size(); ++i)
+        {
+            auto& s = slots_[i];
+            result.threads[i].busy_ns = s.busy_ns.load(std::memory_order_relaxed);
+            result.threads[i].handlers = s.handlers.load(std::memory_order_relaxed);
+            result.threads[i].max_handler_ns = s.max_handler_ns.take(window);
+        }
+        return result;
+    }
+
+    std::string io_monitor::report(const io_usage_snapshot& previous, const io_usage_snapshot& current)
+    {
+        const auto wall_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(current.taken - previous.taken).count();
+        const auto seconds = wall_ns / 1e9;
+
+        std::string out;
+        char line[256];
+
+        snprintf(line, sizeof(line), "%-10s %8s %12s %14s\n", "io thread", "busy %", "handlers/s", "max handler us");
+        out += line;
+
+        for (size_t i = 0; i < current.threads.size(); ++i)
+        {
+            const auto& now = current.threads[i];
+            const auto before = i < previous.threads.size() ? previous.threads[i] : io_usage();
+            const auto busy = now.busy_ns - before.busy_ns;
+            const auto handlers = now.handlers - before.handlers;
+
+            snprintf(line, sizeof(line), "%-10zu %8.1f %12.1f %14.1f\n", i,
+                wall_ns > 0 ? 100.0 * busy / wall_ns : 0.0,
+                seconds > 0 ? handlers / seconds : 0.0,
+                now.max_handler_ns / 1000.0);
+            out += line;
+        }
+
+        return out;
+    }
+}
@@ -0,0 +1,78 @@
+#ifndef __IO_MONITOR_H
+#define __IO_MONITOR_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "peak_windows.h"
+
+namespace network
+{
+    struct io_usage
+    {
+        uint64_t busy_ns = 0;
+        uint64_t handlers = 0;
+        uint64_t max_handler_ns = 0;    // since the previous snapshot of the same window
+    };
+
+    struct io_usage_snapshot
+    {
+        std::chrono::steady_clock::time_point taken;
+        std::vector<io_usage> threads;
+    };
+
+    // busy time and handler counts per io thread
+    // completion handlers open a scope, idle time is wall time minus busy time
+    class io_monitor
+    {
+    public:
+        static constexpr size_t max_threads = 256;
+
+        using clock = std::chrono::steady_clock;
+
+        static io_monitor& instance();
+
+        class scope
+        {
+        public:
+            scope();
+            ~scope();
+
+            scope(const scope&) = delete;
+            scope& operator=(const scope&) = delete;
+
+        private:
+            const int index_;
+            const clock::time_point started_;
+        };
+
+        // when the io handler running on this thread started, time_point() outside one
+        // lets code called from a handler stamp events without reading the clock again
+        static clock::time_point handler_started();
+
+        // a window per reader that reports max_handler_ns, open once and pass to every snapshot
+        size_t open_window() { return windows_.open(); }
+        io_usage_snapshot snapshot(size_t window);
+
+        // utilization and handler rate per thread between two snapshots
+        static std::string report(const io_usage_snapshot& previous, const io_usage_snapshot& current);
+
+    private:
+        io_monitor() = default;
+
+        struct alignas(64) slot
+        {
+            std::atomic<uint64_t> busy_ns{ 0 };
+            std::atomic<uint64_t> handlers{ 0 };
+            peak_windows<uint64_t> max_handler_ns;
+        };
+
+        std::array<slot, max_threads> slots_;
+        peak_window_ids windows_;
+    };
+}
+
+#endif
@@ -0,0 +1,145 @@
+#include "lag_probe.h"
+#include <algorithm>
+#include "../io_helper.h"
+
+namespace network
+{
+    lag_probe& lag_probe::instance()
+    {
+        static lag_probe probe;
+        return probe;
+    }
+
+    void lag_probe::start(std::chrono::milliseconds interval)
+    {
+        interval_ = interval;
+        timer_ = std::make_unique<boost::asio::steady_timer>(io_service());
+        schedule();
+    }
+
+    void lag_probe::stop()
+    {
+        if (timer_)
+        {
+            boost::system::error_code ec;
+            timer_->cancel(ec);
+        }
+    }
+
+    void lag_probe::schedule()
+    {
+        timer_->expires_from_now(interval_);
+        timer_->async_wait([this](const boost::system::error_code& ec)
+        {
+            if (ec)
+            {
+                return;
+            }
+
+            evaluate();
+
+            // one probe per thread, the scheduler decides where they land
+            round_posted_ = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < io_thread_count(); ++i)
+            {
+                const auto posted = std::chrono::steady_clock::now();
+                posted_.fetch_add(1, std::memory_order_relaxed);
+                io_service().post([this, posted]
+                {
+                    const auto index = io_thread_index();
+                    if (index < 0 || index >= static_cast<int>(max_threads))
+                    {
+                        return;
+                    }
+
+                    const auto lag_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - posted).count();
+
+                    // single writer per slot, plain load + store
+                    auto& s = slots_[index];
+                    s.last_us.store(lag_us, std::memory_order_relaxed);
+                    s.max_us.record(lag_us, windows_.opened());
+                    s.samples.store(s.samples.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+                    auto round_max = round_max_us_.load(std::memory_order_relaxed);
+                    while (lag_us > round_max && !round_max_us_.compare_exchange_weak(round_max, lag_us, std::memory_order_relaxed))
+                    {
+                    }
+                    executed_.fetch_add(1, std::memory_order_relaxed);
+                });
+            }
+
+            schedule();
+        });
+    }
+
+    // runs on the timer handler, one evaluation at a time
+    void lag_probe::evaluate()
+    {
+        if (limit_us_ <= 0 || posted_.load(std::memory_order_relaxed) == 0)
+        {
+            return;
+        }
+
+        auto lag_us = round_max_us_.exchange(0, std::memory_order_relaxed);
+
+        // a probe still queued from the previous round has waited at least this long
+        if (executed_.load(std::memory_order_relaxed) < posted_.load(std::memory_order_relaxed))
+        {
+            const long long waiting_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - round_posted_).count();
+            lag_us = (std::max)(lag_us, waiting_us);
+        }
+
+        const auto was_overloaded = overloaded_.load(std::memory_order_relaxed);
+        auto now_overloaded = was_overloaded;
+        if (!was_overloaded && lag_us > limit_us_)
+        {
+            now_overloaded = true;
+            overload_events_.fetch_add(1, std::memory_order_relaxed);
+        }
+        else if (was_overloaded && lag_us < limit_us_ / 2)
+        {
+            now_overloaded = false;
+        }
+
+        if (now_overloaded == was_overloaded)
+        {
+            return;
+        }
+
+        overloaded_.store(now_overloaded, std::memory_order_relaxed);
+
+        std::vector<overload_hook> hooks;
+        {
+            std::lock_guard<std::mutex> lock(hooks_lock_);
+            hooks = hooks_;
+        }
+        for (auto& hook : hooks)
+        {
+            hook(now_overloaded, lag_us);
+        }
+    }
+
+    void lag_probe::set_overload_limit(std::chrono::microseconds limit)
+    {
+        limit_us_ = limit.count();
+    }
+
+    void lag_probe::add_overload_hook(overload_hook hook)
+    {
+        std::lock_guard<std::mutex> lock(hooks_lock_);
+        hooks_.push_back(std::move(hook));
+    }
+
+    std::vector<io_lag> lag_probe::snapshot(size_t window)
+    {
+        std::vector<io_lag> result((std::min)(io_thread_count(), max_threads));
+        for (size_t i = 0; i < result.size(); ++i)
+        {
+            auto& s = slots_[i];
+            result[i].last_us = s.last_us.load(std::memory_order_relaxed);
+            result[i].max_us = s.max_us.take(window);
+            result[i].samples = s.samples.load(std::memory_order_relaxed);
+        }
+        return result;
+    }
+}
@@ -0,0 +1,91 @@
+#ifndef __LAG_PROBE_H
+#define __LAG_PROBE_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <memory>
+#include <vector>
+#include <boost/asio.hpp>
+#include "peak_windows.h"
+
+namespace network
+{
+    struct io_lag
+    {
+        long long last_us = 0;
+        long long max_us = 0;
+        unsigned long long samples = 0;
+    };
+
+    // posts timestamped probes to the shared io_service every interval
+    // whichever io thread runs a probe records post -> execute lag in its own slot
+    // lag above the overload limit flips overloaded() on, below half of it flips it off
+    class lag_probe
+    {
+    public:
+        static constexpr size_t max_threads = 256;
+
+        // called on an io thread when overloaded() changes
+        using overload_hook = std::function<void(bool overloaded, long long lag_us)>;
+
+        static lag_probe& instance();
+
+        // after network::start()
+        void start(std::chrono::milliseconds interval);
+        void stop();
+
+        // a window per reader that reports max_us, open once and pass to every snapshot
+        size_t open_window() { return windows_.open(); }
+
+        // one entry per io thread, max_us is since the previous snapshot of the same window
+        std::vector<io_lag> snapshot(size_t window);
+
+        // 0 disables, set before start()
+        void set_overload_limit(std::chrono::microseconds limit);
+        void add_overload_hook(overload_hook hook);
+
+        bool overloaded() const { return overloaded_.load(std::memory_order_relaxed); }
+        unsigned long long overload_events() const { return overload_events_.load(std::memory_order_relaxed); }
+
+        // work refused by callers that check overloaded()
+        void record_shed() { shed_.fetch_add(1, std::memory_order_relaxed); }
+        unsigned long long shed() const { return shed_.load(std::memory_order_relaxed); }
+
+    private:
+        lag_probe() = default;
+
+        void schedule();
+        void evaluate();
+
+        struct alignas(64) slot
+        {
+            std::atomic<long long> last_us{ 0 };
+            peak_windows<long long> max_us;
+            std::atomic<unsigned long long> samples{ 0 };
+        };
+
+        std::array<slot, max_threads> slots_;
+        peak_window_ids windows_;
+        std::unique_ptr<boost::asio::steady_timer> timer_;
+        std::chrono::milliseconds interval_{ 1000 };
+
+        // worst lag of the current round, and probes posted but not yet run
+        std::atomic<long long> round_max_us_{ 0 };
+        std::atomic<unsigned long long> posted_{ 0 };
+        std::atomic<unsigned long long> executed_{ 0 };
+        std::chrono::steady_clock::time_point round_posted_;
+
+        long long limit_us_ = 0;
+        std::atomic_bool overloaded_{ false };
+        std::atomic<unsigned long long> overload_events_{ 0 };
+        std::atomic<unsigned long long> shed_{ 0 };
+
+        std::mutex hooks_lock_;
+        std::vector<overload_hook> hooks_;
+    };
+}
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef __PEAK_WINDOWS_H
+#define __PEAK_WINDOWS_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace network
+{
+    static constexpr size_t max_peak_windows = 6;
+
+    // running max kept once per reader, a read resets only the reader's own window
+    // so the console report, /metrics and /debug each see the peak since their own previous read
+    template <typename T>
+    class peak_windows
+    {
+    public:
+        // single writer, plain load + store
+        void record(T value, size_t windows)
+        {
+            windows = (std::min)(windows, max_peak_windows);
+            for (size_t i = 0; i < windows; ++i)
+            {
+                if (value > values_[i].load(std::memory_order_relaxed))
+                {
+                    values_[i].store(value, std::memory_order_relaxed);
+                }
+            }
+        }
+
+        T take(size_t window)
+        {
+            return values_[(std::min)(window, max_peak_windows - 1)].exchange(0, std::memory_order_relaxed);
+        }
+
+    private:
+        std::array<std::atomic<T>, max_peak_windows> values_{};
+    };
+
+    // hands out window indexes, readers past max_peak_windows share the last one
+    class peak_window_ids
+    {
+    public:
+        size_t open()
+        {
+            const auto id = next_.fetch_add(1, std::memory_order_relaxed);
+            return (std::min)(id, max_peak_windows - 1);
+        }
+
+        size_t opened() const { return next_.load(std::memory_order_relaxed); }
+
+    private:
+        std::atomic<size_t> next_{ 0 };
+    };
+}
+
+#endif
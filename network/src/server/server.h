@@ -3,6 +3,10 @@
 
 #include <boost/asio.hpp>
 #include "../io_helper.h"
+#include "../session/session_pool.h"
+#include "../monitor/io_monitor.h"
+#include "../monitor/lag_probe.h"
+#include "../core/src/log/logger.h"
 
 namespace network
 {
@@ -11,18 +15,22 @@ namespace network
     {
     public:
 
+        // sessions closed while idle_sessions others are already waiting are deleted, 0 disables recycling
+        static constexpr size_t default_idle_sessions = 4096;
+
         void stop()
         {
             boost::system::error_code ec;
             acceptor_.close(ec);
-            socket_.close(ec);
         }
 
-        server(boost::asio::io_service& io_service, const boost::asio::ip::tcp::endpoint& endpoint) :
+        const session_pool<T>& sessions() const { return *sessions_; }
+
+        server(boost::asio::io_service& io_service, const boost::asio::ip::tcp::endpoint& endpoint, size_t idle_sessions = default_idle_sessions) :
             acceptor_(io_service, endpoint),
-            socket_(io_service)
+            sessions_(std::make_shared<session_pool<T>>(io_service, idle_sessions))
         {
-            wprintf(L" \n");
+            LOG_INFO("listening on port {}", endpoint.port());
             do_accept();
         }
 
@@ -30,13 +38,27 @@ namespace network
 
         void do_accept()
         {
-            acceptor_.async_accept(socket_, [this](boost::system::error_code ec)
+            // accepts straight into a recycled session's socket
+            auto next = sessions_->acquire();
+            auto& socket = next->socket();
+
+            acceptor_.async_accept(socket, [this, next = std::move(next)](boost::system::error_code ec)
             {
-                if (!ec)
+                auto& socket = next->socket();
+                io_monitor::scope busy;
+
+                if (!ec && lag_probe::instance().overloaded())
+                {
+                    // io threads are behind, refuse new players instead of slowing everyone
+                    lag_probe::instance().record_shed();
+                    LOG_WARN_LIMITED(1, "overloaded, refusing connection");
+                    socket.close(ec);
+                }
+                else if (!ec)
                 {
-                    wprintf(L" \n");
-                    socket_.set_option(boost::asio::ip::tcp::no_delay(false));
-                    std::make_shared<T>(std::move(socket_))->start();
+                    LOG_TRACE("accepted {}", socket.remote_endpoint(ec).address().to_string());
+                    socket.set_option(boost::asio::ip::tcp::no_delay(false));
+                    next->start();
                     //sess->on_connect();
                 }
                 else
@@ -59,7 +81,7 @@ namespace network
 
     private:
         boost::asio::ip::tcp::acceptor       acceptor_;
-        boost::asio::ip::tcp::socket         socket_;
+        std::shared_ptr<session_pool<T>>     sessions_;
     };
 }
 
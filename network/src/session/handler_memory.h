@@ -0,0 +1,87 @@
+#ifndef __HANDLER_MEMORY_H
+#define __HANDLER_MEMORY_H
+
+#include <new>
+#include <utility>
+#include <boost/asio.hpp>
+#include "../core/src/memory/fixed_pool.h"
+
+namespace network
+{
+    // storage for a session's outstanding asio operations, see boost/asio/example/cpp11/allocation
+    // blocks come from the shared size class pools only while an operation is in flight: a busy session
+    // keeps reusing warm blocks without the heap and an idle one holds nothing
+    class handler_memory
+    {
+    public:
+        handler_memory() = default;
+
+        handler_memory(const handler_memory&) = delete;
+        handler_memory& operator=(const handler_memory&) = delete;
+
+        void* allocate(std::size_t size)
+        {
+            if (auto pool = core::fixed_pool::for_size(size))
+            {
+                // deallocate hands every block of this size back to the pool, a heap fallback would corrupt it
+                if (auto p = pool->allocate())
+                {
+                    return p;
+                }
+
+                throw std::bad_alloc();
+            }
+
+            return ::operator new(size);
+        }
+
+        void deallocate(void* pointer, std::size_t size)
+        {
+            if (auto pool = core::fixed_pool::for_size(size))
+            {
+                pool->deallocate(pointer);
+                return;
+            }
+
+            ::operator delete(pointer);
+        }
+    };
+
+    template <typename Handler>
+    class custom_alloc_handler
+    {
+    public:
+        custom_alloc_handler(handler_memory& memory, Handler handler)
+            : memory_(memory), handler_(std::move(handler))
+        {
+        }
+
+        template <typename... Args>
+        void operator()(Args&&... args)
+        {
+            handler_(std::forward<Args>(args)...);
+        }
+
+        friend void* asio_handler_allocate(std::size_t size, custom_alloc_handler<Handler>* this_handler)
+        {
+            return this_handler->memory_.allocate(size);
+        }
+
+        friend void asio_handler_deallocate(void* pointer, std::size_t size, custom_alloc_handler<Handler>* this_handler)
+        {
+            this_handler->memory_.deallocate(pointer, size);
+        }
+
+    private:
+        handler_memory& memory_;
+        Handler handler_;
+    };
+
+    template <typename Handler>
+    inline custom_alloc_handler<Handler> make_custom_alloc_handler(handler_memory& memory, Handler handler)
+    {
+        return custom_alloc_handler<Handler>(memory, std::move(handler));
+    }
+}
+
+#endif
@@ -0,0 +1,302 @@
+#include "send_queue.h"
+
+namespace network
+{
+    static const size_t npos = static_cast<size_t>(-1);
+
+    std::atomic<uint64_t> send_queue::total_coalesced_{ 0 };
+
+    namespace
+    {
+        const size_t control = static_cast<size_t>(send_priority::control);
+        const size_t normal = static_cast<size_t>(send_priority::normal);
+        const size_t bulk = static_cast<size_t>(send_priority::bulk);
+
+        // bytes a weighted lane may send per round robin turn, normal gets 4 of every 5 contended bytes
+        const uint32_t quantum[send_priority_count] = { 0, 4 * 4096, 4096 };
+    }
+
+    bool send_queue::push(send_buf_ptr buf)
+    {
+        // the replaced buffer goes back to the pool after the lock is released
+        send_buf_ptr replaced;
+
+        std::lock_guard<std::mutex> lock(m_);
+        if (!buf->key.empty())
+        {
+            auto slot = index_find(buf->key);
+            if (slot != npos)
+            {
+                auto& l = lanes_[index_[slot].lane];
+                auto& queued = l.at(index_[slot].seq);
+                replaced = std::move(queued);
+                ++coalesced_;
+                total_coalesced_.fetch_add(1, std::memory_order_relaxed);
+
+                if (replaced->priority == buf->priority)
+                {
+                    queued = std::move(buf);
+                    return true;
+                }
+
+                // another priority moves the key to the tail of its own lane, the old position stays empty
+                index_erase(slot);
+                --count_;
+                drop_empty(l);
+
+                lanes_[static_cast<size_t>(buf->priority)].tail_open = false;
+                push_locked(std::move(buf));
+                return true;
+            }
+        }
+
+        lanes_[static_cast<size_t>(buf->priority)].tail_open = false;
+        push_locked(std::move(buf));
+        return false;
+    }
+
+    bool send_queue::take(std::vector<send_buf_ptr>& out)
+    {
+        std::lock_guard<std::mutex> lock(m_);
+        if (count_ == 0)
+        {
+            return false;
+        }
+
+        // strict priority
+        while (lanes_[control].count > 0)
+        {
+            out.push_back(pop_locked(lanes_[control]));
+        }
+
+        // deficit round robin, a lane keeps its deficit while it has buffers queued
+        size_t batch = 0;
+        while (batch < write_batch_bytes && (lanes_[normal].count > 0 || lanes_[bulk].count > 0))
+        {
+            auto& l = lanes_[turn_];
+            if (l.count > 0)
+            {
+                if (!granted_)
+                {
+                    l.deficit += quantum[turn_];
+                    granted_ = true;
+                }
+
+                const auto size = l.ring[l.head]->size;
+                if (size <= l.deficit)
+                {
+                    l.deficit -= size;
+                    batch += size;
+                    out.push_back(pop_locked(l));
+                    continue;
+                }
+            }
+            else
+            {
+                l.deficit = 0;
+            }
+
+            turn_ = static_cast<unsigned char>(turn_ == bulk ? normal : bulk);
+            granted_ = false;
+        }
+        return true;
+    }
+
+    bool send_queue::empty() const
+    {
+        std::lock_guard<std::mutex> lock(m_);
+        return count_ == 0;
+    }
+
+    size_t send_queue::size() const
+    {
+        std::lock_guard<std::mutex> lock(m_);
+        return count_;
+    }
+
+    void send_queue::clear()
+    {
+        std::lock_guard<std::mutex> lock(m_);
+        for (auto& l : lanes_)
+        {
+            for (uint32_t i = 0; i < l.count; ++i)
+            {
+                l.ring[(l.head + i) % l.ring.size()].reset();
+            }
+            l.head = 0;
+            l.count = 0;
+            l.head_seq = 0;
+            l.deficit = 0;
+            l.tail_open = false;
+        }
+        count_ = 0;
+        turn_ = static_cast<unsigned char>(normal);
+        granted_ = false;
+
+        for (auto& slot : index_)
+        {
+            slot.used = false;
+        }
+        keyed_ = 0;
+        coalesced_ = 0;
+    }
+
+    uint64_t send_queue::coalesced() const
+    {
+        std::lock_guard<std::mutex> lock(m_);
+        return coalesced_;
+    }
+
+    uint64_t send_queue::total_coalesced()
+    {
+        return total_coalesced_.load(std::memory_order_relaxed);
+    }
+
+    size_t send_queue::hash(const coalesce_key& key)
+    {
+        auto h = (key.entity ^ (static_cast<uint64_t>(key.opcode) << 48)) * 0x9E3779B97F4A7C15ull;
+        return static_cast<size_t>(h ^ (h >> 32));
+    }
+
+    // appends to the lane of its priority, called with m_ held
+    void send_queue::push_locked(send_buf_ptr buf)
+    {
+        const auto lane_index = static_cast<unsigned char>(buf->priority);
+        auto& l = lanes_[lane_index];
+        if (l.count == l.ring.size())
+        {
+            l.grow();
+        }
+
+        const auto seq = l.head_seq + l.count;
+        if (!buf->key.empty())
+        {
+            index_insert(buf->key, lane_index, seq);
+        }
+        l.ring[(l.head + l.count) % l.ring.size()] = std::move(buf);
+        ++l.count;
+        ++count_;
+    }
+
+    // front of a non empty lane, called with m_ held
+    send_buf_ptr send_queue::pop_locked(lane& l)
+    {
+        auto buf = std::move(l.ring[l.head]);
+        l.head = static_cast<uint32_t>((l.head + 1) % l.ring.size());
+        ++l.head_seq;
+        --l.count;
+        --count_;
+
+        if (!buf->key.empty())
+        {
+            index_erase(index_find(buf->key));
+        }
+        drop_empty(l);
+        return buf;
+    }
+
+    // skips positions left empty by keys that moved lane, so a non empty lane starts with a buffer
+    void send_queue::drop_empty(lane& l)
+    {
+        while (l.count > 0 && !l.ring[l.head])
+        {
+            l.head = static_cast<uint32_t>((l.head + 1) % l.ring.size());
+            ++l.head_seq;
+            --l.count;
+        }
+        if (l.count == 0)
+        {
+            l.tail_open = false;
+        }
+    }
+
+    // doubles and unwraps
+    void send_queue::lane::grow()
+    {
+        std::vector<send_buf_ptr> bigger((std::max)(ring.size() * 2, size_t(4)));
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            bigger[i] = std::move(ring[(head + i) % ring.size()]);
+        }
+
+        ring.swap(bigger);
+        head = 0;
+    }
+
+    size_t send_queue::index_find(const coalesce_key& key) const
+    {
+        if (keyed_ == 0)
+        {
+            return npos;
+        }
+
+        const auto mask = index_.size() - 1;
+        for (auto i = hash(key) & mask; index_[i].used; i = (i + 1) & mask)
+        {
+            if (index_[i].key == key)
+            {
+                return i;
+            }
+        }
+        return npos;
+    }
+
+    void send_queue::index_insert(const coalesce_key& key, unsigned char lane, uint64_t seq)
+    {
+        // at most half full
+        if ((keyed_ + 1) * 2 > index_.size())
+        {
+            index_grow();
+        }
+
+        const auto mask = index_.size() - 1;
+        auto i = hash(key) & mask;
+        while (index_[i].used)
+        {
+            i = (i + 1) & mask;
+        }
+
+        index_[i].key = key;
+        index_[i].seq = seq;
+        index_[i].lane = lane;
+        index_[i].used = true;
+        ++keyed_;
+    }
+
+    // shifts later entries of the probe run back so lookups never need tombstones
+    void send_queue::index_erase(size_t slot)
+    {
+        const auto mask = index_.size() - 1;
+        index_[slot].used = false;
+        --keyed_;
+
+        for (auto i = (slot + 1) & mask; index_[i].used; i = (i + 1) & mask)
+        {
+            const auto home = hash(index_[i].key) & mask;
+
+            // the entry stays when its home lies cyclically in (slot, i]
+            const bool stays = slot <= i ? (slot < home && home <= i) : (slot < home || home <= i);
+            if (!stays)
+            {
+                index_[slot] = index_[i];
+                index_[i].used = false;
+                slot = i;
+            }
+        }
+    }
+
+    void send_queue::index_grow()
+    {
+        std::vector<index_slot> old((std::max)(index_.size() * 2, size_t(16)));
+        old.swap(index_);
+        keyed_ = 0;
+
+        for (auto& slot : old)
+        {
+            if (slot.used)
+            {
+                index_insert(slot.key, slot.lane, slot.seq);
+            }
+        }
+    }
+}
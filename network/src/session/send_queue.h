@@ -0,0 +1,123 @@
+#ifndef __SEND_QUEUE_H
+#define __SEND_QUEUE_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include "../io_helper.h"
+#include "../buffer_pool/send_buffer_pool.h"
+
+namespace network
+{
+    // buffers waiting for the session's single outstanding async_write
+    // any thread pushes, the write path takes; the rings keep their storage so a warm queue never allocates
+    // one ring per send_priority, each in push order
+    // buffers with a coalesce key replace the unsent one with the same key where it stands, so keyed
+    // traffic keeps at most one buffer per key queued while unkeyed buffers keep their order around it;
+    // a replacement with another priority moves to the tail of its own lane instead
+    class send_queue
+    {
+    public:
+        // bytes one take() hands to a write past the control traffic; a large bulk backlog goes out in
+        // batches of this size so control buffers queued meanwhile are next, frames are never split
+        static constexpr size_t write_batch_bytes = 16 * 1024;
+
+        // true when buf replaced a queued buffer instead of being appended
+        bool push(send_buf_ptr buf);
+
+        // a frame serialized in place: write(data) fills bytes at data, packed behind the frames already
+        // in the tail buffer of its priority while it has room, so a burst of unicast sends shares a few
+        // pooled buffers; only buffers opened here are appended to, pushed ones may be shared or keyed
+        template <typename Write>
+        void append(send_priority priority, size_t bytes, Write&& write)
+        {
+            std::lock_guard<std::mutex> lock(m_);
+            auto& l = lanes_[static_cast<size_t>(priority)];
+            if (!l.tail_open || l.tail().size + bytes > packet_buf_size)
+            {
+                auto buf = acquire_send_buffer();
+                buf->priority = priority;
+                push_locked(std::move(buf));
+                l.tail_open = true;
+            }
+
+            auto& buf = l.tail();
+            write(buf.buf.data() + buf.size);
+            buf.size = static_cast<unsigned short>(buf.size + bytes);
+        }
+
+        // moves the next write's buffers to out: all control buffers, then normal and bulk by deficit
+        // round robin up to write_batch_bytes; false when empty
+        bool take(std::vector<send_buf_ptr>& out);
+
+        bool empty() const;
+        size_t size() const;
+        void clear();
+
+        // buffers dropped because a newer one with the same key arrived before they were written
+        uint64_t coalesced() const;
+        static uint64_t total_coalesced();
+
+    private:
+        struct lane
+        {
+            std::vector<send_buf_ptr> ring;
+            uint32_t head = 0;
+            uint32_t count = 0;
+
+            // sequence number of ring[head], positions follow from it so grow() leaves the index valid
+            uint64_t head_seq = 0;
+
+            // bytes this lane may still send in the current round robin turn
+            uint32_t deficit = 0;
+
+            // the tail buffer was opened by append() and takes more frames
+            bool tail_open = false;
+
+            send_buffer& tail() { return *ring[(head + count - 1) % ring.size()]; }
+            send_buf_ptr& at(uint64_t seq) { return ring[(head + static_cast<size_t>(seq - head_seq)) % ring.size()]; }
+            void grow();
+        };
+
+        // key -> lane and absolute sequence number of its queued buffer, open addressing with backward shift delete
+        struct index_slot
+        {
+            coalesce_key key;
+            uint64_t seq = 0;
+            unsigned char lane = 0;
+            bool used = false;
+        };
+
+        static size_t hash(const coalesce_key& key);
+
+        void push_locked(send_buf_ptr buf);
+        send_buf_ptr pop_locked(lane& l);
+        void drop_empty(lane& l);
+
+        size_t index_find(const coalesce_key& key) const;
+        void index_insert(const coalesce_key& key, unsigned char lane, uint64_t seq);
+        void index_erase(size_t slot);
+        void index_grow();
+
+        mutable std::mutex m_;
+        std::array<lane, send_priority_count> lanes_;
+
+        // buffers queued, a lane's count also covers positions emptied by a key changing lane
+        size_t count_ = 0;
+
+        // weighted lane whose round robin turn it is, and whether it got its quantum for that turn
+        unsigned char turn_ = static_cast<unsigned char>(send_priority::normal);
+        bool granted_ = false;
+
+        std::vector<index_slot> index_;
+        size_t keyed_ = 0;
+        uint64_t coalesced_ = 0;
+
+        static std::atomic<uint64_t> total_coalesced_;
+    };
+}
+
+#endif
@@ -1,22 +1,102 @@
 #include "session.h"
+#include <atomic>
+#include <cstring>
+#include "../monitor/io_monitor.h"
+#include "../buffer_pool/receive_buffer_pool.h"
+#include "../core/src/log/logger.h"
+#include "../core/src/trace/trace.h"
+#include "../core/src/memory/alloc_tracker.h"
 
 namespace network
 {
+    namespace
+    {
+        std::atomic<unsigned int> next_session_id{ 1 };
+        std::atomic<size_t> live_sessions{ 0 };
+        std::atomic<bool> lazy_receive_enabled{ false };
+    }
+
+    void session::set_lazy_receive(bool on)
+    {
+        lazy_receive_enabled.store(on, std::memory_order_relaxed);
+    }
+
+    bool session::lazy_receive()
+    {
+        return lazy_receive_enabled.load(std::memory_order_relaxed);
+    }
+
+#ifdef NETWORK_COUNT_REF_OPS
+    thread_local uint64_t session::ref_ops_ = 0;
+#endif
+
+    size_t session::count()
+    {
+        return live_sessions.load(std::memory_order_relaxed);
+    }
+
     session::session(tcp::socket socket)
-        : socket_(std::move(socket)), header_(0)
+        : socket_(std::move(socket)), id_(next_session_id.fetch_add(1, std::memory_order_relaxed)), header_(0)
+    {
+        LOG_TRACE("session {} created", id_);
+    }
+
+    session::session(boost::asio::io_service& io_service)
+        : socket_(io_service), id_(next_session_id.fetch_add(1, std::memory_order_relaxed)), header_(0)
     {
-        wprintf(L"session ctor called\n");
+        LOG_TRACE("session {} created", id_);
     }
 
     session::~session()
     {
-        wprintf(L"session dtor called\n");
+        if (started_)
+        {
+            live_sessions.fetch_sub(1, std::memory_order_relaxed);
+        }
+        LOG_TRACE("session {} destroyed", id_);
     }
 
     void session::start()
     {
+        started_ = true;
+        live_sessions.fetch_add(1, std::memory_order_relaxed);
+
         on_connect();
-        do_read_header();
+        do_read_header(session_ptr(this));
+    }
+
+    void session::release_last()
+    {
+        // the recycler may hand this session out again, let go of it first
+        auto recycler = std::move(recycler_);
+        if (recycler)
+        {
+            recycler->recycle(this);
+            return;
+        }
+
+        delete this;
+    }
+
+    void session::reset()
+    {
+        if (started_)
+        {
+            started_ = false;
+            live_sessions.fetch_sub(1, std::memory_order_relaxed);
+        }
+        LOG_TRACE("session {} recycled", id_);
+
+        boost::system::error_code ec;
+        socket_.close(ec);
+
+        q_.clear();
+        writing_.clear();
+        receive_buffer_.reset();
+        header_ = 0;
+        write_in_progress_.clear(std::memory_order_release);
+
+        id_ = next_session_id.fetch_add(1, std::memory_order_relaxed);
     }
 
     void session::close()
@@ -26,18 +106,64 @@ namespace network
 
     void session::send(send_buf_ptr buf)
     {
-        q_.push(buf);
+        core::alloc_scope alloc_tag(core::alloc_tag::send);
+        q_.push(std::move(buf));
 
         do_write();
     }
 
-    void session::do_read_header()
+    namespace
+    {
+        // [size][opcode][body] in send buffers, [opcode][body] in receive buffers
+        int opcode_at(const char* data)
+        {
+            unsigned short code = 0;
+            std::memcpy(&code, data, sizeof(code));
+            return code;
+        }
+    }
+
+    void session::do_read_header(session_ptr self)
+    {
+        // frames already queued in the socket are read straight away
+        boost::system::error_code ec;
+        if (lazy_receive() && socket_.available(ec) == 0 && !ec)
+        {
+            wait_readable(std::move(self));
+            return;
+        }
+
+        read_header(std::move(self));
+    }
+
+    void session::wait_readable(session_ptr self)
+    {
+        // zero byte read: a readiness wait on the reactor, a 0 byte WSARecv on iocp
+        socket_.async_read_some(boost::asio::null_buffers(),
+            [this, self = std::move(self)](boost::system::error_code ec, std::size_t /*length*/) mutable
+        {
+            io_monitor::scope busy;
+
+            if (ec)
+            {
+                on_disconnect(ec);
+                return;
+            }
+
+            // the header is there (or the peer is gone), this read does not wait
+            read_header(std::move(self));
+        });
+    }
+
+    void session::read_header(session_ptr self)
     {
-        auto self(shared_from_this());
         boost::asio::async_read(socket_,
             boost::asio::buffer(&header_, sizeof(header_)),
-            [this, self](boost::system::error_code ec, std::size_t /*length*/)
+            [this, self = std::move(self)](boost::system::error_code ec, std::size_t /*length*/) mutable
         {
+            io_monitor::scope busy;
+            core::alloc_scope alloc_tag(core::alloc_tag::read);
+
             if (ec || header_ <= 0 || header_ > max_packet_size)
             {
                 if (header_ == 0)
@@ -50,20 +176,21 @@ namespace network
                 return;
             }
 
-            do_read_body();
+            do_read_body(std::move(self));
         });
     }
 
-    void session::do_read_body()
+    void session::do_read_body(session_ptr self)
     {
-        receive_buffer_ = std::make_shared<packet_buffer_type>();
+        receive_buffer_ = acquire_receive_buffer();
 
-        auto self(shared_from_this());
         boost::asio::async_read(socket_,
             boost::asio::buffer(receive_buffer_->data(), header_),
-            [this, self](boost::system::error_code ec, std::size_t length)
+            [this, self = std::move(self)](boost::system::error_code ec, std::size_t length) mutable
         {
-           
+            io_monitor::scope busy;
+            core::alloc_scope alloc_tag(core::alloc_tag::read);
+
             if (ec || length <= 0 || length > max_packet_size)
             {
                 if (length == 0)
@@ -75,64 +202,82 @@ namespace network
                 on_disconnect(ec);
                 return;
             }
-            on_read_packet(std::move(receive_buffer_), header_);            
 
-            do_read_header();
+            TRACE_SCOPE("read", id_, header_ >= sizeof(unsigned short) ? opcode_at(receive_buffer_->data()) : -1);
+            on_read_packet(std::move(receive_buffer_), header_);
+
+            do_read_header(std::move(self));
         });
     }
 
     void session::do_write()
     {
-        if (write_in_progress_.test_and_set(std::memory_order_acquire))
+        // a send racing with the end of a burst may find the flag still set, so look at the queue
+        // again after releasing it
+        while (!write_in_progress_.test_and_set(std::memory_order_acquire))
         {
-            //wprintf(L"write in progressing -> return@@\n");
-            return;
+            if (q_.take(writing_))
+            {
+                // one reference for the whole burst, handed from write to write
+                submit_write(session_ptr(this));
+                return;
+            }
+
+            write_in_progress_.clear(std::memory_order_release);
+            if (q_.empty())
+            {
+                return;
+            }
         }
+    }
 
-        auto self(shared_from_this());
+    void session::submit_write(session_ptr self)
+    {
+        const auto opcode = opcode_at(writing_.front()->buf.data() + sizeof(unsigned short));
+        TRACE_SCOPE("write_submit", id_, opcode);
 
-        send_buf_ptr send_buf = nullptr;
-        
-        if (q_.try_pop(send_buf))
+        boost::asio::async_write(socket_,
+            buffer_range(writing_),
+            make_custom_alloc_handler(write_memory_,
+            [this, self = std::move(self), opcode](boost::system::error_code ec, std::size_t length) mutable
         {
-            boost::asio::async_write(socket_,
-                boost::asio::buffer(send_buf->buf.data(),
-                    send_buf->size),
-                [this, self](boost::system::error_code ec, std::size_t length)
+            io_monitor::scope busy;
+            TRACE_SCOPE("write_complete", id_, opcode);
+            core::alloc_scope alloc_tag(core::alloc_tag::send);
+
+            LOG_TRACE("session {} sent {} bytes", id_, length);
+            writing_.clear();
+
+            if (ec)
             {
-                wprintf(L"send complete:%d\n", length);
                 write_in_progress_.clear(std::memory_order_release);
-                
-                if (ec)
-                {
-                    wprintf(L"send error\n");
-                 
-                    handle_error_code(ec);
-                    return;
-                }
+                LOG_WARN_LIMITED(10, "session {} send failed: {}", id_, ec.message());
 
-                //wprintf(L"q size: %d", q_.unsafe_size());
+                handle_error_code(ec);
+                return;
+            }
 
-                if (q_.empty())
-                {
-                    wprintf(L"retur q is empty\n");
-                    return;
-                }
+            if (q_.take(writing_))
+            {
+                submit_write(std::move(self));
+                return;
+            }
 
-                do_write();
-                
-            });
-        }
-        else
-        {
-            //wprintf(L"release flag\n");
             write_in_progress_.clear(std::memory_order_release);
-        }
+
+            if (q_.empty())
+            {
+                LOG_TRACE("session {} send queue empty", id_);
+                return;
+            }
+
+            do_write();
+        }));
     }
 
     void session::handle_error_code(boost::system::error_code& ec)
     {
         q_.clear();
-        wprintf(L"handle_error_code called\n");
+        LOG_DEBUG("session {} send queue cleared, error {}", id_, ec.value());
     }
 }
@@ -1,37 +1,154 @@
 #ifndef __SESSION_H
 #define __SESSION_H
 
+#include <atomic>
+#include <cstdint>
+#include <iterator>
 #include <memory>
+#include <utility>
+#include <vector>
 #include <boost/asio.hpp>
+#include <boost/smart_ptr/intrusive_ptr.hpp>
 #include "../io_helper.h"
-#include <deque>
-
-#ifndef __linux__ 
-#include <ppl.h>
-#include <concurrent_queue.h>
-using namespace concurrency;
-#endif
+#include "send_queue.h"
+#include "handler_memory.h"
 
 namespace network
 {
     using boost::asio::ip::tcp;
 
-    class session : public std::enable_shared_from_this<session>
+    // send buffers as a const buffer sequence for one gathered write, cheap to copy as async_write does
+    class buffer_range
+    {
+    public:
+        class const_iterator
+        {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = boost::asio::const_buffer;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const value_type*;
+            using reference = value_type;
+
+            explicit const_iterator(const send_buf_ptr* at = nullptr) : at_(at) {}
+
+            value_type operator*() const { return boost::asio::const_buffer((*at_)->buf.data(), (*at_)->size); }
+            const_iterator& operator++() { ++at_; return *this; }
+            const_iterator operator++(int) { auto before = *this; ++at_; return before; }
+            bool operator==(const const_iterator& other) const { return at_ == other.at_; }
+            bool operator!=(const const_iterator& other) const { return at_ != other.at_; }
+
+        private:
+            const send_buf_ptr* at_;
+        };
+
+        using value_type = boost::asio::const_buffer;
+
+        explicit buffer_range(const std::vector<send_buf_ptr>& buffers)
+            : first_(buffers.data()), last_(buffers.data() + buffers.size())
+        {
+        }
+
+        const_iterator begin() const { return const_iterator(first_); }
+        const_iterator end() const { return const_iterator(last_); }
+
+    private:
+        const send_buf_ptr* first_;
+        const send_buf_ptr* last_;
+    };
+
+    class session;
+    using session_ptr = boost::intrusive_ptr<session>;
+
+    // takes a session back when its last session_ptr goes, instead of deleting it
+    class session_recycler
+    {
+    public:
+        virtual ~session_recycler() {}
+        virtual void recycle(session* s) = 0;
+    };
+
+    // sessions are reference counted in place: a session_ptr costs one atomic add/sub on the session's
+    // own count, moving one costs nothing; code that only uses a session for the call takes session&
+    // a session must be held by a session_ptr before start()
+    class session
     {
     public:
         explicit session(tcp::socket socket);
+
+        // not connected yet, accept into socket() then start()
+        explicit session(boost::asio::io_service& io_service);
         virtual ~session();
 
         void start();
         void close();
 
+        // back to the state of a fresh session(io_service) for the next connection, called by session_pool
+        // once nothing refers to the session any more; storage is kept, only the contents are dropped
+        virtual void reset();
+
+        tcp::socket& socket() { return socket_; }
+
         void send(send_buf_ptr buf);
 
+        // serializes a frame of bytes straight into the send queue, write(data) fills it
+        template <typename Write>
+        void send_frame(send_priority priority, size_t bytes, Write&& write)
+        {
+            q_.append(priority, bytes, std::forward<Write>(write));
+            do_write();
+        }
+
+        // buffers waiting behind the outstanding write
+        size_t queued() const { return q_.size(); }
+
+        // process unique, assigned per connection
+        unsigned int id() const { return id_; }
+
+        // started sessions that have not been destroyed or recycled
+        static size_t count();
+
+        // idle lobby mode, off by default: idle sessions wait for readability with no read posted and no buffer,
+        // at the cost of a FIONREAD per frame and an extra wakeup after each burst
+        // off: a header read stays posted
+        static void set_lazy_receive(bool on);
+        static bool lazy_receive();
+
+#ifdef NETWORK_COUNT_REF_OPS
+        // session_ptr add/release calls made by this thread so far, only the benchmark builds with the counter
+        static uint64_t ref_ops() { return ref_ops_; }
+#endif
+
+        // refs_ stays atomic: io threads, executors, room threads and any thread calling send() copy and drop
+        // session_ptrs, no path can prove a session is confined to one thread
+        friend void intrusive_ptr_add_ref(session* s)
+        {
+#ifdef NETWORK_COUNT_REF_OPS
+            ++ref_ops_;
+#endif
+            s->refs_.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        friend void intrusive_ptr_release(session* s)
+        {
+#ifdef NETWORK_COUNT_REF_OPS
+            ++ref_ops_;
+#endif
+            if (s->refs_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            {
+                s->release_last();
+            }
+        }
+
     protected:
         void do_write();
+        void submit_write(session_ptr self);
 
-        void do_read_header();
-        void do_read_body();
+        // the read loop owns one reference, moved from handler to handler
+        void do_read_header(session_ptr self);
+        void wait_readable(session_ptr self);
+        void read_header(session_ptr self);
+        void do_read_body(session_ptr self);
 
         virtual void on_read_packet(std::shared_ptr<packet_buffer_type> buf, unsigned short size) {}
         virtual void on_connect() {}
@@ -40,16 +157,31 @@ namespace network
 
         void handle_error_code(boost::system::error_code& ec);
 
+        template <typename T> friend class session_pool;
+
+        void release_last();
+
+#ifdef NETWORK_COUNT_REF_OPS
+        static thread_local uint64_t ref_ops_;
+#endif
+
+        std::atomic<uint32_t> refs_{ 0 };
+        std::shared_ptr<session_recycler> recycler_;
+
         tcp::socket socket_;
+        unsigned int id_;
+        bool started_ = false;
         unsigned short header_;
         std::shared_ptr<packet_buffer_type> receive_buffer_;
 
         std::atomic_flag write_in_progress_ = ATOMIC_FLAG_INIT;
 
-#ifndef __linux__ 
-        concurrent_queue<send_buf_ptr> q_;
-#endif
+        send_queue q_;
 
+        // one send_queue::take() goes out in one gathered async_write, the buffers are held until it
+        // completes while new frames fill fresh buffers in the queue; the list keeps its storage
+        std::vector<send_buf_ptr> writing_;
+        handler_memory write_memory_;
     };
 }
 
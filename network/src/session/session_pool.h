@@ -0,0 +1,80 @@
+#ifndef __SESSION_POOL_H
+#define __SESSION_POOL_H
+
+#include <atomic>
+#include <memory>
+#include <boost/asio.hpp>
+#include <boost/smart_ptr/intrusive_ptr.hpp>
+#include "session.h"
+#include "../core/src/concurrency/mpmc_queue.h"
+
+namespace network
+{
+    // recycles session objects across connections
+    // the last session_ptr to a session hands it back here instead of deleting it: reset() closes the
+    // socket and clears per connection state while buffers, queue storage and handler memory stay
+    // T is a session with T(io_service&), the pool is kept alive by the sessions it handed out
+    template <typename T>
+    class session_pool : public session_recycler, public std::enable_shared_from_this<session_pool<T>>
+    {
+    public:
+        session_pool(boost::asio::io_service& io_service, size_t max_idle)
+            : io_service_(io_service), idle_(max_idle != 0 ? max_idle : 1), max_idle_(max_idle)
+        {
+        }
+
+        ~session_pool()
+        {
+            T* session;
+            while (idle_.try_pop(session))
+            {
+                delete session;
+            }
+        }
+
+        session_pool(const session_pool&) = delete;
+        session_pool& operator=(const session_pool&) = delete;
+
+        // an idle session, or a new one when none is left; its socket is closed and ready to accept into
+        boost::intrusive_ptr<T> acquire()
+        {
+            T* session = nullptr;
+            if (!idle_.try_pop(session))
+            {
+                session = new T(io_service_);
+                created_.fetch_add(1, std::memory_order_relaxed);
+            }
+            else
+            {
+                reused_.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            session->recycler_ = this->shared_from_this();
+            return boost::intrusive_ptr<T>(session);
+        }
+
+        size_t created() const { return created_.load(std::memory_order_relaxed); }
+        size_t reused() const { return reused_.load(std::memory_order_relaxed); }
+        size_t idle() const { return idle_.size(); }
+
+        void recycle(session* s) override
+        {
+            auto session = static_cast<T*>(s);
+            session->reset();
+            if (max_idle_ == 0 || !idle_.try_push(session))
+            {
+                delete session;
+            }
+        }
+
+    private:
+        boost::asio::io_service& io_service_;
+        core::mpmc_queue<T*> idle_;
+        const size_t max_idle_;
+
+        std::atomic<size_t> created_{ 0 };
+        std::atomic<size_t> reused_{ 0 };
+    };
+}
+
+#endif
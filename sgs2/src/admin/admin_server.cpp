@@ -0,0 +1,209 @@
+#include "admin_server.h"
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+#include "metrics_export.h"
+#include "../core/src/trace/trace.h"
+#include "../core/src/memory/alloc_tracker.h"
+
+using boost::asio::ip::tcp;
+
+namespace
+{
+    static constexpr size_t max_trace_seconds = 60;
+    static constexpr size_t default_session_limit = 100;
+
+    // "/trace?seconds=5" -> "/trace", "seconds=5"
+    std::string split_query(const std::string& target, std::string& query)
+    {
+        const auto pos = target.find('?');
+        if (pos == std::string::npos)
+        {
+            query.clear();
+            return target;
+        }
+
+        query = target.substr(pos + 1);
+        return target.substr(0, pos);
+    }
+
+    size_t query_value(const std::string& query, const std::string& key, size_t default_value)
+    {
+        const auto pos = query.find(key + "=");
+        if (pos == std::string::npos || (pos != 0 && query[pos - 1] != '&'))
+        {
+            return default_value;
+        }
+        return std::strtoul(query.c_str() + pos + key.size() + 1, nullptr, 10);
+    }
+
+    // one request per connection, closed after the response
+    class admin_connection : public std::enable_shared_from_this<admin_connection>
+    {
+    public:
+        admin_connection(tcp::socket socket, boost::asio::io_service& io_service, bool& trace_capture)
+            : socket_(std::move(socket)), request_(8192), timer_(io_service), trace_capture_(trace_capture) {}
+
+        void start()
+        {
+            auto self(shared_from_this());
+            boost::asio::async_read_until(socket_, request_, "\r\n\r\n", [this, self](boost::system::error_code ec, std::size_t)
+            {
+                if (ec)
+                {
+                    return;
+                }
+
+                std::istream stream(&request_);
+                std::string method;
+                std::string path;
+                stream >> method >> path;
+
+                respond(method, path);
+            });
+        }
+
+    private:
+        void respond(const std::string& method, const std::string& target)
+        {
+            core::alloc_scope alloc_tag(core::alloc_tag::admin);
+
+            std::string query;
+            const auto path = split_query(target, query);
+
+            std::string status = "200 OK";
+            std::string content_type = "text/plain; version=0.0.4";
+            std::string body;
+
+            if (method != "GET")
+            {
+                status = "405 Method Not Allowed";
+            }
+            else if (path == "/metrics")
+            {
+                body = render_prometheus();
+            }
+            else if (path == "/debug")
+            {
+                content_type = "application/json";
+                body = render_debug_json();
+            }
+            else if (path == "/sessions")
+            {
+                content_type = "application/json";
+                body = render_sessions_json(query_value(query, "limit", default_session_limit));
+            }
+            else if (path == "/trace")
+            {
+                const auto seconds = (std::min)(query_value(query, "seconds", 5), max_trace_seconds);
+
+                // held until the json is built: a new capture resets the buffers to_chrome_json() reads
+                if (trace_capture_ || !core::trace::start())
+                {
+                    status = "409 Conflict";
+                    body = "trace already running\n";
+                }
+                else
+                {
+                    trace_capture_ = true;
+
+                    // the capture runs while the admin thread serves other requests, the timer ends it
+                    auto self(shared_from_this());
+                    timer_.expires_from_now(std::chrono::seconds(seconds));
+                    timer_.async_wait([this, self](boost::system::error_code)
+                    {
+                        core::alloc_scope alloc_tag(core::alloc_tag::admin);
+                        core::trace::stop();
+                        auto json = core::trace::to_chrome_json();
+                        trace_capture_ = false;
+                        write("200 OK", "application/json", json);
+                    });
+                    return;
+                }
+            }
+            else
+            {
+                status = "404 Not Found";
+                body = "/metrics, /debug, /sessions?limit=n, /trace?seconds=n\n";
+            }
+
+            write(status, content_type, body);
+        }
+
+        void write(const std::string& status, const std::string& content_type, const std::string& body)
+        {
+            response_ = "HTTP/1.1 " + status + "\r\n"
+                "Content-Type: " + content_type + "\r\n"
+                "Content-Length: " + std::to_string(body.size()) + "\r\n"
+                "Connection: close\r\n\r\n" + body;
+
+            auto self(shared_from_this());
+            boost::asio::async_write(socket_, boost::asio::buffer(response_), [this, self](boost::system::error_code ec, std::size_t)
+            {
+                boost::system::error_code ignored;
+                socket_.shutdown(tcp::socket::shutdown_both, ignored);
+                socket_.close(ignored);
+            });
+        }
+
+        tcp::socket socket_;
+        boost::asio::streambuf request_;
+        std::string response_;
+        boost::asio::steady_timer timer_;
+
+        // admin_server's, admin thread only
+        bool& trace_capture_;
+    };
+}
+
+admin_server::admin_server(unsigned short port) :
+    work_(std::make_unique<boost::asio::io_service::work>(io_service_)),
+    acceptor_(io_service_, tcp::endpoint(boost::asio::ip::address_v4::loopback(), port)),
+    socket_(io_service_)
+{
+    do_accept();
+    thread_ = std::thread([this] { io_service_.run(); });
+}
+
+admin_server::~admin_server()
+{
+    stop();
+}
+
+// connections still in flight are dropped with the io_service
+void admin_server::stop()
+{
+    if (!thread_.joinable())
+    {
+        return;
+    }
+
+    work_.reset();
+    io_service_.stop();
+    thread_.join();
+
+    // a /trace whose timer never fired would leave tracing on
+    if (trace_capture_)
+    {
+        core::trace::stop();
+        trace_capture_ = false;
+    }
+
+    boost::system::error_code ec;
+    acceptor_.close(ec);
+    socket_.close(ec);
+}
+
+void admin_server::do_accept()
+{
+    acceptor_.async_accept(socket_, [this](boost::system::error_code ec)
+    {
+        if (ec)
+        {
+            return;
+        }
+
+        std::make_shared<admin_connection>(std::move(socket_), io_service_, trace_capture_)->start();
+        do_accept();
+    });
+}
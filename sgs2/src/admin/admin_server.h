@@ -0,0 +1,35 @@
+#ifndef __ADMIN_SERVER_H
+#define __ADMIN_SERVER_H
+
+#include <memory>
+#include <thread>
+#include <boost/asio.hpp>
+
+// GET /metrics (Prometheus text) and GET /debug (json) on a local port
+// accept, socket io and rendering run on the admin server's own thread: snapshot merging stays off
+// the io threads and scrapes neither wait behind nor hold up the blocking executor's logins
+class admin_server
+{
+public:
+    explicit admin_server(unsigned short port);
+    ~admin_server();
+
+    admin_server(const admin_server&) = delete;
+    admin_server& operator=(const admin_server&) = delete;
+
+    void stop();
+
+private:
+    void do_accept();
+
+    boost::asio::io_service io_service_;
+    std::unique_ptr<boost::asio::io_service::work> work_;
+    boost::asio::ip::tcp::acceptor acceptor_;
+    boost::asio::ip::tcp::socket socket_;
+    std::thread thread_;
+
+    // a /trace capture is running or its json is being built, admin thread only until stop()
+    bool trace_capture_ = false;
+};
+
+#endif
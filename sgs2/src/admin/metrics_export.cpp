@@ -0,0 +1,424 @@
+#include "metrics_export.h"
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
+#include <vector>
+#include "session/session.h"
+#include "monitor/lag_probe.h"
+#include "monitor/io_monitor.h"
+#include "buffer_pool/send_buffer_pool.h"
+#include "../executor/executor.h"
+#include "../room/room_scheduler.h"
+#include "../capture/capture.h"
+#include "../metrics/packet_metrics.h"
+#include "../time/time_sync.h"
+#include "../core/src/memory/alloc_tracker.h"
+
+namespace
+{
+    // 1-2-5 series, 1us .. 10s
+    const std::vector<uint64_t>& latency_bounds_ns()
+    {
+        static const std::vector<uint64_t> bounds = []
+        {
+            std::vector<uint64_t> b;
+            for (uint64_t decade = 1000; decade <= 1000000000ULL; decade *= 10)
+            {
+                b.push_back(decade);
+                b.push_back(decade * 2);
+                b.push_back(decade * 5);
+            }
+            b.push_back(10000000000ULL);
+            return b;
+        }();
+        return bounds;
+    }
+
+    // 1-2-5 series, 100us .. 5s
+    const std::vector<uint64_t>& rtt_bounds_us()
+    {
+        static const std::vector<uint64_t> bounds = { 100, 200, 500, 1000, 2000, 5000, 10000, 20000, 50000, 100000, 200000, 500000, 1000000, 2000000, 5000000 };
+        return bounds;
+    }
+
+    const std::vector<uint64_t>& size_bounds()
+    {
+        static const std::vector<uint64_t> bounds = { 16, 32, 64, 128, 256, 512, 1024, 2048, 4096, 8192 };
+        return bounds;
+    }
+
+    void append(std::string& out, const char* format, ...)
+    {
+        char line[512];
+
+        va_list args;
+        va_start(args, format);
+        vsnprintf(line, sizeof(line), format, args);
+        va_end(args);
+
+        out += line;
+    }
+
+    void header(std::string& out, const char* name, const char* type, const char* help)
+    {
+        append(out, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+    }
+
+    // scale converts recorded units to the exported unit, 1e-9 for ns -> seconds; label may be ""
+    void histogram_series(std::string& out, const char* name, const char* label, const core::histogram& h, const std::vector<uint64_t>& bounds, double scale)
+    {
+        const char* comma = label[0] ? "," : "";
+        for (auto bound : bounds)
+        {
+            append(out, "%s_bucket{%s%sle=\"%g\"} %llu\n", name, label, comma, bound * scale, static_cast<unsigned long long>(h.count_at_or_below(bound)));
+        }
+        append(out, "%s_bucket{%s%sle=\"+Inf\"} %llu\n", name, label, comma, static_cast<unsigned long long>(h.count()));
+        const char* open = label[0] ? "{" : "";
+        const char* close = label[0] ? "}" : "";
+        append(out, "%s_sum%s%s%s %g\n", name, open, label, close, h.sum() * scale);
+        append(out, "%s_count%s%s%s %llu\n", name, open, label, close, static_cast<unsigned long long>(h.count()));
+    }
+
+    std::vector<executor*> executors()
+    {
+        return { &worker_executor(), &logic_executor(), &blocking_executor() };
+    }
+
+    room_stats total_room_stats(size_t& room_count)
+    {
+        room_stats total;
+        auto rooms = room_scheduler::instance().rooms();
+        room_count = rooms.size();
+        for (auto& r : rooms)
+        {
+            auto s = r->stats();
+            total.ticks += s.ticks;
+            total.overruns += s.overruns;
+            total.tasks += s.tasks;
+        }
+        return total;
+    }
+}
+
+std::string render_prometheus()
+{
+    std::string out;
+    out.reserve(64 * 1024);
+
+    header(out, "sgs2_sessions", "gauge", "Live sessions");
+    append(out, "sgs2_sessions %zu\n", network::session::count());
+
+    static const auto lag_window = network::lag_probe::instance().open_window();
+    auto lag = network::lag_probe::instance().snapshot(lag_window);
+    header(out, "sgs2_io_lag_seconds", "gauge", "Last post to execute lag per io thread");
+    for (size_t i = 0; i < lag.size(); ++i)
+    {
+        append(out, "sgs2_io_lag_seconds{thread=\"%zu\"} %g\n", i, lag[i].last_us * 1e-6);
+    }
+    header(out, "sgs2_io_lag_max_seconds", "gauge", "Max post to execute lag per io thread since the previous scrape");
+    for (size_t i = 0; i < lag.size(); ++i)
+    {
+        append(out, "sgs2_io_lag_max_seconds{thread=\"%zu\"} %g\n", i, lag[i].max_us * 1e-6);
+    }
+
+    static const auto usage_window = network::io_monitor::instance().open_window();
+    auto usage = network::io_monitor::instance().snapshot(usage_window);
+    header(out, "sgs2_io_busy_seconds_total", "counter", "Time io threads spent inside completion handlers");
+    for (size_t i = 0; i < usage.threads.size(); ++i)
+    {
+        append(out, "sgs2_io_busy_seconds_total{thread=\"%zu\"} %g\n", i, usage.threads[i].busy_ns * 1e-9);
+    }
+    header(out, "sgs2_io_handlers_total", "counter", "Completion handlers run per io thread");
+    for (size_t i = 0; i < usage.threads.size(); ++i)
+    {
+        append(out, "sgs2_io_handlers_total{thread=\"%zu\"} %llu\n", i, static_cast<unsigned long long>(usage.threads[i].handlers));
+    }
+    header(out, "sgs2_io_handler_max_seconds", "gauge", "Longest completion handler per io thread since the previous scrape");
+    for (size_t i = 0; i < usage.threads.size(); ++i)
+    {
+        append(out, "sgs2_io_handler_max_seconds{thread=\"%zu\"} %g\n", i, usage.threads[i].max_handler_ns * 1e-9);
+    }
+
+    auto& probe = network::lag_probe::instance();
+    header(out, "sgs2_overloaded", "gauge", "1 while io lag is over the overload limit");
+    append(out, "sgs2_overloaded %d\n", probe.overloaded() ? 1 : 0);
+    header(out, "sgs2_overload_events_total", "counter", "Times the server entered the overloaded state");
+    append(out, "sgs2_overload_events_total %llu\n", probe.overload_events());
+    header(out, "sgs2_shed_total", "counter", "Work refused while overloaded");
+    append(out, "sgs2_shed_total %llu\n", probe.shed());
+
+    header(out, "sgs2_executor_queue_depth", "gauge", "Tasks waiting in an executor");
+    for (auto e : executors())
+    {
+        append(out, "sgs2_executor_queue_depth{executor=\"%s\"} %zu\n", e->name().c_str(), e->stats().queue_depth);
+    }
+    header(out, "sgs2_executor_executed_total", "counter", "Tasks run by an executor");
+    for (auto e : executors())
+    {
+        append(out, "sgs2_executor_executed_total{executor=\"%s\"} %zu\n", e->name().c_str(), e->stats().executed);
+    }
+    header(out, "sgs2_executor_wait_seconds_total", "counter", "Summed queueing time of executed tasks");
+    for (auto e : executors())
+    {
+        append(out, "sgs2_executor_wait_seconds_total{executor=\"%s\"} %g\n", e->name().c_str(), e->stats().total_wait_us * 1e-6);
+    }
+
+    auto& pool = network::send_buffer_pool::instance();
+    header(out, "sgs2_send_buffers_created", "gauge", "Send buffers allocated by the pool");
+    append(out, "sgs2_send_buffers_created %zu\n", pool.created());
+    header(out, "sgs2_send_buffers_in_use", "gauge", "Send buffers handed out and not yet returned");
+    append(out, "sgs2_send_buffers_in_use %zu\n", pool.in_use());
+    header(out, "sgs2_send_coalesced_total", "counter", "Queued send buffers replaced by a newer one with the same coalesce key");
+    append(out, "sgs2_send_coalesced_total %llu\n", static_cast<unsigned long long>(network::send_queue::total_coalesced()));
+
+    auto memory = core::alloc_tracker::snapshot();
+    header(out, "sgs2_memory_live_bytes", "gauge", "Heap bytes allocated and not yet freed, by the subsystem that allocated them");
+    for (size_t i = 0; i < core::alloc_tag_count; ++i)
+    {
+        append(out, "sgs2_memory_live_bytes{subsystem=\"%s\"} %lld\n", core::alloc_tag_name(static_cast<core::alloc_tag>(i)), static_cast<long long>(memory[i].live_bytes()));
+    }
+    header(out, "sgs2_allocations_total", "counter", "Heap allocations per subsystem");
+    for (size_t i = 0; i < core::alloc_tag_count; ++i)
+    {
+        append(out, "sgs2_allocations_total{subsystem=\"%s\"} %llu\n", core::alloc_tag_name(static_cast<core::alloc_tag>(i)), static_cast<unsigned long long>(memory[i].allocations));
+    }
+    header(out, "sgs2_allocated_bytes_total", "counter", "Heap bytes allocated per subsystem");
+    for (size_t i = 0; i < core::alloc_tag_count; ++i)
+    {
+        append(out, "sgs2_allocated_bytes_total{subsystem=\"%s\"} %llu\n", core::alloc_tag_name(static_cast<core::alloc_tag>(i)), static_cast<unsigned long long>(memory[i].bytes));
+    }
+
+    size_t room_count = 0;
+    auto rooms = total_room_stats(room_count);
+    header(out, "sgs2_rooms", "gauge", "Rooms on the simulation threads");
+    append(out, "sgs2_rooms %zu\n", room_count);
+    header(out, "sgs2_room_ticks_total", "counter", "Ticks over live rooms");
+    append(out, "sgs2_room_ticks_total %zu\n", rooms.ticks);
+    header(out, "sgs2_room_overruns_total", "counter", "Ticks that ran past their interval");
+    append(out, "sgs2_room_overruns_total %zu\n", rooms.overruns);
+
+    // recorded in us, bounds are in ns
+    auto time = time_sync::snapshot();
+    header(out, "sgs2_rtt_seconds", "histogram", "Round trip time of every ping exchange, measured on the server clock");
+    histogram_series(out, "sgs2_rtt_seconds", "", time.rtt_us, rtt_bounds_us(), 1e-6);
+    header(out, "sgs2_rtt_jitter_seconds", "histogram", "Session jitter estimate at every ping exchange");
+    histogram_series(out, "sgs2_rtt_jitter_seconds", "", time.jitter_us, rtt_bounds_us(), 1e-6);
+    header(out, "sgs2_rtt_rejected_total", "counter", "Ping exchanges with impossible times");
+    append(out, "sgs2_rtt_rejected_total %llu\n", static_cast<unsigned long long>(time.rejected));
+
+    auto capture = capture_writer::instance().stats();
+    header(out, "sgs2_capture_records_total", "counter", "Frames written to the capture file");
+    append(out, "sgs2_capture_records_total %llu\n", static_cast<unsigned long long>(capture.records));
+    header(out, "sgs2_capture_dropped_total", "counter", "Frames dropped because the capture file was full");
+    append(out, "sgs2_capture_dropped_total %llu\n", static_cast<unsigned long long>(capture.dropped));
+
+    auto packets = packet_metrics::snapshot();
+
+    header(out, "sgs2_packets_in_total", "counter", "Inbound frames per opcode");
+    for (size_t i = 0; i < opcode_count; ++i)
+    {
+        if (auto& m = packets.opcodes[i])
+        {
+            append(out, "sgs2_packets_in_total{opcode=\"%s\"} %llu\n", opcode_name(opcode_at(i)), static_cast<unsigned long long>(m->inbound));
+        }
+    }
+    header(out, "sgs2_packets_slow_total", "counter", "Handlers over the slow threshold per opcode");
+    for (size_t i = 0; i < opcode_count; ++i)
+    {
+        if (auto& m = packets.opcodes[i])
+        {
+            append(out, "sgs2_packets_slow_total{opcode=\"%s\"} %llu\n", opcode_name(opcode_at(i)), static_cast<unsigned long long>(m->slow));
+        }
+    }
+    header(out, "sgs2_packets_out_total", "counter", "Outbound frames per opcode");
+    for (size_t i = 0; i < opcode_count; ++i)
+    {
+        if (auto& m = packets.opcodes[i])
+        {
+            append(out, "sgs2_packets_out_total{opcode=\"%s\"} %llu\n", opcode_name(opcode_at(i)), static_cast<unsigned long long>(m->outbound));
+        }
+    }
+
+    header(out, "sgs2_packet_perf_total", "counter", "Hardware counter deltas summed over profiled handler calls (--perf)");
+    for (size_t i = 0; i < opcode_count; ++i)
+    {
+        auto& m = packets.opcodes[i];
+        if (!m)
+        {
+            continue;
+        }
+
+        for (size_t c = 0; c < core::perf_counter_count; ++c)
+        {
+            if (m->perf_samples[c] != 0)
+            {
+                append(out, "sgs2_packet_perf_total{opcode=\"%s\",counter=\"%s\"} %llu\n", opcode_name(opcode_at(i)), core::perf_counter_name(static_cast<core::perf_counter>(c)), static_cast<unsigned long long>(m->perf_total[c]));
+            }
+        }
+    }
+    header(out, "sgs2_packet_perf_samples_total", "counter", "Profiled handler calls per counter (--perf)");
+    for (size_t i = 0; i < opcode_count; ++i)
+    {
+        auto& m = packets.opcodes[i];
+        if (!m)
+        {
+            continue;
+        }
+
+        for (size_t c = 0; c < core::perf_counter_count; ++c)
+        {
+            if (m->perf_samples[c] != 0)
+            {
+                append(out, "sgs2_packet_perf_samples_total{opcode=\"%s\",counter=\"%s\"} %llu\n", opcode_name(opcode_at(i)), core::perf_counter_name(static_cast<core::perf_counter>(c)), static_cast<unsigned long long>(m->perf_samples[c]));
+            }
+        }
+    }
+
+    struct histogram_family
+    {
+        const char* name;
+        const char* help;
+        core::histogram opcode_metrics::* member;
+        const std::vector<uint64_t>& bounds;
+        double scale;
+    };
+
+    const histogram_family families[] = {
+        { "sgs2_packet_queue_delay_seconds", "Socket read to handler start", &opcode_metrics::queue_delay_ns, latency_bounds_ns(), 1e-9 },
+        { "sgs2_packet_handler_seconds", "Handler execution time", &opcode_metrics::handler_ns, latency_bounds_ns(), 1e-9 },
+        { "sgs2_packet_size_bytes", "Serialized size, opcode + body", &opcode_metrics::size_bytes, size_bounds(), 1.0 },
+    };
+
+    for (auto& family : families)
+    {
+        header(out, family.name, "histogram", family.help);
+        for (size_t i = 0; i < opcode_count; ++i)
+        {
+            auto& m = packets.opcodes[i];
+            if (!m || ((*m).*family.member).count() == 0)
+            {
+                continue;
+            }
+
+            char label[64];
+            snprintf(label, sizeof(label), "opcode=\"%s\"", opcode_name(opcode_at(i)));
+            histogram_series(out, family.name, label, (*m).*family.member, family.bounds, family.scale);
+        }
+    }
+
+    return out;
+}
+
+std::string render_debug_json()
+{
+    std::string out;
+    out.reserve(16 * 1024);
+
+    append(out, "{\n  \"sessions\": %zu,\n", network::session::count());
+
+    static const auto lag_window = network::lag_probe::instance().open_window();
+    static const auto usage_window = network::io_monitor::instance().open_window();
+    auto lag = network::lag_probe::instance().snapshot(lag_window);
+    auto usage = network::io_monitor::instance().snapshot(usage_window);
+    out += "  \"io_threads\": [";
+    for (size_t i = 0; i < lag.size(); ++i)
+    {
+        const auto u = i < usage.threads.size() ? usage.threads[i] : network::io_usage();
+        append(out, "%s\n    { \"thread\": %zu, \"lag_us\": %lld, \"max_lag_us\": %lld, \"samples\": %llu, \"busy_ms\": %.1f, \"handlers\": %llu, \"max_handler_us\": %.1f }",
+            i ? "," : "", i, lag[i].last_us, lag[i].max_us, lag[i].samples,
+            u.busy_ns / 1e6, static_cast<unsigned long long>(u.handlers), u.max_handler_ns / 1e3);
+    }
+    out += "\n  ],\n";
+
+    auto& probe = network::lag_probe::instance();
+    append(out, "  \"overload\": { \"overloaded\": %s, \"events\": %llu, \"shed\": %llu },\n",
+        probe.overloaded() ? "true" : "false", probe.overload_events(), probe.shed());
+
+    out += "  \"executors\": [";
+    auto first = true;
+    for (auto e : executors())
+    {
+        auto s = e->stats();
+        append(out, "%s\n    { \"name\": \"%s\", \"threads\": %zu, \"queue_depth\": %zu, \"executed\": %zu, \"avg_wait_us\": %.1f, \"max_wait_us\": %lld }",
+            first ? "" : ",", e->name().c_str(), e->thread_count(), s.queue_depth, s.executed, s.executed ? static_cast<double>(s.total_wait_us) / s.executed : 0.0, s.max_wait_us);
+        first = false;
+    }
+    out += "\n  ],\n";
+
+    auto& pool = network::send_buffer_pool::instance();
+    append(out, "  \"send_buffers\": { \"created\": %zu, \"in_use\": %zu },\n", pool.created(), pool.in_use());
+
+    auto memory = core::alloc_tracker::snapshot();
+    out += "  \"memory\": [";
+    for (size_t i = 0; i < core::alloc_tag_count; ++i)
+    {
+        append(out, "%s\n    { \"subsystem\": \"%s\", \"live_bytes\": %lld, \"allocations\": %llu, \"bytes\": %llu, \"frees\": %llu }",
+            i == 0 ? "" : ",", core::alloc_tag_name(static_cast<core::alloc_tag>(i)), static_cast<long long>(memory[i].live_bytes()),
+            static_cast<unsigned long long>(memory[i].allocations), static_cast<unsigned long long>(memory[i].bytes), static_cast<unsigned long long>(memory[i].frees));
+    }
+    out += "\n  ],\n";
+
+    size_t room_count = 0;
+    auto rooms = total_room_stats(room_count);
+    append(out, "  \"rooms\": { \"count\": %zu, \"ticks\": %zu, \"overruns\": %zu, \"tasks\": %zu },\n", room_count, rooms.ticks, rooms.overruns, rooms.tasks);
+
+    auto time = time_sync::snapshot();
+    append(out, "  \"rtt\": { \"samples\": %llu, \"p50_us\": %llu, \"p99_us\": %llu, \"jitter_p50_us\": %llu, \"jitter_p99_us\": %llu, \"rejected\": %llu },\n",
+        static_cast<unsigned long long>(time.rtt_us.count()),
+        static_cast<unsigned long long>(time.rtt_us.percentile(50.0)), static_cast<unsigned long long>(time.rtt_us.percentile(99.0)),
+        static_cast<unsigned long long>(time.jitter_us.percentile(50.0)), static_cast<unsigned long long>(time.jitter_us.percentile(99.0)),
+        static_cast<unsigned long long>(time.rejected));
+
+    auto capture = capture_writer::instance().stats();
+    append(out, "  \"capture\": { \"enabled\": %s, \"records\": %llu, \"bytes\": %llu, \"dropped\": %llu },\n",
+        capture_writer::instance().enabled() ? "true" : "false",
+        static_cast<unsigned long long>(capture.records), static_cast<unsigned long long>(capture.bytes), static_cast<unsigned long long>(capture.dropped));
+
+    auto packets = packet_metrics::snapshot();
+    out += "  \"opcodes\": [";
+    first = true;
+    for (size_t i = 0; i < opcode_count; ++i)
+    {
+        auto& m = packets.opcodes[i];
+        if (!m)
+        {
+            continue;
+        }
+
+        append(out, "%s\n    { \"opcode\": \"%s\", \"in\": %llu, \"out\": %llu, \"slow\": %llu, \"queue_p50_us\": %.1f, \"queue_p99_us\": %.1f, \"handler_p50_us\": %.1f, \"handler_p99_us\": %.1f, \"size_p50\": %llu }",
+            first ? "" : ",", opcode_name(opcode_at(i)),
+            static_cast<unsigned long long>(m->inbound), static_cast<unsigned long long>(m->outbound), static_cast<unsigned long long>(m->slow),
+            m->queue_delay_ns.percentile(50.0) / 1000.0, m->queue_delay_ns.percentile(99.0) / 1000.0,
+            m->handler_ns.percentile(50.0) / 1000.0, m->handler_ns.percentile(99.0) / 1000.0,
+            static_cast<unsigned long long>(m->size_bytes.percentile(50.0)));
+        first = false;
+    }
+    out += "\n  ]\n}\n";
+
+    return out;
+}
+
+std::string render_sessions_json(size_t limit)
+{
+    auto sessions = time_sync::sessions();
+    const auto count = (std::min)(limit, sessions.size());
+    std::partial_sort(sessions.begin(), sessions.begin() + count, sessions.end(), [](const session_rtt& a, const session_rtt& b)
+    {
+        return a.estimate.srtt_us > b.estimate.srtt_us;
+    });
+
+    std::string out;
+    out.reserve(128 + count * 160);
+    append(out, "{\n  \"sessions\": %zu,\n  \"worst\": [", sessions.size());
+    for (size_t i = 0; i < count; ++i)
+    {
+        const auto& e = sessions[i].estimate;
+        append(out, "%s\n    { \"session\": %u, \"samples\": %llu, \"rtt_us\": %lld, \"srtt_us\": %lld, \"jitter_us\": %lld, \"min_us\": %lld, \"offset_us\": %lld }",
+            i ? "," : "", sessions[i].session_id, static_cast<unsigned long long>(e.samples),
+            static_cast<long long>(e.last_us), static_cast<long long>(e.srtt_us), static_cast<long long>(e.jitter_us),
+            static_cast<long long>(e.min_us), static_cast<long long>(e.offset_us));
+    }
+    out += "\n  ]\n}\n";
+
+    return out;
+}
@@ -0,0 +1,17 @@
+#ifndef __METRICS_EXPORT_H
+#define __METRICS_EXPORT_H
+
+#include <string>
+
+// both read snapshots only, safe to call from any thread
+
+// Prometheus text exposition format 0.0.4
+std::string render_prometheus();
+
+// human readable /debug view
+std::string render_debug_json();
+
+// /sessions: per session rtt, jitter and clock offset, the limit highest smoothed rtts first
+std::string render_sessions_json(size_t limit);
+
+#endif
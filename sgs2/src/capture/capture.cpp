@@ -0,0 +1,177 @@
+#include "capture.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include "io_helper.h"
+#include "monitor/io_monitor.h"
+#include "../core/src/log/logger.h"
+
+capture_writer& capture_writer::instance()
+{
+    static capture_writer writer;
+    return writer;
+}
+
+bool capture_writer::open(const std::string& path, size_t capacity)
+{
+    if (enabled() || capacity <= sizeof(capture_format::file_header))
+    {
+        return false;
+    }
+
+    if (!file_.create(path, capacity))
+    {
+        LOG_ERROR("capture open failed: {}", path);
+        return false;
+    }
+
+    // touch every page now so record() never faults on an io thread
+    for (size_t offset = 0; offset < capacity; offset += 4096)
+    {
+        file_.data()[offset] = 0;
+    }
+
+    capture_format::file_header header = {};
+    std::memcpy(header.magic, capture_format::magic, sizeof(header.magic));
+    header.version = capture_format::version;
+    header.start_unix_ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    std::memcpy(file_.data(), &header, sizeof(header));
+
+    start_ = std::chrono::steady_clock::now();
+    offset_ = sizeof(header);
+    end_ = capacity;
+    for (auto& count : records_)
+    {
+        count.records.store(0, std::memory_order_relaxed);
+    }
+    dropped_ = 0;
+
+    enabled_.store(true, std::memory_order_release);
+    return true;
+}
+
+void capture_writer::close()
+{
+    if (!enabled_.exchange(false))
+    {
+        return;
+    }
+
+    const auto used = (std::min)(offset_.load(), end_.load());
+    file_.close(static_cast<size_t>(used));
+
+    auto s = stats();
+    LOG_INFO("capture closed: {} records, {} bytes, {} dropped", s.records, s.bytes, s.dropped);
+}
+
+void capture_writer::record(unsigned int session_id, const char* data, unsigned short size)
+{
+    const auto total = sizeof(capture_format::record_header) + size;
+    const auto offset = offset_.fetch_add(total, std::memory_order_relaxed);
+
+    if (offset + total > file_.size())
+    {
+        // first overflow marks where the valid records end
+        auto end = end_.load(std::memory_order_relaxed);
+        while (offset < end && !end_.compare_exchange_weak(end, offset, std::memory_order_relaxed))
+        {
+        }
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    capture_format::record_header header;
+    // frames are recorded from the read handler, which has already read the clock
+    auto received = network::io_monitor::handler_started();
+    if (received == network::io_monitor::clock::time_point())
+    {
+        received = std::chrono::steady_clock::now();
+    }
+    header.timestamp_ns = std::chrono::duration_cast<std::chrono::nanoseconds>((std::max)(received, start_) - start_).count();
+    header.session_id = session_id;
+    header.size = size;
+    header.reserved = 0;
+
+    auto out = file_.data() + offset;
+    std::memcpy(out, &header, sizeof(header));
+    std::memcpy(out + sizeof(header), data, size);
+
+    const auto index = network::io_thread_index();
+    if (index >= 0 && index < static_cast<int>(max_io_threads))
+    {
+        // single writer, plain load + store
+        auto& count = records_[index].records;
+        count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+    else
+    {
+        records_[max_io_threads].records.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+capture_stats capture_writer::stats() const
+{
+    capture_stats stats;
+    for (auto& count : records_)
+    {
+        stats.records += count.records.load(std::memory_order_relaxed);
+    }
+    stats.bytes = (std::min)(offset_.load(std::memory_order_relaxed), end_.load(std::memory_order_relaxed));
+    stats.dropped = dropped_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+unsigned short capture_record::opcode() const
+{
+    unsigned short code = 0;
+    if (size >= sizeof(code))
+    {
+        std::memcpy(&code, data, sizeof(code));
+    }
+    return code;
+}
+
+bool capture_reader::open(const std::string& path)
+{
+    if (!file_.open_read(path) || file_.size() < sizeof(capture_format::file_header))
+    {
+        return false;
+    }
+
+    capture_format::file_header header;
+    std::memcpy(&header, file_.data(), sizeof(header));
+
+    if (std::memcmp(header.magic, capture_format::magic, sizeof(header.magic)) != 0 || header.version != capture_format::version)
+    {
+        file_.close();
+        return false;
+    }
+
+    start_unix_ms_ = header.start_unix_ms;
+    rewind();
+    return true;
+}
+
+bool capture_reader::next(capture_record& record)
+{
+    if (offset_ + sizeof(capture_format::record_header) > file_.size())
+    {
+        return false;
+    }
+
+    capture_format::record_header header;
+    std::memcpy(&header, file_.data() + offset_, sizeof(header));
+
+    if (header.size == 0 || offset_ + sizeof(header) + header.size > file_.size())
+    {
+        return false;
+    }
+
+    record.timestamp_ns = header.timestamp_ns;
+    record.session_id = header.session_id;
+    record.size = header.size;
+    record.data = file_.data() + offset_ + sizeof(header);
+
+    offset_ += sizeof(header) + header.size;
+    return true;
+}
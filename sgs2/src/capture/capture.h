@@ -0,0 +1,112 @@
+#ifndef __CAPTURE_H
+#define __CAPTURE_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include "../core/src/io/mapped_file.h"
+
+// capture file: [file_header][record_header][opcode + body][record_header]...
+// a record with size 0 (zero filled tail) ends the file
+namespace capture_format
+{
+    static constexpr char magic[8] = { 'S', 'G', 'S', '2', 'C', 'A', 'P', 0 };
+    static constexpr uint32_t version = 1;
+
+#pragma pack(push, 1)
+    struct file_header
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t reserved;
+        int64_t start_unix_ms;
+    };
+
+    struct record_header
+    {
+        uint64_t timestamp_ns;  // since capture start
+        uint32_t session_id;
+        uint16_t size;          // opcode + body, same as the wire header
+        uint16_t reserved;
+    };
+#pragma pack(pop)
+}
+
+struct capture_stats
+{
+    uint64_t records = 0;
+    uint64_t bytes = 0;
+    uint64_t dropped = 0;
+};
+
+// inbound frames from server_session::on_read_packet into a preallocated mapped file
+// record() is a fetch_add + memcpy, when the file is full frames are dropped and counted
+// the timestamp is the read handler's start and records are counted per io thread, no clock read or shared counter per frame
+class capture_writer
+{
+public:
+    static capture_writer& instance();
+
+    bool open(const std::string& path, size_t capacity);
+
+    // call after network::stop(), no record() may be in flight
+    void close();
+
+    bool enabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+    void record(unsigned int session_id, const char* data, unsigned short size);
+
+    capture_stats stats() const;
+
+private:
+    capture_writer() = default;
+
+    static constexpr size_t max_io_threads = 256;
+
+    // one writer per io thread slot, the last slot is shared by every other thread
+    struct alignas(64) record_count
+    {
+        std::atomic<uint64_t> records{ 0 };
+    };
+
+    core::mapped_file file_;
+    std::chrono::steady_clock::time_point start_;
+
+    std::atomic_bool enabled_{ false };
+    std::atomic<uint64_t> offset_{ 0 };
+    std::atomic<uint64_t> end_{ 0 };
+    std::array<record_count, max_io_threads + 1> records_;
+    std::atomic<uint64_t> dropped_{ 0 };
+};
+
+struct capture_record
+{
+    uint64_t timestamp_ns = 0;
+    unsigned int session_id = 0;
+    unsigned short size = 0;
+    const char* data = nullptr;     // opcode + body
+
+    unsigned short opcode() const;
+};
+
+class capture_reader
+{
+public:
+    bool open(const std::string& path);
+
+    // false at the end of the capture or on a truncated record
+    bool next(capture_record& record);
+
+    void rewind() { offset_ = sizeof(capture_format::file_header); }
+
+    int64_t start_unix_ms() const { return start_unix_ms_; }
+
+private:
+    core::mapped_file file_;
+    size_t offset_ = 0;
+    int64_t start_unix_ms_ = 0;
+};
+
+#endif
@@ -0,0 +1,108 @@
+#include "executor.h"
+#include "../core/src/trace/trace.h"
+
+executor::executor(std::string name)
+    : name_(std::move(name))
+{
+}
+
+executor::~executor()
+{
+    stop();
+}
+
+void executor::start(size_t thread_count)
+{
+    if (!threads_.empty())
+    {
+        return;
+    }
+
+    io_service_.reset();
+    work_ = std::make_unique<boost::asio::io_service::work>(io_service_);
+
+    threads_.reserve(thread_count);
+    for (size_t i = 0; i < thread_count; ++i)
+    {
+        threads_.emplace_back([this, i]
+        {
+            core::trace::set_thread_name(name_ + " " + std::to_string(i));
+
+            boost::system::error_code ec;
+            io_service_.run(ec);
+        });
+    }
+}
+
+void executor::stop()
+{
+    work_.reset();
+    io_service_.stop();
+
+    for (auto& thread : threads_)
+    {
+        thread.join();
+    }
+
+    threads_.clear();
+}
+
+executor_stats executor::stats() const
+{
+    executor_stats stats;
+    stats.queue_depth = queue_depth_.load(std::memory_order_relaxed);
+    stats.executed = executed_.load(std::memory_order_relaxed);
+    stats.total_wait_us = total_wait_us_.load(std::memory_order_relaxed);
+    stats.max_wait_us = max_wait_us_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void executor::on_dequeue(std::chrono::steady_clock::time_point posted)
+{
+    auto wait_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - posted).count();
+
+    queue_depth_.fetch_sub(1, std::memory_order_relaxed);
+    executed_.fetch_add(1, std::memory_order_relaxed);
+    total_wait_us_.fetch_add(wait_us, std::memory_order_relaxed);
+
+    auto max_wait_us = max_wait_us_.load(std::memory_order_relaxed);
+    while (wait_us > max_wait_us && !max_wait_us_.compare_exchange_weak(max_wait_us, wait_us, std::memory_order_relaxed))
+    {
+    }
+}
+
+namespace
+{
+    executor g_worker_executor("worker");
+    executor g_logic_executor("logic");
+    executor g_blocking_executor("blocking");
+}
+
+executor& worker_executor()
+{
+    return g_worker_executor;
+}
+
+executor& logic_executor()
+{
+    return g_logic_executor;
+}
+
+executor& blocking_executor()
+{
+    return g_blocking_executor;
+}
+
+void start_executors(size_t worker_count, size_t blocking_count)
+{
+    g_worker_executor.start(worker_count);
+    g_logic_executor.start(1);
+    g_blocking_executor.start(blocking_count);
+}
+
+void stop_executors()
+{
+    g_worker_executor.stop();
+    g_logic_executor.stop();
+    g_blocking_executor.stop();
+}
@@ -0,0 +1,76 @@
+#ifndef __EXECUTOR_H
+#define __EXECUTOR_H
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <boost/asio.hpp>
+
+struct executor_stats
+{
+    size_t queue_depth = 0;
+    size_t executed = 0;
+    long long total_wait_us = 0;
+    long long max_wait_us = 0;
+};
+
+class executor
+{
+public:
+    explicit executor(std::string name);
+    ~executor();
+
+    executor(const executor&) = delete;
+    executor& operator=(const executor&) = delete;
+
+    void start(size_t thread_count);
+    void stop();
+
+    template <typename Handler>
+    void post(Handler&& handler)
+    {
+        queue_depth_.fetch_add(1, std::memory_order_relaxed);
+
+        auto posted = std::chrono::steady_clock::now();
+        io_service_.post([this, posted, handler = std::forward<Handler>(handler)]() mutable
+        {
+            on_dequeue(posted);
+            handler();
+        });
+    }
+
+    const std::string& name() const { return name_; }
+    size_t thread_count() const { return threads_.size(); }
+    executor_stats stats() const;
+
+private:
+    void on_dequeue(std::chrono::steady_clock::time_point posted);
+
+    std::string name_;
+
+    boost::asio::io_service io_service_;
+    std::unique_ptr<boost::asio::io_service::work> work_;
+    std::vector<std::thread> threads_;
+
+    std::atomic<size_t> queue_depth_{ 0 };
+    std::atomic<size_t> executed_{ 0 };
+    std::atomic<long long> total_wait_us_{ 0 };
+    std::atomic<long long> max_wait_us_{ 0 };
+};
+
+// policy="worker" : cpu bound handlers
+executor& worker_executor();
+
+// policy="logic" : world state, single thread
+executor& logic_executor();
+
+// policy="blocking" : db, file io and other blocking calls
+executor& blocking_executor();
+
+void start_executors(size_t worker_count, size_t blocking_count);
+void stop_executors();
+
+#endif
@@ -3,6 +3,16 @@
 #include "io_helper.h"
 #include "server_session/server_session.h"
 #include "packet_processor/packet_processor.h"
+#include "executor/executor.h"
+#include "room/room_scheduler.h"
+#include "capture/capture.h"
+#include "metrics/packet_metrics.h"
+#include "admin/admin_server.h"
+#include "monitor/lag_probe.h"
+#include "monitor/io_monitor.h"
+#include "../core/src/log/logger.h"
+#include "../core/src/trace/trace.h"
+#include "../core/src/perf/perf_counters.h"
 #include <csignal>
 
 std::mutex m;
@@ -16,7 +26,7 @@ void sig_handler(int signal_val)
     cv.notify_all();
 }
 
-int main()
+int main(int argc, char* argv[])
 {
     //   ctrl + break
     std::signal(SIGBREAK, sig_handler);
@@ -25,9 +35,86 @@ int main()
     std::locale::global(std::locale(""));
     std::wcout.imbue(std::locale(""));
 
+    //  Ŷ : --capture file [--capture-mb size]
+    //  http (127.0.0.1): --admin-port port, 0 ̸  
+    // α : --log path (path.log, path.1.log ...)
+    // ϵ ī (linux): --perf, opcode  cycles / instructions / cache miss / branch miss
+    //  Ǵ: --lag-limit-ms ms (io ), --slow-handler-ms ms (ڵ鷯  ð), 0 ̸  
+    // idle κ : --lazy-receive, idle   read  readable   read (⺻  read  ɾ)
+    std::string capture_path;
+    size_t capture_mb = 1024;
+    unsigned short admin_port = 3001;
+    core::logger_config log_config;
+    size_t lag_limit_ms = 200;
+    size_t slow_handler_ms = 20;
+    auto perf = false;
+    auto lazy_receive = false;
+    for (auto i = 1; i < argc; ++i)
+    {
+        if (std::string(argv[i]) == "--perf")
+        {
+            perf = true;
+        }
+        else if (std::string(argv[i]) == "--lazy-receive")
+        {
+            lazy_receive = true;
+        }
+        else if (i + 1 >= argc)
+        {
+            break;
+        }
+        else if (std::string(argv[i]) == "--capture")
+        {
+            capture_path = argv[++i];
+        }
+        else if (std::string(argv[i]) == "--capture-mb")
+        {
+            capture_mb = std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if (std::string(argv[i]) == "--admin-port")
+        {
+            admin_port = static_cast<unsigned short>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (std::string(argv[i]) == "--log")
+        {
+            log_config.path = argv[++i];
+        }
+        else if (std::string(argv[i]) == "--lag-limit-ms")
+        {
+            lag_limit_ms = std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if (std::string(argv[i]) == "--slow-handler-ms")
+        {
+            slow_handler_ms = std::strtoul(argv[++i], nullptr, 10);
+        }
+    }
+
+    core::logger::instance().start(log_config);
+
+    if (perf)
+    {
+        const auto probe = core::perf_counters::enable();
+        if (probe.valid == 0)
+        {
+            LOG_WARN("perf counters unavailable, handlers are timed only");
+        }
+        else
+        {
+            LOG_INFO("perf counters: {}", core::perf_counters::describe(probe.valid));
+        }
+    }
+
+    if (!capture_path.empty())
+    {
+        capture_writer::instance().open(capture_path, capture_mb * 1024 * 1024);
+    }
+
     // Ŷ 
     register_handlers();
+    core::trace::set_opcode_namer([](int code) { return opcode_name(static_cast<opcode>(code)); });
+    packet_metrics::set_slow_handler_threshold(std::chrono::milliseconds(slow_handler_ms));
     network::initialize();
+    network::session::set_lazy_receive(lazy_receive);
 
     //  
     tcp::endpoint endpoint(tcp::v4(), 3000);
@@ -35,23 +122,68 @@ int main()
 
     const auto num_cpus = std::thread::hardware_concurrency();
     network::start(num_cpus);
+    start_executors(num_cpus, 4);
+    room_scheduler::instance().start((std::max)(num_cpus / 2, 1u));
 
+    //     server  ź
+    auto& probe = network::lag_probe::instance();
+    probe.set_overload_limit(std::chrono::milliseconds(lag_limit_ms));
+    probe.add_overload_hook([](bool overloaded, long long lag_us)
+    {
+        if (overloaded)
+        {
+            LOG_WARN("overloaded: io lag {} us, shedding new connections", lag_us);
+        }
+        else
+        {
+            LOG_INFO("recovered: io lag {} us", lag_us);
+        }
+    });
+    probe.start(std::chrono::milliseconds(1000));
+
+    std::unique_ptr<admin_server> admin;
+    if (admin_port != 0)
+    {
+        admin = std::make_unique<admin_server>(admin_port);
+    }
+
+    auto metrics = packet_metrics::snapshot();
+    const auto usage_window = network::io_monitor::instance().open_window();
+    auto usage = network::io_monitor::instance().snapshot(usage_window);
     std::unique_lock<std::mutex> lk(m);
 
-    cv.wait(lk, [] 
+    // 10ʸ opcode   
+    while (!cv.wait_for(lk, std::chrono::seconds(10), [] 
     {
         if (stop)
         {
-            wprintf(L"  ˸\n");
+            LOG_INFO("stop signal received");
             return true;
         }
-        
-        wprintf(L"  \n");
+
         return false;
-    });
+    }))
+    {
+        auto current = packet_metrics::snapshot();
+        printf("%s", packet_metrics::report(metrics, current).c_str());
+        metrics = std::move(current);
+
+        auto current_usage = network::io_monitor::instance().snapshot(usage_window);
+        printf("%s", network::io_monitor::report(usage, current_usage).c_str());
+        usage = std::move(current_usage);
+    }
     
-    wprintf(L"  \n");
+    LOG_INFO("server shutting down");
+    if (admin)
+    {
+        admin->stop();
+    }
+    network::lag_probe::instance().stop();
     network::stop();
+    room_scheduler::instance().stop();
+    stop_executors();
+    capture_writer::instance().close();
+    core::logger::instance().stop();
 
     return 0;
 }
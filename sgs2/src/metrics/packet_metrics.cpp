@@ -0,0 +1,252 @@
+#include "packet_metrics.h"
+#include <atomic>
+#include <cstdio>
+#include <mutex>
+#include <vector>
+#include "../core/src/log/logger.h"
+
+namespace
+{
+    // opcode_metrics as its owning thread writes it, snapshot() reads it from another thread
+    struct shard_metrics
+    {
+        core::shared_histogram queue_delay_ns;
+        core::shared_histogram handler_ns;
+        core::shared_histogram size_bytes;
+        std::atomic<uint64_t> inbound{ 0 };
+        std::atomic<uint64_t> outbound{ 0 };
+        std::atomic<uint64_t> slow{ 0 };
+
+        std::array<std::atomic<uint64_t>, core::perf_counter_count> perf_total{};
+        std::array<std::atomic<uint64_t>, core::perf_counter_count> perf_samples{};
+    };
+
+    struct shard
+    {
+        // created on first use, a thread usually sees a handful of opcodes
+        std::array<std::unique_ptr<shard_metrics>, opcode_count> opcodes;
+    };
+
+    // single writer, plain load + store
+    void add(std::atomic<uint64_t>& counter, uint64_t value)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    std::atomic<int64_t> slow_threshold_ns{ 0 };
+
+    std::mutex shards_lock;
+    std::vector<std::unique_ptr<shard>> shards;
+
+    // shards outlive their threads so counts from stopped executors stay in the totals
+    shard& local_shard()
+    {
+        thread_local shard* local = nullptr;
+        if (local == nullptr)
+        {
+            std::lock_guard<std::mutex> lock(shards_lock);
+            shards.emplace_back(std::make_unique<shard>());
+            local = shards.back().get();
+        }
+        return *local;
+    }
+
+    shard_metrics* local_metrics(opcode code)
+    {
+        const auto index = opcode_index(code);
+        if (index >= opcode_count)
+        {
+            return nullptr;
+        }
+
+        auto& slot = local_shard().opcodes[index];
+        if (!slot)
+        {
+            // published under the lock, snapshot() reads slots while holding it
+            std::lock_guard<std::mutex> lock(shards_lock);
+            slot = std::make_unique<shard_metrics>();
+        }
+        return slot.get();
+    }
+
+    uint64_t to_ns(packet_metrics::clock::duration duration)
+    {
+        const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+        return ns > 0 ? static_cast<uint64_t>(ns) : 0;
+    }
+}
+
+namespace packet_metrics
+{
+    void on_inbound(opcode code, size_t size)
+    {
+        if (auto metrics = local_metrics(code))
+        {
+            add(metrics->inbound, 1);
+            metrics->size_bytes.record(size);
+        }
+    }
+
+    void on_outbound(opcode code, size_t size)
+    {
+        if (auto metrics = local_metrics(code))
+        {
+            add(metrics->outbound, 1);
+            metrics->size_bytes.record(size);
+        }
+    }
+
+    void on_handler(opcode code, unsigned int session_id, clock::time_point received, clock::time_point started, clock::time_point finished)
+    {
+        auto metrics = local_metrics(code);
+        if (!metrics)
+        {
+            return;
+        }
+
+        const auto handler_ns = to_ns(finished - started);
+        metrics->queue_delay_ns.record(to_ns(started - received));
+        metrics->handler_ns.record(handler_ns);
+
+        const auto threshold = slow_threshold_ns.load(std::memory_order_relaxed);
+        if (threshold > 0 && handler_ns > static_cast<uint64_t>(threshold))
+        {
+            add(metrics->slow, 1);
+            LOG_WARN_LIMITED(10, "slow handler {} session {}: {} us", opcode_name(code), session_id, handler_ns / 1000);
+        }
+    }
+
+    void on_perf(opcode code, const core::perf_sample& delta)
+    {
+        auto metrics = local_metrics(code);
+        if (!metrics)
+        {
+            return;
+        }
+
+        for (size_t i = 0; i < core::perf_counter_count; ++i)
+        {
+            if (delta.has(static_cast<core::perf_counter>(i)))
+            {
+                add(metrics->perf_total[i], delta.values[i]);
+                add(metrics->perf_samples[i], 1);
+            }
+        }
+    }
+
+    void set_slow_handler_threshold(std::chrono::microseconds threshold)
+    {
+        slow_threshold_ns.store(std::chrono::duration_cast<std::chrono::nanoseconds>(threshold).count(), std::memory_order_relaxed);
+    }
+
+    packet_metrics_snapshot snapshot()
+    {
+        packet_metrics_snapshot result;
+        result.taken = clock::now();
+
+        std::lock_guard<std::mutex> lock(shards_lock);
+        for (auto& s : shards)
+        {
+            for (size_t i = 0; i < opcode_count; ++i)
+            {
+                auto& source = s->opcodes[i];
+                if (!source)
+                {
+                    continue;
+                }
+
+                auto& target = result.opcodes[i];
+                if (!target)
+                {
+                    target = std::make_shared<opcode_metrics>();
+                }
+
+                target->queue_delay_ns.merge(source->queue_delay_ns);
+                target->handler_ns.merge(source->handler_ns);
+                target->size_bytes.merge(source->size_bytes);
+                target->inbound += source->inbound.load(std::memory_order_relaxed);
+                target->outbound += source->outbound.load(std::memory_order_relaxed);
+                target->slow += source->slow.load(std::memory_order_relaxed);
+                for (size_t c = 0; c < core::perf_counter_count; ++c)
+                {
+                    target->perf_total[c] += source->perf_total[c].load(std::memory_order_relaxed);
+                    target->perf_samples[c] += source->perf_samples[c].load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        return result;
+    }
+
+    std::string report(const packet_metrics_snapshot& previous, const packet_metrics_snapshot& current)
+    {
+        const auto seconds = std::chrono::duration<double>(current.taken - previous.taken).count();
+
+        std::string out;
+        char line[256];
+
+        snprintf(line, sizeof(line), "%-24s %10s %10s %12s %12s %12s %12s %8s\n",
+            "opcode", "in/s", "out/s", "queue p50us", "queue p99us", "handle p50us", "handle p99us", "size p50");
+        out += line;
+
+        for (size_t i = 0; i < opcode_count; ++i)
+        {
+            auto& metrics = current.opcodes[i];
+            if (!metrics)
+            {
+                continue;
+            }
+
+            auto& before = previous.opcodes[i];
+            const auto inbound = metrics->inbound - (before ? before->inbound : 0);
+            const auto outbound = metrics->outbound - (before ? before->outbound : 0);
+
+            snprintf(line, sizeof(line), "%-24s %10.1f %10.1f %12.1f %12.1f %12.1f %12.1f %8llu\n",
+                opcode_name(opcode_at(i)),
+                seconds > 0 ? inbound / seconds : 0.0,
+                seconds > 0 ? outbound / seconds : 0.0,
+                metrics->queue_delay_ns.percentile(50.0) / 1000.0,
+                metrics->queue_delay_ns.percentile(99.0) / 1000.0,
+                metrics->handler_ns.percentile(50.0) / 1000.0,
+                metrics->handler_ns.percentile(99.0) / 1000.0,
+                static_cast<unsigned long long>(metrics->size_bytes.percentile(50.0)));
+            out += line;
+        }
+
+        // --perf, averages per profiled call over the whole uptime
+        auto header_written = false;
+        for (size_t i = 0; i < opcode_count; ++i)
+        {
+            auto& metrics = current.opcodes[i];
+            if (!metrics || metrics->perf_samples[0] + metrics->perf_samples[1] + metrics->perf_samples[4] == 0)
+            {
+                continue;
+            }
+
+            if (!header_written)
+            {
+                snprintf(line, sizeof(line), "%-24s %12s %8s %12s %12s %12s\n", "opcode", "cycles", "ipc", "l1d miss", "llc miss", "branch miss");
+                out += line;
+                header_written = true;
+            }
+
+            auto average = [&](core::perf_counter counter)
+            {
+                const auto c = static_cast<size_t>(counter);
+                return metrics->perf_samples[c] ? static_cast<double>(metrics->perf_total[c]) / metrics->perf_samples[c] : 0.0;
+            };
+
+            const auto cycles = average(core::perf_counter::cycles);
+            snprintf(line, sizeof(line), "%-24s %12.0f %8.2f %12.1f %12.1f %12.1f\n",
+                opcode_name(opcode_at(i)),
+                cycles,
+                cycles > 0 ? average(core::perf_counter::instructions) / cycles : 0.0,
+                average(core::perf_counter::l1d_misses),
+                average(core::perf_counter::llc_misses),
+                average(core::perf_counter::branch_misses));
+            out += line;
+        }
+
+        return out;
+    }
+}
@@ -0,0 +1,55 @@
+#ifndef __PACKET_METRICS_H
+#define __PACKET_METRICS_H
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "../packet_processor/opcode.h"
+#include "../core/src/metrics/histogram.h"
+#include "../core/src/perf/perf_counters.h"
+
+struct opcode_metrics
+{
+    core::histogram queue_delay_ns;     // socket read -> handler start
+    core::histogram handler_ns;
+    core::histogram size_bytes;         // opcode + body, inbound and outbound
+    uint64_t inbound = 0;
+    uint64_t outbound = 0;
+    uint64_t slow = 0;                  // handlers over the slow threshold
+
+    // hardware counters summed over profiled handler calls, --perf only
+    std::array<uint64_t, core::perf_counter_count> perf_total{};
+    std::array<uint64_t, core::perf_counter_count> perf_samples{};
+};
+
+struct packet_metrics_snapshot
+{
+    std::chrono::steady_clock::time_point taken;
+    std::array<std::shared_ptr<opcode_metrics>, opcode_count> opcodes;
+};
+
+// per opcode counters and histograms, one shard per thread
+// writers touch only their own shard with relaxed load + store, snapshot() merges every shard
+namespace packet_metrics
+{
+    using clock = std::chrono::steady_clock;
+
+    void on_inbound(opcode code, size_t size);
+    void on_outbound(opcode code, size_t size);
+    void on_handler(opcode code, unsigned int session_id, clock::time_point received, clock::time_point started, clock::time_point finished);
+
+    // counter deltas around one handler call
+    void on_perf(opcode code, const core::perf_sample& delta);
+
+    // handlers running longer than this are counted and logged with opcode and session, 0 disables
+    void set_slow_handler_threshold(std::chrono::microseconds threshold);
+
+    packet_metrics_snapshot snapshot();
+
+    // rates cover the interval between the two snapshots, percentiles the whole uptime
+    std::string report(const packet_metrics_snapshot& previous, const packet_metrics_snapshot& current);
+}
+
+#endif
@@ -1,6 +1,8 @@
 #ifndef __OPCODE_H
 #define __OPCODE_H
 
+#include <cstddef>
+
   enum class opcode : unsigned short
   {
 		CS_LOG_IN = 1000,
@@ -8,4 +10,38 @@
 		CS_PING = 2000,
 		SC_PING = 2001,
   };
+
+static constexpr size_t opcode_count = 4;
+
+// 0 .. opcode_count - 1, opcode_count for unknown codes
+inline size_t opcode_index(opcode code)
+{
+	switch (code)
+	{
+	case opcode::CS_LOG_IN: return 0;
+	case opcode::SC_LOG_IN: return 1;
+	case opcode::CS_PING: return 2;
+	case opcode::SC_PING: return 3;
+	default: return opcode_count;
+	}
+}
+
+inline opcode opcode_at(size_t index)
+{
+	static constexpr opcode codes[] = { opcode::CS_LOG_IN, opcode::SC_LOG_IN, opcode::CS_PING, opcode::SC_PING };
+	return codes[index];
+}
+
+inline const char* opcode_name(opcode code)
+{
+	switch (code)
+	{
+	case opcode::CS_LOG_IN: return "CS_LOG_IN";
+	case opcode::SC_LOG_IN: return "SC_LOG_IN";
+	case opcode::CS_PING: return "CS_PING";
+	case opcode::SC_PING: return "SC_PING";
+	default: return "UNKNOWN";
+	}
+}
+
 #endif
@@ -54,17 +54,20 @@ const ::google::protobuf::uint32 TableStruct::offsets[] = {
   ~0u,  // no _oneof_case_
   ~0u,  // no _weak_field_map_
   GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(CS_PING, timestamp_),
+  GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(CS_PING, echo_),
+  GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(CS_PING, hold_),
   ~0u,  // no _has_bits_
   GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(SC_PING, _internal_metadata_),
   ~0u,  // no _extensions_
   ~0u,  // no _oneof_case_
   ~0u,  // no _weak_field_map_
   GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(SC_PING, timestamp_),
+  GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(SC_PING, server_time_),
 };
 
 static const ::google::protobuf::internal::MigrationSchema schemas[] = {
   { 0, -1, sizeof(CS_PING)},
-  { 6, -1, sizeof(SC_PING)},
+  { 8, -1, sizeof(SC_PING)},
 };
 
 static ::google::protobuf::Message const * const file_default_instances[] = {
@@ -117,12 +120,13 @@ void InitDefaults() {
 void AddDescriptorsImpl() {
   InitDefaults();
   static const char descriptor[] = {
-      "\n\nGAME.proto\022\004GAME\"\034\n\007CS_PING\022\021\n\ttimesta"
-      "mp\030\001 \001(\003\"\034\n\007SC_PING\022\021\n\ttimestamp\030\001 \001(\003b\006"
-      "proto3"
+      "\n\nGAME.proto\022\004GAME\"8\n\007CS_PING\022\021\n\ttimesta"
+      "mp\030\001 \001(\003\022\014\n\004echo\030\002 \001(\003\022\014\n\004hold\030\003 \001(\003\"1\n\007"
+      "SC_PING\022\021\n\ttimestamp\030\001 \001(\003\022\023\n\013server_tim"
+      "e\030\002 \001(\003b\006proto3"
   };
   ::google::protobuf::DescriptorPool::InternalAddGeneratedFile(
-      descriptor, 86);
+      descriptor, 135);
   ::google::protobuf::MessageFactory::InternalRegisterGeneratedFile(
     "GAME.proto", &protobuf_RegisterTypes);
   ::google::protobuf::internal::OnShutdown(&TableStruct::Shutdown);
@@ -146,6 +150,8 @@ struct StaticDescriptorInitializer {
 
 #if !defined(_MSC_VER) || _MSC_VER >= 1900
 const int CS_PING::kTimestampFieldNumber;
+const int CS_PING::kEchoFieldNumber;
+const int CS_PING::kHoldFieldNumber;
 #endif  // !defined(_MSC_VER) || _MSC_VER >= 1900
 
 CS_PING::CS_PING()
@@ -161,12 +167,15 @@ CS_PING::CS_PING(const CS_PING& from)
       _internal_metadata_(NULL),
       _cached_size_(0) {
   _internal_metadata_.MergeFrom(from._internal_metadata_);
-  timestamp_ = from.timestamp_;
+  ::memcpy(&timestamp_, &from.timestamp_,
+    reinterpret_cast<char*>(&hold_) -
+    reinterpret_cast<char*>(&timestamp_) + sizeof(hold_));
   // @@protoc_insertion_point(copy_constructor:GAME.CS_PING)
 }
 
 void CS_PING::SharedCtor() {
-  timestamp_ = GOOGLE_LONGLONG(0);
+  ::memset(&timestamp_, 0, reinterpret_cast<char*>(&hold_) -
+    reinterpret_cast<char*>(&timestamp_) + sizeof(hold_));
   _cached_size_ = 0;
 }
 
@@ -203,7 +212,8 @@ CS_PING* CS_PING::New(::google::protobuf::Arena* arena) const {
 
 void CS_PING::Clear() {
 // @@protoc_insertion_point(message_clear_start:GAME.CS_PING)
-  timestamp_ = GOOGLE_LONGLONG(0);
+  ::memset(&timestamp_, 0, reinterpret_cast<char*>(&hold_) -
+    reinterpret_cast<char*>(&timestamp_) + sizeof(hold_));
 }
 
 bool CS_PING::MergePartialFromCodedStream(
@@ -230,6 +240,34 @@ bool CS_PING::MergePartialFromCodedStream(
         break;
       }
 
+      // int64 echo = 2;
+      case 2: {
+        if (static_cast< ::google::protobuf::uint8>(tag) ==
+            static_cast< ::google::protobuf::uint8>(16u)) {
+
+          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
+                   ::google::protobuf::int64, ::google::protobuf::internal::WireFormatLite::TYPE_INT64>(
+                 input, &echo_)));
+        } else {
+          goto handle_unusual;
+        }
+        break;
+      }
+
+      // int64 hold = 3;
+      case 3: {
+        if (static_cast< ::google::protobuf::uint8>(tag) ==
+            static_cast< ::google::protobuf::uint8>(24u)) {
+
+          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
+                   ::google::protobuf::int64, ::google::protobuf::internal::WireFormatLite::TYPE_INT64>(
+                 input, &hold_)));
+        } else {
+          goto handle_unusual;
+        }
+        break;
+      }
+
       default: {
       handle_unusual:
         if (tag == 0 ||
@@ -262,6 +300,16 @@ void CS_PING::SerializeWithCachedSizes(
     ::google::protobuf::internal::WireFormatLite::WriteInt64(1, this->timestamp(), output);
   }
 
+  // int64 echo = 2;
+  if (this->echo() != 0) {
+    ::google::protobuf::internal::WireFormatLite::WriteInt64(2, this->echo(), output);
+  }
+
+  // int64 hold = 3;
+  if (this->hold() != 0) {
+    ::google::protobuf::internal::WireFormatLite::WriteInt64(3, this->hold(), output);
+  }
+
   // @@protoc_insertion_point(serialize_end:GAME.CS_PING)
 }
 
@@ -276,6 +324,16 @@ void CS_PING::SerializeWithCachedSizes(
     target = ::google::protobuf::internal::WireFormatLite::WriteInt64ToArray(1, this->timestamp(), target);
   }
 
+  // int64 echo = 2;
+  if (this->echo() != 0) {
+    target = ::google::protobuf::internal::WireFormatLite::WriteInt64ToArray(2, this->echo(), target);
+  }
+
+  // int64 hold = 3;
+  if (this->hold() != 0) {
+    target = ::google::protobuf::internal::WireFormatLite::WriteInt64ToArray(3, this->hold(), target);
+  }
+
   // @@protoc_insertion_point(serialize_to_array_end:GAME.CS_PING)
   return target;
 }
@@ -291,6 +349,20 @@ size_t CS_PING::ByteSizeLong() const {
         this->timestamp());
   }
 
+  // int64 echo = 2;
+  if (this->echo() != 0) {
+    total_size += 1 +
+      ::google::protobuf::internal::WireFormatLite::Int64Size(
+        this->echo());
+  }
+
+  // int64 hold = 3;
+  if (this->hold() != 0) {
+    total_size += 1 +
+      ::google::protobuf::internal::WireFormatLite::Int64Size(
+        this->hold());
+  }
+
   int cached_size = ::google::protobuf::internal::ToCachedSize(total_size);
   GOOGLE_SAFE_CONCURRENT_WRITES_BEGIN();
   _cached_size_ = cached_size;
@@ -323,6 +395,12 @@ void CS_PING::MergeFrom(const CS_PING& from) {
   if (from.timestamp() != 0) {
     set_timestamp(from.timestamp());
   }
+  if (from.echo() != 0) {
+    set_echo(from.echo());
+  }
+  if (from.hold() != 0) {
+    set_hold(from.hold());
+  }
 }
 
 void CS_PING::CopyFrom(const ::google::protobuf::Message& from) {
@@ -349,6 +427,8 @@ void CS_PING::Swap(CS_PING* other) {
 }
 void CS_PING::InternalSwap(CS_PING* other) {
   std::swap(timestamp_, other->timestamp_);
+  std::swap(echo_, other->echo_);
+  std::swap(hold_, other->hold_);
   std::swap(_cached_size_, other->_cached_size_);
 }
 
@@ -374,12 +454,41 @@ void CS_PING::set_timestamp(::google::protobuf::int64 value) {
   // @@protoc_insertion_point(field_set:GAME.CS_PING.timestamp)
 }
 
+// int64 echo = 2;
+void CS_PING::clear_echo() {
+  echo_ = GOOGLE_LONGLONG(0);
+}
+::google::protobuf::int64 CS_PING::echo() const {
+  // @@protoc_insertion_point(field_get:GAME.CS_PING.echo)
+  return echo_;
+}
+void CS_PING::set_echo(::google::protobuf::int64 value) {
+  
+  echo_ = value;
+  // @@protoc_insertion_point(field_set:GAME.CS_PING.echo)
+}
+
+// int64 hold = 3;
+void CS_PING::clear_hold() {
+  hold_ = GOOGLE_LONGLONG(0);
+}
+::google::protobuf::int64 CS_PING::hold() const {
+  // @@protoc_insertion_point(field_get:GAME.CS_PING.hold)
+  return hold_;
+}
+void CS_PING::set_hold(::google::protobuf::int64 value) {
+  
+  hold_ = value;
+  // @@protoc_insertion_point(field_set:GAME.CS_PING.hold)
+}
+
 #endif  // PROTOBUF_INLINE_NOT_IN_HEADERS
 
 // ===================================================================
 
 #if !defined(_MSC_VER) || _MSC_VER >= 1900
 const int SC_PING::kTimestampFieldNumber;
+const int SC_PING::kServerTimeFieldNumber;
 #endif  // !defined(_MSC_VER) || _MSC_VER >= 1900
 
 SC_PING::SC_PING()
@@ -395,12 +504,15 @@ SC_PING::SC_PING(const SC_PING& from)
       _internal_metadata_(NULL),
       _cached_size_(0) {
   _internal_metadata_.MergeFrom(from._internal_metadata_);
-  timestamp_ = from.timestamp_;
+  ::memcpy(&timestamp_, &from.timestamp_,
+    reinterpret_cast<char*>(&server_time_) -
+    reinterpret_cast<char*>(&timestamp_) + sizeof(server_time_));
   // @@protoc_insertion_point(copy_constructor:GAME.SC_PING)
 }
 
 void SC_PING::SharedCtor() {
-  timestamp_ = GOOGLE_LONGLONG(0);
+  ::memset(&timestamp_, 0, reinterpret_cast<char*>(&server_time_) -
+    reinterpret_cast<char*>(&timestamp_) + sizeof(server_time_));
   _cached_size_ = 0;
 }
 
@@ -437,7 +549,8 @@ SC_PING* SC_PING::New(::google::protobuf::Arena* arena) const {
 
 void SC_PING::Clear() {
 // @@protoc_insertion_point(message_clear_start:GAME.SC_PING)
-  timestamp_ = GOOGLE_LONGLONG(0);
+  ::memset(&timestamp_, 0, reinterpret_cast<char*>(&server_time_) -
+    reinterpret_cast<char*>(&timestamp_) + sizeof(server_time_));
 }
 
 bool SC_PING::MergePartialFromCodedStream(
@@ -464,6 +577,20 @@ bool SC_PING::MergePartialFromCodedStream(
         break;
       }
 
+      // int64 server_time = 2;
+      case 2: {
+        if (static_cast< ::google::protobuf::uint8>(tag) ==
+            static_cast< ::google::protobuf::uint8>(16u)) {
+
+          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
+                   ::google::protobuf::int64, ::google::protobuf::internal::WireFormatLite::TYPE_INT64>(
+                 input, &server_time_)));
+        } else {
+          goto handle_unusual;
+        }
+        break;
+      }
+
       default: {
       handle_unusual:
         if (tag == 0 ||
@@ -496,6 +623,11 @@ void SC_PING::SerializeWithCachedSizes(
     ::google::protobuf::internal::WireFormatLite::WriteInt64(1, this->timestamp(), output);
   }
 
+  // int64 server_time = 2;
+  if (this->server_time() != 0) {
+    ::google::protobuf::internal::WireFormatLite::WriteInt64(2, this->server_time(), output);
+  }
+
   // @@protoc_insertion_point(serialize_end:GAME.SC_PING)
 }
 
@@ -510,6 +642,11 @@ void SC_PING::SerializeWithCachedSizes(
     target = ::google::protobuf::internal::WireFormatLite::WriteInt64ToArray(1, this->timestamp(), target);
   }
 
+  // int64 server_time = 2;
+  if (this->server_time() != 0) {
+    target = ::google::protobuf::internal::WireFormatLite::WriteInt64ToArray(2, this->server_time(), target);
+  }
+
   // @@protoc_insertion_point(serialize_to_array_end:GAME.SC_PING)
   return target;
 }
@@ -525,6 +662,13 @@ size_t SC_PING::ByteSizeLong() const {
         this->timestamp());
   }
 
+  // int64 server_time = 2;
+  if (this->server_time() != 0) {
+    total_size += 1 +
+      ::google::protobuf::internal::WireFormatLite::Int64Size(
+        this->server_time());
+  }
+
   int cached_size = ::google::protobuf::internal::ToCachedSize(total_size);
   GOOGLE_SAFE_CONCURRENT_WRITES_BEGIN();
   _cached_size_ = cached_size;
@@ -557,6 +701,9 @@ void SC_PING::MergeFrom(const SC_PING& from) {
   if (from.timestamp() != 0) {
     set_timestamp(from.timestamp());
   }
+  if (from.server_time() != 0) {
+    set_server_time(from.server_time());
+  }
 }
 
 void SC_PING::CopyFrom(const ::google::protobuf::Message& from) {
@@ -583,6 +730,7 @@ void SC_PING::Swap(SC_PING* other) {
 }
 void SC_PING::InternalSwap(SC_PING* other) {
   std::swap(timestamp_, other->timestamp_);
+  std::swap(server_time_, other->server_time_);
   std::swap(_cached_size_, other->_cached_size_);
 }
 
@@ -608,6 +756,20 @@ void SC_PING::set_timestamp(::google::protobuf::int64 value) {
   // @@protoc_insertion_point(field_set:GAME.SC_PING.timestamp)
 }
 
+// int64 server_time = 2;
+void SC_PING::clear_server_time() {
+  server_time_ = GOOGLE_LONGLONG(0);
+}
+::google::protobuf::int64 SC_PING::server_time() const {
+  // @@protoc_insertion_point(field_get:GAME.SC_PING.server_time)
+  return server_time_;
+}
+void SC_PING::set_server_time(::google::protobuf::int64 value) {
+  
+  server_time_ = value;
+  // @@protoc_insertion_point(field_set:GAME.SC_PING.server_time)
+}
+
 #endif  // PROTOBUF_INLINE_NOT_IN_HEADERS
 
 // @@protoc_insertion_point(namespace_scope)
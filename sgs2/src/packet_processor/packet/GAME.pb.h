@@ -127,11 +127,25 @@ class CS_PING : public ::google::protobuf::Message /* @@protoc_insertion_point(c
   ::google::protobuf::int64 timestamp() const;
   void set_timestamp(::google::protobuf::int64 value);
 
+  // int64 echo = 2;
+  void clear_echo();
+  static const int kEchoFieldNumber = 2;
+  ::google::protobuf::int64 echo() const;
+  void set_echo(::google::protobuf::int64 value);
+
+  // int64 hold = 3;
+  void clear_hold();
+  static const int kHoldFieldNumber = 3;
+  ::google::protobuf::int64 hold() const;
+  void set_hold(::google::protobuf::int64 value);
+
   // @@protoc_insertion_point(class_scope:GAME.CS_PING)
  private:
 
   ::google::protobuf::internal::InternalMetadataWithArena _internal_metadata_;
   ::google::protobuf::int64 timestamp_;
+  ::google::protobuf::int64 echo_;
+  ::google::protobuf::int64 hold_;
   mutable int _cached_size_;
   friend struct protobuf_GAME_2eproto::TableStruct;
 };
@@ -207,11 +221,18 @@ class SC_PING : public ::google::protobuf::Message /* @@protoc_insertion_point(c
   ::google::protobuf::int64 timestamp() const;
   void set_timestamp(::google::protobuf::int64 value);
 
+  // int64 server_time = 2;
+  void clear_server_time();
+  static const int kServerTimeFieldNumber = 2;
+  ::google::protobuf::int64 server_time() const;
+  void set_server_time(::google::protobuf::int64 value);
+
   // @@protoc_insertion_point(class_scope:GAME.SC_PING)
  private:
 
   ::google::protobuf::internal::InternalMetadataWithArena _internal_metadata_;
   ::google::protobuf::int64 timestamp_;
+  ::google::protobuf::int64 server_time_;
   mutable int _cached_size_;
   friend struct protobuf_GAME_2eproto::TableStruct;
 };
@@ -237,6 +258,34 @@ inline void CS_PING::set_timestamp(::google::protobuf::int64 value) {
   // @@protoc_insertion_point(field_set:GAME.CS_PING.timestamp)
 }
 
+// int64 echo = 2;
+inline void CS_PING::clear_echo() {
+  echo_ = GOOGLE_LONGLONG(0);
+}
+inline ::google::protobuf::int64 CS_PING::echo() const {
+  // @@protoc_insertion_point(field_get:GAME.CS_PING.echo)
+  return echo_;
+}
+inline void CS_PING::set_echo(::google::protobuf::int64 value) {
+  
+  echo_ = value;
+  // @@protoc_insertion_point(field_set:GAME.CS_PING.echo)
+}
+
+// int64 hold = 3;
+inline void CS_PING::clear_hold() {
+  hold_ = GOOGLE_LONGLONG(0);
+}
+inline ::google::protobuf::int64 CS_PING::hold() const {
+  // @@protoc_insertion_point(field_get:GAME.CS_PING.hold)
+  return hold_;
+}
+inline void CS_PING::set_hold(::google::protobuf::int64 value) {
+  
+  hold_ = value;
+  // @@protoc_insertion_point(field_set:GAME.CS_PING.hold)
+}
+
 // -------------------------------------------------------------------
 
 // SC_PING
@@ -255,6 +304,20 @@ inline void SC_PING::set_timestamp(::google::protobuf::int64 value) {
   // @@protoc_insertion_point(field_set:GAME.SC_PING.timestamp)
 }
 
+// int64 server_time = 2;
+inline void SC_PING::clear_server_time() {
+  server_time_ = GOOGLE_LONGLONG(0);
+}
+inline ::google::protobuf::int64 SC_PING::server_time() const {
+  // @@protoc_insertion_point(field_get:GAME.SC_PING.server_time)
+  return server_time_;
+}
+inline void SC_PING::set_server_time(::google::protobuf::int64 value) {
+  
+  server_time_ = value;
+  // @@protoc_insertion_point(field_set:GAME.SC_PING.server_time)
+}
+
 #endif  // !PROTOBUF_INLINE_NOT_IN_HEADERS
 // -------------------------------------------------------------------
 
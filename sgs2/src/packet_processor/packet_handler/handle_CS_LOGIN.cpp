@@ -1,17 +1,25 @@
 #include "../packet_processor.h"
-#include <memory>
 #include "../../server_session/server_session.h"
 #include "../opcode.h"
 #include "../send_helper.h"
-#include "../core/src/locale/string_helper.h"
+#include "../core/src/log/logger.h"
+#include "../core/src/locale/utf8.h"
 
-void handle_CS_LOG_IN(std::shared_ptr<server_session> session, const LOBBY::CS_LOG_IN& read)
+void handle_CS_LOG_IN(server_session& session, const LOBBY::CS_LOG_IN& read)
 {
-    auto id = core::utf8_to_wstring(read.id());
-    wprintf(L"id: %s\n", id.c_str());
+    LOG_DEBUG("session {} login id: {}", session.id(), read.id());
 
-    auto password = core::utf8_to_wstring(read.password());
-    wprintf(L"password: %s\n", password.c_str());
+    // protobuf checks proto3 strings only in debug builds
+    if (!core::utf8_validate(read.id()) || !core::utf8_validate(read.password()))
+    {
+        LOG_WARN_LIMITED(10, "session {} login with invalid utf-8", session.id());
+
+        LOBBY::SC_LOG_IN response;
+        response.set_result(false);
+        response.set_ec("invalid utf-8");
+        send(session, response);
+        return;
+    }
 
     auto error_message = "";
     auto result = true;
@@ -19,22 +27,22 @@ void handle_CS_LOG_IN(std::shared_ptr<server_session> session, const LOBBY::CS_L
     // id  password   account_id 
     auto account_id = 1000;
 
-    LOBBY::SC_LOG_IN send;
-    send.set_result(result);
-    send.set_timestamp(200000);
+    LOBBY::SC_LOG_IN response;
+    response.set_result(result);
+    response.set_timestamp(200000);
 
-    send_packet(session, opcode::SC_LOG_IN, send);
+    send(session, response);
     return;
 
     /*
     std::vector<std::thread> v;
     for (auto thread_count = 0; thread_count < 4; ++thread_count)
     {
-        v.emplace_back([session, send] {
+        v.emplace_back([session, response] {
             for (auto i = 0; i < 5; ++i)
             {
                 //wprintf(L"Ŷ : %d\n", i);
-                send_packet(session, opcode::SC_LOG_IN, send);
+                send(session, response);
             }
         });
     }
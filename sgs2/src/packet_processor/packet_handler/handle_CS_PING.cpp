@@ -1,16 +1,24 @@
 #include "../packet_processor.h"
-#include <memory>
 #include "../../server_session/server_session.h"
 #include "../opcode.h"
 #include "../send_helper.h"
+#include "../../time/server_clock.h"
+#include "../core/src/log/logger.h"
 
-void handle_CS_PING(std::shared_ptr<server_session> session, const GAME::CS_PING& read)
+void handle_CS_PING(server_session& session, const GAME::CS_PING& read)
 {
-    auto timestamp = read.timestamp();
-    wprintf(L"timestamp: %lld\n", timestamp);
+    const auto received = server_clock::now_us();
+    LOG_TRACE("session {} ping {} echo {} hold {}", session.id(), read.timestamp(), read.echo(), read.hold());
 
-    GAME::SC_PING send;
-    send.set_timestamp(400);
+    // 0 until the client has seen an SC_PING, no estimator before then
+    if (read.echo() != 0)
+    {
+        session.rtt().on_ping(read.timestamp(), read.echo(), read.hold(), received);
+    }
 
-    send_packet(session, opcode::SC_PING, send);
+    GAME::SC_PING response;
+    response.set_timestamp(read.timestamp());
+    response.set_server_time(server_clock::now_us());
+
+    send(session, response);
 }
@@ -3,11 +3,20 @@
 #include <google/protobuf/io/zero_copy_stream_impl_lite.h>
 #include "opcode.h"
 #include "../server_session/server_session.h"
+#include "../executor/executor.h"
+#include "../metrics/packet_metrics.h"
+#include "../core/src/trace/trace.h"
+#include "../core/src/perf/perf_counters.h"
+#include "../core/src/memory/alloc_tracker.h"
+#include "packet_traits.h"
 
 
 template <typename T, typename = typename std::enable_if_t<std::is_base_of<::google::protobuf::Message, T>::value>>
-void deserialize(std::shared_ptr<server_session> session, buf_ptr buffer, int size, std::function<void(std::shared_ptr<server_session>, const T&)> process_function)
+void deserialize(server_session& session, buf_ptr buffer, int size, packet_metrics::clock::time_point received, void (*process_function)(server_session&, const T&))
 {
+	TRACE_SCOPE("handler", session.id(), static_cast<int>(packet_traits<T>::code));
+	core::alloc_scope alloc_tag(core::alloc_tag::handler);
+	const auto started = packet_metrics::clock::now();
 	google::protobuf::io::ArrayInputStream is(buffer->data() + sizeof(unsigned short), size - sizeof(unsigned short));
 	T read;
 
@@ -16,10 +25,21 @@ void deserialize(std::shared_ptr<server_session> session, buf_ptr buffer, int si
 		auto r = read.ParseFromZeroCopyStream(&is);
 		if (!r)
 		{
-			session->close();
+			session.close();
 			return;
 		}
+
+		// --perf: hardware counters around the handler only, timing alone when unavailable
+		core::perf_sample perf_begin;
+		const auto profiling = core::perf_counters::read(perf_begin);
 		process_function(session, read);
+		core::perf_sample perf_end;
+		if (profiling && core::perf_counters::read(perf_end))
+		{
+			packet_metrics::on_perf(packet_traits<T>::code, perf_end - perf_begin);
+		}
+
+		packet_metrics::on_handler(packet_traits<T>::code, session.id(), received, started, packet_metrics::clock::now());
 	}
 	catch (std::logic_error& e)
 	{
@@ -29,7 +49,8 @@ void deserialize(std::shared_ptr<server_session> session, buf_ptr buffer, int si
 	}
 }
 
-using packet_handler = std::function<void(std::shared_ptr<server_session> session, buf_ptr buffer, int size)>;
+// handlers borrow the session, only the ones that run later (executor policies) take a server_session_ptr
+using packet_handler = void (*)(server_session& session, buf_ptr buffer, int size, packet_metrics::clock::time_point received);
 packet_handler packet_handlers[(std::numeric_limits<unsigned short>::max)()] = { nullptr };
  auto to_index = [](opcode code)
 {
@@ -40,23 +61,27 @@ void register_handlers()
 {
 	for (auto& handler : packet_handlers)
 	{
-		handler = [](std::shared_ptr<server_session> session, buf_ptr const buffer, int size)
+		handler = [](server_session& session, buf_ptr const buffer, int size, packet_metrics::clock::time_point received)
 		{
 			return;
 		};
 	}
-	packet_handlers[to_index(opcode::CS_LOG_IN)] = [](std::shared_ptr<server_session> session, buf_ptr buffer, int size) { deserialize<LOBBY::CS_LOG_IN>(std::move(session), std::move(buffer), size, handle_CS_LOG_IN); };
-	packet_handlers[to_index(opcode::CS_PING)] = [](std::shared_ptr<server_session> session, buf_ptr buffer, int size) { deserialize<GAME::CS_PING>(std::move(session), std::move(buffer), size, handle_CS_PING); };
+	packet_handlers[to_index(opcode::CS_LOG_IN)] = [](server_session& session, buf_ptr buffer, int size, packet_metrics::clock::time_point received) { blocking_executor().post([owner = server_session_ptr(&session), buffer = std::move(buffer), size, received]() mutable { deserialize<LOBBY::CS_LOG_IN>(*owner, std::move(buffer), size, received, handle_CS_LOG_IN); }); };
+	packet_handlers[to_index(opcode::CS_PING)] = [](server_session& session, buf_ptr buffer, int size, packet_metrics::clock::time_point received) { deserialize<GAME::CS_PING>(session, std::move(buffer), size, received, handle_CS_PING); };
 }
 
-void handle_packet(std::shared_ptr<server_session> session, buf_ptr buffer, int size)
+void handle_packet(server_session& session, buf_ptr buffer, int size)
 {
 	if (size < sizeof(opcode) || size - sizeof(unsigned short) < 0)
 	{
 		return;
 	}
 
+	const auto received = packet_metrics::clock::now();
 	auto packet_num = *reinterpret_cast<opcode*>(buffer->data());
+	TRACE_SCOPE("dispatch", session.id(), to_index(packet_num));
+	core::alloc_scope alloc_tag(core::alloc_tag::dispatch);
+	packet_metrics::on_inbound(packet_num, size);
 
-	packet_handlers[to_index(packet_num)](std::move(session), std::move(buffer), size);
+	packet_handlers[to_index(packet_num)](session, std::move(buffer), size, received);
 }
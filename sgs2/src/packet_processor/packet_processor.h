@@ -11,12 +11,12 @@ using buf_ptr = std::shared_ptr<network::packet_buffer_type>;
 
 class server_session;
 
-void handle_CS_LOG_IN(std::shared_ptr<server_session> session, const LOBBY::CS_LOG_IN& read);
-void handle_CS_PING(std::shared_ptr<server_session> session, const GAME::CS_PING& read);
+void handle_CS_LOG_IN(server_session& session, const LOBBY::CS_LOG_IN& read);
+void handle_CS_PING(server_session& session, const GAME::CS_PING& read);
 
 
 void register_handlers();
-void handle_packet(std::shared_ptr<server_session> session, buf_ptr buffer, int size);
+void handle_packet(server_session& session, buf_ptr buffer, int size);
 
 
 
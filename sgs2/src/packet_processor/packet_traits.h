@@ -0,0 +1,23 @@
+#ifndef __PACKET_TRAITS_H
+#define __PACKET_TRAITS_H
+
+#include "opcode.h"
+#include "packet/LOBBY.pb.h"
+#include "packet/GAME.pb.h"
+
+template <class Protobuf>
+struct packet_traits;
+
+template <> struct packet_traits<LOBBY::CS_LOG_IN> { static constexpr opcode code = opcode::CS_LOG_IN; };
+template <> struct packet_traits<LOBBY::SC_LOG_IN> { static constexpr opcode code = opcode::SC_LOG_IN; };
+template <> struct packet_traits<GAME::CS_PING> { static constexpr opcode code = opcode::CS_PING; };
+template <> struct packet_traits<GAME::SC_PING> { static constexpr opcode code = opcode::SC_PING; };
+
+// X(package, message) for every message, for code that has to touch all of them
+#define FOR_EACH_PACKET(X) \
+	X(LOBBY, CS_LOG_IN) \
+	X(LOBBY, SC_LOG_IN) \
+	X(GAME, CS_PING) \
+	X(GAME, SC_PING)
+
+#endif
@@ -1,55 +1,69 @@
 #ifndef __SEND_HELPER_H
 #define __SEND_HELPER_H
 
-#include "static_if.h"
+#include <cstring>
 #include "opcode.h"
-#include "../../../network/src/io_helper.h"
-#include <google/protobuf/io/zero_copy_stream_impl_lite.h>
+#include "session/session.h"
+#include "buffer_pool/send_buffer_pool.h"
+#include "../room/room.h"
+#include "../metrics/packet_metrics.h"
+#include "../core/src/trace/trace.h"
+#include "../core/src/memory/alloc_tracker.h"
+#include "packet/LOBBY.pb.h"
+#include "packet/GAME.pb.h"
 
-template <class Protobuf>
-bool serialize_packet(opcode opcode, Protobuf protobuf, char* buffer, unsigned short& written)
+template <opcode Opcode, class Protobuf>
+bool send_packet(network::session& session, const Protobuf& protobuf, network::send_priority priority = network::send_priority::normal, network::coalesce_key key = network::coalesce_key())
 {
-    auto ret = false;
-    static_if<std::is_pointer<Protobuf>::value>([&](auto f)
-    {
-        written = protobuf->ByteSize();
-        google::protobuf::io::ArrayOutputStream os(buffer, written);
-        ret = protobuf->SerializeToZeroCopyStream(&os);
-    }).else_([&](auto f)
-    {
-        written = protobuf.ByteSize();
-        google::protobuf::io::ArrayOutputStream os(buffer, written);
-        ret = protobuf.SerializeToZeroCopyStream(&os);
-    });
-
-    return ret;
-}
+	static constexpr auto header_size = sizeof(unsigned short) * 2;
 
-template <class Session, class Protobuf>
-void send_packet(Session session, opcode opcode, Protobuf protobuf)
-{
-    using namespace network;
-    auto buffer = std::make_shared<send_buffer>();
-
-    // copy opcode
-    std::memcpy(buffer->buf.data() + sizeof(unsigned short), &opcode, sizeof(unsigned short));
-
-    auto r = serialize_packet(opcode, protobuf, buffer->buf.data() + sizeof(unsigned short)*2, buffer->size);
-
-    if (r)
-    {
-        // header size
-        buffer->size = buffer->size + sizeof(unsigned short);
-        std::memcpy(buffer->buf.data(), &(buffer->size), sizeof(unsigned short));
-
-        // total packet size
-        buffer->size = buffer->size + sizeof(unsigned short);
-        session->send(buffer);
-    }
-    else
-    {
-        // error 
-    }
+	// ByteSizeLong() caches the size for SerializeWithCachedSizesToArray()
+	const auto body_size = protobuf.ByteSizeLong();
+	if (body_size + sizeof(unsigned short) > network::max_packet_size)
+	{
+		return false;
+	}
+
+	core::alloc_scope alloc_tag(core::alloc_tag::send);
+	const auto size = static_cast<unsigned short>(body_size + sizeof(unsigned short));
+	auto serialize = [&](char* data)
+	{
+		TRACE_SCOPE("serialize", session.id(), static_cast<int>(Opcode));
+		const auto code = Opcode;
+		std::memcpy(data, &size, sizeof(unsigned short));
+		std::memcpy(data + sizeof(unsigned short), &code, sizeof(unsigned short));
+		protobuf.SerializeWithCachedSizesToArray(reinterpret_cast<google::protobuf::uint8*>(data + header_size));
+	};
+	packet_metrics::on_outbound(Opcode, size);
+
+	// unicast frames are serialized straight into the session's send queue
+	// a room defers its sends to the end of the tick and a keyed frame may be replaced, both need a buffer of their own
+	auto r = room::current();
+	if (!r && key.empty())
+	{
+		session.send_frame(priority, size + sizeof(unsigned short), serialize);
+		return true;
+	}
+
+	auto buffer = network::acquire_send_buffer();
+	serialize(buffer->buf.data());
+	buffer->size = static_cast<unsigned short>(size + sizeof(unsigned short));
+	buffer->key = key;
+	buffer->priority = priority;
+
+	if (r)
+	{
+		r->defer_send(session, std::move(buffer));
+	}
+	else
+	{
+		session.send(std::move(buffer));
+	}
+
+	return true;
 }
 
+inline bool send(network::session& session, const LOBBY::SC_LOG_IN& packet, network::send_priority priority = network::send_priority::normal) { return send_packet<opcode::SC_LOG_IN>(session, packet, priority); }
+inline bool send(network::session& session, const GAME::SC_PING& packet, network::send_priority priority = network::send_priority::control) { return send_packet<opcode::SC_PING>(session, packet, priority); }
+
 #endif
@@ -0,0 +1,133 @@
+#include "room.h"
+#include "../core/src/trace/trace.h"
+#include "../core/src/memory/alloc_tracker.h"
+
+#ifndef __linux__
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+namespace
+{
+    thread_local room* current_room = nullptr;
+
+    long long thread_cpu_time_us()
+    {
+#ifndef __linux__
+        FILETIME creation, exit, kernel, user;
+        if (!GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user))
+        {
+            return 0;
+        }
+
+        ULARGE_INTEGER k, u;
+        k.LowPart = kernel.dwLowDateTime;
+        k.HighPart = kernel.dwHighDateTime;
+        u.LowPart = user.dwLowDateTime;
+        u.HighPart = user.dwHighDateTime;
+
+        // 100ns units
+        return static_cast<long long>((k.QuadPart + u.QuadPart) / 10);
+#else
+        timespec ts;
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+        return static_cast<long long>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+#endif
+    }
+}
+
+room::room(unsigned int id, unsigned int tick_rate)
+    : id_(id),
+    tick_interval_(std::chrono::duration_cast<clock::duration>(std::chrono::seconds(1)) / (tick_rate > 0 ? tick_rate : 1)),
+    next_tick_(clock::now())
+{
+}
+
+room::~room()
+{
+}
+
+void room::post(task t)
+{
+    mailbox_.push(std::move(t));
+}
+
+void room::defer_send(network::session& session, network::send_buf_ptr buffer)
+{
+    outbox_.emplace_back(network::session_ptr(&session), std::move(buffer));
+}
+
+room_stats room::stats() const
+{
+    room_stats stats;
+    stats.ticks = ticks_.load(std::memory_order_relaxed);
+    stats.overruns = overruns_.load(std::memory_order_relaxed);
+    stats.tasks = tasks_.load(std::memory_order_relaxed);
+    stats.max_jitter_us = max_jitter_us_.load(std::memory_order_relaxed);
+    stats.total_jitter_us = total_jitter_us_.load(std::memory_order_relaxed);
+    stats.cpu_time_us = cpu_time_us_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+room* room::current()
+{
+    return current_room;
+}
+
+void room::run_tick(clock::time_point now)
+{
+    using std::chrono::duration_cast;
+    using std::chrono::microseconds;
+
+    auto jitter_us = duration_cast<microseconds>(now - next_tick_).count();
+    auto cpu_begin = thread_cpu_time_us();
+
+    current_room = this;
+
+    TRACE_SCOPE("room_tick");
+    core::alloc_scope alloc_tag(core::alloc_tag::room);
+    drain_mailbox();
+    on_tick(tick_interval_);
+    flush_outbox();
+
+    current_room = nullptr;
+
+    auto end = clock::now();
+    cpu_time_us_.fetch_add(thread_cpu_time_us() - cpu_begin, std::memory_order_relaxed);
+    ticks_.fetch_add(1, std::memory_order_relaxed);
+    total_jitter_us_.fetch_add(jitter_us, std::memory_order_relaxed);
+    if (jitter_us > max_jitter_us_.load(std::memory_order_relaxed))
+    {
+        max_jitter_us_.store(jitter_us, std::memory_order_relaxed);
+    }
+
+    next_tick_ += tick_interval_;
+
+    // fell behind by a whole tick, skip ahead instead of bursting to catch up
+    if (end >= next_tick_)
+    {
+        overruns_.fetch_add(1, std::memory_order_relaxed);
+        next_tick_ = end + tick_interval_;
+    }
+}
+
+void room::drain_mailbox()
+{
+    task t;
+    while (mailbox_.pop(t))
+    {
+        tasks_.fetch_add(1, std::memory_order_relaxed);
+        t();
+    }
+}
+
+void room::flush_outbox()
+{
+    for (auto& out : outbox_)
+    {
+        out.first->send(std::move(out.second));
+    }
+
+    outbox_.clear();
+}
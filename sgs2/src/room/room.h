@@ -0,0 +1,72 @@
+#ifndef __ROOM_H
+#define __ROOM_H
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "session/session.h"
+#include "../core/src/concurrency/mpsc_queue.h"
+
+struct room_stats
+{
+    size_t ticks = 0;
+    size_t overruns = 0;
+    size_t tasks = 0;
+    long long max_jitter_us = 0;
+    long long total_jitter_us = 0;
+    long long cpu_time_us = 0;
+};
+
+class room : public std::enable_shared_from_this<room>
+{
+public:
+    using clock = std::chrono::steady_clock;
+    using task = std::function<void()>;
+
+    static constexpr unsigned int default_tick_rate = 30;
+
+    room(unsigned int id, unsigned int tick_rate);
+    virtual ~room();
+
+    unsigned int id() const { return id_; }
+    clock::duration tick_interval() const { return tick_interval_; }
+
+    // any thread, executed at the start of the next tick
+    void post(task t);
+
+    // sends issued while ticking are flushed at the end of the tick
+    void defer_send(network::session& session, network::send_buf_ptr buffer);
+
+    room_stats stats() const;
+
+    // room being ticked on this thread, nullptr outside of a tick
+    static room* current();
+
+protected:
+    virtual void on_tick(clock::duration dt) {}
+
+private:
+    friend class room_scheduler;
+
+    void run_tick(clock::time_point now);
+    void drain_mailbox();
+    void flush_outbox();
+
+    unsigned int id_;
+    clock::duration tick_interval_;
+    clock::time_point next_tick_;
+
+    core::mpsc_queue<task> mailbox_;
+    std::vector<std::pair<network::session_ptr, network::send_buf_ptr>> outbox_;
+
+    std::atomic<size_t> ticks_{ 0 };
+    std::atomic<size_t> overruns_{ 0 };
+    std::atomic<size_t> tasks_{ 0 };
+    std::atomic<long long> max_jitter_us_{ 0 };
+    std::atomic<long long> total_jitter_us_{ 0 };
+    std::atomic<long long> cpu_time_us_{ 0 };
+};
+
+#endif
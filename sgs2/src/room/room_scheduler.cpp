@@ -0,0 +1,139 @@
+#include "room_scheduler.h"
+#include <algorithm>
+#include <string>
+#include "../core/src/trace/trace.h"
+
+room_scheduler& room_scheduler::instance()
+{
+    static room_scheduler scheduler;
+    return scheduler;
+}
+
+void room_scheduler::start(size_t thread_count)
+{
+    stop_ = false;
+
+    std::vector<std::unique_ptr<sim_thread>> threads;
+    threads.reserve(thread_count);
+    for (size_t i = 0; i < thread_count; ++i)
+    {
+        threads.emplace_back(std::make_unique<sim_thread>());
+    }
+
+    for (size_t i = 0; i < threads.size(); ++i)
+    {
+        auto ptr = threads[i].get();
+        threads[i]->thread = std::thread([this, ptr, i]
+        {
+            core::trace::set_thread_name("room " + std::to_string(i));
+            run(*ptr);
+        });
+    }
+
+    std::lock_guard<std::mutex> lock(threads_lock_);
+    threads_ = std::move(threads);
+}
+
+void room_scheduler::stop()
+{
+    std::vector<std::unique_ptr<sim_thread>> threads;
+    {
+        std::lock_guard<std::mutex> lock(threads_lock_);
+        threads.swap(threads_);
+    }
+
+    stop_ = true;
+
+    for (auto& t : threads)
+    {
+        {
+            std::lock_guard<std::mutex> lock(t->m);
+        }
+        t->cv.notify_all();
+        t->thread.join();
+    }
+}
+
+bool room_scheduler::add(std::shared_ptr<room> r)
+{
+    std::lock_guard<std::mutex> threads_lock(threads_lock_);
+    if (threads_.empty())
+    {
+        return false;
+    }
+
+    auto& t = threads_[next_thread_.fetch_add(1, std::memory_order_relaxed) % threads_.size()];
+    {
+        std::lock_guard<std::mutex> lock(t->m);
+        r->next_tick_ = room::clock::now();
+        t->rooms.emplace_back(std::move(r));
+        t->changed = true;
+    }
+    t->cv.notify_all();
+    return true;
+}
+
+void room_scheduler::remove(const std::shared_ptr<room>& r)
+{
+    std::lock_guard<std::mutex> threads_lock(threads_lock_);
+    for (auto& t : threads_)
+    {
+        std::lock_guard<std::mutex> lock(t->m);
+        auto it = std::find(t->rooms.begin(), t->rooms.end(), r);
+        if (it != t->rooms.end())
+        {
+            t->rooms.erase(it);
+            t->changed = true;
+            return;
+        }
+    }
+}
+
+std::vector<std::shared_ptr<room>> room_scheduler::rooms() const
+{
+    std::vector<std::shared_ptr<room>> all;
+
+    std::lock_guard<std::mutex> threads_lock(threads_lock_);
+    for (auto& t : threads_)
+    {
+        std::lock_guard<std::mutex> lock(t->m);
+        all.insert(all.end(), t->rooms.begin(), t->rooms.end());
+    }
+
+    return all;
+}
+
+void room_scheduler::run(sim_thread& t)
+{
+    static constexpr auto idle_wait = std::chrono::milliseconds(100);
+
+    auto next_wakeup = room::clock::now();
+
+    while (!stop_)
+    {
+        {
+            std::unique_lock<std::mutex> lock(t.m);
+            t.cv.wait_until(lock, next_wakeup, [&] { return stop_ || t.changed; });
+
+            if (t.changed)
+            {
+                t.snapshot = t.rooms;
+                t.changed = false;
+            }
+        }
+
+        auto now = room::clock::now();
+        next_wakeup = now + idle_wait;
+
+        for (auto& r : t.snapshot)
+        {
+            if (r->next_tick_ <= now)
+            {
+                r->run_tick(now);
+                now = room::clock::now();
+            }
+
+            next_wakeup = (std::min)(next_wakeup, r->next_tick_);
+        }
+    }
+}
@@ -0,0 +1,50 @@
+#ifndef __ROOM_SCHEDULER_H
+#define __ROOM_SCHEDULER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "room.h"
+
+// fixed pool of simulation threads, each room is pinned to one of them
+class room_scheduler
+{
+public:
+    static room_scheduler& instance();
+
+    void start(size_t thread_count);
+    void stop();
+
+    // false when the scheduler is not running, the room would never tick
+    bool add(std::shared_ptr<room> r);
+    void remove(const std::shared_ptr<room>& r);
+
+    std::vector<std::shared_ptr<room>> rooms() const;
+
+private:
+    struct sim_thread
+    {
+        std::mutex m;
+        std::condition_variable cv;
+        std::vector<std::shared_ptr<room>> rooms;
+        std::vector<std::shared_ptr<room>> snapshot;
+        bool changed = false;
+        std::thread thread;
+    };
+
+    room_scheduler() = default;
+
+    void run(sim_thread& t);
+
+    std::atomic_bool stop_{ false };
+
+    // start() and stop() swap the whole set, add/remove/rooms() read it under the same lock
+    mutable std::mutex threads_lock_;
+    std::vector<std::unique_ptr<sim_thread>> threads_;
+    std::atomic<size_t> next_thread_{ 0 };
+};
+
+#endif
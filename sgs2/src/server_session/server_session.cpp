@@ -1,41 +1,106 @@
 #include "server_session.h"
 #include "../packet_processor/packet_processor.h"
 #include "../packet_processor/send_helper.h"
+#include "../executor/executor.h"
+#include "../capture/capture.h"
+#include "../core/src/log/logger.h"
 
 server_session::server_session(tcp::socket socket) : session(std::move(socket))
 {
     
 }
 
+server_session::server_session(boost::asio::io_service& io_service) : session(io_service)
+{
+
+}
+
 server_session::~server_session()
 {
+    if (rtt_)
+    {
+        time_sync::untrack(id());
+    }
+}
+
+void server_session::reset()
+{
+    leave_room();
+    if (rtt_)
+    {
+        time_sync::untrack(id());
+        rtt_.reset();
+    }
+    session::reset();
+}
+
+void server_session::enter_room(std::shared_ptr<room> r)
+{
+    std::atomic_store(&room_, std::move(r));
+}
+
+void server_session::leave_room()
+{
+    std::atomic_store(&room_, std::shared_ptr<room>());
+}
+
+std::shared_ptr<room> server_session::current_room() const
+{
+    return std::atomic_load(&room_);
+}
 
+rtt_estimator& server_session::rtt()
+{
+    if (!rtt_)
+    {
+        rtt_ = std::make_shared<rtt_estimator>();
+        time_sync::track(id(), rtt_);
+    }
+    return *rtt_;
 }
 
 void server_session::on_read_packet(std::shared_ptr<network::packet_buffer_type> buf, unsigned short size)
 {
-    wprintf(L"server_session on_read_packet called\n");
-    auto self = std::static_pointer_cast<server_session>(shared_from_this());
-    handle_packet(self, buf, size);
+    LOG_TRACE("session {} read {} bytes", id(), size);
+
+    auto& capture = capture_writer::instance();
+    if (capture.enabled())
+    {
+        capture.record(id(), buf->data(), size);
+    }
+
+    // the read loop keeps the session alive until handle_packet returns
+    handle_packet(*this, std::move(buf), size);
 }
 
 void server_session::on_connect()
 {
-    wprintf(L"server_session on_connected called\n");
+    LOG_TRACE("session {} connected", id());
     
-    LOBBY::SC_LOG_IN send;
-    send.set_result(true);
-    send.set_timestamp(200000);
-    send_packet(shared_from_this(), opcode::SC_LOG_IN, send);
+    LOBBY::SC_LOG_IN response;
+    response.set_result(true);
+    response.set_timestamp(200000);
+    ::send(*this, response);
     
 }
 
 void server_session::on_disconnect(boost::system::error_code& ec)
 {
-    wprintf(L"on disconnect with error\n");
+    LOG_DEBUG("session {} disconnected: {}", id(), ec.message());
 }
 
 void server_session::on_disconnect()
 {
-    wprintf(L"on disconnect\n");
+    LOG_DEBUG("session {} disconnected", id());
+}
+
+void post_logic(server_session& session, room::task task)
+{
+    if (auto r = session.current_room())
+    {
+        r->post(std::move(task));
+        return;
+    }
+
+    logic_executor().post(std::move(task));
 }
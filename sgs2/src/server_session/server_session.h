@@ -2,6 +2,8 @@
 #define __SERVER_SESSION_H
 
 #include "session/session.h"
+#include "../room/room.h"
+#include "../time/time_sync.h"
 
 using boost::asio::ip::tcp;
 
@@ -10,8 +12,19 @@ class server_session : public network::session
 public:
 
     explicit server_session(tcp::socket socket);
+    explicit server_session(boost::asio::io_service& io_service);
     virtual ~server_session();
 
+    virtual void reset() override;
+
+    void enter_room(std::shared_ptr<room> r);
+    void leave_room();
+    std::shared_ptr<room> current_room() const;
+
+    // latency and clock offset from this connection's pings, created and tracked on first use
+    // read path only
+    rtt_estimator& rtt();
+
 protected:
 
     virtual void on_read_packet(std::shared_ptr<network::packet_buffer_type> buf, unsigned short size) override;
@@ -19,6 +32,16 @@ protected:
     virtual void on_disconnect(boost::system::error_code& ec) override;
     virtual void on_disconnect() override;
 
+private:
+    std::shared_ptr<room> room_;
+
+    // shared with time_sync while connected, empty until the first echoed ping so idle sessions don't pay for it
+    std::shared_ptr<rtt_estimator> rtt_;
 };
 
+using server_session_ptr = boost::intrusive_ptr<server_session>;
+
+// policy="logic" : runs on the session's room, or on the logic executor outside of a room
+void post_logic(server_session& session, room::task task);
+
 #endif
@@ -0,0 +1,31 @@
+#include "server_clock.h"
+
+namespace
+{
+    server_clock::clock::time_point origin()
+    {
+        static const auto start = server_clock::clock::now();
+        return start;
+    }
+
+    // pinned before main so time 0 is process start rather than the first call
+    const auto pinned_origin = origin();
+}
+
+namespace server_clock
+{
+    int64_t now_us()
+    {
+        return to_us(clock::now());
+    }
+
+    int64_t to_us(clock::time_point time)
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(time - origin()).count();
+    }
+
+    int64_t tick_at(int64_t time_us, unsigned int tick_rate)
+    {
+        return time_us * tick_rate / 1000000;
+    }
+}
@@ -0,0 +1,24 @@
+#ifndef __SERVER_CLOCK_H
+#define __SERVER_CLOCK_H
+
+#include <chrono>
+#include <cstdint>
+
+// monotonic server time in microseconds since the process started, the one time base for game code
+// SC_PING carries it as server_time; clients map it onto their own clock with the offset the server
+// estimates per session, see rtt_estimator
+namespace server_clock
+{
+    using clock = std::chrono::steady_clock;
+
+    int64_t now_us();
+
+    // a steady_clock time point in server time
+    int64_t to_us(clock::time_point time);
+
+    // simulation tick a server time falls into at tick_rate ticks per second, e.g. to rewind a hit
+    // check to the tick the client saw: tick_at(now_us() - estimate.srtt_us / 2, room::default_tick_rate)
+    int64_t tick_at(int64_t time_us, unsigned int tick_rate);
+}
+
+#endif
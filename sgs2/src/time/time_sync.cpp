@@ -0,0 +1,157 @@
+#include "time_sync.h"
+#include <algorithm>
+#include <cstdlib>
+#include <mutex>
+#include "../core/src/concurrency/concurrent_hash_map.h"
+
+namespace
+{
+    // older echoes belong to a stalled or lying client
+    static constexpr int64_t max_rtt_us = 60 * 1000000LL;
+
+    // written by its own thread only, merged by snapshot() while written
+    struct shard
+    {
+        core::shared_histogram rtt_us;
+        core::shared_histogram jitter_us;
+        std::atomic<uint64_t> rejected{ 0 };
+    };
+
+    std::mutex shards_lock;
+    std::vector<std::unique_ptr<shard>> shards;
+
+    // shards outlive their threads, same as packet_metrics
+    shard& local_shard()
+    {
+        thread_local shard* local = nullptr;
+        if (local == nullptr)
+        {
+            std::lock_guard<std::mutex> lock(shards_lock);
+            shards.emplace_back(std::make_unique<shard>());
+            local = shards.back().get();
+        }
+        return *local;
+    }
+
+    using registry = core::concurrent_hash_map<unsigned int, std::shared_ptr<const rtt_estimator>>;
+
+    // never destroyed, sessions released while the io_service shuts down still untrack
+    registry& tracked()
+    {
+        static auto sessions = new registry(1024);
+        return *sessions;
+    }
+}
+
+bool rtt_estimator::on_ping(int64_t client_sent_us, int64_t echo_us, int64_t hold_us, int64_t received_us)
+{
+    const auto rtt = received_us - echo_us - hold_us;
+    if (echo_us <= 0 || hold_us < 0 || echo_us > received_us || rtt < 0 || rtt > max_rtt_us)
+    {
+        time_sync::on_rejected();
+        return false;
+    }
+
+    const auto offset = ((client_sent_us - hold_us - echo_us) + (client_sent_us - received_us)) / 2;
+
+    rtt_window_[next_] = static_cast<int32_t>(rtt);
+    offset_window_[next_] = offset;
+    next_ = static_cast<unsigned char>((next_ + 1) % window);
+    filled_ = static_cast<unsigned char>((std::min)(static_cast<size_t>(filled_) + 1, window));
+
+    size_t best = 0;
+    for (size_t i = 1; i < filled_; ++i)
+    {
+        if (rtt_window_[i] < rtt_window_[best])
+        {
+            best = i;
+        }
+    }
+
+    // RFC 6298: the variation is updated against the previous srtt
+    auto srtt = srtt_us_.load(std::memory_order_relaxed);
+    auto jitter = jitter_us_.load(std::memory_order_relaxed);
+    const auto samples = samples_.load(std::memory_order_relaxed);
+    if (samples == 0)
+    {
+        srtt = rtt;
+        jitter = rtt / 2;
+    }
+    else
+    {
+        jitter += (std::llabs(rtt - srtt) - jitter) / 4;
+        srtt += (rtt - srtt) / 8;
+    }
+
+    last_us_.store(rtt, std::memory_order_relaxed);
+    srtt_us_.store(srtt, std::memory_order_relaxed);
+    jitter_us_.store(jitter, std::memory_order_relaxed);
+    min_us_.store(rtt_window_[best], std::memory_order_relaxed);
+    offset_us_.store(offset_window_[best], std::memory_order_relaxed);
+    samples_.store(samples + 1, std::memory_order_relaxed);
+
+    time_sync::on_sample(rtt, jitter);
+    return true;
+}
+
+rtt_estimate rtt_estimator::estimate() const
+{
+    rtt_estimate e;
+    e.samples = samples_.load(std::memory_order_relaxed);
+    e.last_us = last_us_.load(std::memory_order_relaxed);
+    e.srtt_us = srtt_us_.load(std::memory_order_relaxed);
+    e.jitter_us = jitter_us_.load(std::memory_order_relaxed);
+    e.min_us = min_us_.load(std::memory_order_relaxed);
+    e.offset_us = offset_us_.load(std::memory_order_relaxed);
+    return e;
+}
+
+namespace time_sync
+{
+    void track(unsigned int session_id, std::shared_ptr<const rtt_estimator> estimator)
+    {
+        tracked().insert_or_assign(session_id, estimator);
+    }
+
+    void untrack(unsigned int session_id)
+    {
+        tracked().erase(session_id);
+    }
+
+    std::vector<session_rtt> sessions()
+    {
+        std::vector<session_rtt> out;
+        tracked().for_each([&](unsigned int session_id, const std::shared_ptr<const rtt_estimator>& estimator)
+        {
+            out.push_back(session_rtt{ session_id, estimator->estimate() });
+        });
+        return out;
+    }
+
+    void on_sample(int64_t rtt_us, int64_t jitter_us)
+    {
+        auto& s = local_shard();
+        s.rtt_us.record(static_cast<uint64_t>(rtt_us));
+        s.jitter_us.record(static_cast<uint64_t>(jitter_us));
+    }
+
+    void on_rejected()
+    {
+        // single writer, plain load + store
+        auto& rejected = local_shard().rejected;
+        rejected.store(rejected.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    time_sync_totals snapshot()
+    {
+        time_sync_totals totals;
+        std::lock_guard<std::mutex> lock(shards_lock);
+        for (auto& s : shards)
+        {
+            totals.rtt_us.merge(s->rtt_us);
+            totals.jitter_us.merge(s->jitter_us);
+            totals.rejected += s->rejected.load(std::memory_order_relaxed);
+        }
+        return totals;
+    }
+}
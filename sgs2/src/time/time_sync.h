@@ -0,0 +1,85 @@
+#ifndef __TIME_SYNC_H
+#define __TIME_SYNC_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "../core/src/metrics/histogram.h"
+
+// what the server knows about one client's latency and clock, microseconds
+struct rtt_estimate
+{
+    uint64_t samples = 0;
+    int64_t last_us = 0;
+    int64_t srtt_us = 0;        // EWMA, gain 1/8
+    int64_t jitter_us = 0;      // EWMA of |rtt - srtt|, gain 1/4
+    int64_t min_us = 0;         // lowest rtt of the last window samples
+    int64_t offset_us = 0;      // client clock - server clock, from the lowest rtt sample
+};
+
+// rtt and clock offset of one session from its CS_PING / SC_PING exchanges, measured on the server clock
+// SC_PING carries server_time; the next CS_PING echoes it with hold, the time it sat on the client,
+// and the client's own send time t0. received at t1:
+//   rtt    = t1 - echo - hold
+//   offset = ((t0 - hold - echo) + (t0 - t1)) / 2      client - server over the two legs, as NTP does
+// the offset comes from the sample with the lowest rtt in the window, it queued least (NTP clock filter)
+// one writer, the session's read path; readers on any thread may see fields from neighbouring samples
+class rtt_estimator
+{
+public:
+    // NTP's clock filter keeps 8
+    static constexpr size_t window = 8;
+
+    // false and no change when the exchange can't be used: no echo yet, or times that can't be right
+    bool on_ping(int64_t client_sent_us, int64_t echo_us, int64_t hold_us, int64_t received_us);
+
+    rtt_estimate estimate() const;
+
+    // a client timestamp in server time, the client's time itself until there is a sample
+    int64_t to_server_us(int64_t client_us) const { return client_us - offset_us_.load(std::memory_order_relaxed); }
+
+private:
+    // rtt is bounded by max_rtt_us and fits 32 bits
+    std::array<int32_t, window> rtt_window_{};
+    std::array<int64_t, window> offset_window_{};
+    unsigned char next_ = 0;
+    unsigned char filled_ = 0;
+
+    std::atomic<uint64_t> samples_{ 0 };
+    std::atomic<int64_t> last_us_{ 0 };
+    std::atomic<int64_t> srtt_us_{ 0 };
+    std::atomic<int64_t> jitter_us_{ 0 };
+    std::atomic<int64_t> min_us_{ 0 };
+    std::atomic<int64_t> offset_us_{ 0 };
+};
+
+struct time_sync_totals
+{
+    core::histogram rtt_us;
+    core::histogram jitter_us;
+    uint64_t rejected = 0;
+};
+
+struct session_rtt
+{
+    unsigned int session_id;
+    rtt_estimate estimate;
+};
+
+// sessions and totals for export
+namespace time_sync
+{
+    // connected sessions are listed by sessions() until untrack()
+    void track(unsigned int session_id, std::shared_ptr<const rtt_estimator> estimator);
+    void untrack(unsigned int session_id);
+    std::vector<session_rtt> sessions();
+
+    // every accepted sample over all sessions, one shard per thread
+    void on_sample(int64_t rtt_us, int64_t jitter_us);
+    void on_rejected();
+    time_sync_totals snapshot();
+}
+
+#endif